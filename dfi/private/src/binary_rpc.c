@@ -0,0 +1,294 @@
+/**
+ *Licensed to the Apache Software Foundation (ASF) under one
+ *or more contributor license agreements.  See the NOTICE file
+ *distributed with this work for additional information
+ *regarding copyright ownership.  The ASF licenses this file
+ *to you under the Apache License, Version 2.0 (the
+ *"License"); you may not use this file except in compliance
+ *with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *Unless required by applicable law or agreed to in writing,
+ *software distributed under the License is distributed on an
+ *"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ *specific language governing permissions and limitations
+ *under the License.
+ */
+#include "binary_rpc.h"
+#include "binary_serializer.h"
+#include "dyn_type.h"
+#include "dyn_interface.h"
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ffi.h>
+
+
+static int OK = 0;
+static int ERROR = 1;
+
+DFI_SETUP_LOG(binaryRpc);
+
+typedef void (*gen_func_type)(void);
+
+struct generic_service_layout {
+	void *handle;
+	gen_func_type methods[];
+};
+
+static int binaryRpc_deserializeArgument(dyn_type *argType, binary_buffer_type *input, void **arg);
+static int binaryRpc_prepareInvoke(dyn_function_type *func, binary_buffer_type *output, int status, void *args[], char **out, size_t *outSize);
+
+int binaryRpc_call(dyn_interface_type *intf, void *service, const char *request, size_t requestSize, char **out, size_t *outSize) {
+	int status = OK;
+
+	binary_buffer_type input;
+	binaryBuffer_wrap(&input, request, requestSize);
+
+	const char *sig = NULL;
+	uint32_t sigLength = 0;
+	status = binaryBuffer_readText(&input, &sig, &sigLength);
+	if (status != OK) {
+		LOG_ERROR("Cannot read method id from binary request");
+		return ERROR;
+	}
+
+	struct method_entry *method = NULL;
+	if (sig == NULL) {
+		//compact form, the method index follows
+		uint32_t index = 0;
+		if (binaryBuffer_readUint32(&input, &index) != OK || dynInterface_methodForIndex(intf, (int) index, &method) != OK) {
+			LOG_ERROR("Cannot find method with index %u", index);
+			return ERROR;
+		}
+	} else {
+		char *id = strndup(sig, sigLength);
+		status = id != NULL ? dynInterface_findMethod(intf, id, &method) : ERROR;
+		if (status != OK) {
+			LOG_ERROR("Cannot find method with sig '%.*s'", (int) sigLength, sig);
+		}
+		free(id);
+		if (status != OK) {
+			return ERROR;
+		}
+	}
+
+	dyn_function_type *func = method->dynFunc;
+	dyn_type *returnType = dynFunction_returnType(func);
+	if (dynType_descriptorType(returnType) != 'N') {
+		//NOTE To be able to handle exception only N as returnType is supported
+		LOG_ERROR("Only interface methods with a native int are supported. Found type '%c'", (char)dynType_descriptorType(returnType));
+		return ERROR;
+	}
+
+	struct generic_service_layout *serv = service;
+	void *handle = serv->handle;
+	void (*fp)(void) = serv->methods[method->index];
+
+	int nrOfArgs = dynFunction_nrOfArguments(func);
+	void *args[nrOfArgs];
+	memset(args, 0, sizeof(args));
+
+	void *ptr = NULL;
+	void *ptrToPtr = &ptr;
+	void *noCompletion = NULL; //the exported service is always called synchronously
+
+	int i;
+	for (i = 0; i < nrOfArgs && status == OK; i += 1) {
+		dyn_type *argType = dynFunction_argumentTypeForIndex(func, i);
+		enum dyn_function_argument_meta  meta = dynFunction_argumentMetaForIndex(func, i);
+		if (meta == DYN_FUNCTION_ARGUMENT_META__STD) {
+			status = binaryRpc_deserializeArgument(argType, &input, &args[i]);
+		} else if (meta == DYN_FUNCTION_ARGUMENT_META__PRE_ALLOCATED_OUTPUT) {
+			status = dynType_alloc(argType, &args[i]);
+		} else if (meta == DYN_FUNCTION_ARGUMENT_META__OUTPUT) {
+			args[i] = &ptrToPtr;
+		} else if (meta == DYN_FUNCTION_ARGUMENT_META__HANDLE) {
+			args[i] = &handle;
+		} else if (meta == DYN_FUNCTION_ARGUMENT_META__ASYNC) {
+			args[i] = &noCompletion;
+		}
+	}
+
+	ffi_sarg returnVal = 1;
+
+	if (status == OK) {
+		dynFunction_call(func, fp, (void *) &returnVal, args);
+	}
+
+	int funcCallStatus = (int)returnVal;
+	if (status == OK && funcCallStatus != 0) {
+		LOG_WARNING("Error calling remote endpoint function, got error code %i", funcCallStatus);
+	}
+
+	binary_buffer_type output;
+	binaryBuffer_init(&output);
+	if (status == OK) {
+		status = binaryBuffer_writeUint32(&output, (uint32_t) funcCallStatus);
+	}
+
+	for (i = 0; i < nrOfArgs; i += 1) {
+		dyn_type *argType = dynFunction_argumentTypeForIndex(func, i);
+		enum dyn_function_argument_meta  meta = dynFunction_argumentMetaForIndex(func, i);
+		dyn_type *subType = NULL;
+		if (meta == DYN_FUNCTION_ARGUMENT_META__STD) {
+			dynType_free(argType, args[i]);
+		} else if (meta == DYN_FUNCTION_ARGUMENT_META__PRE_ALLOCATED_OUTPUT && args[i] != NULL) {
+			if (status == OK && funcCallStatus == 0) {
+				if (dynType_descriptorType(argType) == 't') {
+					status = binarySerializer_serializeBuffer(argType, args[i], &output);
+				} else {
+					dynType_typedPointer_getTypedType(argType, &subType);
+					status = binarySerializer_serializeBuffer(subType, *(void **) args[i], &output);
+				}
+			}
+			dynType_free(argType, args[i]);
+		} else if (meta == DYN_FUNCTION_ARGUMENT_META__OUTPUT) {
+			//'*t' or '**T', both written as the (nullable) value ptr refers to
+			dynType_typedPointer_getTypedType(argType, &subType);
+			if (status == OK && funcCallStatus == 0) {
+				status = binarySerializer_serializeBuffer(subType, &ptr, &output);
+			}
+			if (ptr != NULL && dynType_descriptorType(subType) == 't') {
+				free(ptr);
+			} else if (ptr != NULL) {
+				dyn_type *typedType = NULL;
+				dynType_typedPointer_getTypedType(subType, &typedType);
+				dynType_free(typedType, ptr);
+			}
+			ptr = NULL;
+		}
+	}
+
+	if (status == OK) {
+		*out = output.data;
+		*outSize = output.size;
+	} else {
+		free(output.data);
+	}
+
+	return status;
+}
+
+static int binaryRpc_deserializeArgument(dyn_type *argType, binary_buffer_type *input, void **arg) {
+	int status = OK;
+	if (dynType_descriptorType(argType) == 't') {
+		//the argument is the char pointer, so the text needs a slot to live in
+		void *textLoc = calloc(1, sizeof(char *));
+		status = textLoc != NULL ? binarySerializer_deserializeBuffer(argType, input, textLoc) : ERROR;
+		if (status == OK) {
+			*arg = textLoc;
+		} else {
+			free(textLoc);
+		}
+	} else {
+		status = binarySerializer_deserializeBuffer(argType, input, arg);
+	}
+	return status;
+}
+
+int binaryRpc_prepareInvokeRequest(dyn_function_type *func, const char *id, void *args[], char **out, size_t *outSize) {
+	LOG_DEBUG("Calling remote function '%s'\n", id);
+	binary_buffer_type output;
+	binaryBuffer_init(&output);
+	int status = binaryBuffer_writeText(&output, id);
+	return binaryRpc_prepareInvoke(func, &output, status, args, out, outSize);
+}
+
+int binaryRpc_prepareInvokeRequestForIndex(dyn_function_type *func, int index, void *args[], char **out, size_t *outSize) {
+	LOG_DEBUG("Calling remote function with index %i\n", index);
+	binary_buffer_type output;
+	binaryBuffer_init(&output);
+	int status = binaryBuffer_writeText(&output, NULL);
+	if (status == OK) {
+		status = binaryBuffer_writeUint32(&output, (uint32_t) index);
+	}
+	return binaryRpc_prepareInvoke(func, &output, status, args, out, outSize);
+}
+
+static int binaryRpc_prepareInvoke(dyn_function_type *func, binary_buffer_type *output, int status, void *args[], char **out, size_t *outSize) {
+	int i;
+	int nrOfArgs = dynFunction_nrOfArguments(func);
+	for (i = 0; i < nrOfArgs && status == OK; i +=1) {
+		dyn_type *type = dynFunction_argumentTypeForIndex(func, i);
+		enum dyn_function_argument_meta  meta = dynFunction_argumentMetaForIndex(func, i);
+		if (meta == DYN_FUNCTION_ARGUMENT_META__STD) {
+			status = binarySerializer_serializeBuffer(type, args[i], output);
+		} else {
+			//skip handle / output types
+		}
+	}
+
+	if (status == OK) {
+		*out = output->data;
+		*outSize = output->size;
+	} else {
+		free(output->data);
+	}
+
+	return status;
+}
+
+int binaryRpc_handleReply(dyn_function_type *func, const char *reply, size_t replySize, void *args[]) {
+	int status = OK;
+
+	binary_buffer_type input;
+	binaryBuffer_wrap(&input, reply, replySize);
+
+	uint32_t remoteStatus = 0;
+	status = binaryBuffer_readUint32(&input, &remoteStatus);
+	if (status == OK && remoteStatus != 0) {
+		LOG_WARNING("Remote function returned error code %i", (int) remoteStatus);
+		status = ERROR;
+	}
+
+	int nrOfArgs = dynFunction_nrOfArguments(func);
+	int i;
+	for (i = 0; i < nrOfArgs && status == OK; i += 1) {
+		dyn_type *argType = dynFunction_argumentTypeForIndex(func, i);
+		enum dyn_function_argument_meta meta = dynFunction_argumentMetaForIndex(func, i);
+		if (meta == DYN_FUNCTION_ARGUMENT_META__PRE_ALLOCATED_OUTPUT) {
+			void *tmp = NULL;
+			void **out = (void **) args[i];
+
+			if (dynType_descriptorType(argType) == 't') {
+				status = binarySerializer_deserializeBuffer(argType, &input, &tmp);
+				if (status == OK && tmp != NULL) {
+					strcpy(*out, tmp);
+				}
+				free(tmp);
+			} else {
+				dyn_type *subType = NULL;
+				dynType_typedPointer_getTypedType(argType, &subType);
+				status = binarySerializer_deserializeBuffer(subType, &input, &tmp);
+				if (status == OK) {
+					//nested allocations are handed over to the caller, only the top level is freed
+					memcpy(*out, tmp, dynType_size(subType));
+					free(tmp);
+				}
+			}
+		} else if (meta == DYN_FUNCTION_ARGUMENT_META__OUTPUT) {
+			dyn_type *subType = NULL;
+			dynType_typedPointer_getTypedType(argType, &subType);
+			void ***out = (void ***) args[i];
+
+			if (dynType_descriptorType(subType) == 't') {
+				status = binarySerializer_deserializeBuffer(subType, &input, *out);
+			} else {
+				void **tmp = NULL;
+				status = binarySerializer_deserializeBuffer(subType, &input, (void **) &tmp);
+				if (status == OK) {
+					**out = *tmp;
+					free(tmp);
+				}
+			}
+		} else {
+			//skip
+		}
+	}
+
+	return status;
+}
@@ -0,0 +1,543 @@
+/**
+ *Licensed to the Apache Software Foundation (ASF) under one
+ *or more contributor license agreements.  See the NOTICE file
+ *distributed with this work for additional information
+ *regarding copyright ownership.  The ASF licenses this file
+ *to you under the Apache License, Version 2.0 (the
+ *"License"); you may not use this file except in compliance
+ *with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *Unless required by applicable law or agreed to in writing,
+ *software distributed under the License is distributed on an
+ *"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ *specific language governing permissions and limitations
+ *under the License.
+ */
+#include "binary_serializer.h"
+#include "dyn_type.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BINARY_NULL_LENGTH UINT32_MAX
+#define BINARY_INITIAL_CAPACITY 64
+
+static int OK = 0;
+static int ERROR = 1;
+
+DFI_SETUP_LOG(binarySerializer);
+
+//same layout as used by dyn_type for sequences
+struct generic_sequence {
+    uint32_t cap;
+    uint32_t len;
+    void *buf;
+};
+
+static int binarySerializer_createType(dyn_type *type, binary_buffer_type *input, void **result);
+static int binarySerializer_readAny(dyn_type *type, binary_buffer_type *input, void *loc);
+static int binarySerializer_readComplex(dyn_type *type, binary_buffer_type *input, void *loc);
+static int binarySerializer_readSequence(dyn_type *type, binary_buffer_type *input, void *loc);
+
+static int binarySerializer_writeAny(dyn_type *type, void *input, binary_buffer_type *output);
+static int binarySerializer_writeComplex(dyn_type *type, void *input, binary_buffer_type *output);
+static int binarySerializer_writeSequence(dyn_type *type, void *input, binary_buffer_type *output);
+
+static size_t binarySerializer_scalarWidth(int descriptor);
+
+static inline bool binaryBuffer_isLittleEndian(void) {
+    const uint16_t val = 1;
+    return *(const uint8_t *) &val == 1;
+}
+
+void binaryBuffer_init(binary_buffer_type *buffer) {
+    buffer->data = NULL;
+    buffer->size = 0;
+    buffer->capacity = 0;
+    buffer->pos = 0;
+}
+
+void binaryBuffer_wrap(binary_buffer_type *buffer, const char *data, size_t size) {
+    buffer->data = (char *) data;
+    buffer->size = size;
+    buffer->capacity = 0; //not owned, never written
+    buffer->pos = 0;
+}
+
+static int binaryBuffer_reserve(binary_buffer_type *buffer, size_t extra) {
+    int status = OK;
+    if (buffer->size + extra > buffer->capacity) {
+        size_t cap = buffer->capacity == 0 ? BINARY_INITIAL_CAPACITY : buffer->capacity;
+        while (cap < buffer->size + extra) {
+            cap *= 2;
+        }
+        char *data = realloc(buffer->data, cap);
+        if (data != NULL) {
+            buffer->data = data;
+            buffer->capacity = cap;
+        } else {
+            status = ERROR;
+            LOG_ERROR("Cannot grow binary buffer to %zu bytes", cap);
+        }
+    }
+    return status;
+}
+
+static int binaryBuffer_writeBytes(binary_buffer_type *buffer, const void *bytes, size_t size) {
+    int status = binaryBuffer_reserve(buffer, size);
+    if (status == OK && size > 0) {
+        memcpy(buffer->data + buffer->size, bytes, size);
+        buffer->size += size;
+    }
+    return status;
+}
+
+static int binaryBuffer_readBytes(binary_buffer_type *buffer, void *bytes, size_t size) {
+    int status = OK;
+    if (size > buffer->size - buffer->pos) {
+        status = ERROR;
+        LOG_ERROR("Binary input truncated, need %zu bytes but only %zu left", size, buffer->size - buffer->pos);
+    } else {
+        memcpy(bytes, buffer->data + buffer->pos, size);
+        buffer->pos += size;
+    }
+    return status;
+}
+
+//writes a native scalar of the given width as little-endian
+static int binaryBuffer_writeScalar(binary_buffer_type *buffer, const void *loc, size_t width) {
+    int status = binaryBuffer_reserve(buffer, width);
+    if (status == OK) {
+        char *dst = buffer->data + buffer->size;
+        if (binaryBuffer_isLittleEndian()) {
+            memcpy(dst, loc, width);
+        } else {
+            size_t i;
+            for (i = 0; i < width; i += 1) {
+                dst[i] = ((const char *) loc)[width - 1 - i];
+            }
+        }
+        buffer->size += width;
+    }
+    return status;
+}
+
+static int binaryBuffer_readScalar(binary_buffer_type *buffer, void *loc, size_t width) {
+    int status = OK;
+    if (width > buffer->size - buffer->pos) {
+        status = ERROR;
+        LOG_ERROR("Binary input truncated, need %zu bytes but only %zu left", width, buffer->size - buffer->pos);
+    } else {
+        const char *src = buffer->data + buffer->pos;
+        if (binaryBuffer_isLittleEndian()) {
+            memcpy(loc, src, width);
+        } else {
+            size_t i;
+            for (i = 0; i < width; i += 1) {
+                ((char *) loc)[i] = src[width - 1 - i];
+            }
+        }
+        buffer->pos += width;
+    }
+    return status;
+}
+
+int binaryBuffer_writeUint32(binary_buffer_type *buffer, uint32_t val) {
+    return binaryBuffer_writeScalar(buffer, &val, sizeof(val));
+}
+
+int binaryBuffer_readUint32(binary_buffer_type *buffer, uint32_t *val) {
+    return binaryBuffer_readScalar(buffer, val, sizeof(*val));
+}
+
+int binaryBuffer_writeText(binary_buffer_type *buffer, const char *text) {
+    int status = OK;
+    if (text == NULL) {
+        status = binaryBuffer_writeUint32(buffer, BINARY_NULL_LENGTH);
+    } else {
+        size_t len = strlen(text);
+        status = binaryBuffer_writeUint32(buffer, (uint32_t) len);
+        if (status == OK) {
+            status = binaryBuffer_writeBytes(buffer, text, len);
+        }
+    }
+    return status;
+}
+
+int binaryBuffer_readText(binary_buffer_type *buffer, const char **text, uint32_t *length) {
+    uint32_t len = 0;
+    int status = binaryBuffer_readUint32(buffer, &len);
+    if (status == OK && len == BINARY_NULL_LENGTH) {
+        *text = NULL;
+        *length = 0;
+    } else if (status == OK && len > buffer->size - buffer->pos) {
+        status = ERROR;
+        LOG_ERROR("Binary input truncated, text of %u bytes but only %zu left", len, buffer->size - buffer->pos);
+    } else if (status == OK) {
+        *text = buffer->data + buffer->pos;
+        *length = len;
+        buffer->pos += len;
+    }
+    return status;
+}
+
+int binarySerializer_deserialize(dyn_type *type, const char *input, size_t inputSize, void **result) {
+    binary_buffer_type buffer;
+    binaryBuffer_wrap(&buffer, input, inputSize);
+    int status = binarySerializer_deserializeBuffer(type, &buffer, result);
+    if (status == OK && buffer.pos != buffer.size) {
+        LOG_WARNING("Ignoring %zu trailing bytes in binary input", buffer.size - buffer.pos);
+    }
+    return status;
+}
+
+int binarySerializer_deserializeBuffer(dyn_type *type, binary_buffer_type *input, void **result) {
+    return binarySerializer_createType(type, input, result);
+}
+
+static int binarySerializer_createType(dyn_type *type, binary_buffer_type *input, void **result) {
+    int status = OK;
+    void *inst = NULL;
+
+    if (dynType_descriptorType(type) == 't') {
+        const char *text = NULL;
+        uint32_t len = 0;
+        status = binaryBuffer_readText(input, &text, &len);
+        if (status == OK && text != NULL) {
+            inst = strndup(text, len);
+            if (inst == NULL) {
+                status = ERROR;
+                LOG_ERROR("Cannot allocate memory for string");
+            }
+        }
+    } else {
+        //not dynType_alloc, that would also allocate the target of a typed pointer before it is read
+        inst = calloc(1, dynType_size(type));
+        if (inst != NULL) {
+            status = binarySerializer_readAny(type, input, inst);
+        } else {
+            status = ERROR;
+            LOG_ERROR("Error allocating memory for type '%c'", (char) dynType_descriptorType(type));
+        }
+    }
+
+    if (status == OK) {
+        *result = inst;
+    } else {
+        dynType_free(type, inst);
+    }
+
+    return status;
+}
+
+static size_t binarySerializer_scalarWidth(int descriptor) {
+    size_t width = 0;
+    switch (descriptor) {
+        case 'Z' :
+        case 'B' :
+        case 'b' :
+            width = 1;
+            break;
+        case 'S' :
+        case 's' :
+            width = 2;
+            break;
+        case 'I' :
+        case 'i' :
+        case 'N' :
+        case 'F' :
+            width = 4;
+            break;
+        case 'J' :
+        case 'j' :
+        case 'D' :
+            width = 8;
+            break;
+        default :
+            break;
+    }
+    return width;
+}
+
+static int binarySerializer_readAny(dyn_type *type, binary_buffer_type *input, void *loc) {
+    int status = OK;
+    int descriptor = dynType_descriptorType(type);
+    dyn_type *subType = NULL;
+    uint8_t present = 0;
+    uint8_t z = 0;
+    int32_t n = 0;
+
+    switch (descriptor) {
+        case 'Z' :
+            status = binaryBuffer_readScalar(input, &z, 1);
+            if (status == OK) {
+                *(bool *) loc = z != 0;
+            }
+            break;
+        case 'N' :
+            status = binaryBuffer_readScalar(input, &n, sizeof(n));
+            if (status == OK) {
+                *(int *) loc = (int) n;
+            }
+            break;
+        case 'B' :
+        case 'b' :
+        case 'S' :
+        case 's' :
+        case 'I' :
+        case 'i' :
+        case 'J' :
+        case 'j' :
+        case 'F' :
+        case 'D' :
+            status = binaryBuffer_readScalar(input, loc, binarySerializer_scalarWidth(descriptor));
+            break;
+        case 't' :
+            status = binarySerializer_createType(type, input, (void **) loc);
+            break;
+        case '[' :
+            status = binarySerializer_readSequence(type, input, loc);
+            break;
+        case '{' :
+            status = binarySerializer_readComplex(type, input, loc);
+            break;
+        case '*' :
+            status = binaryBuffer_readScalar(input, &present, 1);
+            if (status == OK) {
+                status = dynType_typedPointer_getTypedType(type, &subType);
+            }
+            if (status == OK && present) {
+                if (dynType_descriptorType(subType) == 't') {
+                    //pointer to text, the text itself needs a slot as well
+                    void *textLoc = calloc(1, sizeof(char *));
+                    status = textLoc != NULL ? binarySerializer_createType(subType, input, textLoc) : ERROR;
+                    if (status == OK) {
+                        *(void **) loc = textLoc;
+                    } else {
+                        free(textLoc);
+                    }
+                } else {
+                    status = binarySerializer_createType(subType, input, (void **) loc);
+                }
+            }
+            break;
+        case 'P' :
+            LOG_WARNING("Untyped pointer not supported for serialization. ignoring");
+            break;
+        default :
+            status = ERROR;
+            LOG_ERROR("Error provided type '%c' not supported for binary serialization\n", descriptor);
+            break;
+    }
+
+    return status;
+}
+
+static int binarySerializer_readComplex(dyn_type *type, binary_buffer_type *input, void *loc) {
+    assert(dynType_type(type) == DYN_TYPE_COMPLEX);
+    struct complex_type_entries_head *entries = NULL;
+    struct complex_type_entry *entry = NULL;
+
+    int status = dynType_complex_entries(type, &entries);
+    if (status == OK) {
+        int index = 0;
+        TAILQ_FOREACH(entry, entries, entries) {
+            void *valLoc = NULL;
+            dyn_type *valType = NULL;
+            status = dynType_complex_valLocAt(type, index, loc, &valLoc);
+            if (status == OK) {
+                status = dynType_complex_dynTypeAt(type, index, &valType);
+            }
+            if (status == OK) {
+                status = binarySerializer_readAny(valType, input, valLoc);
+            }
+            if (status != OK) {
+                break;
+            }
+            index += 1;
+        }
+    }
+
+    return status;
+}
+
+static int binarySerializer_readSequence(dyn_type *type, binary_buffer_type *input, void *loc) {
+    assert(dynType_type(type) == DYN_TYPE_SEQUENCE);
+    struct generic_sequence *seq = loc;
+    dyn_type *itemType = dynType_sequence_itemType(type);
+    int itemDescriptor = dynType_descriptorType(itemType);
+    size_t width = binarySerializer_scalarWidth(itemDescriptor);
+    size_t left = input->size - input->pos;
+
+    uint32_t len = 0;
+    int status = binaryBuffer_readUint32(input, &len);
+    left -= status == OK ? sizeof(len) : 0;
+
+    //every encoded item takes at least one byte, reject lengths the input cannot hold before allocating
+    if (status == OK && (len > left || (width > 0 && (size_t) len * width > left))) {
+        status = ERROR;
+        LOG_ERROR("Binary input truncated, sequence of %u items but only %zu bytes left", len, left);
+    }
+
+    if (status == OK) {
+        status = dynType_sequence_alloc(type, loc, len);
+    }
+
+    if (status == OK) {
+        size_t itemSize = dynType_size(itemType);
+        if (width > 0 && width == itemSize && itemDescriptor != 'Z' && binaryBuffer_isLittleEndian()) {
+            //wire and memory layout are the same, copy in one go
+            status = binaryBuffer_readBytes(input, seq->buf, (size_t) len * width);
+            if (status == OK) {
+                seq->len = len;
+            }
+        } else {
+            uint32_t i;
+            for (i = 0; i < len && status == OK; i += 1) {
+                status = binarySerializer_readAny(itemType, input, (char *) seq->buf + i * itemSize);
+                if (status == OK) {
+                    seq->len = i + 1;
+                }
+            }
+        }
+    }
+
+    return status;
+}
+
+int binarySerializer_serialize(dyn_type *type, void *input, char **output, size_t *outputSize) {
+    binary_buffer_type buffer;
+    binaryBuffer_init(&buffer);
+
+    int status = binarySerializer_serializeBuffer(type, input, &buffer);
+
+    if (status == OK) {
+        *output = buffer.data;
+        *outputSize = buffer.size;
+    } else {
+        free(buffer.data);
+    }
+
+    return status;
+}
+
+int binarySerializer_serializeBuffer(dyn_type *type, void *input, binary_buffer_type *output) {
+    return binarySerializer_writeAny(type, input, output);
+}
+
+static int binarySerializer_writeAny(dyn_type *type, void *input, binary_buffer_type *output) {
+    int status = OK;
+    int descriptor = dynType_descriptorType(type);
+    dyn_type *subType = NULL;
+    void *ptr = NULL;
+    uint8_t present = 0;
+    uint8_t z = 0;
+    int32_t n = 0;
+
+    switch (descriptor) {
+        case 'Z' :
+            z = *(bool *) input ? 1 : 0;
+            status = binaryBuffer_writeScalar(output, &z, 1);
+            break;
+        case 'N' :
+            n = (int32_t) *(int *) input;
+            status = binaryBuffer_writeScalar(output, &n, sizeof(n));
+            break;
+        case 'B' :
+        case 'b' :
+        case 'S' :
+        case 's' :
+        case 'I' :
+        case 'i' :
+        case 'J' :
+        case 'j' :
+        case 'F' :
+        case 'D' :
+            status = binaryBuffer_writeScalar(output, input, binarySerializer_scalarWidth(descriptor));
+            break;
+        case 't' :
+            status = binaryBuffer_writeText(output, *(const char **) input);
+            break;
+        case '*' :
+            ptr = *(void **) input;
+            present = ptr != NULL ? 1 : 0;
+            status = binaryBuffer_writeScalar(output, &present, 1);
+            if (status == OK) {
+                status = dynType_typedPointer_getTypedType(type, &subType);
+            }
+            if (status == OK && ptr != NULL) {
+                status = binarySerializer_writeAny(subType, ptr, output);
+            }
+            break;
+        case '{' :
+            status = binarySerializer_writeComplex(type, input, output);
+            break;
+        case '[' :
+            status = binarySerializer_writeSequence(type, input, output);
+            break;
+        case 'P' :
+            LOG_WARNING("Untyped pointer not supported for serialization. ignoring");
+            break;
+        default :
+            LOG_ERROR("Unsupported descriptor '%c'", descriptor);
+            status = ERROR;
+            break;
+    }
+
+    return status;
+}
+
+static int binarySerializer_writeComplex(dyn_type *type, void *input, binary_buffer_type *output) {
+    assert(dynType_type(type) == DYN_TYPE_COMPLEX);
+    struct complex_type_entries_head *entries = NULL;
+    struct complex_type_entry *entry = NULL;
+
+    int status = dynType_complex_entries(type, &entries);
+    if (status == OK) {
+        int index = 0;
+        TAILQ_FOREACH(entry, entries, entries) {
+            void *subLoc = NULL;
+            dyn_type *subType = NULL;
+            status = dynType_complex_valLocAt(type, index, input, &subLoc);
+            if (status == OK) {
+                status = dynType_complex_dynTypeAt(type, index, &subType);
+            }
+            if (status == OK) {
+                status = binarySerializer_writeAny(subType, subLoc, output);
+            }
+            if (status != OK) {
+                break;
+            }
+            index += 1;
+        }
+    }
+
+    return status;
+}
+
+static int binarySerializer_writeSequence(dyn_type *type, void *input, binary_buffer_type *output) {
+    assert(dynType_type(type) == DYN_TYPE_SEQUENCE);
+    struct generic_sequence *seq = input;
+    dyn_type *itemType = dynType_sequence_itemType(type);
+    int itemDescriptor = dynType_descriptorType(itemType);
+    size_t width = binarySerializer_scalarWidth(itemDescriptor);
+    size_t itemSize = dynType_size(itemType);
+
+    int status = binaryBuffer_writeUint32(output, seq->len);
+
+    if (status == OK && width > 0 && width == itemSize && itemDescriptor != 'Z' && binaryBuffer_isLittleEndian()) {
+        status = binaryBuffer_writeBytes(output, seq->buf, (size_t) seq->len * width);
+    } else if (status == OK) {
+        uint32_t i;
+        for (i = 0; i < seq->len && status == OK; i += 1) {
+            status = binarySerializer_writeAny(itemType, (char *) seq->buf + i * itemSize, output);
+        }
+    }
+
+    return status;
+}
@@ -28,6 +28,8 @@ struct _dyn_function_type {
     char *name;
     struct types_head *refTypes; //NOTE not owned
     TAILQ_HEAD(,_dyn_function_argument_type) arguments;
+    int nrOfArguments;
+    struct _dyn_function_argument_type **argumentsByIndex; //index -> argument, for O(1) lookups
     ffi_type **ffiArguments;
     dyn_type *funcReturn;
     ffi_cif cif;
@@ -39,6 +41,12 @@ struct _dyn_function_type {
     void (*bind)(void *userData, void *args[], void *ret);
 };
 
+struct _dyn_closure_type {
+    ffi_closure *ffiClosure;
+    void *userData;
+    void (*bind)(void *userData, void *args[], void *ret);
+};
+
 typedef struct _dyn_function_argument_type dyn_function_argument_type;
 struct _dyn_function_argument_type {
     int index;
@@ -96,6 +104,8 @@ int dynFunction_parse(FILE *descriptor, struct types_head *refTypes, dyn_functio
                 arg->argumentMeta = DYN_FUNCTION_ARGUMENT_META__PRE_ALLOCATED_OUTPUT;
             } else if (strcmp(meta, "out") == 0) {
                 arg->argumentMeta = DYN_FUNCTION_ARGUMENT_META__OUTPUT;
+            } else if (strcmp(meta, "async") == 0) {
+                arg->argumentMeta = DYN_FUNCTION_ARGUMENT_META__ASYNC;
             } else {
                 LOG_WARNING("unknown argument meta '%s' encountered", meta);
                 arg->argumentMeta = DYN_FUNCTION_ARGUMENT_META__STD;
@@ -188,14 +198,8 @@ static int dynFunction_parseDescriptor(dyn_function_type *dynFunc, FILE *descrip
 
 enum dyn_function_argument_meta dynFunction_argumentMetaForIndex(dyn_function_type *dynFunc, int argumentNr) {
     enum dyn_function_argument_meta result = 0;
-    dyn_function_argument_type *arg = NULL;
-    int index = 0;
-    TAILQ_FOREACH(arg, &dynFunc->arguments, entries) {
-        if (index == argumentNr) {
-            result = arg->argumentMeta;
-            break;
-        }
-        index += 1;
+    if (argumentNr >= 0 && argumentNr < dynFunc->nrOfArguments) {
+        result = dynFunc->argumentsByIndex[argumentNr]->argumentMeta;
     }
     return result;
 }
@@ -210,10 +214,16 @@ static int dynFunction_initCif(dyn_function_type *dynFunc) {
         count +=1;
     }
 
+    dynFunc->nrOfArguments = count;
     dynFunc->ffiArguments = calloc(count, sizeof(ffi_type*));
+    dynFunc->argumentsByIndex = calloc(count, sizeof(*dynFunc->argumentsByIndex));
+    if ((dynFunc->ffiArguments == NULL || dynFunc->argumentsByIndex == NULL) && count > 0) {
+        return 1;
+    }
 
     TAILQ_FOREACH(entry, &dynFunc->arguments, entries) {
         dynFunc->ffiArguments[entry->index] = dynType_ffiType(entry->type);
+        dynFunc->argumentsByIndex[entry->index] = entry;
     }
     
     ffi_type **args = dynFunc->ffiArguments;
@@ -241,6 +251,7 @@ void dynFunction_destroy(dyn_function_type *dynFunc) {
         if (dynFunc->ffiArguments != NULL) {
             free(dynFunc->ffiArguments);
         }
+        free(dynFunc->argumentsByIndex);
         
         dyn_function_argument_type *entry = NULL;
         dyn_function_argument_type *tmp = NULL;
@@ -292,6 +303,50 @@ int dynFunction_createClosure(dyn_function_type *dynFunc, void (*bind)(void *, v
     return status;
 }
 
+static void dynFunction_ffiClosureBind(ffi_cif *cif, void *ret, void *args[], void *userData) {
+    dyn_closure_type *closure = userData;
+    closure->bind(closure->userData, args, ret);
+}
+
+int dynFunction_allocClosure(dyn_function_type *dynFunc, void (*bind)(void *, void **, void*), void *userData, dyn_closure_type **out, void(**outFn)(void)) {
+    int status = OK;
+    void (*fn)(void) = NULL;
+    dyn_closure_type *closure = calloc(1, sizeof(*closure));
+    if (closure != NULL) {
+        closure->ffiClosure = ffi_closure_alloc(sizeof(ffi_closure), (void **)&fn);
+    }
+
+    if (closure != NULL && closure->ffiClosure != NULL) {
+        closure->userData = userData;
+        closure->bind = bind;
+        //the cif is only read, so it can be shared between closures
+        int rc = ffi_prep_closure_loc(closure->ffiClosure, &dynFunc->cif, dynFunction_ffiClosureBind, closure, fn);
+        if (rc != FFI_OK) {
+            status = ERROR;
+        }
+    } else {
+        status = MEM_ERROR;
+    }
+
+    if (status == OK) {
+        *out = closure;
+        *outFn = fn;
+    } else {
+        dynFunction_freeClosure(closure);
+    }
+
+    return status;
+}
+
+void dynFunction_freeClosure(dyn_closure_type *closure) {
+    if (closure != NULL) {
+        if (closure->ffiClosure != NULL) {
+            ffi_closure_free(closure->ffiClosure);
+        }
+        free(closure);
+    }
+}
+
 int dynFunction_getFnPointer(dyn_function_type *dynFunc, void (**fn)(void)) {
     int status = 0;
     if (dynFunc != NULL && dynFunc->fn != NULL) {
@@ -303,24 +358,13 @@ int dynFunction_getFnPointer(dyn_function_type *dynFunc, void (**fn)(void)) {
 }
 
 int dynFunction_nrOfArguments(dyn_function_type *dynFunc) {
-    int count = 0;
-    dyn_function_argument_type *entry = NULL;
-    TAILQ_FOREACH(entry, &dynFunc->arguments, entries) {
-        count += 1;
-    }
-    return count;
+    return dynFunc->nrOfArguments;
 }
 
 dyn_type *dynFunction_argumentTypeForIndex(dyn_function_type *dynFunc, int argumentNr) {
     dyn_type *result = NULL;
-    int index = 0;
-    dyn_function_argument_type *entry = NULL;
-    TAILQ_FOREACH(entry, &dynFunc->arguments, entries) {
-        if (index == argumentNr) {
-            result = entry->type;
-            break;
-        }
-        index +=1;
+    if (argumentNr >= 0 && argumentNr < dynFunc->nrOfArguments) {
+        result = dynFunc->argumentsByIndex[argumentNr]->type;
     }
     return result;
 }
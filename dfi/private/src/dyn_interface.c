@@ -24,6 +24,7 @@
 #include "dyn_common.h"
 #include "dyn_type.h"
 #include "dyn_interface.h"
+#include "hash_map.h"
 
 DFI_SETUP_LOG(dynInterface);
 
@@ -33,6 +34,11 @@ struct _dyn_interface_type {
     struct types_head types;
     struct methods_head methods;
     version_pt version;
+
+    //dispatch tables, created after parsing
+    int nrOfMethods;
+    struct method_entry **methodsByIndex;
+    hash_map_pt methodsById; //key -> method id (owned by the entry), value -> method_entry
 };
 
 static const int OK = 0;
@@ -42,6 +48,9 @@ static int dynInterface_parseSection(dyn_interface_type *intf, FILE *stream);
 static int dynInterface_parseAnnotations(dyn_interface_type *intf, FILE *stream);
 static int dynInterface_parseTypes(dyn_interface_type *intf, FILE *stream);
 static int dynInterface_parseMethods(dyn_interface_type *intf, FILE *stream);
+static int dynInterface_createDispatchTables(dyn_interface_type *intf);
+static unsigned int dynInterface_idHash(const void *id);
+static int dynInterface_idEquals(const void *id1, const void *id2);
 static int dynInterface_parseHeader(dyn_interface_type *intf, FILE *stream);
 static int dynInterface_parseNameValueSection(dyn_interface_type *intf, FILE *stream, struct namvals_head *head);
 static int dynInterface_checkInterface(dyn_interface_type *intf);
@@ -76,6 +85,10 @@ int dynInterface_parse(FILE *descriptor, dyn_interface_type **out) {
             status = dynInterface_checkInterface(intf);
         }
 
+        if (status == OK) {
+            status = dynInterface_createDispatchTables(intf);
+        }
+
         if(status==OK){ /* We are sure that version field is present in the header */
         	char* version=NULL;
             dynInterface_getVersionString(intf,&version);
@@ -99,6 +112,50 @@ int dynInterface_parse(FILE *descriptor, dyn_interface_type **out) {
     return status;
 }
 
+static int dynInterface_createDispatchTables(dyn_interface_type *intf) {
+    int status = OK;
+
+    int count = 0;
+    struct method_entry *entry = NULL;
+    TAILQ_FOREACH(entry, &intf->methods, entries) {
+        count += 1;
+    }
+
+    intf->methodsByIndex = calloc(count + 1, sizeof(*intf->methodsByIndex));
+    intf->methodsById = hashMap_create(dynInterface_idHash, NULL, dynInterface_idEquals, NULL);
+    if (intf->methodsByIndex == NULL || intf->methodsById == NULL) {
+        status = ERROR;
+        LOG_ERROR("Error allocating memory for method dispatch tables");
+    }
+
+    if (status == OK) {
+        intf->nrOfMethods = count;
+        TAILQ_FOREACH(entry, &intf->methods, entries) {
+            intf->methodsByIndex[entry->index] = entry;
+            if (!hashMap_containsKey(intf->methodsById, entry->id)) {
+                hashMap_put(intf->methodsById, entry->id, entry);
+            }
+        }
+    }
+
+    return status;
+}
+
+static unsigned int dynInterface_idHash(const void *id) {
+    //djb2
+    const unsigned char *str = id;
+    unsigned int hash = 5381;
+    int c;
+    while ((c = *str++) != 0) {
+        hash = ((hash << 5) + hash) + c;
+    }
+    return hash;
+}
+
+static int dynInterface_idEquals(const void *id1, const void *id2) {
+    return strcmp(id1, id2) == 0;
+}
+
 static int dynInterface_checkInterface(dyn_interface_type *intf) {
     int status = OK;
 
@@ -377,6 +434,11 @@ void dynInterface_destroy(dyn_interface_type *intf) {
             free(tmp);
         }
 
+        if (intf->methodsById != NULL) {
+            hashMap_destroy(intf->methodsById, false, false);
+        }
+        free(intf->methodsByIndex);
+
         if(intf->version!=NULL){
         	version_destroy(intf->version);
         }
@@ -435,10 +497,26 @@ int dynInterface_methods(dyn_interface_type *intf, struct methods_head **list) {
 }
 
 int dynInterface_nrOfMethods(dyn_interface_type *intf) {
-    int count = 0;
-    struct method_entry *entry = NULL;
-    TAILQ_FOREACH(entry, &intf->methods, entries) {
-        count +=1;
+    return intf->nrOfMethods;
+}
+
+int dynInterface_findMethod(dyn_interface_type *intf, const char *id, struct method_entry **out) {
+    int status = OK;
+    struct method_entry *entry = hashMap_get(intf->methodsById, id);
+    if (entry != NULL) {
+        *out = entry;
+    } else {
+        status = ERROR;
     }
-    return count;
+    return status;
+}
+
+int dynInterface_methodForIndex(dyn_interface_type *intf, int index, struct method_entry **out) {
+    int status = OK;
+    if (index >= 0 && index < intf->nrOfMethods) {
+        *out = intf->methodsByIndex[index];
+    } else {
+        status = ERROR;
+    }
+    return status;
 }
@@ -74,6 +74,27 @@ struct generic_sequence {
     void *buf;
 };
 
+#define DYN_TYPE_ARENA_DEFAULT_BLOCK_SIZE 4096
+#define DYN_TYPE_ARENA_ALIGN 16
+
+struct arena_block {
+    struct arena_block *next;
+    size_t size;
+    size_t used;
+    //data follows aligned
+};
+
+struct _dyn_type_arena {
+    size_t blockSize;
+    struct arena_block *blocks; //current block first
+    //fixed region (not owned) used instead of blocks, e.g. part of a shared memory segment
+    char *region;
+    size_t regionSize;
+    size_t regionUsed;
+};
+
+static struct arena_block * dynType_arenaAllocBlock(size_t size);
+
 TAILQ_HEAD(meta_properties_head, meta_entry);
 struct meta_entry {
     char *name;
@@ -591,18 +612,22 @@ static void dynType_clearTypedPointer(dyn_type *type) {
 }
 
 int dynType_alloc(dyn_type *type, void **bufLoc) {
+    return dynType_allocInArena(NULL, type, bufLoc);
+}
+
+int dynType_allocInArena(dyn_type_arena *arena, dyn_type *type, void **bufLoc) {
     assert(type->type != DYN_TYPE_REF);
     assert(type->ffiType->size != 0);
     int status = OK;
 
-    void *inst = calloc(1, type->ffiType->size);
+    void *inst = arena == NULL ? calloc(1, type->ffiType->size) : dynType_arenaAlloc(arena, type->ffiType->size);
     if (inst != NULL) {
         if (type->type == DYN_TYPE_TYPED_POINTER) {
             void *ptr = NULL;
             dyn_type *sub = NULL;
             status = dynType_typedPointer_getTypedType(type, &sub);
             if (status == OK) {
-                status = dynType_alloc(sub, &ptr);
+                status = dynType_allocInArena(arena, sub, &ptr);
                 if (status == OK) {
                     *(void **)inst = ptr;
                 }
@@ -618,6 +643,139 @@ int dynType_alloc(dyn_type *type, void **bufLoc) {
 }
 
 
+int dynType_arenaCreate(size_t blockSize, dyn_type_arena **out) {
+    int status = OK;
+    dyn_type_arena *arena = calloc(1, sizeof(*arena));
+    if (arena != NULL) {
+        arena->blockSize = blockSize > 0 ? blockSize : DYN_TYPE_ARENA_DEFAULT_BLOCK_SIZE;
+        *out = arena;
+    } else {
+        status = MEM_ERROR;
+        LOG_ERROR("Error allocating memory for arena");
+    }
+    return status;
+}
+
+int dynType_arenaCreateInRegion(void *region, size_t size, dyn_type_arena **out) {
+    int status = OK;
+    dyn_type_arena *arena = NULL;
+    if (region == NULL || ((uintptr_t) region % DYN_TYPE_ARENA_ALIGN) != 0) {
+        status = ERROR;
+        LOG_ERROR("Arena region must be aligned on %i bytes", DYN_TYPE_ARENA_ALIGN);
+    } else if ((arena = calloc(1, sizeof(*arena))) != NULL) {
+        arena->region = region;
+        arena->regionSize = size;
+        *out = arena;
+    } else {
+        status = MEM_ERROR;
+        LOG_ERROR("Error allocating memory for arena");
+    }
+    return status;
+}
+
+size_t dynType_arenaUsed(dyn_type_arena *arena) {
+    size_t used = arena->regionUsed;
+    struct arena_block *block = arena->blocks;
+    while (block != NULL) {
+        used += block->used;
+        block = block->next;
+    }
+    return used;
+}
+
+void dynType_arenaReset(dyn_type_arena *arena) {
+    if (arena != NULL) {
+        arena->regionUsed = 0;
+    }
+    if (arena != NULL && arena->blocks != NULL) {
+        //keep the first (largest used) block around for the next use of the arena
+        struct arena_block *keep = arena->blocks;
+        struct arena_block *block = keep->next;
+        while (block != NULL) {
+            struct arena_block *next = block->next;
+            if (block->size > keep->size) {
+                free(keep);
+                keep = block;
+            } else {
+                free(block);
+            }
+            block = next;
+        }
+        keep->next = NULL;
+        keep->used = 0;
+        arena->blocks = keep;
+    }
+}
+
+void dynType_arenaDestroy(dyn_type_arena *arena) {
+    if (arena != NULL) {
+        struct arena_block *block = arena->blocks;
+        while (block != NULL) {
+            struct arena_block *next = block->next;
+            free(block);
+            block = next;
+        }
+        free(arena);
+    }
+}
+
+void * dynType_arenaAlloc(dyn_type_arena *arena, size_t size) {
+    void *result = NULL;
+    size_t aligned = (size + DYN_TYPE_ARENA_ALIGN - 1) & ~((size_t) DYN_TYPE_ARENA_ALIGN - 1);
+    if (aligned < size) {
+        return NULL; //overflow
+    }
+
+    if (arena->region != NULL) {
+        if (arena->regionSize - arena->regionUsed >= aligned) {
+            result = arena->region + arena->regionUsed;
+            arena->regionUsed += aligned;
+            memset(result, 0, aligned);
+        } else {
+            LOG_ERROR("Error allocating %zu bytes in arena region, %zu of %zu bytes used", size, arena->regionUsed, arena->regionSize);
+        }
+        return result;
+    }
+
+    struct arena_block *block = arena->blocks;
+    if (block == NULL || block->size - block->used < aligned) {
+        block = dynType_arenaAllocBlock(aligned > arena->blockSize ? aligned : arena->blockSize);
+        if (block != NULL && arena->blocks != NULL && aligned > arena->blockSize) {
+            //dedicated block for a large allocation, keep filling the current block
+            block->next = arena->blocks->next;
+            arena->blocks->next = block;
+        } else if (block != NULL) {
+            block->next = arena->blocks;
+            arena->blocks = block;
+        }
+    }
+
+    if (block != NULL) {
+        char *data = (char *) block + ((sizeof(*block) + DYN_TYPE_ARENA_ALIGN - 1) & ~((size_t) DYN_TYPE_ARENA_ALIGN - 1));
+        result = data + block->used;
+        block->used += aligned;
+        memset(result, 0, aligned);
+    } else {
+        LOG_ERROR("Error allocating %zu bytes in arena", size);
+    }
+
+    return result;
+}
+
+static struct arena_block * dynType_arenaAllocBlock(size_t size) {
+    size_t header = (sizeof(struct arena_block) + DYN_TYPE_ARENA_ALIGN - 1) & ~((size_t) DYN_TYPE_ARENA_ALIGN - 1);
+    struct arena_block *block = NULL;
+    if (size <= SIZE_MAX - header) {
+        block = malloc(header + size);
+    }
+    if (block != NULL) {
+        block->next = NULL;
+        block->size = size;
+        block->used = 0;
+    }
+    return block;
+}
+
 int dynType_complex_indexForName(dyn_type *type, const char *name) {
     assert(type->type == DYN_TYPE_COMPLEX);
     int i = 0;
@@ -668,12 +826,22 @@ int dynType_complex_entries(dyn_type *type, struct complex_type_entries_head **e
 
 //sequence
 int dynType_sequence_alloc(dyn_type *type, void *inst, uint32_t cap) {
+    return dynType_sequence_allocInArena(NULL, type, inst, cap);
+}
+
+int dynType_sequence_allocInArena(dyn_type_arena *arena, dyn_type *type, void *inst, uint32_t cap) {
     assert(type->type == DYN_TYPE_SEQUENCE);
     int status = OK;
     struct generic_sequence *seq = inst;
     if (seq != NULL) {
         size_t size = dynType_size(type->sequence.itemType);
-        seq->buf = calloc(cap, size);
+        if (arena == NULL) {
+            seq->buf = calloc(cap, size);
+        } else if (size == 0 || cap <= SIZE_MAX / size) {
+            seq->buf = dynType_arenaAlloc(arena, cap * size);
+        } else {
+            seq->buf = NULL;
+        }
         if (seq->buf != NULL) {
             seq->cap = cap;
             seq->len = 0;;
@@ -742,6 +910,111 @@ void dynType_freeComplexType(dyn_type *type, void *loc) {
     }
 }
 
+bool dynType_isPositionIndependent(dyn_type *type) {
+    bool result = true;
+    struct complex_type_entry *entry = NULL;
+    if (type->type == DYN_TYPE_REF) {
+        type = type->ref.ref;
+    }
+    switch (type->type) {
+        case DYN_TYPE_SIMPLE :
+            result = type->descriptor != 'P';
+            break;
+        case DYN_TYPE_COMPLEX :
+            TAILQ_FOREACH(entry, &type->complex.entriesHead, entries) {
+                result = result && dynType_isPositionIndependent(entry->type);
+            }
+            break;
+        case DYN_TYPE_SEQUENCE :
+            result = dynType_isPositionIndependent(type->sequence.itemType);
+            break;
+        default :
+            result = false;
+            break;
+    }
+    return result;
+}
+
+/*
+ * Sequence buffers of position independent values are stored as offset + 1 from the region start,
+ * 0 is used for a NULL buffer.
+ */
+static int dynType_relocate(dyn_type *type, void *loc, char *base, size_t size, bool toOffsets) {
+    int status = OK;
+    if (type->type == DYN_TYPE_REF) {
+        type = type->ref.ref;
+    }
+
+    if (type->type == DYN_TYPE_COMPLEX) {
+        int index = 0;
+        void *entryLoc = NULL;
+        struct complex_type_entry *entry = NULL;
+        TAILQ_FOREACH(entry, &type->complex.entriesHead, entries) {
+            dynType_complex_valLocAt(type, index++, loc, &entryLoc);
+            if (status == OK) {
+                status = dynType_relocate(entry->type, entryLoc, base, size, toOffsets);
+            }
+        }
+    } else if (type->type == DYN_TYPE_SEQUENCE) {
+        struct generic_sequence *seq = loc;
+        size_t itemSize = dynType_size(type->sequence.itemType);
+        size_t bufSize = (size_t) seq->cap * itemSize;
+
+        if (seq->len > seq->cap || (itemSize != 0 && seq->cap > SIZE_MAX / itemSize)) {
+            status = ERROR;
+        } else if (toOffsets && seq->buf != NULL) {
+            char *buf = seq->buf;
+            if (buf < base || (size_t) (buf - base) > size || bufSize > size - (size_t) (buf - base)) {
+                status = ERROR;
+            }
+            for (uint32_t i = 0; status == OK && i < seq->len; i += 1) {
+                status = dynType_relocate(type->sequence.itemType, buf + i * itemSize, base, size, toOffsets);
+            }
+            if (status == OK) {
+                seq->buf = (void *) ((uintptr_t) (buf - base) + 1);
+            }
+        } else if (!toOffsets && seq->buf != NULL) {
+            uintptr_t offset = (uintptr_t) seq->buf - 1;
+            if (offset > size || bufSize > size - offset) {
+                status = ERROR;
+            } else {
+                seq->buf = base + offset;
+            }
+            for (uint32_t i = 0; status == OK && i < seq->len; i += 1) {
+                status = dynType_relocate(type->sequence.itemType, (char *) seq->buf + i * itemSize, base, size, toOffsets);
+            }
+        }
+
+        if (status != OK) {
+            LOG_ERROR("Sequence buffer outside of region (%zu bytes)", size);
+        }
+    }
+
+    return status;
+}
+
+int dynType_pointersToOffsets(dyn_type *type, void *inst, void *base, size_t size) {
+    int status = OK;
+    if (!dynType_isPositionIndependent(type)) {
+        status = ERROR;
+        LOG_ERROR("Type '%c' is not position independent", type->descriptor);
+    } else {
+        status = dynType_relocate(type, inst, base, size, true);
+    }
+    return status;
+}
+
+int dynType_offsetsToPointers(dyn_type *type, void *inst, void *base, size_t size) {
+    int status = OK;
+    if (!dynType_isPositionIndependent(type)) {
+        status = ERROR;
+        LOG_ERROR("Type '%c' is not position independent", type->descriptor);
+    } else {
+        status = dynType_relocate(type, inst, base, size, false);
+    }
+    return status;
+}
+
 
 uint32_t dynType_sequence_length(void *seqLoc) {
     struct generic_sequence *seq = seqLoc;
@@ -970,9 +1243,22 @@ int dynType_typedPointer_getTypedType(dyn_type *type, dyn_type **out) {
 
 
 int dynType_text_allocAndInit(dyn_type *type, void *textLoc, const char *value) {
+    return dynType_text_allocAndInitInArena(NULL, type, textLoc, value);
+}
+
+int dynType_text_allocAndInitInArena(dyn_type_arena *arena, dyn_type *type, void *textLoc, const char *value) {
     assert(type->type == DYN_TYPE_TEXT);
     int status = 0;
-    const char *str = strdup(value);
+    char *str = NULL;
+    if (arena == NULL) {
+        str = strdup(value);
+    } else {
+        size_t size = strlen(value) + 1;
+        str = dynType_arenaAlloc(arena, size);
+        if (str != NULL) {
+            memcpy(str, value, size);
+        }
+    }
     char const **loc = textLoc;
     if (str != NULL) {
         *loc = str;
@@ -23,6 +23,7 @@
 #include <jansson.h>
 #include <assert.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 #include <ffi.h>
 
@@ -30,6 +31,9 @@
 static int OK = 0;
 static int ERROR = 1;
 
+//the layout json_dumps produced with the JSON_DECODE_ANY (0x4) flag used so far, an indent of 4
+#define JSON_RPC_ENCODE_FLAGS JSON_INDENT(4)
+
 DFI_SETUP_LOG(jsonRpc);
 
 typedef void (*gen_func_type)(void);
@@ -39,44 +43,98 @@ struct generic_service_layout {
 	gen_func_type methods[];
 };
 
+static int jsonRpc_callSingle(dyn_interface_type *intf, void *service, dyn_type_arena *arena, json_t *js_request, json_serializer_writer_type *writer);
+static int jsonRpc_prepareInvoke(dyn_function_type *func, const char *id, int index, void *args[], char **out);
+
 int jsonRpc_call(dyn_interface_type *intf, void *service, const char *request, char **out) {
 	int status = OK;
 
-	dyn_type* returnType = NULL;
-
 	LOG_DEBUG("Parsing data: %s\n", request);
 	json_error_t error;
 	json_t *js_request = json_loads(request, 0, &error);
-	json_t *arguments = NULL;
-	const char *sig;
-	if (js_request) {
-		if (json_unpack(js_request, "{s:s}", "m", &sig) != 0) {
-			LOG_ERROR("Got json error '%s'\n", error.text);
-		} else {
-			arguments = json_object_get(js_request, "a");
-		}
-	} else {
+	if (js_request == NULL) {
 		LOG_ERROR("Got json error '%s' for '%s'\n", error.text, request);
 		return 0;
 	}
 
-	LOG_DEBUG("Looking for method %s\n", sig);
-	struct methods_head *methods = NULL;
-	dynInterface_methods(intf, &methods);
+	//the deserialized arguments only live during the invocation, release them all at once
+	dyn_type_arena *arena = NULL;
+	if (dynType_arenaCreate(0, &arena) != OK) {
+		json_decref(js_request);
+		return ERROR;
+	}
+
+	//the reply is written directly from the (output) arguments, without building a json_t tree
+	json_serializer_writer_type *writer = NULL;
+	if (jsonSerializer_writerCreate(JSON_RPC_ENCODE_FLAGS, NULL, NULL, &writer) != OK) {
+		dynType_arenaDestroy(arena);
+		json_decref(js_request);
+		return ERROR;
+	}
+
+	if (json_is_array(js_request)) {
+		//batch, one reply per invocation in the same order
+		jsonSerializer_writerBeginArray(writer);
+		size_t i;
+		for (i = 0; i < json_array_size(js_request); i += 1) {
+			if (jsonRpc_callSingle(intf, service, arena, json_array_get(js_request, i), writer) != OK) {
+				//nothing is written for a failed invocation
+				jsonSerializer_writerBeginObject(writer);
+				jsonSerializer_writerKey(writer, "e");
+				jsonSerializer_writerInteger(writer, JSON_RPC_INVOCATION_ERROR);
+				jsonSerializer_writerEnd(writer);
+			}
+			dynType_arenaReset(arena);
+		}
+		jsonSerializer_writerEnd(writer);
+	} else {
+		status = jsonRpc_callSingle(intf, service, arena, js_request, writer);
+	}
+	dynType_arenaDestroy(arena);
+	json_decref(js_request);
+
+	if (status == OK) {
+		status = jsonSerializer_writerFinish(writer, out);
+	}
+	if (status == OK) {
+		LOG_DEBUG("response is '%s'\n", *out);
+	}
+	jsonSerializer_writerDestroy(writer);
+
+	return status;
+}
+
+static int jsonRpc_callSingle(dyn_interface_type *intf, void *service, dyn_type_arena *arena, json_t *js_request, json_serializer_writer_type *writer) {
+	int status = OK;
+
+	dyn_type* returnType = NULL;
+
+	//the method is the method id or, more compact, the index of the method in the interface
+	json_t *arguments = json_object_get(js_request, "a");
+	json_t *sig = json_object_get(js_request, "m");
 	struct method_entry *entry = NULL;
 	struct method_entry *method = NULL;
-	TAILQ_FOREACH(entry, methods, entries) {
-		if (strcmp(sig, entry->id) == 0) {
+	if (json_is_string(sig)) {
+		LOG_DEBUG("Looking for method %s\n", json_string_value(sig));
+		if (dynInterface_findMethod(intf, json_string_value(sig), &entry) == OK) {
 			method = entry;
-			break;
+		} else {
+			status = ERROR;
+			LOG_ERROR("Cannot find method with sig '%s'", json_string_value(sig));
 		}
-	}
-
-	if (method == NULL) {
+	} else if (json_is_integer(sig)) {
+		if (dynInterface_methodForIndex(intf, (int) json_integer_value(sig), &entry) == OK) {
+			method = entry;
+		} else {
+			status = ERROR;
+			LOG_ERROR("Cannot find method with index %" JSON_INTEGER_FORMAT, json_integer_value(sig));
+		}
+	} else {
 		status = ERROR;
-		LOG_ERROR("Cannot find method with sig '%s'", sig);
+		LOG_ERROR("Invalid request, no method in json request\n");
 	}
-	else if (status == OK) {
+
+	if (status == OK) {
 		LOG_DEBUG("RSA: found method '%s'\n", entry->id);
 		returnType = dynFunction_returnType(method->dynFunc);
 	}
@@ -97,6 +155,7 @@ int jsonRpc_call(dyn_interface_type *intf, void *service, const char *request, c
 	}
 
 	void *args[nrOfArgs];
+	memset(args, 0, sizeof(args));
 
 	json_t *value = NULL;
 
@@ -105,26 +164,28 @@ int jsonRpc_call(dyn_interface_type *intf, void *service, const char *request, c
 
 	void *ptr = NULL;
 	void *ptrToPtr = &ptr;
+	void *noCompletion = NULL; //the exported service is always called synchronously
 
 	for (i = 0; i < nrOfArgs; i += 1) {
 		dyn_type *argType = dynFunction_argumentTypeForIndex(func, i);
 		enum dyn_function_argument_meta  meta = dynFunction_argumentMetaForIndex(func, i);
 		if (meta == DYN_FUNCTION_ARGUMENT_META__STD) {
 			value = json_array_get(arguments, index++);
-			status = jsonSerializer_deserializeJson(argType, value, &(args[i]));
+			status = jsonSerializer_deserializeJsonInArena(arena, argType, value, &(args[i]));
 		} else if (meta == DYN_FUNCTION_ARGUMENT_META__PRE_ALLOCATED_OUTPUT) {
 			dynType_alloc(argType, &args[i]);
 		} else if (meta == DYN_FUNCTION_ARGUMENT_META__OUTPUT) {
 			args[i] = &ptrToPtr;
 		} else if (meta == DYN_FUNCTION_ARGUMENT_META__HANDLE) {
 			args[i] = &handle;
+		} else if (meta == DYN_FUNCTION_ARGUMENT_META__ASYNC) {
+			args[i] = &noCompletion;
 		}
 
 		if (status != OK) {
 			break;
 		}
 	}
-	json_decref(js_request);
 
 	if (status == OK) {
 		if (dynType_descriptorType(returnType) != 'N') {
@@ -145,48 +206,29 @@ int jsonRpc_call(dyn_interface_type *intf, void *service, const char *request, c
 		LOG_WARNING("Error calling remote endpoint function, got error code %i", funcCallStatus);
 	}
 
-	json_t *jsonResult = NULL;
-	for(i = 0; i < nrOfArgs; i += 1) {
-		dyn_type *argType = dynFunction_argumentTypeForIndex(func, i);
-		enum dyn_function_argument_meta  meta = dynFunction_argumentMetaForIndex(func, i);
-		if (meta == DYN_FUNCTION_ARGUMENT_META__STD) {
-			dynType_free(argType, args[i]);
-		}
-	}
+	//NOTE the std arguments are in the arena and released by the caller
 
+	//the reply value is the (last) output argument
+	dyn_type *resultType = NULL;
+	void *resultLoc = NULL;
+	dyn_type *outputType = NULL;
 	if (funcCallStatus == 0 && status == OK) {
 		for (i = 0; i < nrOfArgs; i += 1) {
 			dyn_type *argType = dynFunction_argumentTypeForIndex(func, i);
 			enum dyn_function_argument_meta  meta = dynFunction_argumentMetaForIndex(func, i);
 			if (meta == DYN_FUNCTION_ARGUMENT_META__PRE_ALLOCATED_OUTPUT) {
-				if (status == OK) {
-					status = jsonSerializer_serializeJson(argType, args[i], &jsonResult);
-				}
-				dynType_free(argType, args[i]);
+				resultType = argType;
+				resultLoc = args[i];
 			} else if (meta == DYN_FUNCTION_ARGUMENT_META__OUTPUT) {
 				if (ptr != NULL) {
-					dyn_type *typedType = NULL;
-					if (status == OK) {
-						status = dynType_typedPointer_getTypedType(argType, &typedType);
-					}
-					if (dynType_descriptorType(typedType) == 't') {
-						status = jsonSerializer_serializeJson(typedType, (void*) &ptr, &jsonResult);
-						free(ptr);
-					} else {
-						dyn_type *typedTypedType = NULL;
-						if (status == OK) {
-							status = dynType_typedPointer_getTypedType(typedType, &typedTypedType);
-						}
-
-						if(status == OK){
-							status = jsonSerializer_serializeJson(typedTypedType, ptr, &jsonResult);
-						}
-
-						if (status == OK) {
-							dynType_free(typedTypedType, ptr);
-						}
+					status = dynType_typedPointer_getTypedType(argType, &outputType);
+					if (status == OK && dynType_descriptorType(outputType) == 't') {
+						resultType = outputType;
+						resultLoc = &ptr;
+					} else if (status == OK) {
+						status = dynType_typedPointer_getTypedType(outputType, &resultType);
+						resultLoc = ptr;
 					}
-
 				} else {
 					LOG_DEBUG("Output ptr is null");
 				}
@@ -198,45 +240,70 @@ int jsonRpc_call(dyn_interface_type *intf, void *service, const char *request, c
 		}
 	}
 
-	char *response = NULL;
 	if (status == OK) {
 		LOG_DEBUG("creating payload\n");
-		json_t *payload = json_object();
+		status = jsonSerializer_writerBeginObject(writer);
 		if (funcCallStatus == 0) {
-			if (jsonResult == NULL) {
+			if (resultType == NULL) {
 				//ignore -> no result
 			} else {
 				LOG_DEBUG("Setting result payload");
-				json_object_set_new(payload, "r", jsonResult);
+				jsonSerializer_writerMember(writer, "r", resultType, resultLoc);
 			}
 		} else {
 			LOG_DEBUG("Setting error payload");
-			json_object_set_new(payload, "e", json_integer(funcCallStatus));
+			jsonSerializer_writerKey(writer, "e");
+			jsonSerializer_writerInteger(writer, funcCallStatus);
 		}
-		response = json_dumps(payload, JSON_DECODE_ANY);
-		json_decref(payload);
-		LOG_DEBUG("status ptr is %p. response is '%s'\n", status, response);
+		status = jsonSerializer_writerEnd(writer);
 	}
 
-	if (status == OK) {
-		*out = response;
-	} else {
-		free(response);
+	for (i = 0; i < nrOfArgs; i += 1) {
+		dyn_type *argType = dynFunction_argumentTypeForIndex(func, i);
+		enum dyn_function_argument_meta  meta = dynFunction_argumentMetaForIndex(func, i);
+		if (meta == DYN_FUNCTION_ARGUMENT_META__PRE_ALLOCATED_OUTPUT && args[i] != NULL) {
+			dynType_free(argType, args[i]);
+		}
+	}
+
+	if (funcCallStatus == 0 && ptr != NULL && outputType != NULL) {
+		if (dynType_descriptorType(outputType) == 't') {
+			free(ptr);
+		} else if (resultType != NULL) {
+			dynType_free(resultType, ptr);
+		}
 	}
 
 	return status;
 }
 
 int jsonRpc_prepareInvokeRequest(dyn_function_type *func, const char *id, void *args[], char **out) {
-	int status = OK;
+	LOG_DEBUG("Calling remote function '%s'\n", id);
+	return jsonRpc_prepareInvoke(func, id, -1, args, out);
+}
 
+int jsonRpc_prepareInvokeRequestForIndex(dyn_function_type *func, int index, void *args[], char **out) {
+	LOG_DEBUG("Calling remote function with index %i\n", index);
+	return jsonRpc_prepareInvoke(func, NULL, index, args, out);
+}
 
-	LOG_DEBUG("Calling remote function '%s'\n", id);
-	json_t *invoke = json_object();
-	json_object_set_new(invoke, "m", json_string(id));
+static int jsonRpc_prepareInvoke(dyn_function_type *func, const char *id, int index, void *args[], char **out) {
+	json_serializer_writer_type *writer = NULL;
+	int status = jsonSerializer_writerCreate(JSON_RPC_ENCODE_FLAGS, NULL, NULL, &writer);
+	if (status != OK) {
+		return status;
+	}
 
-	json_t *arguments = json_array();
-	json_object_set_new(invoke, "a", arguments);
+	jsonSerializer_writerBeginObject(writer);
+	jsonSerializer_writerKey(writer, "m");
+	if (id != NULL) {
+		jsonSerializer_writerString(writer, id);
+	} else {
+		jsonSerializer_writerInteger(writer, index);
+	}
+
+	jsonSerializer_writerKey(writer, "a");
+	jsonSerializer_writerBeginArray(writer);
 
 	int i;
 	int nrOfArgs = dynFunction_nrOfArguments(func);
@@ -244,13 +311,8 @@ int jsonRpc_prepareInvokeRequest(dyn_function_type *func, const char *id, void *
 		dyn_type *type = dynFunction_argumentTypeForIndex(func, i);
 		enum dyn_function_argument_meta  meta = dynFunction_argumentMetaForIndex(func, i);
 		if (meta == DYN_FUNCTION_ARGUMENT_META__STD) {
-			json_t *val = NULL;
-
-			int rc = jsonSerializer_serializeJson(type, args[i], &val);
-			if (rc == 0) {
-				json_array_append_new(arguments, val);
-			} else {
-				status = ERROR;
+			status = jsonSerializer_writerValue(writer, type, args[i]);
+			if (status != OK) {
 				break;
 			}
 		} else {
@@ -258,12 +320,10 @@ int jsonRpc_prepareInvokeRequest(dyn_function_type *func, const char *id, void *
 		}
 	}
 
-	char *invokeStr = json_dumps(invoke, JSON_DECODE_ANY);
-	json_decref(invoke);
-
-	if (status == OK) {
-		*out = invokeStr;
-	}
+	jsonSerializer_writerEnd(writer);
+	jsonSerializer_writerEnd(writer);
+	status = jsonSerializer_writerFinish(writer, out);
+	jsonSerializer_writerDestroy(writer);
 
 	return status;
 }
@@ -279,6 +339,7 @@ int jsonRpc_handleReply(dyn_function_type *func, const char *reply, void *args[]
 	}
 
 	json_t *result = NULL;
+	dyn_type_arena *arena = NULL;
 	if (status == OK) {
 		result = json_object_get(replyJson, "r"); //TODO check
 		if (result == NULL) {
@@ -299,22 +360,28 @@ int jsonRpc_handleReply(dyn_function_type *func, const char *reply, void *args[]
 
 				size_t size = 0;
 
+				//the deserialized value is only needed until it is copied into the pre allocated output
+				if (arena == NULL) {
+					status = dynType_arenaCreate(0, &arena);
+					if (status != OK) {
+						break;
+					}
+				}
+
 				if (dynType_descriptorType(argType) == 't') {
-					status = jsonSerializer_deserializeJson(argType, result, &tmp);
+					status = jsonSerializer_deserializeJsonInArena(arena, argType, result, &tmp);
 					if(tmp!=NULL){
 						size = strnlen(((char *) *(char**) tmp), 1024 * 1024);
 						memcpy(*out, *(void**) tmp, size);
 					}
 				} else {
 					dynType_typedPointer_getTypedType(argType, &argType);
-					status = jsonSerializer_deserializeJson(argType, result, &tmp);
+					status = jsonSerializer_deserializeJsonInArena(arena, argType, result, &tmp);
 					if(tmp!=NULL){
 						size = dynType_size(argType);
 						memcpy(*out, tmp, size);
 					}
 				}
-
-				dynType_free(argType, tmp);
 			} else if (meta == DYN_FUNCTION_ARGUMENT_META__OUTPUT) {
 				dyn_type *subType = NULL;
 
@@ -335,7 +402,78 @@ int jsonRpc_handleReply(dyn_function_type *func, const char *reply, void *args[]
 		}
 	}
 
+	dynType_arenaDestroy(arena);
 	json_decref(replyJson);
 
 	return status;
 }
+
+int jsonRpc_prepareBatchRequest(char *requests[], size_t nrOfRequests, char **out) {
+	int status = OK;
+
+	//the requests are json objects already, so the batch is just the joined array
+	size_t length = 2;
+	size_t i;
+	for (i = 0; i < nrOfRequests; i += 1) {
+		length += strlen(requests[i]) + 1;
+	}
+
+	char *batch = malloc(length + 1);
+	if (batch != NULL) {
+		char *ptr = batch;
+		*ptr++ = '[';
+		for (i = 0; i < nrOfRequests; i += 1) {
+			size_t len = strlen(requests[i]);
+			if (i > 0) {
+				*ptr++ = ',';
+			}
+			memcpy(ptr, requests[i], len);
+			ptr += len;
+		}
+		*ptr++ = ']';
+		*ptr = '\0';
+		*out = batch;
+	} else {
+		status = ERROR;
+		LOG_ERROR("Error allocating memory for batch request");
+	}
+
+	return status;
+}
+
+int jsonRpc_splitBatchReply(const char *reply, size_t nrOfReplies, char *replies[]) {
+	int status = OK;
+
+	json_error_t error;
+	json_t *replyJson = json_loads(reply, 0, &error);
+	if (replyJson == NULL) {
+		status = ERROR;
+		LOG_ERROR("Error parsing json '%s', got error '%s'", reply, error.text);
+	} else if (!json_is_array(replyJson) || json_array_size(replyJson) != nrOfReplies) {
+		status = ERROR;
+		LOG_ERROR("Expected a batch reply with %zu replies, got '%s'", nrOfReplies, reply);
+	}
+
+	size_t i;
+	for (i = 0; i < nrOfReplies && status == OK; i += 1) {
+		replies[i] = json_dumps(json_array_get(replyJson, i), JSON_RPC_ENCODE_FLAGS);
+		if (replies[i] == NULL) {
+			status = ERROR;
+			LOG_ERROR("Error creating reply %zu of batch", i);
+		}
+	}
+
+	if (status != OK) {
+		size_t j;
+		for (j = 0; j < i; j += 1) {
+			free(replies[j]);
+			replies[j] = NULL;
+		}
+	}
+
+	if (replyJson != NULL) {
+		json_decref(replyJson);
+	}
+
+	return status;
+}
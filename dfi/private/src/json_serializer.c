@@ -22,14 +22,18 @@
 
 #include <jansson.h>
 #include <assert.h>
+#include <locale.h>
+#include <math.h>
+#include <stdbool.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 
-static int jsonSerializer_createType(dyn_type *type, json_t *object, void **result);
-static int jsonSerializer_parseObject(dyn_type *type, json_t *object, void *inst);
-static int jsonSerializer_parseObjectMember(dyn_type *type, const char *name, json_t *val, void *inst);
-static int jsonSerializer_parseSequence(dyn_type *seq, json_t *array, void *seqLoc);
-static int jsonSerializer_parseAny(dyn_type *type, void *input, json_t *val);
+static int jsonSerializer_createType(dyn_type_arena *arena, dyn_type *type, json_t *object, void **result);
+static int jsonSerializer_parseObject(dyn_type_arena *arena, dyn_type *type, json_t *object, void *inst);
+static int jsonSerializer_parseObjectMember(dyn_type_arena *arena, dyn_type *type, const char *name, json_t *val, void *inst);
+static int jsonSerializer_parseSequence(dyn_type_arena *arena, dyn_type *seq, json_t *array, void *seqLoc);
+static int jsonSerializer_parseAny(dyn_type_arena *arena, dyn_type *type, void *input, json_t *val);
 
 static int jsonSerializer_writeAny(dyn_type *type, void *input, json_t **val);
 
@@ -61,48 +65,60 @@ int jsonSerializer_deserialize(dyn_type *type, const char *input, void **result)
 }
 
 int jsonSerializer_deserializeJson(dyn_type *type, json_t *input, void **out) {
-    return jsonSerializer_createType(type, input, out);
+    return jsonSerializer_createType(NULL, type, input, out);
 }
 
-static int jsonSerializer_createType(dyn_type *type, json_t *val, void **result) {
+int jsonSerializer_deserializeJsonInArena(dyn_type_arena *arena, dyn_type *type, json_t *input, void **out) {
+    return jsonSerializer_createType(arena, type, input, out);
+}
+
+static int jsonSerializer_createType(dyn_type_arena *arena, dyn_type *type, json_t *val, void **result) {
     assert(val != NULL);
     int status = OK;
     void *inst = NULL;
 
     if (dynType_descriptorType(type) == 't') {
         if (json_typeof(val) == JSON_STRING) {
-            inst = strdup(json_string_value(val));
+            if (arena == NULL) {
+                inst = strdup(json_string_value(val));
+            } else {
+                size_t size = strlen(json_string_value(val)) + 1;
+                inst = dynType_arenaAlloc(arena, size);
+                if (inst != NULL) {
+                    memcpy(inst, json_string_value(val), size);
+                }
+            }
         } else {
             status = ERROR;
             LOG_ERROR("Expected json_string type got %i\n", json_typeof(val));
         }
     } else {
-        status = dynType_alloc(type, &inst);
+        status = dynType_allocInArena(arena, type, &inst);
 
         if (status == OK) {
             assert(inst != NULL);
-            status = jsonSerializer_parseAny(type, inst, val);
+            status = jsonSerializer_parseAny(arena, type, inst, val);
         }
     }
 
     if (status == OK) {
         *result = inst;
     }
-    else{
+    else if (arena == NULL) {
     	dynType_free(type, inst);
     }
 
     return status;
 }
 
-static int jsonSerializer_parseObject(dyn_type *type, json_t *object, void *inst) {
+static int jsonSerializer_parseObject(dyn_type_arena *arena, dyn_type *type, json_t *object, void *inst) {
     assert(object != NULL);
     int status = 0;
     json_t *value;
     const char *key;
 
     json_object_foreach(object, key, value) {
-        status = jsonSerializer_parseObjectMember(type, key, value, inst);
+        status = jsonSerializer_parseObjectMember(arena, type, key, value, inst);
         if (status != OK) {
             break;
         }
@@ -111,7 +127,7 @@ static int jsonSerializer_parseObject(dyn_type *type, json_t *object, void *inst
     return status;
 }
 
-static int jsonSerializer_parseObjectMember(dyn_type *type, const char *name, json_t *val, void *inst) {
+static int jsonSerializer_parseObjectMember(dyn_type_arena *arena, dyn_type *type, const char *name, json_t *val, void *inst) {
     int status = OK;
     void *valp = NULL;
     dyn_type *valType = NULL;
@@ -131,13 +147,13 @@ static int jsonSerializer_parseObjectMember(dyn_type *type, const char *name, js
     }
 
     if (status == OK) {
-        status = jsonSerializer_parseAny(valType, valp, val);
+        status = jsonSerializer_parseAny(arena, valType, valp, val);
     }
 
     return status;
 }
 
-static int jsonSerializer_parseAny(dyn_type *type, void *loc, json_t *val) {
+static int jsonSerializer_parseAny(dyn_type_arena *arena, dyn_type *type, void *loc, json_t *val) {
     int status = OK;
 
     dyn_type *subType = NULL;
@@ -213,7 +229,7 @@ static int jsonSerializer_parseAny(dyn_type *type, void *loc, json_t *val) {
             break;
         case 't' :
             if (json_is_string(val)) {
-                dynType_text_allocAndInit(type, loc, json_string_value(val));
+                dynType_text_allocAndInitInArena(arena, type, loc, json_string_value(val));
             } else {
                 status = ERROR;
                 LOG_ERROR("Expected json string type got %i", json_typeof(val));
@@ -221,7 +237,7 @@ static int jsonSerializer_parseAny(dyn_type *type, void *loc, json_t *val) {
             break;
         case '[' :
             if (json_is_array(val)) {
-                status = jsonSerializer_parseSequence(type, val, loc);
+                status = jsonSerializer_parseSequence(arena, type, val, loc);
             } else {
                 status = ERROR;
                 LOG_ERROR("Expected json array type got '%i'", json_typeof(val));
@@ -229,13 +245,13 @@ static int jsonSerializer_parseAny(dyn_type *type, void *loc, json_t *val) {
             break;
         case '{' :
             if (status == OK) {
-                status = jsonSerializer_parseObject(type, val, loc);
+                status = jsonSerializer_parseObject(arena, type, val, loc);
             }
             break;
         case '*' :
             status = dynType_typedPointer_getTypedType(type, &subType);
             if (status == OK) {
-                status = jsonSerializer_createType(subType, val, (void **) loc);
+                status = jsonSerializer_createType(arena, subType, val, (void **) loc);
             }
             break;
         case 'P' :
@@ -251,13 +267,13 @@ static int jsonSerializer_parseAny(dyn_type *type, void *loc, json_t *val) {
     return status;
 }
 
-static int jsonSerializer_parseSequence(dyn_type *seq, json_t *array, void *seqLoc) {
+static int jsonSerializer_parseSequence(dyn_type_arena *arena, dyn_type *seq, json_t *array, void *seqLoc) {
     assert(dynType_type(seq) == DYN_TYPE_SEQUENCE);
     int status = OK;
 
     size_t size = json_array_size(array);
     //LOG_DEBUG("Allocating sequence with capacity %zu", size);
-    status = dynType_sequence_alloc(seq, seqLoc, (int) size);
+    status = dynType_sequence_allocInArena(arena, seq, seqLoc, (int) size);
 
     if (status == OK) {
         dyn_type *itemType = dynType_sequence_itemType(seq);
@@ -269,7 +285,7 @@ static int jsonSerializer_parseSequence(dyn_type *seq, json_t *array, void *seqL
             //LOG_DEBUG("Got sequence loc %p for index %zu", valLoc, index);
 
             if (status == OK) {
-                status = jsonSerializer_parseAny(itemType, valLoc, val);
+                status = jsonSerializer_parseAny(arena, itemType, valLoc, val);
                 if (status != OK) {
                     break;
                 }
@@ -281,16 +297,13 @@ static int jsonSerializer_parseSequence(dyn_type *seq, json_t *array, void *seqL
 }
 
 int jsonSerializer_serialize(dyn_type *type, void *input, char **output) {
-    int status = OK;
-
-    json_t *root = NULL;
-    status = jsonSerializer_serializeJson(type, input, &root);
-
+    json_serializer_writer_type *writer = NULL;
+    int status = jsonSerializer_writerCreate(JSON_COMPACT, NULL, NULL, &writer);
     if (status == OK) {
-        *output = json_dumps(root, JSON_COMPACT);
-        json_decref(root);
+        jsonSerializer_writerValue(writer, type, input);
+        status = jsonSerializer_writerFinish(writer, output);
+        jsonSerializer_writerDestroy(writer);
     }
-
     return status;
 }
 
@@ -479,3 +492,573 @@ static int jsonSerializer_writeComplex(dyn_type *type, void *input, json_t **out
     return status;
 }
 
+
+//streaming writer
+
+#define JSON_WRITER_CHUNK_SIZE 4096
+#define JSON_WRITER_FLAGS_TO_INDENT(f) ((f) & 0x1F)
+#define JSON_WRITER_REAL_PRECISION 17
+
+struct json_writer_level {
+    bool isObject;
+    size_t count;
+};
+
+struct json_serializer_writer {
+    size_t flags;
+    json_serializer_sink_fn sink; //NULL -> the output is collected in buf
+    void *handle;
+    char *buf;
+    size_t len;
+    size_t cap;
+    struct json_writer_level *levels;
+    int depth;
+    int levelsCap;
+    bool afterKey; //next value is the value of an object member
+    int status;
+};
+
+static void jsonSerializer_writerRaw(json_serializer_writer_type *writer, const char *data, size_t length);
+static void jsonSerializer_writerIndent(json_serializer_writer_type *writer, int depth, bool space);
+static void jsonSerializer_writerBeginItem(json_serializer_writer_type *writer);
+static void jsonSerializer_writerBegin(json_serializer_writer_type *writer, bool isObject);
+static void jsonSerializer_writerQuoted(json_serializer_writer_type *writer, const char *value);
+static void jsonSerializer_writerReal(json_serializer_writer_type *writer, double value);
+static bool jsonSerializer_isOmitted(dyn_type *type, void *input);
+static bool jsonSerializer_isValidUtf8(const char *str);
+static int jsonSerializer_streamAny(json_serializer_writer_type *writer, dyn_type *type, void *input);
+static int jsonSerializer_streamComplex(json_serializer_writer_type *writer, dyn_type *type, void *input);
+static int jsonSerializer_streamSequence(json_serializer_writer_type *writer, dyn_type *type, void *input);
+
+int jsonSerializer_writerCreate(size_t flags, json_serializer_sink_fn sink, void *handle, json_serializer_writer_type **out) {
+    int status = OK;
+    json_serializer_writer_type *writer = calloc(1, sizeof(*writer));
+    if (writer != NULL) {
+        writer->flags = flags;
+        writer->sink = sink;
+        writer->handle = handle;
+        writer->cap = JSON_WRITER_CHUNK_SIZE;
+        writer->buf = malloc(writer->cap);
+        if (writer->buf == NULL) {
+            free(writer);
+            writer = NULL;
+        }
+    }
+
+    if (writer != NULL) {
+        *out = writer;
+    } else {
+        status = ERROR;
+        LOG_ERROR("Error allocating memory for json writer");
+    }
+
+    return status;
+}
+
+void jsonSerializer_writerDestroy(json_serializer_writer_type *writer) {
+    if (writer != NULL) {
+        free(writer->buf);
+        free(writer->levels);
+        free(writer);
+    }
+}
+
+int jsonSerializer_writerBeginObject(json_serializer_writer_type *writer) {
+    jsonSerializer_writerBegin(writer, true);
+    return writer->status;
+}
+
+int jsonSerializer_writerBeginArray(json_serializer_writer_type *writer) {
+    jsonSerializer_writerBegin(writer, false);
+    return writer->status;
+}
+
+int jsonSerializer_writerEnd(json_serializer_writer_type *writer) {
+    if (writer->status == OK && writer->depth > 0) {
+        struct json_writer_level *level = &writer->levels[writer->depth - 1];
+        writer->depth -= 1;
+        if (level->count > 0) {
+            jsonSerializer_writerIndent(writer, writer->depth, false);
+        }
+        jsonSerializer_writerRaw(writer, level->isObject ? "}" : "]", 1);
+    } else if (writer->status == OK) {
+        writer->status = ERROR;
+        LOG_ERROR("No object or array to end");
+    }
+    return writer->status;
+}
+
+int jsonSerializer_writerKey(json_serializer_writer_type *writer, const char *key) {
+    if (writer->status == OK && writer->depth > 0 && writer->levels[writer->depth - 1].isObject) {
+        jsonSerializer_writerBeginItem(writer);
+        jsonSerializer_writerQuoted(writer, key);
+        if (writer->flags & JSON_COMPACT) {
+            jsonSerializer_writerRaw(writer, ":", 1);
+        } else {
+            jsonSerializer_writerRaw(writer, ": ", 2);
+        }
+        writer->afterKey = true;
+    } else if (writer->status == OK) {
+        writer->status = ERROR;
+        LOG_ERROR("A key can only be written in an object");
+    }
+    return writer->status;
+}
+
+int jsonSerializer_writerInteger(json_serializer_writer_type *writer, json_int_t value) {
+    char tmp[32];
+    int length = snprintf(tmp, sizeof(tmp), "%" JSON_INTEGER_FORMAT, value);
+    jsonSerializer_writerBeginItem(writer);
+    jsonSerializer_writerRaw(writer, tmp, (size_t) length);
+    return writer->status;
+}
+
+int jsonSerializer_writerString(json_serializer_writer_type *writer, const char *value) {
+    if (value != NULL && jsonSerializer_isValidUtf8(value)) {
+        jsonSerializer_writerBeginItem(writer);
+        jsonSerializer_writerQuoted(writer, value);
+    } else if (writer->status == OK) {
+        writer->status = ERROR;
+        LOG_ERROR("Cannot write invalid string");
+    }
+    return writer->status;
+}
+
+int jsonSerializer_writerValue(json_serializer_writer_type *writer, dyn_type *type, void *input) {
+    if (writer->status == OK && !jsonSerializer_isOmitted(type, input)) {
+        int rc = jsonSerializer_streamAny(writer, type, input);
+        if (rc != OK && writer->status == OK) {
+            writer->status = rc;
+        }
+    }
+    return writer->status;
+}
+
+int jsonSerializer_writerMember(json_serializer_writer_type *writer, const char *key, dyn_type *type, void *input) {
+    //like json_object_set with a NULL value, members which cannot be represented are left out
+    if (writer->status == OK && !jsonSerializer_isOmitted(type, input)) {
+        jsonSerializer_writerKey(writer, key);
+        jsonSerializer_writerValue(writer, type, input);
+    }
+    return writer->status;
+}
+
+int jsonSerializer_writerFinish(json_serializer_writer_type *writer, char **out) {
+    if (writer->status == OK && writer->depth != 0) {
+        writer->status = ERROR;
+        LOG_ERROR("Cannot finish json output with %i unterminated object(s)/array(s)", writer->depth);
+    }
+
+    if (writer->status == OK && writer->sink != NULL) {
+        if (writer->len > 0 && writer->sink(writer->handle, writer->buf, writer->len) != 0) {
+            writer->status = ERROR;
+            LOG_ERROR("Error writing json output to sink");
+        }
+        writer->len = 0;
+    } else if (writer->status == OK && out != NULL) {
+        jsonSerializer_writerRaw(writer, "", 1); //terminating '\0'
+        if (writer->status == OK) {
+            *out = writer->buf;
+            writer->buf = NULL;
+            writer->len = 0;
+            writer->cap = 0;
+        }
+    }
+
+    return writer->status;
+}
+
+int jsonSerializer_serializeToSink(dyn_type *type, void *input, size_t flags, json_serializer_sink_fn sink, void *handle) {
+    json_serializer_writer_type *writer = NULL;
+    int status = jsonSerializer_writerCreate(flags, sink, handle, &writer);
+    if (status == OK) {
+        jsonSerializer_writerValue(writer, type, input);
+        status = jsonSerializer_writerFinish(writer, NULL);
+        jsonSerializer_writerDestroy(writer);
+    }
+    return status;
+}
+
+static void jsonSerializer_writerRaw(json_serializer_writer_type *writer, const char *data, size_t length) {
+    if (writer->status != OK) {
+        return;
+    }
+
+    if (writer->sink != NULL) {
+        while (length > 0 && writer->status == OK) {
+            size_t n = writer->cap - writer->len;
+            n = n < length ? n : length;
+            memcpy(writer->buf + writer->len, data, n);
+            writer->len += n;
+            data += n;
+            length -= n;
+            if (writer->len == writer->cap) {
+                if (writer->sink(writer->handle, writer->buf, writer->len) != 0) {
+                    writer->status = ERROR;
+                    LOG_ERROR("Error writing json output to sink");
+                }
+                writer->len = 0;
+            }
+        }
+    } else {
+        if (writer->cap - writer->len < length) {
+            size_t cap = writer->cap > 0 ? writer->cap : JSON_WRITER_CHUNK_SIZE;
+            while (cap - writer->len < length) {
+                cap *= 2;
+            }
+            char *buf = realloc(writer->buf, cap);
+            if (buf != NULL) {
+                writer->buf = buf;
+                writer->cap = cap;
+            } else {
+                writer->status = ERROR;
+                LOG_ERROR("Error allocating memory for json output");
+                return;
+            }
+        }
+        memcpy(writer->buf + writer->len, data, length);
+        writer->len += length;
+    }
+}
+
+//same layout as the jansson dump
+static void jsonSerializer_writerIndent(json_serializer_writer_type *writer, int depth, bool space) {
+    static const char whitespace[] = "                                ";
+    size_t indent = JSON_WRITER_FLAGS_TO_INDENT(writer->flags);
+    if (indent > 0) {
+        jsonSerializer_writerRaw(writer, "\n", 1);
+        size_t spaces = (size_t) depth * indent;
+        while (spaces > 0) {
+            size_t n = spaces < sizeof(whitespace) - 1 ? spaces : sizeof(whitespace) - 1;
+            jsonSerializer_writerRaw(writer, whitespace, n);
+            spaces -= n;
+        }
+    } else if (space && !(writer->flags & JSON_COMPACT)) {
+        jsonSerializer_writerRaw(writer, " ", 1);
+    }
+}
+
+static void jsonSerializer_writerBeginItem(json_serializer_writer_type *writer) {
+    if (writer->afterKey) {
+        writer->afterKey = false;
+    } else if (writer->depth > 0) {
+        struct json_writer_level *level = &writer->levels[writer->depth - 1];
+        if (level->count > 0) {
+            jsonSerializer_writerRaw(writer, ",", 1);
+            jsonSerializer_writerIndent(writer, writer->depth, true);
+        } else {
+            jsonSerializer_writerIndent(writer, writer->depth, false);
+        }
+        level->count += 1;
+    }
+}
+
+static void jsonSerializer_writerBegin(json_serializer_writer_type *writer, bool isObject) {
+    if (writer->status != OK) {
+        return;
+    }
+
+    if (writer->depth == writer->levelsCap) {
+        int cap = writer->levelsCap > 0 ? writer->levelsCap * 2 : 8;
+        struct json_writer_level *levels = realloc(writer->levels, cap * sizeof(*levels));
+        if (levels != NULL) {
+            writer->levels = levels;
+            writer->levelsCap = cap;
+        } else {
+            writer->status = ERROR;
+            LOG_ERROR("Error allocating memory for json writer");
+            return;
+        }
+    }
+
+    jsonSerializer_writerBeginItem(writer);
+    jsonSerializer_writerRaw(writer, isObject ? "{" : "[", 1);
+    writer->levels[writer->depth].isObject = isObject;
+    writer->levels[writer->depth].count = 0;
+    writer->depth += 1;
+}
+
+static void jsonSerializer_writerQuoted(json_serializer_writer_type *writer, const char *value) {
+    jsonSerializer_writerRaw(writer, "\"", 1);
+    const char *start = value;
+    const char *pos = value;
+    while (*pos != '\0') {
+        unsigned char c = (unsigned char) *pos;
+        const char *escaped = NULL;
+        char tmp[8];
+        switch (c) {
+            case '"' : escaped = "\\\""; break;
+            case '\\' : escaped = "\\\\"; break;
+            case '\b' : escaped = "\\b"; break;
+            case '\f' : escaped = "\\f"; break;
+            case '\n' : escaped = "\\n"; break;
+            case '\r' : escaped = "\\r"; break;
+            case '\t' : escaped = "\\t"; break;
+            default :
+                if (c < 0x20) {
+                    snprintf(tmp, sizeof(tmp), "\\u%04X", c);
+                    escaped = tmp;
+                }
+                break;
+        }
+
+        if (escaped != NULL) {
+            jsonSerializer_writerRaw(writer, start, (size_t) (pos - start));
+            jsonSerializer_writerRaw(writer, escaped, strlen(escaped));
+            start = pos + 1;
+        }
+        pos += 1;
+    }
+    jsonSerializer_writerRaw(writer, start, (size_t) (pos - start));
+    jsonSerializer_writerRaw(writer, "\"", 1);
+}
+
+//same format as the jansson real encoding
+static void jsonSerializer_writerReal(json_serializer_writer_type *writer, double value) {
+    char tmp[64];
+    int rc = snprintf(tmp, sizeof(tmp), "%.*g", JSON_WRITER_REAL_PRECISION, value);
+    if (rc < 0 || (size_t) rc >= sizeof(tmp) - 3) {
+        writer->status = ERROR;
+        LOG_ERROR("Error formatting real %f", value);
+        return;
+    }
+    size_t length = (size_t) rc;
+
+    const char *point = localeconv()->decimal_point;
+    if (point != NULL && point[0] != '.' && point[0] != '\0') {
+        char *pos = strchr(tmp, point[0]);
+        if (pos != NULL) {
+            *pos = '.';
+        }
+    }
+
+    //a dot or an exponent, otherwise it would be read back as integer
+    if (strchr(tmp, '.') == NULL && strchr(tmp, 'e') == NULL) {
+        tmp[length++] = '.';
+        tmp[length++] = '0';
+        tmp[length] = '\0';
+    }
+
+    //no '+' and no leading zeros in the exponent
+    char *start = strchr(tmp, 'e');
+    if (start != NULL) {
+        start += 1;
+        char *end = start + 1;
+        if (*start == '-') {
+            start += 1;
+        }
+        while (*end == '0') {
+            end += 1;
+        }
+        if (end != start) {
+            memmove(start, end, length - (size_t) (end - tmp) + 1);
+            length -= (size_t) (end - start);
+        }
+    }
+
+    jsonSerializer_writerBeginItem(writer);
+    jsonSerializer_writerRaw(writer, tmp, length);
+}
+
+//values for which jansson creates no json value, those are left out of objects and arrays
+static bool jsonSerializer_isOmitted(dyn_type *type, void *input) {
+    bool omitted = false;
+    dyn_type *subType = NULL;
+    switch (dynType_descriptorType(type)) {
+        case 'F' :
+            omitted = !isfinite(*(float *) input);
+            break;
+        case 'D' :
+            omitted = !isfinite(*(double *) input);
+            break;
+        case 't' :
+            omitted = *(const char **) input == NULL || !jsonSerializer_isValidUtf8(*(const char **) input);
+            break;
+        case '*' :
+            omitted = *(void **) input == NULL;
+            if (!omitted && dynType_typedPointer_getTypedType(type, &subType) == OK) {
+                omitted = jsonSerializer_isOmitted(subType, *(void **) input);
+            }
+            break;
+        case 'P' :
+            LOG_WARNING("Untyped pointer not supported for serialization. ignoring");
+            omitted = true;
+            break;
+        default :
+            break;
+    }
+    return omitted;
+}
+
+//same rules as the jansson utf-8 check
+static bool jsonSerializer_isValidUtf8(const char *str) {
+    const unsigned char *pos = (const unsigned char *) str;
+    while (*pos != '\0') {
+        unsigned char c = *pos;
+        size_t count = 0;
+        int32_t value = 0;
+        if (c < 0x80) {
+            pos += 1;
+            continue;
+        } else if (c <= 0xC1) {
+            return false; //continuation byte or overlong 2 byte encoding
+        } else if (c <= 0xDF) {
+            count = 2;
+            value = c & 0x1F;
+        } else if (c <= 0xEF) {
+            count = 3;
+            value = c & 0x0F;
+        } else if (c <= 0xF4) {
+            count = 4;
+            value = c & 0x07;
+        } else {
+            return false;
+        }
+
+        size_t i;
+        for (i = 1; i < count; i += 1) {
+            if ((pos[i] & 0xC0) != 0x80) {
+                return false;
+            }
+            value = (value << 6) + (pos[i] & 0x3F);
+        }
+
+        if (value > 0x10FFFF || (value >= 0xD800 && value <= 0xDFFF)
+                || (count == 3 && value < 0x800) || (count == 4 && value < 0x10000)) {
+            return false;
+        }
+        pos += count;
+    }
+    return true;
+}
+
+static int jsonSerializer_streamAny(json_serializer_writer_type *writer, dyn_type *type, void *input) {
+    int status = OK;
+    dyn_type *subType = NULL;
+    int descriptor = dynType_descriptorType(type);
+
+    switch (descriptor) {
+        case 'Z' :
+            jsonSerializer_writerBeginItem(writer);
+            if (*(bool *) input) {
+                jsonSerializer_writerRaw(writer, "true", 4);
+            } else {
+                jsonSerializer_writerRaw(writer, "false", 5);
+            }
+            break;
+        case 'B' :
+            jsonSerializer_writerInteger(writer, (json_int_t) *(char *) input);
+            break;
+        case 'S' :
+            jsonSerializer_writerInteger(writer, (json_int_t) *(int16_t *) input);
+            break;
+        case 'I' :
+            jsonSerializer_writerInteger(writer, (json_int_t) *(int32_t *) input);
+            break;
+        case 'J' :
+            jsonSerializer_writerInteger(writer, (json_int_t) *(int64_t *) input);
+            break;
+        case 'b' :
+            jsonSerializer_writerInteger(writer, (json_int_t) *(uint8_t *) input);
+            break;
+        case 's' :
+            jsonSerializer_writerInteger(writer, (json_int_t) *(uint16_t *) input);
+            break;
+        case 'i' :
+            jsonSerializer_writerInteger(writer, (json_int_t) *(uint32_t *) input);
+            break;
+        case 'j' :
+            jsonSerializer_writerInteger(writer, (json_int_t) *(uint64_t *) input);
+            break;
+        case 'N' :
+            jsonSerializer_writerInteger(writer, (json_int_t) *(int *) input);
+            break;
+        case 'F' :
+            jsonSerializer_writerReal(writer, (double) *(float *) input);
+            break;
+        case 'D' :
+            jsonSerializer_writerReal(writer, *(double *) input);
+            break;
+        case 't' :
+            jsonSerializer_writerString(writer, *(const char **) input);
+            break;
+        case '*' :
+            status = dynType_typedPointer_getTypedType(type, &subType);
+            if (status == OK) {
+                status = jsonSerializer_streamAny(writer, subType, *(void **) input);
+            }
+            break;
+        case '{' :
+            status = jsonSerializer_streamComplex(writer, type, input);
+            break;
+        case '[' :
+            status = jsonSerializer_streamSequence(writer, type, input);
+            break;
+        default :
+            LOG_ERROR("Unsupported descriptor '%c'", descriptor);
+            status = ERROR;
+            break;
+    }
+
+    return status == OK ? writer->status : status;
+}
+
+static int jsonSerializer_streamSequence(json_serializer_writer_type *writer, dyn_type *type, void *input) {
+    assert(dynType_type(type) == DYN_TYPE_SEQUENCE);
+    int status = jsonSerializer_writerBeginArray(writer);
+
+    dyn_type *itemType = dynType_sequence_itemType(type);
+    uint32_t len = dynType_sequence_length(input);
+    uint32_t i;
+    void *itemLoc = NULL;
+    for (i = 0; i < len && status == OK; i += 1) {
+        status = dynType_sequence_locForIndex(type, input, i, &itemLoc);
+        if (status == OK && !jsonSerializer_isOmitted(itemType, itemLoc)) {
+            status = jsonSerializer_streamAny(writer, itemType, itemLoc);
+        }
+    }
+
+    if (status == OK) {
+        status = jsonSerializer_writerEnd(writer);
+    }
+
+    return status;
+}
+
+static int jsonSerializer_streamComplex(json_serializer_writer_type *writer, dyn_type *type, void *input) {
+    assert(dynType_type(type) == DYN_TYPE_COMPLEX);
+    int status = jsonSerializer_writerBeginObject(writer);
+
+    struct complex_type_entry *entry = NULL;
+    struct complex_type_entries_head *entries = NULL;
+    int index = 0;
+    if (status == OK) {
+        status = dynType_complex_entries(type, &entries);
+    }
+    if (status == OK) {
+        TAILQ_FOREACH(entry, entries, entries) {
+            void *subLoc = NULL;
+            dyn_type *subType = NULL;
+            status = dynType_complex_valLocAt(type, index, input, &subLoc);
+            if (status == OK) {
+                status = dynType_complex_dynTypeAt(type, index, &subType);
+            }
+            if (status == OK && !jsonSerializer_isOmitted(subType, subLoc)) {
+                status = jsonSerializer_writerKey(writer, entry->name);
+                if (status == OK) {
+                    status = jsonSerializer_streamAny(writer, subType, subLoc);
+                }
+            }
+            if (status != OK) {
+                break;
+            }
+            index += 1;
+        }
+    }
+
+    if (status == OK) {
+        status = jsonSerializer_writerEnd(writer);
+    }
+
+    return status;
+}
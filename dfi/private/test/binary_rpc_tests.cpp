@@ -0,0 +1,444 @@
+/**
+ *Licensed to the Apache Software Foundation (ASF) under one
+ *or more contributor license agreements.  See the NOTICE file
+ *distributed with this work for additional information
+ *regarding copyright ownership.  The ASF licenses this file
+ *to you under the Apache License, Version 2.0 (the
+ *"License"); you may not use this file except in compliance
+ *with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *Unless required by applicable law or agreed to in writing,
+ *software distributed under the License is distributed on an
+ *"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ *specific language governing permissions and limitations
+ *under the License.
+ */
+#include <CppUTest/TestHarness.h>
+#include <float.h>
+#include <assert.h>
+#include "CppUTest/CommandLineTestRunner.h"
+
+extern "C" {
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <ffi.h>
+
+#include "dyn_common.h"
+#include "dyn_type.h"
+#include "binary_serializer.h"
+#include "binary_rpc.h"
+
+static void stdLog(void *handle, int level, const char *file, int line, const char *msg, ...) {
+    va_list ap;
+    const char *levels[5] = {"NIL", "ERROR", "WARNING", "INFO", "DEBUG"};
+    fprintf(stderr, "%s: FILE:%s, LINE:%i, MSG:",levels[level], file, line);
+    va_start(ap, msg);
+    vfprintf(stderr, msg, ap);
+    fprintf(stderr, "\n");
+    va_end(ap);
+}
+
+    struct brpc_seq {
+        uint32_t cap;
+        uint32_t len;
+        double *buf;
+    };
+
+    struct brpc_StatsResult {
+        double average;
+        double min;
+        double max;
+        struct brpc_seq input;
+    };
+
+    struct brpc_serv {
+        void *handle;
+        int (*add)(void *, double, double, double *);
+        int (*sub)(void *, double, double, double *);
+        int (*sqrt)(void *, double, double *);
+        int (*stats)(void *, struct brpc_seq, struct brpc_StatsResult **);
+    };
+
+    struct brpc_serv_example5 {
+        void *handle;
+        int (*add)(void *, double, double, double *, void *);
+    };
+
+    struct brpc_serv_example4 {
+        void *handle;
+        int (*getName_example4)(void *, char** name);
+    };
+
+    static int brpc_add(void *handle, double a, double b, double *result) {
+        *result = a + b;
+        return 0;
+    }
+
+    static int brpc_addAsync(void *handle, double a, double b, double *result, void *completion) {
+        //an exported service is called synchronously, without completion
+        if (completion != NULL) {
+            return 1;
+        }
+        *result = a + b;
+        return 0;
+    }
+
+    static int brpc_sub(void *handle, double a, double b, double *result) {
+        return 3; //remote error
+    }
+
+    static int brpc_stats(void *handle, struct brpc_seq input, struct brpc_StatsResult **out) {
+        struct brpc_StatsResult *result = (struct brpc_StatsResult *) calloc(1, sizeof(*result));
+        double total = 0.0;
+        unsigned int i;
+        result->min = DBL_MAX;
+        result->max = -DBL_MAX;
+        for (i = 0; i < input.len; i += 1) {
+            total += input.buf[i];
+            result->min = input.buf[i] < result->min ? input.buf[i] : result->min;
+            result->max = input.buf[i] > result->max ? input.buf[i] : result->max;
+        }
+        result->average = input.len > 0 ? total / input.len : 0.0;
+        result->input.buf = (double *) calloc(input.len, sizeof(double));
+        memcpy(result->input.buf, input.buf, input.len * sizeof(double));
+        result->input.len = input.len;
+        result->input.cap = input.len;
+        *out = result;
+        return 0;
+    }
+
+    static int brpc_getName(void *handle, char **result) {
+        *result = strdup("allocatedInFunction");
+        return 0;
+    }
+
+    static struct method_entry *findMethod(dyn_interface_type *intf, const char *name) {
+        struct methods_head *head = NULL;
+        dynInterface_methods(intf, &head);
+        struct method_entry *entry = NULL;
+        TAILQ_FOREACH(entry, head, entries) {
+            if (strcmp(entry->name, name) == 0) {
+                break;
+            }
+        }
+        return entry;
+    }
+
+    static dyn_interface_type *parseInterface(const char *file) {
+        dyn_interface_type *intf = NULL;
+        FILE *desc = fopen(file, "r");
+        CHECK(desc != NULL);
+        int rc = dynInterface_parse(desc, &intf);
+        CHECK_EQUAL(0, rc);
+        fclose(desc);
+        return intf;
+    }
+
+    static void callPreAllocated(void) {
+        dyn_interface_type *intf = parseInterface("descriptors/example1.descriptor");
+        struct method_entry *entry = findMethod(intf, "add");
+        CHECK(entry != NULL);
+
+        struct brpc_serv serv;
+        serv.handle = NULL;
+        serv.add = brpc_add;
+
+        void *handle = NULL;
+        double a = 1.0;
+        double b = 2.0;
+        double result = -1.0;
+        double *out = &result;
+        void *args[4];
+        args[0] = &handle;
+        args[1] = &a;
+        args[2] = &b;
+        args[3] = &out;
+
+        char *request = NULL;
+        size_t requestSize = 0;
+        int rc = binaryRpc_prepareInvokeRequest(entry->dynFunc, entry->id, args, &request, &requestSize);
+        CHECK_EQUAL(0, rc);
+
+        char *reply = NULL;
+        size_t replySize = 0;
+        rc = binaryRpc_call(intf, &serv, request, requestSize, &reply, &replySize);
+        CHECK_EQUAL(0, rc);
+
+        rc = binaryRpc_handleReply(entry->dynFunc, reply, replySize, args);
+        CHECK_EQUAL(0, rc);
+        CHECK_EQUAL(3.0, result);
+
+        free(request);
+        free(reply);
+        dynInterface_destroy(intf);
+    }
+
+    static void callAsync(void) {
+        dyn_interface_type *intf = parseInterface("descriptors/example5.descriptor");
+        struct method_entry *entry = findMethod(intf, "add");
+        CHECK(entry != NULL);
+
+        struct brpc_serv_example5 serv;
+        serv.handle = NULL;
+        serv.add = brpc_addAsync;
+
+        void *handle = NULL;
+        double a = 1.0;
+        double b = 2.0;
+        double result = -1.0;
+        double *out = &result;
+        void *completion = NULL;
+        void *args[5];
+        args[0] = &handle;
+        args[1] = &a;
+        args[2] = &b;
+        args[3] = &out;
+        args[4] = &completion;
+
+        char *request = NULL;
+        size_t requestSize = 0;
+        int rc = binaryRpc_prepareInvokeRequest(entry->dynFunc, entry->id, args, &request, &requestSize);
+        CHECK_EQUAL(0, rc);
+
+        char *reply = NULL;
+        size_t replySize = 0;
+        rc = binaryRpc_call(intf, &serv, request, requestSize, &reply, &replySize);
+        CHECK_EQUAL(0, rc);
+
+        rc = binaryRpc_handleReply(entry->dynFunc, reply, replySize, args);
+        CHECK_EQUAL(0, rc);
+        CHECK_EQUAL(3.0, result);
+
+        free(request);
+        free(reply);
+        dynInterface_destroy(intf);
+    }
+
+    static void callPreAllocatedWithIndex(void) {
+        dyn_interface_type *intf = parseInterface("descriptors/example1.descriptor");
+        struct method_entry *entry = findMethod(intf, "add");
+        CHECK(entry != NULL);
+
+        struct brpc_serv serv;
+        serv.handle = NULL;
+        serv.add = brpc_add;
+
+        void *handle = NULL;
+        double a = 1.0;
+        double b = 2.0;
+        double result = -1.0;
+        double *out = &result;
+        void *args[4];
+        args[0] = &handle;
+        args[1] = &a;
+        args[2] = &b;
+        args[3] = &out;
+
+        char *request = NULL;
+        size_t requestSize = 0;
+        int rc = binaryRpc_prepareInvokeRequestForIndex(entry->dynFunc, entry->index, args, &request, &requestSize);
+        CHECK_EQUAL(0, rc);
+
+        char *reply = NULL;
+        size_t replySize = 0;
+        rc = binaryRpc_call(intf, &serv, request, requestSize, &reply, &replySize);
+        CHECK_EQUAL(0, rc);
+
+        rc = binaryRpc_handleReply(entry->dynFunc, reply, replySize, args);
+        CHECK_EQUAL(0, rc);
+        CHECK_EQUAL(3.0, result);
+
+        free(request);
+        free(reply);
+        dynInterface_destroy(intf);
+    }
+
+    static void callRemoteError(void) {
+        dyn_interface_type *intf = parseInterface("descriptors/example1.descriptor");
+        struct method_entry *entry = findMethod(intf, "sub");
+        CHECK(entry != NULL);
+
+        struct brpc_serv serv;
+        serv.handle = NULL;
+        serv.sub = brpc_sub;
+
+        void *handle = NULL;
+        double a = 1.0;
+        double b = 2.0;
+        double result = -1.0;
+        double *out = &result;
+        void *args[4];
+        args[0] = &handle;
+        args[1] = &a;
+        args[2] = &b;
+        args[3] = &out;
+
+        char *request = NULL;
+        size_t requestSize = 0;
+        int rc = binaryRpc_prepareInvokeRequest(entry->dynFunc, entry->id, args, &request, &requestSize);
+        CHECK_EQUAL(0, rc);
+
+        char *reply = NULL;
+        size_t replySize = 0;
+        rc = binaryRpc_call(intf, &serv, request, requestSize, &reply, &replySize);
+        CHECK_EQUAL(0, rc);
+
+        rc = binaryRpc_handleReply(entry->dynFunc, reply, replySize, args);
+        CHECK(rc != 0);
+        CHECK_EQUAL(-1.0, result);
+
+        free(request);
+        free(reply);
+        dynInterface_destroy(intf);
+    }
+
+    static void callOutput(void) {
+        dyn_interface_type *intf = parseInterface("descriptors/example1.descriptor");
+        struct method_entry *entry = findMethod(intf, "stats");
+        CHECK(entry != NULL);
+
+        struct brpc_serv serv;
+        serv.handle = NULL;
+        serv.stats = brpc_stats;
+
+        double values[] = {1.0, 2.0, 6.0};
+        struct brpc_seq input;
+        input.cap = 3;
+        input.len = 3;
+        input.buf = values;
+
+        void *handle = NULL;
+        struct brpc_StatsResult *result = NULL;
+        void *out = &result;
+        void *args[3];
+        args[0] = &handle;
+        args[1] = &input;
+        args[2] = &out;
+
+        char *request = NULL;
+        size_t requestSize = 0;
+        int rc = binaryRpc_prepareInvokeRequest(entry->dynFunc, entry->id, args, &request, &requestSize);
+        CHECK_EQUAL(0, rc);
+
+        char *reply = NULL;
+        size_t replySize = 0;
+        rc = binaryRpc_call(intf, &serv, request, requestSize, &reply, &replySize);
+        CHECK_EQUAL(0, rc);
+
+        rc = binaryRpc_handleReply(entry->dynFunc, reply, replySize, args);
+        CHECK_EQUAL(0, rc);
+        CHECK(result != NULL);
+        CHECK_EQUAL(3.0, result->average);
+        CHECK_EQUAL(1.0, result->min);
+        CHECK_EQUAL(6.0, result->max);
+        CHECK_EQUAL(3, result->input.len);
+        CHECK_EQUAL(6.0, result->input.buf[2]);
+
+        free(result->input.buf);
+        free(result);
+        free(request);
+        free(reply);
+        dynInterface_destroy(intf);
+    }
+
+    static void callOutputText(void) {
+        dyn_interface_type *intf = parseInterface("descriptors/example4.descriptor");
+        struct method_entry *entry = findMethod(intf, "getName");
+        CHECK(entry != NULL);
+
+        struct brpc_serv_example4 serv;
+        serv.handle = NULL;
+        serv.getName_example4 = brpc_getName;
+
+        void *handle = NULL;
+        char *result = NULL;
+        void *out = &result;
+        void *args[2];
+        args[0] = &handle;
+        args[1] = &out;
+
+        char *request = NULL;
+        size_t requestSize = 0;
+        int rc = binaryRpc_prepareInvokeRequest(entry->dynFunc, entry->id, args, &request, &requestSize);
+        CHECK_EQUAL(0, rc);
+
+        char *reply = NULL;
+        size_t replySize = 0;
+        rc = binaryRpc_call(intf, &serv, request, requestSize, &reply, &replySize);
+        CHECK_EQUAL(0, rc);
+
+        rc = binaryRpc_handleReply(entry->dynFunc, reply, replySize, args);
+        CHECK_EQUAL(0, rc);
+        STRCMP_EQUAL("allocatedInFunction", result);
+
+        free(result);
+        free(request);
+        free(reply);
+        dynInterface_destroy(intf);
+    }
+
+    static void callUnknownMethod(void) {
+        dyn_interface_type *intf = parseInterface("descriptors/example1.descriptor");
+        struct brpc_serv serv;
+        serv.handle = NULL;
+
+        binary_buffer_type request;
+        binaryBuffer_init(&request);
+        binaryBuffer_writeText(&request, "add(DD)");
+
+        char *reply = NULL;
+        size_t replySize = 0;
+        int rc = binaryRpc_call(intf, &serv, request.data, request.size, &reply, &replySize);
+        CHECK(rc != 0);
+
+        free(request.data);
+        dynInterface_destroy(intf);
+    }
+}
+
+TEST_GROUP(BinaryRpcTests) {
+    void setup() {
+        int lvl = 1;
+        dynCommon_logSetup(stdLog, NULL, lvl);
+        dynType_logSetup(stdLog, NULL,lvl);
+        dynFunction_logSetup(stdLog, NULL,lvl);
+        dynInterface_logSetup(stdLog, NULL,lvl);
+        binarySerializer_logSetup(stdLog, NULL, lvl);
+        binaryRpc_logSetup(stdLog, NULL, lvl);
+    }
+};
+
+TEST(BinaryRpcTests, callPre) {
+    callPreAllocated();
+}
+
+TEST(BinaryRpcTests, callPreWithIndex) {
+    callPreAllocatedWithIndex();
+}
+
+TEST(BinaryRpcTests, callAsync) {
+    callAsync();
+}
+
+TEST(BinaryRpcTests, callRemoteError) {
+    callRemoteError();
+}
+
+TEST(BinaryRpcTests, callOut) {
+    callOutput();
+}
+
+TEST(BinaryRpcTests, callOutText) {
+    callOutputText();
+}
+
+TEST(BinaryRpcTests, callUnknownMethod) {
+    callUnknownMethod();
+}
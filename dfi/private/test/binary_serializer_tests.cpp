@@ -0,0 +1,200 @@
+/**
+ *Licensed to the Apache Software Foundation (ASF) under one
+ *or more contributor license agreements.  See the NOTICE file
+ *distributed with this work for additional information
+ *regarding copyright ownership.  The ASF licenses this file
+ *to you under the Apache License, Version 2.0 (the
+ *"License"); you may not use this file except in compliance
+ *with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *Unless required by applicable law or agreed to in writing,
+ *software distributed under the License is distributed on an
+ *"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ *specific language governing permissions and limitations
+ *under the License.
+ */
+#include <CppUTest/TestHarness.h>
+#include "CppUTest/CommandLineTestRunner.h"
+
+extern "C" {
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dyn_common.h"
+#include "dyn_type.h"
+#include "json_serializer.h"
+#include "binary_serializer.h"
+
+static void stdLog(void *handle, int level, const char *file, int line, const char *msg, ...) {
+	va_list ap;
+	const char *levels[5] = {"NIL", "ERROR", "WARNING", "INFO", "DEBUG"};
+	fprintf(stderr, "%s: FILE:%s, LINE:%i, MSG:",levels[level], file, line);
+	va_start(ap, msg);
+	vfprintf(stderr, msg, ap);
+	fprintf(stderr, "\n");
+	va_end(ap);
+}
+
+/*
+ * Reads the json input, writes it binary, reads that back and checks writing
+ * the result gives the same bytes again.
+ */
+static void *roundtripType(dyn_type *type, const char *input) {
+	void *inst = NULL;
+	int rc = jsonSerializer_deserialize(type, input, &inst);
+	CHECK_EQUAL(0, rc);
+
+	char *data = NULL;
+	size_t size = 0;
+	rc = binarySerializer_serialize(type, inst, &data, &size);
+	CHECK_EQUAL(0, rc);
+
+	void *copy = NULL;
+	rc = binarySerializer_deserialize(type, data, size, &copy);
+	CHECK_EQUAL(0, rc);
+
+	char *again = NULL;
+	size_t againSize = 0;
+	rc = binarySerializer_serialize(type, copy, &again, &againSize);
+	CHECK_EQUAL(0, rc);
+	CHECK_EQUAL(size, againSize);
+	CHECK_EQUAL(0, memcmp(data, again, size));
+
+	free(data);
+	free(again);
+	dynType_free(type, inst);
+	return copy;
+}
+
+static void roundtrip(const char *descriptor, const char *input) {
+	dyn_type *type = NULL;
+	int rc = dynType_parseWithStr(descriptor, NULL, NULL, &type);
+	CHECK_EQUAL(0, rc);
+	void *copy = roundtripType(type, input);
+	dynType_free(type, copy);
+	dynType_destroy(type);
+}
+
+struct tree_leaf {
+	char *name;
+	int32_t age;
+};
+
+struct tree_node {
+	struct tree_node *left;
+	struct tree_node *right;
+	struct tree_leaf *value;
+};
+
+static void treeTest(void) {
+	dyn_type *type = NULL;
+	int rc = dynType_parseWithStr("Tleaf={ts name age};Tnode={Lnode;Lnode;Lleaf; left right value};{Lnode; head}", NULL, NULL, &type);
+	CHECK_EQUAL(0, rc);
+
+	struct tree_node **tree = (struct tree_node **) roundtripType(type,
+			"{\"head\":{\"left\":{\"value\":{\"name\":\"John\",\"age\":44}},\"right\":{\"value\":{\"name\":\"Peter\",\"age\":55}}}}");
+	CHECK((*tree)->value == NULL);
+	STRCMP_EQUAL("John", (*tree)->left->value->name);
+	CHECK_EQUAL(44, (*tree)->left->value->age);
+	CHECK((*tree)->left->left == NULL);
+	STRCMP_EQUAL("Peter", (*tree)->right->value->name);
+	CHECK_EQUAL(55, (*tree)->right->value->age);
+
+	dynType_free(type, tree);
+	dynType_destroy(type);
+}
+
+static void roundtripTests(void) {
+	roundtrip("{DJISF a b c d e}", "{\"a\":1.0,\"b\":22,\"c\":32,\"d\":42,\"e\":4.4}");
+	roundtrip("{BJJDFD byte long1 long2 double1 float1 double2}",
+			"{\"byte\":42,\"long1\":232,\"long2\":242,\"double1\":4.2,\"float1\":3.2,\"double2\":4.4}");
+	roundtrip("{[I numbers}", "{\"numbers\":[22,32,42]}");
+	roundtrip("{[I numbers}", "{\"numbers\":[]}");
+	roundtrip("{{IDD index val1 val2}{IDD index val1 val2} left right}",
+			"{\"left\":{\"index\":1,\"val1\":1.0,\"val2\":2.0},\"right\":{\"index\":2,\"val1\":5.0,\"val2\":4.0}}");
+	roundtrip("Tsample={DD v1 v2};[lsample;", "[{\"v1\":0.1,\"v2\":0.2},{\"v1\":1.1,\"v2\":1.2},{\"v1\":2.1,\"v2\":2.2}]");
+	roundtrip("{t a}", "{\"a\":\"apache celix\"}");
+	roundtrip("{ZbijN a b c d e}", "{\"a\":true,\"b\":4,\"c\":8,\"d\":16,\"e\":-32}");
+	roundtrip("{[t names}", "{\"names\":[\"a\",\"\",\"apache celix\"]}");
+}
+
+struct wire_example {
+	int16_t s;
+	int32_t i;
+	char *t;
+};
+
+static void wireFormatTest(void) {
+	dyn_type *type = NULL;
+	int rc = dynType_parseWithStr("{SIt s i t}", NULL, NULL, &type);
+	CHECK_EQUAL(0, rc);
+
+	char text[] = "ab";
+	struct wire_example ex;
+	ex.s = 0x0102;
+	ex.i = 0x03040506;
+	ex.t = text;
+
+	char *data = NULL;
+	size_t size = 0;
+	rc = binarySerializer_serialize(type, &ex, &data, &size);
+	CHECK_EQUAL(0, rc);
+
+	const unsigned char expected[] = {0x02, 0x01, 0x06, 0x05, 0x04, 0x03, 0x02, 0x00, 0x00, 0x00, 'a', 'b'};
+	CHECK_EQUAL(sizeof(expected), size);
+	CHECK_EQUAL(0, memcmp(expected, data, size));
+
+	free(data);
+	dynType_destroy(type);
+}
+
+static void truncatedInputTest(void) {
+	dyn_type *type = NULL;
+	int rc = dynType_parseWithStr("{[I numbers}", NULL, NULL, &type);
+	CHECK_EQUAL(0, rc);
+
+	//claims 1000 items but only carries one
+	const unsigned char input[] = {0xe8, 0x03, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00};
+	void *inst = NULL;
+	rc = binarySerializer_deserialize(type, (const char *) input, sizeof(input), &inst);
+	CHECK(rc != 0);
+	CHECK(inst == NULL);
+
+	rc = binarySerializer_deserialize(type, (const char *) input, 2, &inst);
+	CHECK(rc != 0);
+
+	dynType_destroy(type);
+}
+}
+
+TEST_GROUP(BinarySerializerTests) {
+	void setup() {
+		int lvl = 1;
+		dynCommon_logSetup(stdLog, NULL, lvl);
+		dynType_logSetup(stdLog, NULL,lvl);
+		jsonSerializer_logSetup(stdLog, NULL, lvl);
+		binarySerializer_logSetup(stdLog, NULL, lvl);
+	}
+};
+
+TEST(BinarySerializerTests, Roundtrip) {
+	roundtripTests();
+}
+
+TEST(BinarySerializerTests, Tree) {
+	treeTest();
+}
+
+TEST(BinarySerializerTests, WireFormat) {
+	wireFormatTest();
+}
+
+TEST(BinarySerializerTests, TruncatedInput) {
+	truncatedInputTest();
+}
@@ -143,6 +143,44 @@ static void tests() {
     }
 }
 
+static void offset_binding(void *userData, void* args[], void *out) {
+    int32_t offset = *((int32_t *)userData);
+    int32_t a = *((int32_t *)args[0]);
+    int32_t b = *((int32_t *)args[1]);
+    int32_t c = *((int32_t *)args[2]);
+    int32_t *ret = (int32_t *)out;
+    *ret = a + b + c + offset;
+    g_count += 1;
+}
+
+static void sharedFunctionTest() {
+    dyn_function_type *dynFunction = NULL;
+    int rc = dynFunction_parseWithStr(EXAMPLE1_DESCRIPTOR, NULL, &dynFunction);
+    CHECK_EQUAL(0, rc);
+
+    //two closures on the same function, each with its own user data
+    int32_t offset1 = 10;
+    int32_t offset2 = 100;
+    dyn_closure_type *closure1 = NULL;
+    dyn_closure_type *closure2 = NULL;
+    int32_t (*func1)(int32_t a, int32_t b, int32_t c) = NULL;
+    int32_t (*func2)(int32_t a, int32_t b, int32_t c) = NULL;
+    rc = dynFunction_allocClosure(dynFunction, offset_binding, &offset1, &closure1, (void(**)(void))&func1);
+    CHECK_EQUAL(0, rc);
+    rc = dynFunction_allocClosure(dynFunction, offset_binding, &offset2, &closure2, (void(**)(void))&func2);
+    CHECK_EQUAL(0, rc);
+    CHECK(func1 != func2);
+
+    CHECK_EQUAL(19, func1(2,3,4));
+    CHECK_EQUAL(109, func2(2,3,4));
+    CHECK_EQUAL(2, g_count);
+
+    dynFunction_freeClosure(closure1);
+    CHECK_EQUAL(109, func2(2,3,4));
+    dynFunction_freeClosure(closure2);
+    dynFunction_destroy(dynFunction);
+}
+
 }
 
 
@@ -160,3 +198,7 @@ TEST(DynClosureTests, DynCLosureTest1) {
     //TODO split up
     tests();
 }
+
+TEST(DynClosureTests, DynClosureSharedFunctionTest) {
+    sharedFunctionTest();
+}
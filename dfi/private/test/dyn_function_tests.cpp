@@ -222,6 +222,22 @@ extern "C" {
         dynFunction_destroy(dynFunc);
     }
 
+    #define EXAMPLE5_DESCRIPTOR "add(#am=handle;PDD#am=pre;*D#am=async;P)N"
+
+    static void test_example5(void) {
+        dyn_function_type *dynFunc = NULL;
+        int rc = dynFunction_parseWithStr(EXAMPLE5_DESCRIPTOR, NULL, &dynFunc);
+        CHECK_EQUAL(0, rc);
+
+        CHECK_EQUAL(5, dynFunction_nrOfArguments(dynFunc));
+        CHECK_EQUAL(DYN_FUNCTION_ARGUMENT_META__HANDLE, dynFunction_argumentMetaForIndex(dynFunc, 0));
+        CHECK_EQUAL(DYN_FUNCTION_ARGUMENT_META__STD, dynFunction_argumentMetaForIndex(dynFunc, 1));
+        CHECK_EQUAL(DYN_FUNCTION_ARGUMENT_META__PRE_ALLOCATED_OUTPUT, dynFunction_argumentMetaForIndex(dynFunc, 3));
+        CHECK_EQUAL(DYN_FUNCTION_ARGUMENT_META__ASYNC, dynFunction_argumentMetaForIndex(dynFunc, 4));
+
+        dynFunction_destroy(dynFunc);
+    }
+
     #define INVALID_FUNC_DESCRIPTOR "example$[D)V"//$ is an invalid symbol, missing (
 
     static void test_invalidDynFunc(void) {
@@ -268,6 +284,10 @@ TEST(DynFunctionTests, DynFuncTest4) {
     test_example4();
 }
 
+TEST(DynFunctionTests, DynFuncAsyncMetaTest) {
+    test_example5();
+}
+
 TEST(DynFunctionTests, InvalidDynFuncTest) {
     test_invalidDynFunc();
     test_invalidDynFuncType();
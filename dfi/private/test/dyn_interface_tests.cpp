@@ -96,6 +96,21 @@ extern "C" {
         int count = dynInterface_nrOfMethods(dynIntf);
         CHECK_EQUAL(4, count);
 
+        struct method_entry *entry = NULL;
+        status = dynInterface_findMethod(dynIntf, "sqrt(D)D", &entry);
+        CHECK_EQUAL(0, status);
+        STRCMP_EQUAL("sqrt", entry->name);
+
+        struct method_entry *byIndex = NULL;
+        status = dynInterface_methodForIndex(dynIntf, entry->index, &byIndex);
+        CHECK_EQUAL(0, status);
+        CHECK(entry == byIndex);
+
+        status = dynInterface_findMethod(dynIntf, "sqrt", &entry);
+        CHECK(status != 0);
+        status = dynInterface_methodForIndex(dynIntf, count, &entry);
+        CHECK(status != 0);
+
         dynInterface_destroy(dynIntf);
     }
 
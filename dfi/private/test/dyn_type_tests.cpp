@@ -295,3 +295,129 @@ TEST(DynTypeTests, SequenceWithPointerTest) {
     dynType_destroy(type);
 }
 
+
+TEST(DynTypeTests, ArenaTest) {
+    struct item {
+        char *text;
+        double val;
+    };
+
+    struct item_sequence {
+        uint32_t cap;
+        uint32_t len;
+        struct item *buf;
+    };
+
+    dyn_type *type = NULL;
+    int rc = dynType_parseWithStr("Titem={tD text val};[litem;", NULL, NULL, &type);
+    CHECK_EQUAL(0, rc);
+
+    dyn_type_arena *arena = NULL;
+    rc = dynType_arenaCreate(128, &arena);
+    CHECK_EQUAL(0, rc);
+
+    struct item_sequence *seq = NULL;
+    rc = dynType_allocInArena(arena, type, (void **)&seq);
+    CHECK_EQUAL(0, rc);
+    CHECK_EQUAL(0, seq->cap);
+
+    //larger than a single arena block
+    rc = dynType_sequence_allocInArena(arena, type, seq, 100);
+    CHECK_EQUAL(0, rc);
+    CHECK_EQUAL(100, seq->cap);
+
+    dyn_type *itemType = dynType_sequence_itemType(type);
+    dyn_type *textType = NULL;
+    dynType_complex_dynTypeAt(itemType, 0, &textType);
+    int i;
+    for (i = 0; i < 100; i += 1) {
+        struct item *item = NULL;
+        rc = dynType_sequence_increaseLengthAndReturnLastLoc(type, seq, (void **)&item);
+        CHECK_EQUAL(0, rc);
+        CHECK(item->text == NULL);
+        rc = dynType_text_allocAndInitInArena(arena, textType, &item->text, "celix");
+        CHECK_EQUAL(0, rc);
+        item->val = i;
+    }
+    STRCMP_EQUAL("celix", seq->buf[99].text);
+    CHECK_EQUAL(99.0, seq->buf[99].val);
+
+    dynType_arenaReset(arena);
+    rc = dynType_allocInArena(arena, type, (void **)&seq);
+    CHECK_EQUAL(0, rc);
+    CHECK(seq->buf == NULL);
+
+    dynType_arenaDestroy(arena);
+    dynType_destroy(type);
+}
+
+TEST(DynTypeTests, PositionIndependentTest) {
+    struct frame {
+        int64_t timestamp;
+        struct {
+            uint32_t cap;
+            uint32_t len;
+            double *buf;
+        } samples;
+    };
+
+    dyn_type *type = NULL;
+    int rc = dynType_parseWithStr("{J[D timestamp samples}", NULL, NULL, &type);
+    CHECK_EQUAL(0, rc);
+    CHECK(dynType_isPositionIndependent(type));
+
+    dyn_type *textType = NULL;
+    rc = dynType_parseWithStr("{Jt timestamp name}", NULL, NULL, &textType);
+    CHECK_EQUAL(0, rc);
+    CHECK(!dynType_isPositionIndependent(textType));
+    dynType_destroy(textType);
+
+    double region[256] __attribute__((aligned(16)));
+    dyn_type_arena *arena = NULL;
+    rc = dynType_arenaCreateInRegion(region, sizeof(region), &arena);
+    CHECK_EQUAL(0, rc);
+
+    dyn_type *samplesType = NULL;
+    dynType_complex_dynTypeAt(type, 1, &samplesType);
+    struct frame *frame = NULL;
+    rc = dynType_allocInArena(arena, type, (void **)&frame);
+    CHECK_EQUAL(0, rc);
+    POINTERS_EQUAL(region, frame);
+    rc = dynType_sequence_allocInArena(arena, samplesType, &frame->samples, 100);
+    CHECK_EQUAL(0, rc);
+    frame->timestamp = 42;
+    for (int i = 0; i < 100; i += 1) {
+        frame->samples.buf[i] = i * 0.5;
+    }
+    frame->samples.len = 100;
+
+    //does not fit in the remaining part of the region
+    struct frame unused;
+    rc = dynType_sequence_allocInArena(arena, samplesType, &unused.samples, 200);
+    CHECK(rc != 0);
+
+    size_t used = dynType_arenaUsed(arena);
+    CHECK(used <= sizeof(region));
+    rc = dynType_pointersToOffsets(type, frame, region, used);
+    CHECK_EQUAL(0, rc);
+
+    //the receiver maps the region at another address
+    double copy[256];
+    memcpy(copy, region, used);
+    struct frame *received = (struct frame *)copy;
+    rc = dynType_offsetsToPointers(type, received, copy, used);
+    CHECK_EQUAL(0, rc);
+    CHECK_EQUAL(42, received->timestamp);
+    CHECK_EQUAL(100, received->samples.len);
+    CHECK((char *)received->samples.buf > (char *)copy && (char *)received->samples.buf < (char *)copy + used);
+    CHECK_EQUAL(49.5, received->samples.buf[99]);
+
+    //offsets outside of the region are rejected
+    rc = dynType_pointersToOffsets(type, received, copy, used);
+    CHECK_EQUAL(0, rc);
+    rc = dynType_offsetsToPointers(type, received, copy, sizeof(struct frame));
+    CHECK(rc != 0);
+
+    dynType_arenaDestroy(arena);
+    dynType_destroy(type);
+}
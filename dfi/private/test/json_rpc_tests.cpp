@@ -97,6 +97,15 @@ static void stdLog(void *handle, int level, const char *file, int line, const ch
         return 0;
     }
 
+    int addAsync(void *handle, double a, double b, double *result, void *completion) {
+        //an exported service is called synchronously, without completion
+        if (completion != NULL) {
+            return 1;
+        }
+        *result = a + b;
+        return 0;
+    }
+
     int getName_example4(void *handle, char** result) {
         *result = strdup("allocatedInFunction");
         return 0;
@@ -173,6 +182,11 @@ static void stdLog(void *handle, int level, const char *file, int line, const ch
         int (*stats)(void *, struct tst_seq, struct tst_StatsResult **);
     };
 
+    struct tst_serv_example5 {
+        void *handle;
+        int (*add)(void *, double, double, double *, void *);
+    };
+
     struct tst_serv_example4 {
         void *handle;
         int (*getName_example4)(void *, char** name);
@@ -201,6 +215,72 @@ static void stdLog(void *handle, int level, const char *file, int line, const ch
         dynInterface_destroy(intf);
     }
 
+    void callTestAsync(void) {
+        dyn_interface_type *intf = NULL;
+        FILE *desc = fopen("descriptors/example5.descriptor", "r");
+        CHECK(desc != NULL);
+        int rc = dynInterface_parse(desc, &intf);
+        CHECK_EQUAL(0, rc);
+        fclose(desc);
+
+        char *result = NULL;
+
+        struct tst_serv_example5 serv;
+        serv.handle = NULL;
+        serv.add = addAsync;
+
+        rc = jsonRpc_call(intf, &serv, "{\"m\":\"add(DD)D\", \"a\": [1.0,2.0]}", &result);
+        CHECK_EQUAL(0, rc);
+        STRCMP_CONTAINS("3.0", result);
+
+        free(result);
+        dynInterface_destroy(intf);
+    }
+
+    void callTestIndex(void) {
+        dyn_interface_type *intf = NULL;
+        FILE *desc = fopen("descriptors/example1.descriptor", "r");
+        CHECK(desc != NULL);
+        int rc = dynInterface_parse(desc, &intf);
+        CHECK_EQUAL(0, rc);
+        fclose(desc);
+
+        struct method_entry *entry = NULL;
+        rc = dynInterface_findMethod(intf, "add(DD)D", &entry);
+        CHECK_EQUAL(0, rc);
+
+        void *handle = NULL;
+        double arg1 = 1.0;
+        double arg2 = 2.0;
+        void *args[4];
+        args[0] = &handle;
+        args[1] = &arg1;
+        args[2] = &arg2;
+
+        char *request = NULL;
+        rc = jsonRpc_prepareInvokeRequestForIndex(entry->dynFunc, entry->index, args, &request);
+        CHECK_EQUAL(0, rc);
+        STRCMP_CONTAINS("\"m\": 0", request);
+
+        struct tst_serv serv;
+        serv.handle = NULL;
+        serv.add = add;
+
+        char *result = NULL;
+        rc = jsonRpc_call(intf, &serv, request, &result);
+        CHECK_EQUAL(0, rc);
+        STRCMP_CONTAINS("3.0", result);
+        free(result);
+        free(request);
+
+        //out of range index
+        result = NULL;
+        rc = jsonRpc_call(intf, &serv, "{\"m\": 42, \"a\": [1.0,2.0]}", &result);
+        CHECK_EQUAL(1, rc);
+
+        dynInterface_destroy(intf);
+    }
+
     void callTestOutput(void) {
         dyn_interface_type *intf = NULL;
         FILE *desc = fopen("descriptors/example1.descriptor", "r");
@@ -380,7 +460,62 @@ static void stdLog(void *handle, int level, const char *file, int line, const ch
         dynInterface_destroy(intf);
     }
 
+    void callTestBatch(void) {
+        dyn_interface_type *intf = NULL;
+        FILE *desc = fopen("descriptors/example1.descriptor", "r");
+        CHECK(desc != NULL);
+        int rc = dynInterface_parse(desc, &intf);
+        CHECK_EQUAL(0, rc);
+        fclose(desc);
+
+        struct tst_serv serv;
+        serv.handle = NULL;
+        serv.add = add;
+
+        char *requests[3];
+        requests[0] = (char *)"{\"m\":\"add(DD)D\", \"a\": [1.0,2.0]}";
+        requests[1] = (char *)"{\"m\":\"unknown(D)D\", \"a\": [1.0]}";
+        requests[2] = (char *)"{\"m\":\"add(DD)D\", \"a\": [3.0,4.0]}";
+        char *batch = NULL;
+        rc = jsonRpc_prepareBatchRequest(requests, 3, &batch);
+        CHECK_EQUAL(0, rc);
+
+        char *result = NULL;
+        rc = jsonRpc_call(intf, &serv, batch, &result);
+        CHECK_EQUAL(0, rc);
+
+        char *replies[3];
+        rc = jsonRpc_splitBatchReply(result, 3, replies);
+        CHECK_EQUAL(0, rc);
+        STRCMP_CONTAINS("3.0", replies[0]);
+        STRCMP_CONTAINS("\"e\"", replies[1]);
+        STRCMP_CONTAINS("7.0", replies[2]);
 
+        //reply count must match
+        char *tooMany[4];
+        rc = jsonRpc_splitBatchReply(result, 4, tooMany);
+        CHECK_EQUAL(1, rc);
+
+        dyn_function_type *dynFunc = NULL;
+        rc = dynFunction_parseWithStr("add(#am=handle;PDD#am=pre;*D)N", NULL, &dynFunc);
+        CHECK_EQUAL(0, rc);
+        double sum = -1.0;
+        double *out = &sum;
+        void *args[4];
+        args[3] = &out;
+        rc = jsonRpc_handleReply(dynFunc, replies[2], args);
+        CHECK_EQUAL(0, rc);
+        CHECK_EQUAL(7.0, sum);
+        dynFunction_destroy(dynFunc);
+
+        int i;
+        for (i = 0; i < 3; i += 1) {
+            free(replies[i]);
+        }
+        free(result);
+        free(batch);
+        dynInterface_destroy(intf);
+    }
 }
 
 TEST_GROUP(JsonRpcTests) {
@@ -413,6 +548,14 @@ TEST(JsonRpcTests, callPre) {
     callTestPreAllocated();
 }
 
+TEST(JsonRpcTests, callAsync) {
+    callTestAsync();
+}
+
+TEST(JsonRpcTests, callIndex) {
+    callTestIndex();
+}
+
 TEST(JsonRpcTests, callOut) {
     callTestOutput();
 }
@@ -431,3 +574,6 @@ TEST(JsonRpcTests, handleOutChar) {
     handleTestOutChar();
 }
 
+TEST(JsonRpcTests, callBatch) {
+    callTestBatch();
+}
@@ -25,6 +25,7 @@ extern "C" {
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <math.h>
 
 #include <ffi.h>
 
@@ -525,7 +526,116 @@ void writeTest3(void) {
 	free(result);
 }
 
+struct stream_buffer {
+	char *data;
+	size_t len;
+};
+
+static int streamSink(void *handle, const char *data, size_t length) {
+	struct stream_buffer *buffer = (struct stream_buffer *)handle;
+	buffer->data = (char *)realloc(buffer->data, buffer->len + length + 1);
+	memcpy(buffer->data + buffer->len, data, length);
+	buffer->len += length;
+	buffer->data[buffer->len] = '\0';
+	return 0;
+}
+
+static void checkStreamingOutput(const char *descriptor, const char *input, size_t flags) {
+	dyn_type *type = NULL;
+	void *inst = NULL;
+	int rc = dynType_parseWithStr(descriptor, NULL, NULL, &type);
+	CHECK_EQUAL(0, rc);
+	rc = jsonSerializer_deserialize(type, input, &inst);
+	CHECK_EQUAL(0, rc);
+
+	json_t *root = NULL;
+	rc = jsonSerializer_serializeJson(type, inst, &root);
+	CHECK_EQUAL(0, rc);
+	char *expected = json_dumps(root, flags);
+	json_decref(root);
+
+	struct stream_buffer buffer = {NULL, 0};
+	rc = jsonSerializer_serializeToSink(type, inst, flags, streamSink, &buffer);
+	CHECK_EQUAL(0, rc);
+	STRCMP_EQUAL(expected, buffer.data);
+
+	free(expected);
+	free(buffer.data);
+	dynType_free(type, inst);
+	dynType_destroy(type);
+}
+
+static void streamingWriterTest(void) {
+	size_t flags[] = {JSON_COMPACT, JSON_INDENT(4), 0};
+	int i;
+	for (i = 0; i < 3; i += 1) {
+		checkStreamingOutput(example1_descriptor, example1_input, flags[i]);
+		checkStreamingOutput(example7_descriptor, example7_input, flags[i]);
+		checkStreamingOutput(example6_descriptor, example6_input, flags[i]);
+		checkStreamingOutput(example8_descriptor, example8_input, flags[i]);
+		checkStreamingOutput("{DDDF a b c d}", "{\"a\":1e300,\"b\":-2.5e-7,\"c\":3,\"d\":0.1}", flags[i]);
+		checkStreamingOutput("{t[t a b}", "{\"a\":\"q\\\"/\\\\\\n\\t\\u0001 \\u00e9\",\"b\":[]}", flags[i]);
+	}
+
+	//larger than the chunks handed to the sink
+	char *large = (char *)malloc(2000 * 32);
+	size_t len = sprintf(large, "[");
+	for (i = 0; i < 2000; i += 1) {
+		len += sprintf(large + len, "%s{\"v1\":%i.5,\"v2\":%i}", i > 0 ? "," : "", i, -i);
+	}
+	sprintf(large + len, "]");
+	checkStreamingOutput(example6_descriptor, large, JSON_INDENT(4));
+	free(large);
+
+	//values jansson cannot represent are left out
+	struct {
+		double a;
+		char *b;
+		double c;
+	} ex = {NAN, NULL, 1.0};
+	dyn_type *type = NULL;
+	char *result = NULL;
+	int rc = dynType_parseWithStr("{DtD a b c}", NULL, NULL, &type);
+	CHECK_EQUAL(0, rc);
+	rc = jsonSerializer_serialize(type, &ex, &result);
+	CHECK_EQUAL(0, rc);
+	STRCMP_EQUAL("{\"c\":1.0}", result);
+	free(result);
+	dynType_destroy(type);
+}
+
+static void parseInArenaTest(void) {
+	dyn_type_arena *arena = NULL;
+	int rc = dynType_arenaCreate(64, &arena);
+	CHECK_EQUAL(0, rc);
+
+	dyn_type *type = NULL;
+	void *inst = NULL;
+	rc = dynType_parseWithStr(example5_descriptor, NULL, NULL, &type);
+	CHECK_EQUAL(0, rc);
+	json_t *input = json_loads(example5_input, 0, NULL);
+	rc = jsonSerializer_deserializeJsonInArena(arena, type, input, &inst);
+	CHECK_EQUAL(0, rc);
+	check_example5(inst);
+	json_decref(input);
+	dynType_destroy(type);
 
+	//reused after a reset, no dynType_free needed
+	dynType_arenaReset(arena);
+
+	type = NULL;
+	struct ex6_sequence *seq = NULL;
+	rc = dynType_parseWithStr(example6_descriptor, NULL, NULL, &type);
+	CHECK_EQUAL(0, rc);
+	input = json_loads(example6_input, 0, NULL);
+	rc = jsonSerializer_deserializeJsonInArena(arena, type, input, (void **)&seq);
+	CHECK_EQUAL(0, rc);
+	check_example6(*seq);
+	json_decref(input);
+	dynType_destroy(type);
+
+	dynType_arenaDestroy(arena);
+}
 
 }
 
@@ -543,6 +653,14 @@ TEST(JsonSerializerTests, ParseTests) {
 	parseTests();
 }
 
+TEST(JsonSerializerTests, ParseInArenaTest) {
+	parseInArenaTest();
+}
+
+TEST(JsonSerializerTests, StreamingWriterTest) {
+	streamingWriterTest();
+}
+
 TEST(JsonSerializerTests, WriteTest1) {
 	writeTest1();
 }
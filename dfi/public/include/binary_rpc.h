@@ -0,0 +1,44 @@
+/**
+ *Licensed to the Apache Software Foundation (ASF) under one
+ *or more contributor license agreements.  See the NOTICE file
+ *distributed with this work for additional information
+ *regarding copyright ownership.  The ASF licenses this file
+ *to you under the Apache License, Version 2.0 (the
+ *"License"); you may not use this file except in compliance
+ *with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *Unless required by applicable law or agreed to in writing,
+ *software distributed under the License is distributed on an
+ *"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ *specific language governing permissions and limitations
+ *under the License.
+ */
+#ifndef __BINARY_RPC_H_
+#define __BINARY_RPC_H_
+
+#include <stddef.h>
+#include "dfi_log_util.h"
+#include "dyn_type.h"
+#include "dyn_function.h"
+#include "dyn_interface.h"
+
+/*
+ * Binary counterpart of json_rpc using the binary_serializer encoding.
+ * request: method id as length prefixed text followed by the standard arguments. A null text followed by
+ * a 32 bit method index is the compact form of the method id.
+ * reply: 32 bit status followed, when the status is 0, by the output arguments.
+ */
+
+//logging
+DFI_SETUP_LOG_HEADER(binaryRpc);
+
+int binaryRpc_call(dyn_interface_type *intf, void *service, const char *request, size_t requestSize, char **out, size_t *outSize);
+
+int binaryRpc_prepareInvokeRequest(dyn_function_type *func, const char *id, void *args[], char **out, size_t *outSize);
+int binaryRpc_prepareInvokeRequestForIndex(dyn_function_type *func, int index, void *args[], char **out, size_t *outSize);
+int binaryRpc_handleReply(dyn_function_type *func, const char *reply, size_t replySize, void *args[]);
+
+#endif
@@ -0,0 +1,60 @@
+/**
+ *Licensed to the Apache Software Foundation (ASF) under one
+ *or more contributor license agreements.  See the NOTICE file
+ *distributed with this work for additional information
+ *regarding copyright ownership.  The ASF licenses this file
+ *to you under the Apache License, Version 2.0 (the
+ *"License"); you may not use this file except in compliance
+ *with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *Unless required by applicable law or agreed to in writing,
+ *software distributed under the License is distributed on an
+ *"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ *specific language governing permissions and limitations
+ *under the License.
+ */
+#ifndef __BINARY_SERIALIZER_H_
+#define __BINARY_SERIALIZER_H_
+
+#include <stddef.h>
+#include "dfi_log_util.h"
+#include "dyn_type.h"
+#include "dyn_function.h"
+#include "dyn_interface.h"
+
+/*
+ * Compact binary encoding driven by the dyn_type descriptor:
+ * scalars are written little-endian with a fixed width (N as 32 bit, Z as 8 bit),
+ * text and sequences are prefixed with a 32 bit length, complex members follow
+ * in declaration order and typed pointers are prefixed with a presence byte.
+ * Both sides need the same descriptor, no member names are put on the wire.
+ */
+
+typedef struct binary_buffer {
+    char *data;
+    size_t size; //nr of bytes written (or available for reading)
+    size_t capacity;
+    size_t pos; //read position
+} binary_buffer_type;
+
+//logging
+DFI_SETUP_LOG_HEADER(binarySerializer);
+
+void binaryBuffer_init(binary_buffer_type *buffer);
+void binaryBuffer_wrap(binary_buffer_type *buffer, const char *data, size_t size);
+int binaryBuffer_writeUint32(binary_buffer_type *buffer, uint32_t val);
+int binaryBuffer_readUint32(binary_buffer_type *buffer, uint32_t *val);
+int binaryBuffer_writeText(binary_buffer_type *buffer, const char *text);
+//note the returned text points into the buffer and is not '\0' terminated
+int binaryBuffer_readText(binary_buffer_type *buffer, const char **text, uint32_t *length);
+
+int binarySerializer_deserialize(dyn_type *type, const char *input, size_t inputSize, void **result);
+int binarySerializer_deserializeBuffer(dyn_type *type, binary_buffer_type *input, void **result);
+
+int binarySerializer_serialize(dyn_type *type, void *input, char **output, size_t *outputSize);
+int binarySerializer_serializeBuffer(dyn_type *type, void *input, binary_buffer_type *output);
+
+#endif
@@ -30,9 +30,11 @@
  * am=handle #void pointer for the handle
  * am=pre #output pointer with memory preallocated
  * am=out #output pointer
+ * am=async #pointer to a completion, when set the (remote) call is done asynchronously. Not part of the request
  */
 
 typedef struct _dyn_function_type dyn_function_type;
+typedef struct _dyn_closure_type dyn_closure_type;
 
 DFI_SETUP_LOG_HEADER(dynFunction);
 
@@ -40,7 +42,8 @@ enum dyn_function_argument_meta {
     DYN_FUNCTION_ARGUMENT_META__STD = 0,
     DYN_FUNCTION_ARGUMENT_META__HANDLE = 1,
     DYN_FUNCTION_ARGUMENT_META__PRE_ALLOCATED_OUTPUT = 2,
-    DYN_FUNCTION_ARGUMENT_META__OUTPUT = 3
+    DYN_FUNCTION_ARGUMENT_META__OUTPUT = 3,
+    DYN_FUNCTION_ARGUMENT_META__ASYNC = 4
 };
 
 int dynFunction_parse(FILE *descriptorStream, struct types_head *refTypes, dyn_function_type **dynFunc);
@@ -57,4 +60,11 @@ int dynFunction_call(dyn_function_type *dynFunc, void(*fn)(void), void *returnVa
 int dynFunction_createClosure(dyn_function_type *func, void (*bind)(void *, void **, void*), void *userData, void(**fn)(void));
 int dynFunction_getFnPointer(dyn_function_type *func, void (**fn)(void));
 
+/*
+ * Closure owned by the caller instead of the function. Multiple closures can be created for the same function,
+ * which makes it possible to share a (parsed) function between users.
+ */
+int dynFunction_allocClosure(dyn_function_type *func, void (*bind)(void *, void **, void*), void *userData, dyn_closure_type **closure, void(**fn)(void));
+void dynFunction_freeClosure(dyn_closure_type *closure);
+
 #endif
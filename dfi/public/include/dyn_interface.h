@@ -61,6 +61,9 @@ int dynInterface_getHeaderEntry(dyn_interface_type *intf, const char *name, char
 int dynInterface_getAnnotationEntry(dyn_interface_type *intf, const char *name, char **value);
 int dynInterface_methods(dyn_interface_type *intf, struct methods_head **list);
 int dynInterface_nrOfMethods(dyn_interface_type *intf);
+//O(1) method lookups, by method id (e.g. "add(DD)D") or by index (order in the descriptor)
+int dynInterface_findMethod(dyn_interface_type *intf, const char *id, struct method_entry **out);
+int dynInterface_methodForIndex(dyn_interface_type *intf, int index, struct method_entry **out);
 
 
 #endif
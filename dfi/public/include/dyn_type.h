@@ -99,6 +99,13 @@
 
 typedef struct _dyn_type dyn_type;
 
+/*
+ * Arena for instances of dyn types which are only needed for a short time (e.g. the arguments of a single rpc call).
+ * Memory allocated in an arena is not freed with dynType_free, but released all at once with
+ * dynType_arenaReset or dynType_arenaDestroy.
+ */
+typedef struct _dyn_type_arena dyn_type_arena;
+
 TAILQ_HEAD(types_head, type_entry);
 struct type_entry {
     dyn_type *type;
@@ -123,6 +130,26 @@ void dynType_destroy(dyn_type *type);
 int dynType_alloc(dyn_type *type, void **bufLoc);
 void dynType_free(dyn_type *type, void *loc);
 
+//arena
+int dynType_arenaCreate(size_t blockSize, dyn_type_arena **arena);
+void dynType_arenaReset(dyn_type_arena *arena);
+void dynType_arenaDestroy(dyn_type_arena *arena);
+void * dynType_arenaAlloc(dyn_type_arena *arena, size_t size);
+int dynType_allocInArena(dyn_type_arena *arena, dyn_type *type, void **bufLoc);
+//arena using a fixed, 16 byte aligned region (e.g. in a shared memory segment), allocations fail when the region is full
+int dynType_arenaCreateInRegion(void *region, size_t size, dyn_type_arena **arena);
+size_t dynType_arenaUsed(dyn_type_arena *arena);
+
+/*
+ * Position independent values (simple types, complex types and sequences thereof, no text or pointers) can be
+ * placed in a region shared between processes: the sequence buffers are allocated in the region (see
+ * dynType_arenaCreateInRegion) and converted to offsets before handing the region over. The receiver converts
+ * them back to pointers and uses the value in place.
+ */
+bool dynType_isPositionIndependent(dyn_type *type);
+int dynType_pointersToOffsets(dyn_type *type, void *inst, void *base, size_t size);
+int dynType_offsetsToPointers(dyn_type *type, void *inst, void *base, size_t size);
+
 void dynType_print(dyn_type *type, FILE *stream);
 size_t dynType_size(dyn_type *type);
 int dynType_type(dyn_type *type);
@@ -138,6 +165,7 @@ int dynType_complex_entries(dyn_type *type, struct complex_type_entries_head **e
 
 //sequence
 int dynType_sequence_alloc(dyn_type *type, void *inst, uint32_t cap);
+int dynType_sequence_allocInArena(dyn_type_arena *arena, dyn_type *type, void *inst, uint32_t cap);
 int dynType_sequence_locForIndex(dyn_type *type, void *seqLoc, int index, void **valLoc);
 int dynType_sequence_increaseLengthAndReturnLastLoc(dyn_type *type, void *seqLoc, void **valLoc);
 dyn_type * dynType_sequence_itemType(dyn_type *type);
@@ -148,6 +176,7 @@ int dynType_typedPointer_getTypedType(dyn_type *type, dyn_type **typedType);
 
 //text
 int dynType_text_allocAndInit(dyn_type *type, void *textLoc, const char *value);
+int dynType_text_allocAndInitInArena(dyn_type_arena *arena, dyn_type *type, void *textLoc, const char *value);
 
 //simple
 void dynType_simple_setValue(dyn_type *type, void *inst, void *in);
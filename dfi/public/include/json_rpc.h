@@ -28,10 +28,23 @@
 //logging
 DFI_SETUP_LOG_HEADER(jsonRpc);
 
+//value of the "e" entry in a batch reply for an invocation that could not be done (e.g. unknown method)
+#define JSON_RPC_INVOCATION_ERROR -1
+
+/*
+ * The request is a single invoke request ({"m":..,"a":[..]}) or a batch: a json array of invoke requests.
+ * For a batch the reply is a json array with the reply of every invocation, in the same order.
+ */
 int jsonRpc_call(dyn_interface_type *intf, void *service, const char *request, char **out);
 
 
 int jsonRpc_prepareInvokeRequest(dyn_function_type *func, const char *id, void *args[], char **out);
+//same as jsonRpc_prepareInvokeRequest, but with the (compact) index of the method in the remote interface
+int jsonRpc_prepareInvokeRequestForIndex(dyn_function_type *func, int index, void *args[], char **out);
 int jsonRpc_handleReply(dyn_function_type *func, const char *reply, void *args[]);
 
+int jsonRpc_prepareBatchRequest(char *requests[], size_t nrOfRequests, char **out);
+//splits a batch reply in the replies of the individual invocations, which can be handled with jsonRpc_handleReply
+int jsonRpc_splitBatchReply(const char *reply, size_t nrOfReplies, char *replies[]);
+
 #endif
@@ -30,8 +30,38 @@ DFI_SETUP_LOG_HEADER(jsonSerializer);
 
 int jsonSerializer_deserialize(dyn_type *type, const char *input, void **result);
 int jsonSerializer_deserializeJson(dyn_type *type, json_t *input, void **result);
+//allocates the result in the arena, the result is released with the arena instead of with dynType_free
+int jsonSerializer_deserializeJsonInArena(dyn_type_arena *arena, dyn_type *type, json_t *input, void **result);
 
 int jsonSerializer_serialize(dyn_type *type, void *input, char **output);
 int jsonSerializer_serializeJson(dyn_type *type, void *input, json_t **out);
 
+/*
+ * Streaming json writer, writes directly from the dyn type instances without building a json_t tree first.
+ * The output is the same as json_dumps with the same flags (only JSON_INDENT(n) and JSON_COMPACT are supported),
+ * also for top level values which are not an object or array.
+ *
+ * Without a sink the output is collected in a growable buffer and returned by jsonSerializer_writerFinish,
+ * with a sink the output is handed over in chunks. A sink returns 0 on success.
+ */
+typedef int (*json_serializer_sink_fn)(void *handle, const char *data, size_t length);
+typedef struct json_serializer_writer json_serializer_writer_type;
+
+int jsonSerializer_writerCreate(size_t flags, json_serializer_sink_fn sink, void *handle, json_serializer_writer_type **out);
+void jsonSerializer_writerDestroy(json_serializer_writer_type *writer);
+
+int jsonSerializer_writerBeginObject(json_serializer_writer_type *writer);
+int jsonSerializer_writerBeginArray(json_serializer_writer_type *writer);
+int jsonSerializer_writerEnd(json_serializer_writer_type *writer);
+int jsonSerializer_writerKey(json_serializer_writer_type *writer, const char *key);
+int jsonSerializer_writerInteger(json_serializer_writer_type *writer, json_int_t value);
+int jsonSerializer_writerString(json_serializer_writer_type *writer, const char *value);
+//values without a json representation (e.g. a NULL string or an untyped pointer) are skipped, as jansson does
+int jsonSerializer_writerValue(json_serializer_writer_type *writer, dyn_type *type, void *input);
+int jsonSerializer_writerMember(json_serializer_writer_type *writer, const char *key, dyn_type *type, void *input);
+//flushes to the sink or, without a sink, hands over the '\0' terminated output
+int jsonSerializer_writerFinish(json_serializer_writer_type *writer, char **out);
+
+int jsonSerializer_serializeToSink(dyn_type *type, void *input, size_t flags, json_serializer_sink_fn sink, void *handle);
+
 #endif
@@ -46,11 +46,52 @@ typedef enum operand
 	NOT,
 } OPERAND;
 
+typedef enum filter_value_type {
+	FILTER_VALUE_STRING,
+	FILTER_VALUE_LONG,
+	FILTER_VALUE_DOUBLE,
+	FILTER_VALUE_VERSION
+} filter_value_type_e;
+
+struct filter_version {
+	int major;
+	int minor;
+	int micro;
+	const char *qualifier;
+};
+
+/*
+ * A single node of a compiled filter. Instructions are stored in pre-order, so the operands of
+ * an AND/OR/NOT node directly follow it and 'next' is the index of the first instruction after
+ * the complete subtree of the node.
+ */
+struct filter_instruction {
+	OPERAND operand;
+	const char *attribute; //interned property key
+	void *value; //borrowed from the filter tree
+	unsigned int nrOfOperands;
+	unsigned int next;
+
+	filter_value_type_e valueType;
+	union {
+		long longValue;
+		double doubleValue;
+		struct filter_version version;
+	} typedValue;
+};
+
+struct filter_program {
+	unsigned int size;
+	struct filter_instruction instructions[];
+};
+
 struct filter {
 	OPERAND operand;
 	char * attribute;
 	void * value;
 	char *filterStr;
+
+	struct filter_program *program; //only set for the root filter
 };
 
 
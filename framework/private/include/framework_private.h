@@ -55,10 +55,14 @@ struct framework {
     hash_map_pt installedBundleMap;
     hash_map_pt installRequestMap;
     array_list_pt serviceListeners;
+    hash_map_pt serviceListenersByObjectClass; //key = objectClass, value = list (listener) in order of addition
+    array_list_pt unindexedServiceListeners; //listeners without a required objectClass in their filter
+    unsigned long nextServiceListenerId;
     array_list_pt frameworkListeners;
 
     array_list_pt bundleListeners;
-    celix_thread_mutex_t bundleListenerLock;
+    celix_thread_mutex_t bundleListenerLock; //protects bundleListeners, frameworkListeners and nextDispatcher
+    celix_thread_cond_t listenerDelivered; //signaled (with bundleListenerLock) when a bundle/framework listener returns
 
     long nextBundleId;
     struct serviceRegistry * registry;
@@ -73,18 +77,16 @@ struct framework {
     celix_thread_mutex_t bundleLock;
 
     celix_thread_t globalLockThread;
-    array_list_pt globalLockWaitersList;
+    array_list_pt globalLockWaitersList; //struct fw_globalLockWaiter of the threads waiting for the global lock
     int globalLockCount;
 
-    bool interrupted;
     bool shutdown;
 
     properties_pt configurationMap;
 
-    array_list_pt requests;
-    celix_thread_cond_t dispatcher;
-    celix_thread_mutex_t dispatcherLock;
-    celix_thread_t dispatcherThread;
+    struct fw_eventDispatcher *dispatchers; //every dispatcher thread has its own event queue
+    unsigned int nrOfDispatchers;
+    unsigned int nextDispatcher; //bundle and framework listeners are assigned round robin to a dispatcher
     celix_thread_t shutdownThread;
 
     framework_logger_pt logger;
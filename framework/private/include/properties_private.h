@@ -0,0 +1,40 @@
+/**
+ *Licensed to the Apache Software Foundation (ASF) under one
+ *or more contributor license agreements.  See the NOTICE file
+ *distributed with this work for additional information
+ *regarding copyright ownership.  The ASF licenses this file
+ *to you under the Apache License, Version 2.0 (the
+ *"License"); you may not use this file except in compliance
+ *with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *Unless required by applicable law or agreed to in writing,
+ *software distributed under the License is distributed on an
+ *"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ *specific language governing permissions and limitations
+ *under the License.
+ */
+/*
+ * properties_private.h
+ *
+ *  \author     <a href="mailto:dev@celix.apache.org">Apache Celix Project Team</a>
+ *  \copyright  Apache License, Version 2.0
+ */
+
+#ifndef PROPERTIES_PRIVATE_H_
+#define PROPERTIES_PRIVATE_H_
+
+#include "properties.h"
+
+#define PROPERTIES_INITIAL_CAPACITY 4
+
+/**
+ * Returns the shared copy of key from the global key table, every call must be matched by a properties_releaseKey.
+ * Property keys are interned, so a lookup with an interned key is matched on pointer equality.
+ */
+const char* properties_internKey(const char* key);
+void properties_releaseKey(const char* key);
+
+#endif /* PROPERTIES_PRIVATE_H_ */
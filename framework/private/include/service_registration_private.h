@@ -39,6 +39,7 @@ struct serviceRegistration {
 	properties_pt properties;
 	const void * svcObj;
 	unsigned long serviceId;
+	long ranking; //service.ranking property, parsed once when the properties are set
 
 	bool isUnregistering;
 
@@ -67,5 +68,7 @@ celix_status_t serviceRegistration_ungetService(service_registration_pt registra
 
 celix_status_t serviceRegistration_getBundle(service_registration_pt registration, bundle_pt *bundle);
 celix_status_t serviceRegistration_getServiceName(service_registration_pt registration, const char **serviceName);
+celix_status_t serviceRegistration_getServiceId(service_registration_pt registration, unsigned long *serviceId);
+celix_status_t serviceRegistration_getRanking(service_registration_pt registration, long *ranking);
 
 #endif /* SERVICE_REGISTRATION_PRIVATE_H_ */
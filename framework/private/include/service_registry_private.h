@@ -31,11 +31,32 @@
 #include "registry_callback_private.h"
 #include "service_registry.h"
 
+/*
+ * Immutable copy of the registrations of a single service name. Readers access these without
+ * locking, writers publish a new copy and free the old one after a snapshot grace period.
+ */
+struct serviceRegistrySnapshotRegistrations {
+	unsigned int size;
+	service_registration_pt registrations[];
+};
+
+struct serviceRegistrySnapshotEntry {
+	char *serviceName;
+	struct serviceRegistrySnapshotRegistrations *registrations; //NULL if no registrations, atomically replaced
+};
+
+struct serviceRegistrySnapshot {
+	unsigned int capacity; //power of two, open addressing with linear probing
+	unsigned int used;
+	struct serviceRegistrySnapshotEntry *entries[];
+};
+
 struct serviceRegistry {
 	framework_pt framework;
 	registry_callback_t callback;
 
 	hash_map_pt serviceRegistrations; //key = bundle (reg owner), value = list ( registration )
+	hash_map_pt serviceRegistrationsByName; //key = service name, value = list ( registration ) sorted on ranking/service id
 	hash_map_pt serviceReferences; //key = bundle, value = map (key = serviceId, value = reference)
 
 	bool checkDeletedReferences; //If enabled. check if provided service references are still valid
@@ -46,7 +67,12 @@ struct serviceRegistry {
 
 	array_list_pt listenerHooks;
 
-	celix_thread_rwlock_t lock;
+	celix_thread_rwlock_t lock; //protects the registrations and listener hooks
+	celix_thread_rwlock_t referencesLock; //protects serviceReferences and deletedServiceReferences
+
+	struct serviceRegistrySnapshot *snapshot; //published copy of serviceRegistrationsByName, read without locking
+	unsigned int snapshotEpoch;
+	unsigned int snapshotReaders[2]; //nr of active snapshot readers per epoch
 };
 
 typedef enum reference_status_enum {
@@ -64,4 +90,6 @@ struct usageCount {
 
 typedef struct usageCount * usage_count_pt;
 
+celix_status_t serviceRegistry_publishRegistrations(service_registry_pt registry, const char *serviceName);
+
 #endif /* SERVICE_REGISTRY_PRIVATE_H_ */
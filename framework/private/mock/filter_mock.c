@@ -52,3 +52,11 @@ celix_status_t filter_getString(filter_pt filter, const char **filterStr) {
 			->withOutputParameter("filterStr", filterStr);
 	return mock_c()->returnValue().value.intValue;
 }
+
+celix_status_t filter_getRequiredEqualValue(filter_pt filter, const char* attribute, const char** value) {
+	mock_c()->actualCall("filter_getRequiredEqualValue")
+			->withPointerParameters("filter", filter)
+			->withStringParameters("attribute", attribute)
+			->withOutputParameter("value", value);
+	return mock_c()->returnValue().value.intValue;
+}
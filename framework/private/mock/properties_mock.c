@@ -65,6 +65,12 @@ void properties_set(properties_pt properties, const char * key, const char * val
 		->withStringParameters("value", value);
 }
 
+void properties_unset(properties_pt properties, const char * key) {
+	mock_c()->actualCall("properties_unset")
+		->withPointerParameters("properties", properties)
+		->withStringParameters("key", key);
+}
+
 
 
 
@@ -127,6 +127,20 @@ celix_status_t serviceRegistration_getServiceName(service_registration_pt regist
 	return mock_c()->returnValue().value.intValue;
 }
 
+celix_status_t serviceRegistration_getServiceId(service_registration_pt registration, unsigned long *serviceId) {
+	mock_c()->actualCall("serviceRegistration_getServiceId")
+			->withPointerParameters("registration", registration)
+			->withOutputParameter("serviceId", serviceId);
+	return mock_c()->returnValue().value.intValue;
+}
+
+celix_status_t serviceRegistration_getRanking(service_registration_pt registration, long *ranking) {
+	mock_c()->actualCall("serviceRegistration_getRanking")
+			->withPointerParameters("registration", registration)
+			->withOutputParameter("ranking", ranking);
+	return mock_c()->returnValue().value.intValue;
+}
+
 void serviceRegistration_retain(service_registration_pt registration) {
     mock_c()->actualCall("serviceRegistration_retain")
             ->withPointerParameters("registration", registration);
@@ -31,13 +31,59 @@
 #include <stdlib.h>
 #include <libgen.h>
 #include <signal.h>
+#include <time.h>
+#include <unistd.h>
 
 #ifndef CELIX_NO_CURLINIT
 #include <curl/curl.h>
 #endif
 
 #include "framework.h"
-#include "linked_list_iterator.h"
+#include "constants.h"
+#include "bundle_archive.h"
+#include "bundle_revision.h"
+#include "manifest.h"
+#include "module.h"
+#include "celix_threads.h"
+
+#define CELIX_LAUNCHER_AUTO_START_PREFIX "cosgi.auto.start."
+#define CELIX_LAUNCHER_AUTO_START_PARALLEL "cosgi.auto.start.parallel"
+#define CELIX_LAUNCHER_AUTO_START_THREADS "cosgi.auto.start.threads"
+
+struct launcher_bundle {
+	char *location;
+	int level;
+	bundle_context_pt context;
+	bundle_pt bundle; //NULL if the bundle could not be installed
+	double installTime; //ms
+
+	//start scheduling within the run level of the bundle
+	unsigned int nrOfUnstartedDependencies;
+	array_list_pt dependents; //bundles with this bundle in their Start-After header
+	bool scheduled;
+};
+
+struct launcher_installer {
+	array_list_pt bundles;
+	unsigned int next;
+};
+
+struct launcher_scheduler {
+	celix_thread_mutex_t mutex;
+	celix_thread_cond_t cond;
+	array_list_pt bundles;
+	array_list_pt ready; //bundles of which all dependencies are started, in configured order
+	unsigned int running;
+	unsigned int remaining;
+};
+
+static double celixLauncher_now(void);
+static unsigned int celixLauncher_getNrOfThreads(properties_pt config);
+static array_list_pt celixLauncher_createAutoStartBundles(properties_pt config);
+static void celixLauncher_destroyAutoStartBundles(array_list_pt bundles);
+static void celixLauncher_installBundles(bundle_context_pt context, array_list_pt bundles, unsigned int nrOfThreads);
+static const char *celixLauncher_getSymbolicName(struct launcher_bundle *bundle);
+static void celixLauncher_startRunLevel(array_list_pt bundles, unsigned int begin, unsigned int end, unsigned int nrOfThreads);
 
 int celixLauncher_launch(const char *configFile, framework_pt *framework) {
 	int status = 0;
@@ -78,11 +124,9 @@ int celixLauncher_launchWithProperties(properties_pt config, framework_pt *frame
 	curl_global_init(CURL_GLOBAL_NOTHING);
 #endif
 
-	const char* autoStartProp = properties_get(config, "cosgi.auto.start.1");
-	char* autoStart = NULL;
-	if (autoStartProp != NULL) {
-		autoStart = strndup(autoStartProp, 1024*10);
-	}
+	// Collect the bundles of all run levels before the framework takes ownership of the config
+	array_list_pt bundles = celixLauncher_createAutoStartBundles(config);
+	unsigned int nrOfThreads = celixLauncher_getNrOfThreads(config);
 
 	status = framework_create(framework, config);
 	bundle_pt fwBundle = NULL;
@@ -93,50 +137,28 @@ int celixLauncher_launchWithProperties(properties_pt config, framework_pt *frame
 			status = framework_getFrameworkBundle(*framework, &fwBundle);
 
 			if(status == CELIX_SUCCESS){
-				bundle_start(fwBundle);
-
-				char delims[] = " ";
-				char *result = NULL;
-				char *save_ptr = NULL;
-				linked_list_pt bundles;
-				array_list_pt installed = NULL;
 				bundle_context_pt context = NULL;
-				linked_list_iterator_pt iter = NULL;
 				unsigned int i;
+				double launchStart = celixLauncher_now();
 
-				linkedList_create(&bundles);
-				result = strtok_r(autoStart, delims, &save_ptr);
-				while (result != NULL) {
-					char *location = strdup(result);
-					linkedList_addElement(bundles, location);
-					result = strtok_r(NULL, delims, &save_ptr);
-				}
-				// First install all bundles
-				// Afterwards start them
-				arrayList_create(&installed);
+				bundle_start(fwBundle);
 				bundle_getContext(fwBundle, &context);
-				iter = linkedListIterator_create(bundles, 0);
-				while (linkedListIterator_hasNext(iter)) {
-					bundle_pt current = NULL;
-					char *location = (char *) linkedListIterator_next(iter);
-					if (bundleContext_installBundle(context, location, &current) == CELIX_SUCCESS) {
-						// Only add bundle if it is installed correctly
-						arrayList_add(installed, current);
-					} else {
-						printf("Could not install bundle from %s\n", location);
-					}
-					linkedListIterator_remove(iter);
-					free(location);
-				}
-				linkedListIterator_destroy(iter);
-				linkedList_destroy(bundles);
 
-				for (i = 0; i < arrayList_size(installed); i++) {
-					bundle_pt installedBundle = (bundle_pt) arrayList_get(installed, i);
-					bundle_startWithOptions(installedBundle, 0);
+				// First install all bundles
+				// Afterwards start them, run level by run level
+				celixLauncher_installBundles(context, bundles, nrOfThreads);
+
+				for (i = 0; i < arrayList_size(bundles); ) {
+					struct launcher_bundle *first = arrayList_get(bundles, i);
+					unsigned int end = i;
+					while (end < arrayList_size(bundles) && ((struct launcher_bundle *) arrayList_get(bundles, end))->level == first->level) {
+						end++;
+					}
+					celixLauncher_startRunLevel(bundles, i, end, nrOfThreads);
+					i = end;
 				}
 
-				arrayList_destroy(installed);
+				printf("Launcher: Started %u bundles in %.1f ms\n", arrayList_size(bundles), celixLauncher_now() - launchStart);
 			}
 		}
 	}
@@ -147,11 +169,298 @@ int celixLauncher_launchWithProperties(properties_pt config, framework_pt *frame
 
 	printf("Launcher: Framework Started\n");
 
-	free(autoStart);
-	
+	celixLauncher_destroyAutoStartBundles(bundles);
+
 	return status;
 }
 
+static double celixLauncher_now(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1000.0 + now.tv_nsec / 1000000.0;
+}
+
+static unsigned int celixLauncher_getNrOfThreads(properties_pt config) {
+	unsigned int nrOfThreads = 1;
+	const char *parallel = properties_get(config, CELIX_LAUNCHER_AUTO_START_PARALLEL);
+
+	if (parallel != NULL && strcmp(parallel, "true") == 0) {
+		const char *threads = properties_get(config, CELIX_LAUNCHER_AUTO_START_THREADS);
+		long configured = threads != NULL ? strtol(threads, NULL, 10) : sysconf(_SC_NPROCESSORS_ONLN);
+		nrOfThreads = configured > 0 ? (unsigned int) configured : 1;
+	}
+
+	return nrOfThreads;
+}
+
+static array_list_pt celixLauncher_createAutoStartBundles(properties_pt config) {
+	array_list_pt bundles = NULL;
+	size_t prefixLength = strlen(CELIX_LAUNCHER_AUTO_START_PREFIX);
+
+	arrayList_create(&bundles);
+
+	hash_map_iterator_pt iter = hashMapIterator_create(config);
+	while (hashMapIterator_hasNext(iter)) {
+		hash_map_entry_pt entry = hashMapIterator_nextEntry(iter);
+		const char *key = hashMapEntry_getKey(entry);
+		char *endptr = NULL;
+		long level;
+
+		// Only cosgi.auto.start.<level> entries, not the other cosgi.auto.start options
+		if (strncmp(key, CELIX_LAUNCHER_AUTO_START_PREFIX, prefixLength) != 0 || key[prefixLength] == '\0') {
+			continue;
+		}
+		level = strtol(key + prefixLength, &endptr, 10);
+		if (*endptr != '\0' || level < 0) {
+			continue;
+		}
+
+		// Keep the bundles sorted on run level, and in configured order within a run level
+		unsigned int index = 0;
+		while (index < arrayList_size(bundles) && ((struct launcher_bundle *) arrayList_get(bundles, index))->level <= level) {
+			index++;
+		}
+
+		char *autoStart = strndup(hashMapEntry_getValue(entry), 1024*10);
+		char delims[] = " ";
+		char *save_ptr = NULL;
+		char *result = strtok_r(autoStart, delims, &save_ptr);
+		while (result != NULL) {
+			struct launcher_bundle *bundle = calloc(1, sizeof(*bundle));
+			bundle->location = strdup(result);
+			bundle->level = (int) level;
+			arrayList_create(&bundle->dependents);
+			arrayList_addIndex(bundles, index++, bundle);
+			result = strtok_r(NULL, delims, &save_ptr);
+		}
+		free(autoStart);
+	}
+	hashMapIterator_destroy(iter);
+
+	return bundles;
+}
+
+static void celixLauncher_destroyAutoStartBundles(array_list_pt bundles) {
+	unsigned int i;
+	for (i = 0; i < arrayList_size(bundles); i++) {
+		struct launcher_bundle *bundle = arrayList_get(bundles, i);
+		arrayList_destroy(bundle->dependents);
+		free(bundle->location);
+		free(bundle);
+	}
+	arrayList_destroy(bundles);
+}
+
+static void celixLauncher_installBundle(struct launcher_bundle *bundle) {
+	double start = celixLauncher_now();
+	if (bundleContext_installBundle(bundle->context, bundle->location, &bundle->bundle) != CELIX_SUCCESS) {
+		printf("Could not install bundle from %s\n", bundle->location);
+		bundle->bundle = NULL;
+	}
+	bundle->installTime = celixLauncher_now() - start;
+}
+
+static void *celixLauncher_installWorker(void *data) {
+	struct launcher_installer *installer = data;
+	unsigned int index;
+
+	while ((index = __atomic_fetch_add(&installer->next, 1, __ATOMIC_SEQ_CST)) < arrayList_size(installer->bundles)) {
+		celixLauncher_installBundle(arrayList_get(installer->bundles, index));
+	}
+
+	return NULL;
+}
+
+static void celixLauncher_installBundles(bundle_context_pt context, array_list_pt bundles, unsigned int nrOfThreads) {
+	struct launcher_installer installer;
+	unsigned int i;
+
+	installer.bundles = bundles;
+	installer.next = 0;
+	for (i = 0; i < arrayList_size(bundles); i++) {
+		((struct launcher_bundle *) arrayList_get(bundles, i))->context = context;
+	}
+
+	if (nrOfThreads > arrayList_size(bundles)) {
+		nrOfThreads = arrayList_size(bundles);
+	}
+
+	if (nrOfThreads <= 1) {
+		celixLauncher_installWorker(&installer);
+	} else {
+		celix_thread_t threads[nrOfThreads];
+		for (i = 0; i < nrOfThreads; i++) {
+			celixThread_create(&threads[i], NULL, celixLauncher_installWorker, &installer);
+		}
+		for (i = 0; i < nrOfThreads; i++) {
+			celixThread_join(threads[i], NULL);
+		}
+	}
+}
+
+static void celixLauncher_addStartDependencies(array_list_pt bundles, unsigned int begin, unsigned int end) {
+	unsigned int i;
+	unsigned int j;
+
+	for (i = begin; i < end; i++) {
+		struct launcher_bundle *bundle = arrayList_get(bundles, i);
+		bundle_archive_pt archive = NULL;
+		bundle_revision_pt revision = NULL;
+		manifest_pt manifest = NULL;
+		const char *startAfter = NULL;
+
+		if (bundle->bundle == NULL
+				|| bundle_getArchive(bundle->bundle, &archive) != CELIX_SUCCESS
+				|| bundleArchive_getCurrentRevision(archive, &revision) != CELIX_SUCCESS
+				|| bundleRevision_getManifest(revision, &manifest) != CELIX_SUCCESS
+				|| (startAfter = manifest_getValue(manifest, CELIX_FRAMEWORK_BUNDLE_START_AFTER)) == NULL) {
+			continue;
+		}
+
+		// Dependencies on bundles of a lower run level are already satisfied, unknown bundles are ignored
+		char *names = strdup(startAfter);
+		char delims[] = " ,";
+		char *save_ptr = NULL;
+		char *name = strtok_r(names, delims, &save_ptr);
+		while (name != NULL) {
+			for (j = begin; j < end; j++) {
+				struct launcher_bundle *dependency = arrayList_get(bundles, j);
+				const char *symbolicName = celixLauncher_getSymbolicName(dependency);
+				if (dependency != bundle && symbolicName != NULL && strcmp(symbolicName, name) == 0
+						&& !arrayList_contains(dependency->dependents, bundle)) {
+					arrayList_add(dependency->dependents, bundle);
+					bundle->nrOfUnstartedDependencies++;
+				}
+			}
+			name = strtok_r(NULL, delims, &save_ptr);
+		}
+		free(names);
+	}
+}
+
+static const char *celixLauncher_getSymbolicName(struct launcher_bundle *bundle) {
+	module_pt module = NULL;
+	const char *symbolicName = NULL;
+
+	if (bundle->bundle != NULL && bundle_getCurrentModule(bundle->bundle, &module) == CELIX_SUCCESS) {
+		module_getSymbolicName(module, &symbolicName);
+	}
+
+	return symbolicName;
+}
+
+static void celixLauncher_startBundle(struct launcher_bundle *bundle) {
+	double start = celixLauncher_now();
+	const char *symbolicName = celixLauncher_getSymbolicName(bundle);
+
+	celix_status_t status = bundle_startWithOptions(bundle->bundle, 0);
+
+	if (status == CELIX_SUCCESS) {
+		printf("Launcher: Started bundle %s (level %i) in %.1f ms, installed in %.1f ms\n",
+				symbolicName != NULL ? symbolicName : bundle->location, bundle->level, celixLauncher_now() - start, bundle->installTime);
+	} else {
+		printf("Launcher: Could not start bundle %s (level %i)\n", symbolicName != NULL ? symbolicName : bundle->location, bundle->level);
+	}
+}
+
+static void *celixLauncher_startWorker(void *data) {
+	struct launcher_scheduler *scheduler = data;
+
+	celixThreadMutex_lock(&scheduler->mutex);
+	while (scheduler->remaining > 0) {
+		if (arrayList_isEmpty(scheduler->ready) && scheduler->running > 0) {
+			celixThreadCondition_wait(&scheduler->cond, &scheduler->mutex);
+			continue;
+		}
+
+		if (arrayList_isEmpty(scheduler->ready)) {
+			// Nothing is running and nothing is ready, so the Start-After headers form a cycle: break it in configured order
+			unsigned int i;
+			for (i = 0; i < arrayList_size(scheduler->bundles); i++) {
+				struct launcher_bundle *bundle = arrayList_get(scheduler->bundles, i);
+				if (!bundle->scheduled) {
+					printf("Launcher: Start-After cycle, starting %s without its dependencies\n", bundle->location);
+					bundle->scheduled = true;
+					arrayList_add(scheduler->ready, bundle);
+					break;
+				}
+			}
+		}
+
+		struct launcher_bundle *bundle = arrayList_remove(scheduler->ready, 0);
+		scheduler->running++;
+		celixThreadMutex_unlock(&scheduler->mutex);
+
+		celixLauncher_startBundle(bundle);
+
+		celixThreadMutex_lock(&scheduler->mutex);
+		scheduler->running--;
+		scheduler->remaining--;
+		unsigned int i;
+		for (i = 0; i < arrayList_size(bundle->dependents); i++) {
+			struct launcher_bundle *dependent = arrayList_get(bundle->dependents, i);
+			dependent->nrOfUnstartedDependencies--;
+			if (dependent->nrOfUnstartedDependencies == 0 && !dependent->scheduled) {
+				dependent->scheduled = true;
+				arrayList_add(scheduler->ready, dependent);
+			}
+		}
+		celixThreadCondition_broadcast(&scheduler->cond);
+	}
+	celixThreadMutex_unlock(&scheduler->mutex);
+
+	return NULL;
+}
+
+static void celixLauncher_startRunLevel(array_list_pt bundles, unsigned int begin, unsigned int end, unsigned int nrOfThreads) {
+	struct launcher_scheduler scheduler;
+	unsigned int i;
+
+	celixLauncher_addStartDependencies(bundles, begin, end);
+
+	celixThreadMutex_create(&scheduler.mutex, NULL);
+	celixThreadCondition_init(&scheduler.cond, NULL);
+	arrayList_create(&scheduler.bundles);
+	arrayList_create(&scheduler.ready);
+	scheduler.running = 0;
+	scheduler.remaining = 0;
+
+	for (i = begin; i < end; i++) {
+		struct launcher_bundle *bundle = arrayList_get(bundles, i);
+		// Only start the bundles which are installed correctly
+		if (bundle->bundle != NULL) {
+			arrayList_add(scheduler.bundles, bundle);
+			scheduler.remaining++;
+			if (bundle->nrOfUnstartedDependencies == 0) {
+				bundle->scheduled = true;
+				arrayList_add(scheduler.ready, bundle);
+			}
+		}
+	}
+
+	if (nrOfThreads > scheduler.remaining) {
+		nrOfThreads = scheduler.remaining;
+	}
+
+	// Without parallel start the bundles are started on the calling thread, as before
+	if (nrOfThreads <= 1) {
+		celixLauncher_startWorker(&scheduler);
+	} else {
+		celix_thread_t threads[nrOfThreads];
+		for (i = 0; i < nrOfThreads; i++) {
+			celixThread_create(&threads[i], NULL, celixLauncher_startWorker, &scheduler);
+		}
+		for (i = 0; i < nrOfThreads; i++) {
+			celixThread_join(threads[i], NULL);
+		}
+	}
+
+	arrayList_destroy(scheduler.ready);
+	arrayList_destroy(scheduler.bundles);
+	celixThreadCondition_destroy(&scheduler.cond);
+	celixThreadMutex_destroy(&scheduler.mutex);
+}
+
 void celixLauncher_waitForShutdown(framework_pt framework) {
 	framework_waitForStop(framework);
 }
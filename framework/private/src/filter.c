@@ -27,9 +27,11 @@
 #include <string.h>
 #include <stdlib.h>
 #include <ctype.h>
+#include <errno.h>
 
 #include "celix_log.h"
 #include "filter_private.h"
+#include "properties_private.h"
 
 static void filter_skipWhiteSpace(char* filterString, int* pos);
 static filter_pt filter_parseFilter(char* filterString, int* pos);
@@ -44,6 +46,17 @@ static array_list_pt filter_parseSubstring(char* filterString, int* pos);
 
 static celix_status_t filter_compare(OPERAND operand, char * string, void * value2, bool *result);
 static celix_status_t filter_compareString(OPERAND operand, char * string, void * value2, bool *result);
+static celix_status_t filter_matchTree(filter_pt filter, properties_pt properties, bool *result);
+
+static struct filter_program * filter_compile(filter_pt filter);
+static unsigned int filter_countInstructions(filter_pt filter);
+static unsigned int filter_compileInstruction(filter_pt filter, struct filter_instruction *instructions, unsigned int index);
+static bool filter_execute(const struct filter_instruction *instructions, unsigned int index, properties_pt properties);
+static int filter_compareTyped(const struct filter_instruction *instruction, const char *value);
+static bool filter_parseLong(const char *string, long *out);
+static bool filter_parseDouble(const char *string, double *out);
+static bool filter_parseVersion(const char *string, struct filter_version *out);
+static int filter_compareVersion(const struct filter_version *version, const struct filter_version *other);
 
 static void filter_skipWhiteSpace(char * filterString, int * pos) {
 	int length;
@@ -64,7 +77,8 @@ filter_pt filter_create(const char* filterString) {
 	}
 	if(filter != NULL){
 		filter->filterStr = filterStr;
-	} 
+		filter->program = filter_compile(filter);
+	}
 
 	return filter;
 }
@@ -99,6 +113,16 @@ void filter_destroy(filter_pt filter) {
 		}
 		free(filter->attribute);
 		filter->attribute = NULL;
+		if (filter->program != NULL) {
+			unsigned int i;
+			for (i = 0; i < filter->program->size; i++) {
+				if (filter->program->instructions[i].attribute != NULL) {
+					properties_releaseKey(filter->program->instructions[i].attribute);
+				}
+			}
+		}
+		free(filter->program);
+		filter->program = NULL;
 		free(filter);
 		filter = NULL;
 	}
@@ -192,7 +216,7 @@ static filter_pt filter_parseAnd(char * filterString, int * pos) {
 		operands = NULL;
 	}
 
-	filter_pt filter = (filter_pt) malloc(sizeof(*filter));
+	filter_pt filter = (filter_pt) calloc(1, sizeof(*filter));
 	filter->operand = AND;
 	filter->attribute = NULL;
 	filter->value = operands;
@@ -233,7 +257,7 @@ static filter_pt filter_parseOr(char * filterString, int * pos) {
 		operands = NULL;
 	}
 
-	filter_pt filter = (filter_pt) malloc(sizeof(*filter));
+	filter_pt filter = (filter_pt) calloc(1, sizeof(*filter));
 	filter->operand = OR;
 	filter->attribute = NULL;
 	filter->value = operands;
@@ -253,7 +277,7 @@ static filter_pt filter_parseNot(char * filterString, int * pos) {
 	child = filter_parseFilter(filterString, pos);
 
 
-	filter_pt filter = (filter_pt) malloc(sizeof(*filter));
+	filter_pt filter = (filter_pt) calloc(1, sizeof(*filter));
 	filter->operand = NOT;
 	filter->attribute = NULL;
 	filter->value = child;
@@ -271,7 +295,7 @@ static filter_pt filter_parseItem(char * filterString, int * pos) {
 	switch(filterString[*pos]) {
 		case '~': {
 			if (filterString[*pos + 1] == '=') {
-				filter_pt filter = (filter_pt) malloc(sizeof(*filter));
+				filter_pt filter = (filter_pt) calloc(1, sizeof(*filter));
 				*pos += 2;
 				filter->operand = APPROX;
 				filter->attribute = attr;
@@ -282,7 +306,7 @@ static filter_pt filter_parseItem(char * filterString, int * pos) {
 		}
 		case '>': {
 			if (filterString[*pos + 1] == '=') {
-				filter_pt filter = (filter_pt) malloc(sizeof(*filter));
+				filter_pt filter = (filter_pt) calloc(1, sizeof(*filter));
 				*pos += 2;
 				filter->operand = GREATEREQUAL;
 				filter->attribute = attr;
@@ -290,7 +314,7 @@ static filter_pt filter_parseItem(char * filterString, int * pos) {
 				return filter;
 			}
 			else {
-                filter_pt filter = (filter_pt) malloc(sizeof(*filter));
+                filter_pt filter = (filter_pt) calloc(1, sizeof(*filter));
                 *pos += 1;
                 filter->operand = GREATER;
                 filter->attribute = attr;
@@ -301,7 +325,7 @@ static filter_pt filter_parseItem(char * filterString, int * pos) {
 		}
 		case '<': {
 			if (filterString[*pos + 1] == '=') {
-				filter_pt filter = (filter_pt) malloc(sizeof(*filter));
+				filter_pt filter = (filter_pt) calloc(1, sizeof(*filter));
 				*pos += 2;
 				filter->operand = LESSEQUAL;
 				filter->attribute = attr;
@@ -309,7 +333,7 @@ static filter_pt filter_parseItem(char * filterString, int * pos) {
 				return filter;
 			}
 			else {
-                filter_pt filter = (filter_pt) malloc(sizeof(*filter));
+                filter_pt filter = (filter_pt) calloc(1, sizeof(*filter));
                 *pos += 1;
                 filter->operand = LESS;
                 filter->attribute = attr;
@@ -326,7 +350,7 @@ static filter_pt filter_parseItem(char * filterString, int * pos) {
 				*pos += 2;
 				filter_skipWhiteSpace(filterString, pos);
 				if (filterString[*pos] == ')') {
-					filter_pt filter = (filter_pt) malloc(sizeof(*filter));
+					filter_pt filter = (filter_pt) calloc(1, sizeof(*filter));
 					filter->operand = PRESENT;
 					filter->attribute = attr;
 					filter->value = NULL;
@@ -334,7 +358,7 @@ static filter_pt filter_parseItem(char * filterString, int * pos) {
 				}
 				*pos = oldPos;
 			}
-			filter = (filter_pt) malloc(sizeof(*filter));			
+			filter = (filter_pt) calloc(1, sizeof(*filter));			
 			(*pos)++;
 			subs = filter_parseSubstring(filterString, pos);
 			if(subs!=NULL){
@@ -505,6 +529,14 @@ static array_list_pt filter_parseSubstring(char * filterString, int * pos) {
 }
 
 celix_status_t filter_match(filter_pt filter, properties_pt properties, bool *result) {
+	if (filter->program != NULL) {
+		*result = filter_execute(filter->program->instructions, 0, properties);
+		return CELIX_SUCCESS;
+	}
+	return filter_matchTree(filter, properties, result);
+}
+
+static celix_status_t filter_matchTree(filter_pt filter, properties_pt properties, bool *result) {
 	switch (filter->operand) {
 		case AND: {
 			array_list_pt filters = (array_list_pt) filter->value;
@@ -512,7 +544,7 @@ celix_status_t filter_match(filter_pt filter, properties_pt properties, bool *re
 			for (i = 0; i < arrayList_size(filters); i++) {
 				filter_pt sfilter = (filter_pt) arrayList_get(filters, i);
 				bool mresult;
-				filter_match(sfilter, properties, &mresult);
+				filter_matchTree(sfilter, properties, &mresult);
 				if (!mresult) {
 					*result = 0;
 					return CELIX_SUCCESS;
@@ -527,7 +559,7 @@ celix_status_t filter_match(filter_pt filter, properties_pt properties, bool *re
 			for (i = 0; i < arrayList_size(filters); i++) {
 				filter_pt sfilter = (filter_pt) arrayList_get(filters, i);
 				bool mresult;
-				filter_match(sfilter, properties, &mresult);
+				filter_matchTree(sfilter, properties, &mresult);
 				if (mresult) {
 					*result = 1;
 					return CELIX_SUCCESS;
@@ -539,7 +571,7 @@ celix_status_t filter_match(filter_pt filter, properties_pt properties, bool *re
 		case NOT: {
 			filter_pt sfilter = (filter_pt) filter->value;
 			bool mresult;
-			filter_match(sfilter, properties, &mresult);
+			filter_matchTree(sfilter, properties, &mresult);
 			*result = !mresult;
 			return CELIX_SUCCESS;
 		}
@@ -602,17 +634,12 @@ static celix_status_t filter_compareString(OPERAND operand, char * string, void
 						}
 					} else {
 						unsigned int len = strlen(substr);
-						char * region = (char *)malloc(len+1);
-						strncpy(region, string+pos, len);
-						region[len]	= '\0';
-						if (strcmp(region, substr) == 0) {
+						if (strncmp(string+pos, substr, len) == 0) {
 							pos += len;
 						} else {
-							free(region);
 							*result = false;
 							return CELIX_SUCCESS;
 						}
-						free(region);
 					}
 				} else {
 					unsigned int len;
@@ -663,6 +690,245 @@ static celix_status_t filter_compareString(OPERAND operand, char * string, void
 	return CELIX_SUCCESS;
 }
 
+static struct filter_program * filter_compile(filter_pt filter) {
+	unsigned int size = filter_countInstructions(filter);
+	struct filter_program *program = calloc(1, sizeof(*program) + size * sizeof(struct filter_instruction));
+	if (program != NULL) {
+		program->size = size;
+		filter_compileInstruction(filter, program->instructions, 0);
+	} else {
+		fw_log(logger, OSGI_FRAMEWORK_LOG_WARNING, "Cannot compile filter, falling back to matching the filter tree.");
+	}
+	return program;
+}
+
+static unsigned int filter_countInstructions(filter_pt filter) {
+	unsigned int count = 1;
+	if (filter->operand == AND || filter->operand == OR) {
+		array_list_pt filters = (array_list_pt) filter->value;
+		unsigned int i;
+		for (i = 0; i < arrayList_size(filters); i++) {
+			count += filter_countInstructions((filter_pt) arrayList_get(filters, i));
+		}
+	} else if (filter->operand == NOT) {
+		count += filter_countInstructions((filter_pt) filter->value);
+	}
+	return count;
+}
+
+static unsigned int filter_compileInstruction(filter_pt filter, struct filter_instruction *instructions, unsigned int index) {
+	struct filter_instruction *instruction = &instructions[index];
+	unsigned int next = index + 1;
+
+	instruction->operand = filter->operand;
+	//interned, so the property lookup matches the key on pointer equality
+	instruction->attribute = filter->attribute == NULL ? NULL : properties_internKey(filter->attribute);
+	instruction->value = filter->value;
+	instruction->valueType = FILTER_VALUE_STRING;
+
+	switch (filter->operand) {
+		case AND:
+		case OR: {
+			array_list_pt filters = (array_list_pt) filter->value;
+			unsigned int i;
+			for (i = 0; i < arrayList_size(filters); i++) {
+				next = filter_compileInstruction((filter_pt) arrayList_get(filters, i), instructions, next);
+			}
+			instruction->nrOfOperands = arrayList_size(filters);
+			break;
+		}
+		case NOT: {
+			next = filter_compileInstruction((filter_pt) filter->value, instructions, next);
+			instruction->nrOfOperands = 1;
+			break;
+		}
+		case GREATER:
+		case GREATEREQUAL:
+		case LESS:
+		case LESSEQUAL: {
+			//parse the operand once, the property value is compared with the same type if possible
+			const char *value = (const char *) filter->value;
+			if (filter_parseLong(value, &instruction->typedValue.longValue)) {
+				instruction->valueType = FILTER_VALUE_LONG;
+			} else if (filter_parseDouble(value, &instruction->typedValue.doubleValue)) {
+				instruction->valueType = FILTER_VALUE_DOUBLE;
+			} else if (filter_parseVersion(value, &instruction->typedValue.version)) {
+				instruction->valueType = FILTER_VALUE_VERSION;
+			}
+			break;
+		}
+		default:
+			break;
+	}
+
+	instruction->next = next;
+	return next;
+}
+
+static bool filter_execute(const struct filter_instruction *instructions, unsigned int index, properties_pt properties) {
+	const struct filter_instruction *instruction = &instructions[index];
+
+	switch (instruction->operand) {
+		case AND: {
+			unsigned int operand = index + 1;
+			unsigned int i;
+			for (i = 0; i < instruction->nrOfOperands; i++) {
+				if (!filter_execute(instructions, operand, properties)) {
+					return false;
+				}
+				operand = instructions[operand].next;
+			}
+			return true;
+		}
+		case OR: {
+			unsigned int operand = index + 1;
+			unsigned int i;
+			for (i = 0; i < instruction->nrOfOperands; i++) {
+				if (filter_execute(instructions, operand, properties)) {
+					return true;
+				}
+				operand = instructions[operand].next;
+			}
+			return false;
+		}
+		case NOT:
+			return !filter_execute(instructions, index + 1, properties);
+		case PRESENT:
+			return properties != NULL && properties_get(properties, (char *) instruction->attribute) != NULL;
+		case EQUAL:
+		case APPROX: {
+			const char *value = (properties == NULL) ? NULL : properties_get(properties, (char *) instruction->attribute);
+			return value != NULL && strcmp(value, (const char *) instruction->value) == 0;
+		}
+		case SUBSTRING: {
+			bool result = false;
+			char *value = (properties == NULL) ? NULL : (char *) properties_get(properties, (char *) instruction->attribute);
+			filter_compare(SUBSTRING, value, instruction->value, &result);
+			return result;
+		}
+		case GREATER:
+		case GREATEREQUAL:
+		case LESS:
+		case LESSEQUAL: {
+			const char *value = (properties == NULL) ? NULL : properties_get(properties, (char *) instruction->attribute);
+			if (value == NULL) {
+				return false;
+			}
+			int cmp = filter_compareTyped(instruction, value);
+			switch (instruction->operand) {
+				case GREATER:
+					return cmp > 0;
+				case GREATEREQUAL:
+					return cmp >= 0;
+				case LESS:
+					return cmp < 0;
+				default:
+					return cmp <= 0;
+			}
+		}
+	}
+	return false;
+}
+
+static int filter_compareTyped(const struct filter_instruction *instruction, const char *value) {
+	switch (instruction->valueType) {
+		case FILTER_VALUE_LONG: {
+			long longValue;
+			double doubleValue;
+			if (filter_parseLong(value, &longValue)) {
+				return longValue < instruction->typedValue.longValue ? -1 : longValue > instruction->typedValue.longValue;
+			} else if (filter_parseDouble(value, &doubleValue)) {
+				double other = (double) instruction->typedValue.longValue;
+				return doubleValue < other ? -1 : doubleValue > other;
+			}
+			break;
+		}
+		case FILTER_VALUE_DOUBLE: {
+			double doubleValue;
+			if (filter_parseDouble(value, &doubleValue)) {
+				return doubleValue < instruction->typedValue.doubleValue ? -1 : doubleValue > instruction->typedValue.doubleValue;
+			}
+			break;
+		}
+		case FILTER_VALUE_VERSION: {
+			struct filter_version version;
+			if (filter_parseVersion(value, &version)) {
+				return filter_compareVersion(&version, &instruction->typedValue.version);
+			}
+			break;
+		}
+		case FILTER_VALUE_STRING:
+			break;
+	}
+	//not comparable as typed value, fall back to a string compare
+	return strcmp(value, (const char *) instruction->value);
+}
+
+static bool filter_parseLong(const char *string, long *out) {
+	char *end = NULL;
+	errno = 0;
+	long value = strtol(string, &end, 10);
+	if (end == string || *end != '\0' || errno == ERANGE) {
+		return false;
+	}
+	*out = value;
+	return true;
+}
+
+static bool filter_parseDouble(const char *string, double *out) {
+	char *end = NULL;
+	errno = 0;
+	double value = strtod(string, &end);
+	if (end == string || *end != '\0' || errno == ERANGE) {
+		return false;
+	}
+	*out = value;
+	return true;
+}
+
+static bool filter_parseVersion(const char *string, struct filter_version *out) {
+	//<major>[.<minor>[.<micro>[.<qualifier>]]], parsed without allocating
+	int segments[3] = {0, 0, 0};
+	const char *pos = string;
+	const char *qualifier = "";
+	int i;
+
+	for (i = 0; i < 3; i++) {
+		char *end = NULL;
+		if (!isdigit((unsigned char) *pos)) {
+			return false;
+		}
+		segments[i] = (int) strtol(pos, &end, 10);
+		pos = end;
+		if (*pos == '\0') {
+			break;
+		} else if (*pos != '.') {
+			return false;
+		}
+		pos++;
+		if (i == 2) {
+			qualifier = pos;
+		}
+	}
+
+	out->major = segments[0];
+	out->minor = segments[1];
+	out->micro = segments[2];
+	out->qualifier = qualifier;
+	return true;
+}
+
+static int filter_compareVersion(const struct filter_version *version, const struct filter_version *other) {
+	if (version->major != other->major) {
+		return version->major < other->major ? -1 : 1;
+	} else if (version->minor != other->minor) {
+		return version->minor < other->minor ? -1 : 1;
+	} else if (version->micro != other->micro) {
+		return version->micro < other->micro ? -1 : 1;
+	}
+	return strcmp(version->qualifier, other->qualifier);
+}
+
 celix_status_t filter_getString(filter_pt filter, const char **filterStr) {
 	if (filter != NULL) {
 		*filterStr = filter->filterStr;
@@ -670,6 +936,26 @@ celix_status_t filter_getString(filter_pt filter, const char **filterStr) {
 	return CELIX_SUCCESS;
 }
 
+/*
+ * Returns the value the attribute must be equal to for the filter to match, e.g. 'A' for (objectClass=A)
+ * or (&(objectClass=A)(x>1)). value is set to NULL if the filter can match other values as well.
+ */
+celix_status_t filter_getRequiredEqualValue(filter_pt filter, const char* attribute, const char** value) {
+	*value = NULL;
+	if (filter != NULL && attribute != NULL) {
+		if (filter->operand == EQUAL && strcmp(filter->attribute, attribute) == 0) {
+			*value = (const char *) filter->value;
+		} else if (filter->operand == AND) {
+			array_list_pt filters = (array_list_pt) filter->value;
+			unsigned int i;
+			for (i = 0; i < arrayList_size(filters) && *value == NULL; i++) {
+				filter_getRequiredEqualValue((filter_pt) arrayList_get(filters, i), attribute, value);
+			}
+		}
+	}
+	return CELIX_SUCCESS;
+}
+
 celix_status_t filter_match_filter(filter_pt src, filter_pt dest, bool *result) {
 	char *srcStr = NULL;
 	char *destStr = NULL;
@@ -81,7 +81,7 @@ celix_status_t fw_populateDependentGraph(framework_pt framework, bundle_pt expor
 
 celix_status_t fw_fireBundleEvent(framework_pt framework, bundle_event_type_e, bundle_pt bundle);
 celix_status_t fw_fireFrameworkEvent(framework_pt framework, framework_event_type_e eventType, bundle_pt bundle, celix_status_t errorCode);
-static void *fw_eventDispatcher(void *fw);
+static void *fw_eventDispatcher(void *data);
 
 celix_status_t fw_invokeBundleListener(framework_pt framework, bundle_listener_pt listener, bundle_event_pt event, bundle_pt bundle);
 celix_status_t fw_invokeFrameworkListener(framework_pt framework, framework_listener_pt listener, framework_event_pt event, bundle_pt bundle);
@@ -110,13 +110,35 @@ struct fw_serviceListener {
 	service_listener_pt listener;
 	filter_pt filter;
     array_list_pt retainedReferences;
+
+    unsigned long id; //increasing in order of addition, used to keep the notification order
+    char *objectClass; //objectClass used to index the listener, NULL if not indexed
 };
 
 typedef struct fw_serviceListener * fw_service_listener_pt;
 
+static void fw_indexServiceListener(framework_pt framework, fw_service_listener_pt listener);
+static void fw_unindexServiceListener(framework_pt framework, fw_service_listener_pt listener);
+static void fw_serviceChangedForListener(framework_pt framework, fw_service_listener_pt element, service_event_type_e eventType, service_registration_pt registration, properties_pt props, properties_pt oldprops);
+
+//a thread waiting for the global lock, lives on the stack of that thread while it is in globalLockWaitersList
+struct fw_globalLockWaiter {
+	celix_thread_t thread;
+	bool interrupted; //set by the holder of the global lock which needs a bundle locked by this thread
+};
+
+//delivery state of a bundle/framework listener, protected by the bundleListenerLock
+struct fw_listenerUse {
+	unsigned int useCount; //the listener list and every dispatch in progress hold a reference
+	bool removed; //never invoked again once set
+	bool invoking;
+};
+
 struct fw_bundleListener {
 	bundle_pt bundle;
 	bundle_listener_pt listener;
+	unsigned int dispatcher;
+	struct fw_listenerUse use;
 };
 
 typedef struct fw_bundleListener * fw_bundle_listener_pt;
@@ -124,6 +146,8 @@ typedef struct fw_bundleListener * fw_bundle_listener_pt;
 struct fw_frameworkListener {
 	bundle_pt bundle;
 	framework_listener_pt listener;
+	unsigned int dispatcher;
+	struct fw_listenerUse use;
 };
 
 typedef struct fw_frameworkListener * fw_framework_listener_pt;
@@ -138,7 +162,7 @@ typedef enum event_type event_type_e;
 
 struct request {
 	event_type_e type;
-	array_list_pt listeners;
+	unsigned int refCount; //number of dispatchers which still have to handle the request
 
 	int eventType;
 	long bundleId;
@@ -151,6 +175,34 @@ struct request {
 
 typedef struct request *request_pt;
 
+#define FW_DEFAULT_EVENT_DISPATCHERS 4
+#define FW_EVENT_QUEUE_INITIAL_CAPACITY 16
+
+struct fw_eventDispatcher {
+	framework_pt framework;
+	celix_thread_t thread;
+
+	celix_thread_mutex_t lock; //protects the queue
+	celix_thread_cond_t cond;
+	struct fw_eventDispatcher *waitingOn; //dispatcher whose listener this one waits for, protected by the bundleListenerLock
+
+	//FIFO ring buffer of requests
+	request_pt *queue;
+	unsigned int capacity;
+	unsigned int head;
+	unsigned int size;
+};
+
+static celix_status_t fw_createEventDispatchers(framework_pt framework);
+static void fw_stopEventDispatchers(framework_pt framework);
+static void fw_destroyEventDispatchers(framework_pt framework);
+static celix_status_t fw_enqueueRequest(framework_pt framework, request_pt request);
+static void fw_releaseRequest(request_pt request);
+static void fw_dispatchRequest(struct fw_eventDispatcher *dispatcher, request_pt request);
+static bool fw_beginListenerDelivery(framework_pt framework, struct fw_listenerUse *use);
+static bool fw_endListenerDelivery(framework_pt framework, struct fw_listenerUse *use);
+static bool fw_removeListenerUse(framework_pt framework, struct fw_listenerUse *use, unsigned int dispatcherIdx);
+
 framework_logger_pt logger;
 
 //TODO introduce a counter + mutex to control the freeing of the logger when mutiple threads are running a framework.
@@ -212,14 +264,12 @@ celix_status_t framework_create(framework_pt *framework, properties_pt config) {
         status = CELIX_DO_IF(status, celixThreadMutex_create(&(*framework)->installedBundleMapLock, NULL));
         status = CELIX_DO_IF(status, celixThreadMutex_create(&(*framework)->bundleLock, NULL));
         status = CELIX_DO_IF(status, celixThreadMutex_create(&(*framework)->installRequestLock, NULL));
-        status = CELIX_DO_IF(status, celixThreadMutex_create(&(*framework)->dispatcherLock, NULL));
         status = CELIX_DO_IF(status, celixThreadMutex_create(&(*framework)->bundleListenerLock, NULL));
-        status = CELIX_DO_IF(status, celixThreadCondition_init(&(*framework)->dispatcher, NULL));
+        status = CELIX_DO_IF(status, celixThreadCondition_init(&(*framework)->listenerDelivered, NULL));
         if (status == CELIX_SUCCESS) {
             (*framework)->bundle = NULL;
             (*framework)->installedBundleMap = NULL;
             (*framework)->registry = NULL;
-            (*framework)->interrupted = false;
             (*framework)->shutdown = false;
             (*framework)->globalLockWaitersList = NULL;
             (*framework)->globalLockCount = 0;
@@ -228,9 +278,14 @@ celix_status_t framework_create(framework_pt *framework, properties_pt config) {
             (*framework)->cache = NULL;
             (*framework)->installRequestMap = hashMap_create(utils_stringHash, utils_stringHash, utils_stringEquals, utils_stringEquals);
             (*framework)->serviceListeners = NULL;
+            (*framework)->serviceListenersByObjectClass = NULL;
+            (*framework)->unindexedServiceListeners = NULL;
+            (*framework)->nextServiceListenerId = 0UL;
             (*framework)->bundleListeners = NULL;
             (*framework)->frameworkListeners = NULL;
-            (*framework)->requests = NULL;
+            (*framework)->dispatchers = NULL;
+            (*framework)->nrOfDispatchers = 0;
+            (*framework)->nextDispatcher = 0;
             (*framework)->configurationMap = config;
             (*framework)->logger = logger;
 
@@ -311,6 +366,18 @@ celix_status_t framework_destroy(framework_pt framework) {
     if (framework->serviceListeners != NULL) {
         arrayList_destroy(framework->serviceListeners);
     }
+    if (framework->serviceListenersByObjectClass != NULL) {
+        hash_map_iterator_pt iter = hashMapIterator_create(framework->serviceListenersByObjectClass);
+        while (hashMapIterator_hasNext(iter)) {
+            array_list_pt listeners = hashMapIterator_nextValue(iter);
+            arrayList_destroy(listeners);
+        }
+        hashMapIterator_destroy(iter);
+        hashMap_destroy(framework->serviceListenersByObjectClass, true, false);
+    }
+    if (framework->unindexedServiceListeners != NULL) {
+        arrayList_destroy(framework->unindexedServiceListeners);
+    }
     if (framework->bundleListeners) {
         arrayList_destroy(framework->bundleListeners);
     }
@@ -318,23 +385,15 @@ celix_status_t framework_destroy(framework_pt framework) {
         arrayList_destroy(framework->frameworkListeners);
     }
 
-	if(framework->requests){
-	    int i;
-	    for (i = 0; i < arrayList_size(framework->requests); i++) {
-	        request_pt request = arrayList_get(framework->requests, i);
-	        free(request);
-	    }
-	    arrayList_destroy(framework->requests);
-	}
+	fw_destroyEventDispatchers(framework);
 	if(framework->installedBundleMap!=NULL){
 		hashMap_destroy(framework->installedBundleMap, true, false);
 	}
 
 	bundleCache_destroy(&framework->cache);
 
-	celixThreadCondition_destroy(&framework->dispatcher);
+	celixThreadCondition_destroy(&framework->listenerDelivered);
 	celixThreadMutex_destroy(&framework->bundleListenerLock);
-	celixThreadMutex_destroy(&framework->dispatcherLock);
 	celixThreadMutex_destroy(&framework->installRequestLock);
 	celixThreadMutex_destroy(&framework->bundleLock);
 	celixThreadMutex_destroy(&framework->installedBundleMapLock);
@@ -364,10 +423,13 @@ celix_status_t fw_init(framework_pt framework) {
 	celix_status_t status = CELIX_SUCCESS;
 	status = CELIX_DO_IF(status, framework_acquireBundleLock(framework, framework->bundle, OSGI_FRAMEWORK_BUNDLE_INSTALLED|OSGI_FRAMEWORK_BUNDLE_RESOLVED|OSGI_FRAMEWORK_BUNDLE_STARTING|OSGI_FRAMEWORK_BUNDLE_ACTIVE));
 	status = CELIX_DO_IF(status, arrayList_create(&framework->serviceListeners));
+	status = CELIX_DO_IF(status, arrayList_create(&framework->unindexedServiceListeners));
+	if (status == CELIX_SUCCESS) {
+	    framework->serviceListenersByObjectClass = hashMap_create(utils_stringHash, NULL, utils_stringEquals, NULL);
+	}
 	status = CELIX_DO_IF(status, arrayList_create(&framework->bundleListeners));
 	status = CELIX_DO_IF(status, arrayList_create(&framework->frameworkListeners));
-	status = CELIX_DO_IF(status, arrayList_create(&framework->requests));
-	status = CELIX_DO_IF(status, celixThread_create(&framework->dispatcherThread, NULL, fw_eventDispatcher, framework));
+	status = CELIX_DO_IF(status, fw_createEventDispatchers(framework));
 	status = CELIX_DO_IF(status, bundle_getState(framework->bundle, &state));
 	if (status == CELIX_SUCCESS) {
 	    if ((state == OSGI_FRAMEWORK_BUNDLE_INSTALLED) || (state == OSGI_FRAMEWORK_BUNDLE_RESOLVED)) {
@@ -662,8 +724,17 @@ celix_status_t fw_startBundle(framework_pt framework, bundle_pt bundle, int opti
 	char *error = NULL;
 	const char *name = NULL;
 
-	status = CELIX_DO_IF(status, framework_acquireBundleLock(framework, bundle, OSGI_FRAMEWORK_BUNDLE_INSTALLED|OSGI_FRAMEWORK_BUNDLE_RESOLVED|OSGI_FRAMEWORK_BUNDLE_STARTING|OSGI_FRAMEWORK_BUNDLE_ACTIVE));
-	status = CELIX_DO_IF(status, bundle_getState(bundle, &state));
+	for (;;) {
+		status = CELIX_DO_IF(status, framework_acquireBundleLock(framework, bundle, OSGI_FRAMEWORK_BUNDLE_INSTALLED|OSGI_FRAMEWORK_BUNDLE_RESOLVED|OSGI_FRAMEWORK_BUNDLE_STARTING|OSGI_FRAMEWORK_BUNDLE_ACTIVE));
+		status = CELIX_DO_IF(status, bundle_getState(bundle, &state));
+		//the resolver is shared by all bundles, which can be started concurrently
+		if (status != CELIX_SUCCESS || state != OSGI_FRAMEWORK_BUNDLE_INSTALLED || framework_acquireGlobalLock(framework)) {
+			break;
+		}
+		//interrupted because the holder of the global lock (a concurrent resolve) needs the lock of this
+		//bundle: give it up and start over, the bundle may be resolved by then
+		framework_releaseBundleLock(framework, bundle);
+	}
 
 	if (status == CELIX_SUCCESS) {
 	    switch (state) {
@@ -688,15 +759,18 @@ celix_status_t fw_startBundle(framework_pt framework, bundle_pt bundle, int opti
             case OSGI_FRAMEWORK_BUNDLE_INSTALLED:
                 bundle_getCurrentModule(bundle, &module);
                 module_getSymbolicName(module, &name);
+                //the global lock is taken above
                 if (!module_isResolved(module)) {
                     wires = resolver_resolve(module);
                     if (wires == NULL) {
+                        framework_releaseGlobalLock(framework);
                         framework_releaseBundleLock(framework, bundle);
                         return CELIX_BUNDLE_EXCEPTION;
                     }
                     framework_markResolvedModules(framework, wires);
 
                 }
+                framework_releaseGlobalLock(framework);
                 /* no break */
             case OSGI_FRAMEWORK_BUNDLE_RESOLVED:
                 module = NULL;
@@ -1364,13 +1438,10 @@ celix_status_t fw_getServiceReferences(framework_pt framework, array_list_pt *re
 	if (status == CELIX_SUCCESS) {
         for (refIdx = 0; (*references != NULL) && refIdx < arrayList_size(*references); refIdx++) {
             service_reference_pt ref = (service_reference_pt) arrayList_get(*references, refIdx);
-            service_registration_pt reg = NULL;
-            const char* serviceName;
-            properties_pt props = NULL;
-            status = CELIX_DO_IF(status, serviceReference_getServiceRegistration(ref, &reg));
-            status = CELIX_DO_IF(status, serviceRegistration_getProperties(reg, &props));
-            if (status == CELIX_SUCCESS) {
-                serviceName = properties_get(props, OSGI_FRAMEWORK_OBJECTCLASS);
+            const char* serviceName = NULL;
+            //read through the reference, the registration could be unregistered concurrently
+            status = CELIX_DO_IF(status, serviceReference_getProperty(ref, OSGI_FRAMEWORK_OBJECTCLASS, &serviceName));
+            if (status == CELIX_SUCCESS && serviceName != NULL) {
                 if (!serviceReference_isAssignableTo(ref, bundle, serviceName)) {
                     arrayList_remove(*references, refIdx);
                     refIdx--;
@@ -1423,8 +1494,10 @@ void fw_addServiceListener(framework_pt framework, bundle_pt bundle, service_lis
 		fwListener->filter = NULL;
 	}
 	fwListener->listener = listener;
+	fwListener->id = framework->nextServiceListenerId++;
 
 	arrayList_add(framework->serviceListeners, fwListener);
+	fw_indexServiceListener(framework, fwListener);
 
 	serviceRegistry_getListenerHooks(framework->registry, framework->bundle, &listenerHooks);
 
@@ -1484,6 +1557,7 @@ void fw_removeServiceListener(framework_pt framework, bundle_pt bundle, service_
 
 			arrayList_remove(framework->serviceListeners, i);
 			i--;
+			fw_unindexServiceListener(framework, element);
             
             //unregistering retained service references. For these refs a unregister event will not be triggered.
             int k;
@@ -1542,10 +1616,14 @@ celix_status_t fw_addBundleListener(framework_pt framework, bundle_pt bundle, bu
 	} else {
 		bundleListener->listener = listener;
 		bundleListener->bundle = bundle;
+		bundleListener->use.useCount = 1;
+		bundleListener->use.removed = false;
+		bundleListener->use.invoking = false;
 
 		if (celixThreadMutex_lock(&framework->bundleListenerLock) != CELIX_SUCCESS) {
 			status = CELIX_FRAMEWORK_EXCEPTION;
 		} else {
+			bundleListener->dispatcher = framework->nrOfDispatchers > 0 ? framework->nextDispatcher++ % framework->nrOfDispatchers : 0;
 			arrayList_add(framework->bundleListeners, bundleListener);
 
 			if (celixThreadMutex_unlock(&framework->bundleListenerLock)) {
@@ -1564,6 +1642,8 @@ celix_status_t fw_removeBundleListener(framework_pt framework, bundle_pt bundle,
 
 	unsigned int i;
 	fw_bundle_listener_pt bundleListener;
+	fw_bundle_listener_pt removed = NULL;
+	bool last = false;
 
 	if (celixThreadMutex_lock(&framework->bundleListenerLock) != CELIX_SUCCESS) {
 		status = CELIX_FRAMEWORK_EXCEPTION;
@@ -1573,17 +1653,22 @@ celix_status_t fw_removeBundleListener(framework_pt framework, bundle_pt bundle,
 			bundleListener = (fw_bundle_listener_pt) arrayList_get(framework->bundleListeners, i);
 			if (bundleListener->listener == listener && bundleListener->bundle == bundle) {
 				arrayList_remove(framework->bundleListeners, i);
-
-				bundleListener->bundle = NULL;
-				bundleListener->listener = NULL;
-				free(bundleListener);
+				removed = bundleListener;
+				break;
 			}
 		}
+		if (removed != NULL) {
+			last = fw_removeListenerUse(framework, &removed->use, removed->dispatcher);
+		}
 		if (celixThreadMutex_unlock(&framework->bundleListenerLock)) {
 			status = CELIX_FRAMEWORK_EXCEPTION;
 		}
 	}
 
+	if (last) {
+		free(removed);
+	}
+
 	framework_logIfError(framework->logger, status, NULL, "Failed to remove bundle listener");
 
 	return status;
@@ -1599,8 +1684,20 @@ celix_status_t fw_addFrameworkListener(framework_pt framework, bundle_pt bundle,
 	} else {
 		frameworkListener->listener = listener;
 		frameworkListener->bundle = bundle;
+		frameworkListener->use.useCount = 1;
+		frameworkListener->use.removed = false;
+		frameworkListener->use.invoking = false;
+
+		if (celixThreadMutex_lock(&framework->bundleListenerLock) != CELIX_SUCCESS) {
+			status = CELIX_FRAMEWORK_EXCEPTION;
+		} else {
+			frameworkListener->dispatcher = framework->nrOfDispatchers > 0 ? framework->nextDispatcher++ % framework->nrOfDispatchers : 0;
+			arrayList_add(framework->frameworkListeners, frameworkListener);
 
-		arrayList_add(framework->frameworkListeners, frameworkListener);
+			if (celixThreadMutex_unlock(&framework->bundleListenerLock)) {
+				status = CELIX_FRAMEWORK_EXCEPTION;
+			}
+		}
 	}
 
 	framework_logIfError(framework->logger, status, NULL, "Failed to add framework listener");
@@ -1613,95 +1710,193 @@ celix_status_t fw_removeFrameworkListener(framework_pt framework, bundle_pt bund
 
 	unsigned int i;
 	fw_framework_listener_pt frameworkListener;
+	fw_framework_listener_pt removed = NULL;
+	bool last = false;
 
-	for (i = 0; i < arrayList_size(framework->frameworkListeners); i++) {
-		frameworkListener = (fw_framework_listener_pt) arrayList_get(framework->frameworkListeners, i);
-		if (frameworkListener->listener == listener && frameworkListener->bundle == bundle) {
-			arrayList_remove(framework->frameworkListeners, i);
-
-			frameworkListener->bundle = NULL;
-            frameworkListener->listener = NULL;
-            free(frameworkListener);
+	if (celixThreadMutex_lock(&framework->bundleListenerLock) != CELIX_SUCCESS) {
+		status = CELIX_FRAMEWORK_EXCEPTION;
+	} else {
+		for (i = 0; i < arrayList_size(framework->frameworkListeners); i++) {
+			frameworkListener = (fw_framework_listener_pt) arrayList_get(framework->frameworkListeners, i);
+			if (frameworkListener->listener == listener && frameworkListener->bundle == bundle) {
+				arrayList_remove(framework->frameworkListeners, i);
+				removed = frameworkListener;
+				break;
+			}
+		}
+		if (removed != NULL) {
+			last = fw_removeListenerUse(framework, &removed->use, removed->dispatcher);
+		}
+		if (celixThreadMutex_unlock(&framework->bundleListenerLock)) {
+			status = CELIX_FRAMEWORK_EXCEPTION;
 		}
 	}
 
+	if (last) {
+		free(removed);
+	}
+
 	framework_logIfError(framework->logger, status, NULL, "Failed to remove framework listener");
 
 	return status;
 }
 
+static void fw_indexServiceListener(framework_pt framework, fw_service_listener_pt listener) {
+    const char *objectClass = NULL;
+    filter_getRequiredEqualValue(listener->filter, OSGI_FRAMEWORK_OBJECTCLASS, &objectClass);
+
+    if (objectClass != NULL) {
+        array_list_pt listeners = hashMap_get(framework->serviceListenersByObjectClass, objectClass);
+        if (listeners == NULL) {
+            arrayList_create(&listeners);
+            hashMap_put(framework->serviceListenersByObjectClass, strdup(objectClass), listeners);
+        }
+        listener->objectClass = strdup(objectClass);
+        arrayList_add(listeners, listener);
+    } else {
+        listener->objectClass = NULL;
+        arrayList_add(framework->unindexedServiceListeners, listener);
+    }
+}
+
+static void fw_unindexServiceListener(framework_pt framework, fw_service_listener_pt listener) {
+    if (listener->objectClass != NULL) {
+        //note empty lists are kept, a service event could be dispatching over it
+        array_list_pt listeners = hashMap_get(framework->serviceListenersByObjectClass, listener->objectClass);
+        if (listeners != NULL) {
+            arrayList_removeElement(listeners, listener);
+        }
+        free(listener->objectClass);
+        listener->objectClass = NULL;
+    } else {
+        arrayList_removeElement(framework->unindexedServiceListeners, listener);
+    }
+}
+
 void fw_serviceChanged(framework_pt framework, service_event_type_e eventType, service_registration_pt registration, properties_pt oldprops) {
+    properties_pt props = NULL;
+    const char *objectClass = NULL;
+    const char *oldObjectClass = NULL;
+    array_list_pt candidates[3];
+    unsigned int indices[3] = {0, 0, 0};
+    unsigned int nrOfCandidateLists = 0;
     unsigned int i;
-    fw_service_listener_pt element;
-
-    if (arrayList_size(framework->serviceListeners) > 0) {
-        for (i = 0; i < arrayList_size(framework->serviceListeners); i++) {
-            int matched = 0;
-            properties_pt props = NULL;
-            bool matchResult = false;
-
-            element = (fw_service_listener_pt) arrayList_get(framework->serviceListeners, i);
-            serviceRegistration_getProperties(registration, &props);
-            if (element->filter != NULL) {
-                filter_match(element->filter, props, &matchResult);
-            }
-            matched = (element->filter == NULL) || matchResult;
-            if (matched) {
-                service_reference_pt reference = NULL;
-                service_event_pt event;
-
-                event = (service_event_pt) malloc(sizeof (*event));
-
-                serviceRegistry_getServiceReference(framework->registry, element->bundle, registration, &reference);
-                
-                //NOTE: that you are never sure that the UNREGISTERED event will by handle by an service_listener. listener could be gone
-                //Every reference retained is therefore stored and called when a service listener is removed from the framework.
-                if (eventType == OSGI_FRAMEWORK_SERVICE_EVENT_REGISTERED) {
-                    serviceRegistry_retainServiceReference(framework->registry, element->bundle, reference);
-                    arrayList_add(element->retainedReferences, reference); //TODO improve by using set (or hashmap) instead of list
-                }
 
-                event->type = eventType;
-                event->reference = reference;
+    if (arrayList_size(framework->serviceListeners) == 0) {
+        return;
+    }
 
-                element->listener->serviceChanged(element->listener, event);
+    //only listeners indexed on the objectClass of the service (or its old objectClass for a modified event)
+    //and listeners which could not be indexed can match.
+    serviceRegistration_getProperties(registration, &props);
+    objectClass = props == NULL ? NULL : properties_get(props, (char *) OSGI_FRAMEWORK_OBJECTCLASS);
+    if (eventType == OSGI_FRAMEWORK_SERVICE_EVENT_MODIFIED && oldprops != NULL) {
+        oldObjectClass = properties_get(oldprops, (char *) OSGI_FRAMEWORK_OBJECTCLASS);
+    }
 
-                serviceRegistry_ungetServiceReference(framework->registry, element->bundle, reference);
-                
-                if (eventType == OSGI_FRAMEWORK_SERVICE_EVENT_UNREGISTERING) {
-                    //if service listener was active when service was registered, release the retained reference
-                    if (arrayList_removeElement(element->retainedReferences, reference)) {
-                        serviceRegistry_ungetServiceReference(framework->registry, element->bundle, reference); // decrease retain counter
-                    }
-                }
-                
-                free(event);
-
-            } else if (eventType == OSGI_FRAMEWORK_SERVICE_EVENT_MODIFIED) {
-                bool matchResult = false;
-                int matched = 0;
-                if (element->filter != NULL) {
-                    filter_match(element->filter, oldprops, &matchResult);
+    candidates[nrOfCandidateLists++] = framework->unindexedServiceListeners;
+    if (objectClass != NULL) {
+        array_list_pt listeners = hashMap_get(framework->serviceListenersByObjectClass, objectClass);
+        if (listeners != NULL) {
+            candidates[nrOfCandidateLists++] = listeners;
+        }
+    }
+    if (oldObjectClass != NULL && (objectClass == NULL || strcmp(objectClass, oldObjectClass) != 0)) {
+        array_list_pt listeners = hashMap_get(framework->serviceListenersByObjectClass, oldObjectClass);
+        if (listeners != NULL) {
+            candidates[nrOfCandidateLists++] = listeners;
+        }
+    }
+
+    //merge the candidate lists on listener id, so that listeners are notified in order of addition
+    while (true) {
+        fw_service_listener_pt element = NULL;
+        unsigned int selected = 0;
+
+        for (i = 0; i < nrOfCandidateLists; i++) {
+            if (indices[i] < arrayList_size(candidates[i])) {
+                fw_service_listener_pt candidate = arrayList_get(candidates[i], indices[i]);
+                if (element == NULL || candidate->id < element->id) {
+                    element = candidate;
+                    selected = i;
                 }
-                matched = (element->filter == NULL) || matchResult;
-                if (matched) {
-                    service_reference_pt reference = NULL;
-                    service_event_pt endmatch = (service_event_pt) malloc(sizeof (*endmatch));
+            }
+        }
 
-                    serviceRegistry_getServiceReference(framework->registry, element->bundle, registration, &reference);
+        if (element == NULL) {
+            break;
+        }
+
+        fw_serviceChangedForListener(framework, element, eventType, registration, props, oldprops);
+
+        //the listener could be removed during the callback, only advance if it is still in place
+        if (indices[selected] < arrayList_size(candidates[selected]) && arrayList_get(candidates[selected], indices[selected]) == element) {
+            indices[selected] += 1;
+        }
+    }
+}
 
-                    endmatch->reference = reference;
-                    endmatch->type = OSGI_FRAMEWORK_SERVICE_EVENT_MODIFIED_ENDMATCH;
-                    element->listener->serviceChanged(element->listener, endmatch);
+static void fw_serviceChangedForListener(framework_pt framework, fw_service_listener_pt element, service_event_type_e eventType, service_registration_pt registration, properties_pt props, properties_pt oldprops) {
+    int matched = 0;
+    bool matchResult = false;
 
-                    serviceRegistry_ungetServiceReference(framework->registry, element->bundle, reference);
-                    free(endmatch);
+    if (element->filter != NULL) {
+        filter_match(element->filter, props, &matchResult);
+    }
+    matched = (element->filter == NULL) || matchResult;
+    if (matched) {
+        service_reference_pt reference = NULL;
+        service_event_pt event;
 
-                }
+        event = (service_event_pt) malloc(sizeof (*event));
+
+        serviceRegistry_getServiceReference(framework->registry, element->bundle, registration, &reference);
+
+        //NOTE: that you are never sure that the UNREGISTERED event will by handle by an service_listener. listener could be gone
+        //Every reference retained is therefore stored and called when a service listener is removed from the framework.
+        if (eventType == OSGI_FRAMEWORK_SERVICE_EVENT_REGISTERED) {
+            serviceRegistry_retainServiceReference(framework->registry, element->bundle, reference);
+            arrayList_add(element->retainedReferences, reference); //TODO improve by using set (or hashmap) instead of list
+        }
+
+        event->type = eventType;
+        event->reference = reference;
+
+        element->listener->serviceChanged(element->listener, event);
+
+        serviceRegistry_ungetServiceReference(framework->registry, element->bundle, reference);
+
+        if (eventType == OSGI_FRAMEWORK_SERVICE_EVENT_UNREGISTERING) {
+            //if service listener was active when service was registered, release the retained reference
+            if (arrayList_removeElement(element->retainedReferences, reference)) {
+                serviceRegistry_ungetServiceReference(framework->registry, element->bundle, reference); // decrease retain counter
             }
         }
-    }
 
+        free(event);
+
+    } else if (eventType == OSGI_FRAMEWORK_SERVICE_EVENT_MODIFIED) {
+        bool matchResult = false;
+        int matched = 0;
+        if (element->filter != NULL) {
+            filter_match(element->filter, oldprops, &matchResult);
+        }
+        matched = (element->filter == NULL) || matchResult;
+        if (matched) {
+            service_reference_pt reference = NULL;
+            service_event_pt endmatch = (service_event_pt) malloc(sizeof (*endmatch));
+
+            serviceRegistry_getServiceReference(framework->registry, element->bundle, registration, &reference);
+
+            endmatch->reference = reference;
+            endmatch->type = OSGI_FRAMEWORK_SERVICE_EVENT_MODIFIED_ENDMATCH;
+            element->listener->serviceChanged(element->listener, endmatch);
+
+            serviceRegistry_ungetServiceReference(framework->registry, element->bundle, reference);
+            free(endmatch);
+
+        }
+    }
 }
 
 //celix_status_t fw_isServiceAssignable(framework_pt fw, bundle_pt requester, service_reference_pt reference, bool *assignable) {
@@ -1721,9 +1916,8 @@ void fw_serviceChanged(framework_pt framework, service_event_type_e eventType, s
 //}
 
 long framework_getNextBundleId(framework_pt framework) {
-	long id = framework->nextBundleId;
-	framework->nextBundleId++;
-	return id;
+	//bundles can be installed concurrently
+	return __atomic_fetch_add(&framework->nextBundleId, 1, __ATOMIC_SEQ_CST);
 }
 
 celix_status_t framework_markResolvedModules(framework_pt framework, linked_list_pt resolvedModuleWireMap) {
@@ -1967,11 +2161,16 @@ celix_status_t framework_acquireBundleLock(framework_pt framework, bundle_pt bun
 			}
 
 			bundle_getLockingThread(bundle, &lockingThread);
-			if (isSelf && (celixThread_initalized(lockingThread) == true)
-					&& arrayList_contains(framework->globalLockWaitersList, &lockingThread)) {
-				framework->interrupted = true;
-//				celixThreadCondition_signal_thread_np(&framework->condition, bundle_getLockingThread(bundle));
-				celixThreadCondition_signal(&framework->condition);
+			if (isSelf && (celixThread_initalized(lockingThread) == true)) {
+				//the thread holding the bundle waits for the global lock held by this thread, interrupt it
+				unsigned int i;
+				for (i = 0; i < arrayList_size(framework->globalLockWaitersList); i++) {
+					struct fw_globalLockWaiter *waiter = arrayList_get(framework->globalLockWaitersList, i);
+					if (celixThread_equals(waiter->thread, lockingThread)) {
+						waiter->interrupted = true;
+						celixThreadCondition_broadcast(&framework->condition);
+					}
+				}
 			}
 
             celixThreadCondition_wait(&framework->condition, &framework->bundleLock);
@@ -1980,6 +2179,7 @@ celix_status_t framework_acquireBundleLock(framework_pt framework, bundle_pt bun
 			if (status != CELIX_SUCCESS) {
 				break;
 			}
+			thread_equalsSelf(framework->globalLockThread, &isSelf);
 	}
 
 		if (status == CELIX_SUCCESS) {
@@ -2035,17 +2235,16 @@ bool framework_acquireGlobalLock(framework_pt framework) {
 	while (!interrupted
 			&& (celixThread_initalized(framework->globalLockThread) == true)
 			&& (!isSelf)) {
-		celix_thread_t currentThread = celixThread_self();
-		arrayList_add(framework->globalLockWaitersList, &currentThread);
+		struct fw_globalLockWaiter waiter;
+		waiter.thread = celixThread_self();
+		waiter.interrupted = false;
+		arrayList_add(framework->globalLockWaitersList, &waiter);
 		celixThreadCondition_broadcast(&framework->condition);
 
 		celixThreadCondition_wait(&framework->condition, &framework->bundleLock);
-		if (framework->interrupted) {
-			interrupted = true;
-			framework->interrupted = false;
-		}
+		interrupted = waiter.interrupted;
 
-		arrayList_removeElement(framework->globalLockWaitersList, &currentThread);
+		arrayList_removeElement(framework->globalLockWaitersList, &waiter);
 	}
 
 	if (!interrupted) {
@@ -2149,22 +2348,8 @@ static void *framework_shutdown(void *framework) {
         return NULL;
     }
 
-	if (celixThreadMutex_lock(&fw->dispatcherLock) != CELIX_SUCCESS) {
-		fw_log(fw->logger, OSGI_FRAMEWORK_LOG_ERROR, "Error locking the dispatcherThread.");
-	}
-	else {
-		fw->shutdown = true;
-
-		if (celixThreadCondition_broadcast(&fw->dispatcher)) {
-			fw_log(fw->logger, OSGI_FRAMEWORK_LOG_ERROR, "Error broadcasting .");
-		}
-
-		if (celixThreadMutex_unlock(&fw->dispatcherLock)) {
-			fw_log(fw->logger, OSGI_FRAMEWORK_LOG_ERROR, "Error unlocking the dispatcherThread.");
-		}
-
-		celixThread_join(fw->dispatcherThread, NULL);
-	}
+	fw->shutdown = true;
+	fw_stopEventDispatchers(fw);
 
 
 	err = celixThreadCondition_broadcast(&fw->shutdownGate);
@@ -2216,7 +2401,6 @@ celix_status_t fw_fireBundleEvent(framework_pt framework, bundle_event_type_e ev
 
             request->eventType = eventType;
             request->filter = NULL;
-            request->listeners = framework->bundleListeners;
             request->type = BUNDLE_EVENT_TYPE;
             request->error = NULL;
             request->bundleId = -1;
@@ -2245,16 +2429,7 @@ celix_status_t fw_fireBundleEvent(framework_pt framework, bundle_event_type_e ev
                 }
             }
 
-            if (celixThreadMutex_lock(&framework->dispatcherLock) != CELIX_SUCCESS) {
-                status = CELIX_FRAMEWORK_EXCEPTION;
-            } else {
-                arrayList_add(framework->requests, request);
-                celix_status_t bcast_status = celixThreadCondition_broadcast(&framework->dispatcher);
-                celix_status_t unlock_status = celixThreadMutex_unlock(&framework->dispatcherLock);
-                if (bcast_status!=0 || unlock_status!=0) {
-                    status = CELIX_FRAMEWORK_EXCEPTION;
-                }
-            }
+            status = fw_enqueueRequest(framework, request);
         }
     }
 
@@ -2266,7 +2441,7 @@ celix_status_t fw_fireBundleEvent(framework_pt framework, bundle_event_type_e ev
 celix_status_t fw_fireFrameworkEvent(framework_pt framework, framework_event_type_e eventType, bundle_pt bundle, celix_status_t errorCode) {
 	celix_status_t status = CELIX_SUCCESS;
 
-	request_pt request = (request_pt) malloc(sizeof(*request));
+	request_pt request = (request_pt) calloc(1, sizeof(*request));
 	if (!request) {
 		status = CELIX_ENOMEM;
 	} else {
@@ -2275,10 +2450,9 @@ celix_status_t fw_fireFrameworkEvent(framework_pt framework, framework_event_typ
 
         request->eventType = eventType;
         request->filter = NULL;
-        request->listeners = framework->frameworkListeners;
         request->type = FRAMEWORK_EVENT_TYPE;
         request->errorCode = errorCode;
-        request->error = "";
+        request->error = NULL;
         request->bundleId = -1;
 
         status = bundle_getArchive(bundle, &archive);
@@ -2305,22 +2479,16 @@ celix_status_t fw_fireFrameworkEvent(framework_pt framework, framework_event_typ
             }
         }
 
+        //the request outlives this call, so the message is copied
         if (errorCode != CELIX_SUCCESS) {
             char message[256];
             celix_strerror(errorCode, message, 256);
-            request->error = message;
-        }
-
-        if (celixThreadMutex_lock(&framework->dispatcherLock) != CELIX_SUCCESS) {
-            status = CELIX_FRAMEWORK_EXCEPTION;
+            request->error = strdup(message);
         } else {
-            arrayList_add(framework->requests, request);
-            celix_status_t bcast_status = celixThreadCondition_broadcast(&framework->dispatcher);
-            celix_status_t unlock_status = celixThreadMutex_unlock(&framework->dispatcherLock);
-            if (bcast_status!=0 || unlock_status!=0) {
-		status = CELIX_FRAMEWORK_EXCEPTION;
-            }
+            request->error = strdup("");
         }
+
+        status = fw_enqueueRequest(framework, request);
     }
 
 	framework_logIfError(framework->logger, status, NULL, "Failed to fire framework event");
@@ -2328,93 +2496,339 @@ celix_status_t fw_fireFrameworkEvent(framework_pt framework, framework_event_typ
 	return status;
 }
 
-static void *fw_eventDispatcher(void *fw) {
-	framework_pt framework = (framework_pt) fw;
+static celix_status_t fw_createEventDispatchers(framework_pt framework) {
+	celix_status_t status = CELIX_SUCCESS;
+	const char *value = NULL;
+	unsigned int nrOfDispatchers = FW_DEFAULT_EVENT_DISPATCHERS;
+	unsigned int i;
 
-	while (true) {
-		int size;
-		celix_status_t status;
+	fw_getProperty(framework, CELIX_FRAMEWORK_EVENT_DISPATCHERS, NULL, &value);
+	if (value != NULL) {
+		char *endptr = NULL;
+		long configured = strtol(value, &endptr, 10);
+		if (endptr != value && configured > 0) {
+			nrOfDispatchers = (unsigned int) configured;
+		} else {
+			fw_log(framework->logger, OSGI_FRAMEWORK_LOG_WARNING, "Invalid value '%s' for %s, using %u dispatchers", value, CELIX_FRAMEWORK_EVENT_DISPATCHERS, nrOfDispatchers);
+		}
+	}
+
+	framework->dispatchers = calloc(nrOfDispatchers, sizeof(*framework->dispatchers));
+	if (framework->dispatchers == NULL) {
+		status = CELIX_ENOMEM;
+	}
+
+	for (i = 0; status == CELIX_SUCCESS && i < nrOfDispatchers; i += 1) {
+		struct fw_eventDispatcher *dispatcher = &framework->dispatchers[i];
+		dispatcher->framework = framework;
+		dispatcher->capacity = FW_EVENT_QUEUE_INITIAL_CAPACITY;
+		dispatcher->head = 0;
+		dispatcher->size = 0;
+		dispatcher->queue = calloc(dispatcher->capacity, sizeof(*dispatcher->queue));
+		if (dispatcher->queue == NULL) {
+			status = CELIX_ENOMEM;
+		}
+		status = CELIX_DO_IF(status, celixThreadMutex_create(&dispatcher->lock, NULL));
+		status = CELIX_DO_IF(status, celixThreadCondition_init(&dispatcher->cond, NULL));
+		status = CELIX_DO_IF(status, celixThread_create(&dispatcher->thread, NULL, fw_eventDispatcher, dispatcher));
+		if (status == CELIX_SUCCESS) {
+			framework->nrOfDispatchers += 1;
+		} else {
+			free(dispatcher->queue);
+			dispatcher->queue = NULL;
+		}
+	}
+
+	framework_logIfError(framework->logger, status, NULL, "Failed to create event dispatchers");
+
+	return status;
+}
+
+static void fw_stopEventDispatchers(framework_pt framework) {
+	//precondition framework->shutdown is set
+	unsigned int i;
+	for (i = 0; i < framework->nrOfDispatchers; i += 1) {
+		struct fw_eventDispatcher *dispatcher = &framework->dispatchers[i];
+		if (celixThreadMutex_lock(&dispatcher->lock) != CELIX_SUCCESS) {
+			fw_log(framework->logger, OSGI_FRAMEWORK_LOG_ERROR, "Error locking the dispatcherThread.");
+			continue;
+		}
+		if (celixThreadCondition_broadcast(&dispatcher->cond)) {
+			fw_log(framework->logger, OSGI_FRAMEWORK_LOG_ERROR, "Error broadcasting .");
+		}
+		if (celixThreadMutex_unlock(&dispatcher->lock)) {
+			fw_log(framework->logger, OSGI_FRAMEWORK_LOG_ERROR, "Error unlocking the dispatcherThread.");
+		}
+	}
+	for (i = 0; i < framework->nrOfDispatchers; i += 1) {
+		celixThread_join(framework->dispatchers[i].thread, NULL);
+	}
+}
+
+static void fw_destroyEventDispatchers(framework_pt framework) {
+	unsigned int i;
+	for (i = 0; i < framework->nrOfDispatchers; i += 1) {
+		struct fw_eventDispatcher *dispatcher = &framework->dispatchers[i];
+		//requests fired after the shutdown are never dispatched
+		while (dispatcher->size > 0) {
+			fw_releaseRequest(dispatcher->queue[dispatcher->head]);
+			dispatcher->head = (dispatcher->head + 1) % dispatcher->capacity;
+			dispatcher->size -= 1;
+		}
+		free(dispatcher->queue);
+		celixThreadCondition_destroy(&dispatcher->cond);
+		celixThreadMutex_destroy(&dispatcher->lock);
+	}
+	free(framework->dispatchers);
+	framework->dispatchers = NULL;
+	framework->nrOfDispatchers = 0;
+}
+
+static celix_status_t fw_enqueueRequest(framework_pt framework, request_pt request) {
+	celix_status_t status = CELIX_SUCCESS;
+	unsigned int i;
+
+	//every dispatcher delivers the request to its own listeners, the last one to finish frees the request
+	request->refCount = framework->nrOfDispatchers;
+	if (framework->nrOfDispatchers == 0) {
+		request->refCount = 1;
+		fw_releaseRequest(request);
+	}
+
+	for (i = 0; i < framework->nrOfDispatchers; i += 1) {
+		struct fw_eventDispatcher *dispatcher = &framework->dispatchers[i];
+		if (celixThreadMutex_lock(&dispatcher->lock) != CELIX_SUCCESS) {
+			fw_releaseRequest(request);
+			status = CELIX_FRAMEWORK_EXCEPTION;
+			continue;
+		}
+
+		if (dispatcher->size == dispatcher->capacity) {
+			request_pt *queue = malloc(2 * dispatcher->capacity * sizeof(*queue));
+			if (queue != NULL) {
+				unsigned int j;
+				for (j = 0; j < dispatcher->size; j += 1) {
+					queue[j] = dispatcher->queue[(dispatcher->head + j) % dispatcher->capacity];
+				}
+				free(dispatcher->queue);
+				dispatcher->queue = queue;
+				dispatcher->capacity *= 2;
+				dispatcher->head = 0;
+			}
+		}
 
-		if (celixThreadMutex_lock(&framework->dispatcherLock) != 0) {
+		if (dispatcher->size < dispatcher->capacity) {
+			dispatcher->queue[(dispatcher->head + dispatcher->size) % dispatcher->capacity] = request;
+			dispatcher->size += 1;
+		} else {
+			fw_releaseRequest(request);
+			status = CELIX_ENOMEM;
+		}
+
+		celix_status_t bcast_status = celixThreadCondition_signal(&dispatcher->cond);
+		celix_status_t unlock_status = celixThreadMutex_unlock(&dispatcher->lock);
+		if (bcast_status != 0 || unlock_status != 0) {
+			status = CELIX_FRAMEWORK_EXCEPTION;
+		}
+	}
+
+	return status;
+}
+
+static void fw_releaseRequest(request_pt request) {
+	if (__atomic_sub_fetch(&request->refCount, 1, __ATOMIC_SEQ_CST) == 0) {
+		free(request->bundleSymbolicName);
+		free(request->error);
+		free(request);
+	}
+}
+
+//returns the dispatcher running on the calling thread, NULL if called from another thread
+static struct fw_eventDispatcher *fw_currentDispatcher(framework_pt framework) {
+	unsigned int i;
+	celix_thread_t self = celixThread_self();
+	for (i = 0; i < framework->nrOfDispatchers; i += 1) {
+		if (celixThread_equals(self, framework->dispatchers[i].thread)) {
+			return &framework->dispatchers[i];
+		}
+	}
+	return NULL;
+}
+
+//precondition bundleListenerLock is held. Returns false if the listener is removed and must not be invoked
+static bool fw_beginListenerDelivery(framework_pt framework, struct fw_listenerUse *use) {
+	if (use->removed) {
+		return false;
+	}
+	use->invoking = true;
+	return true;
+}
+
+//precondition bundleListenerLock is held. Returns true if the listener can be freed
+static bool fw_endListenerDelivery(framework_pt framework, struct fw_listenerUse *use) {
+	use->invoking = false;
+	celixThreadCondition_broadcast(&framework->listenerDelivered);
+	use->useCount -= 1;
+	return use->useCount == 0;
+}
+
+/*
+ * Marks a removed listener, so that it is not invoked anymore, and waits till a call in progress returns.
+ * A listener removed from within its own callback is not waited for, neither is a listener of a dispatcher
+ * which (indirectly) waits for the calling dispatcher, that would deadlock.
+ * Precondition bundleListenerLock is held. Returns true if the listener can be freed.
+ */
+static bool fw_removeListenerUse(framework_pt framework, struct fw_listenerUse *use, unsigned int dispatcherIdx) {
+	struct fw_eventDispatcher *self = fw_currentDispatcher(framework);
+	struct fw_eventDispatcher *target = dispatcherIdx < framework->nrOfDispatchers ? &framework->dispatchers[dispatcherIdx] : NULL;
+
+	use->removed = true;
+
+	while (use->invoking && target != NULL && target != self) {
+		if (self != NULL) {
+			struct fw_eventDispatcher *waiting = target->waitingOn;
+			unsigned int hops = 0;
+			while (waiting != NULL && waiting != self && hops++ < framework->nrOfDispatchers) {
+				waiting = waiting->waitingOn;
+			}
+			if (waiting == self) {
+				break;
+			}
+			self->waitingOn = target;
+		}
+		celixThreadCondition_wait(&framework->listenerDelivered, &framework->bundleListenerLock);
+		if (self != NULL) {
+			self->waitingOn = NULL;
+		}
+	}
+
+	use->useCount -= 1;
+	return use->useCount == 0;
+}
+
+static void *fw_eventDispatcher(void *data) {
+	struct fw_eventDispatcher *dispatcher = data;
+	framework_pt framework = dispatcher->framework;
+
+	while (true) {
+		if (celixThreadMutex_lock(&dispatcher->lock) != 0) {
 			fw_log(framework->logger, OSGI_FRAMEWORK_LOG_ERROR,  "Error locking the dispatcher");
 			celixThread_exit(NULL);
 			return NULL;
 		}
 
-		size = arrayList_size(framework->requests);
-		while (size == 0 && !framework->shutdown) {
-			celixThreadCondition_wait(&framework->dispatcher, &framework->dispatcherLock);
+		while (dispatcher->size == 0 && !framework->shutdown) {
+			celixThreadCondition_wait(&dispatcher->cond, &dispatcher->lock);
 			// Ignore status and just keep waiting
-			size = arrayList_size(framework->requests);
 		}
 
-		if (size == 0 && framework->shutdown) {
-		    celixThreadMutex_unlock(&framework->dispatcherLock);
+		if (dispatcher->size == 0 && framework->shutdown) {
+		    celixThreadMutex_unlock(&dispatcher->lock);
 			celixThread_exit(NULL);
 			return NULL;
 		}
 
-		request_pt request = (request_pt) arrayList_remove(framework->requests, 0);
+		request_pt request = dispatcher->queue[dispatcher->head];
+		dispatcher->head = (dispatcher->head + 1) % dispatcher->capacity;
+		dispatcher->size -= 1;
 
-		if ((status = celixThreadMutex_unlock(&framework->dispatcherLock)) != 0) {
+		if (celixThreadMutex_unlock(&dispatcher->lock) != 0) {
 			fw_log(framework->logger, OSGI_FRAMEWORK_LOG_ERROR,  "Error unlocking the dispatcher.");
 			celixThread_exit(NULL);
 			return NULL;
 		}
 
-        if (celixThreadMutex_lock(&framework->bundleListenerLock) != CELIX_SUCCESS) {
-            status = CELIX_FRAMEWORK_EXCEPTION;
-        } else if (celixThreadMutex_lock(&framework->bundleLock) != CELIX_SUCCESS) {
-            celixThreadMutex_unlock(&framework->bundleListenerLock);
-            status = CELIX_FRAMEWORK_EXCEPTION;
-        } else {
-            int i;
-            int size = arrayList_size(request->listeners);
-            for (i = 0; i < size; i++) {
-                if (request->type == BUNDLE_EVENT_TYPE) {
-                    fw_bundle_listener_pt listener = (fw_bundle_listener_pt) arrayList_get(request->listeners, i);
-                    bundle_event_pt event = (bundle_event_pt) calloc(1, sizeof(*event));
-                    event->bundleId = request->bundleId;
-                    event->bundleSymbolicName = strdup(request->bundleSymbolicName);
-                    event->type = request->eventType;
-
-                    fw_invokeBundleListener(framework, listener->listener, event, listener->bundle);
-
-                    free(event->bundleSymbolicName);
-                    free(event);
-                } else if (request->type == FRAMEWORK_EVENT_TYPE) {
-                    fw_framework_listener_pt listener = (fw_framework_listener_pt) arrayList_get(request->listeners, i);
-                    framework_event_pt event = (framework_event_pt) calloc(1, sizeof(*event));
-                    event->bundleId = request->bundleId;
-                    event->bundleSymbolicName = strdup(request->bundleSymbolicName);
-                    event->type = request->eventType;
-                    event->error = request->error;
-                    event->errorCode = request->errorCode;
-
-                    fw_invokeFrameworkListener(framework, listener->listener, event, listener->bundle);
-
-                    free(event);
-                }
-            }
+		fw_dispatchRequest(dispatcher, request);
+		fw_releaseRequest(request);
+	}
 
-            if (celixThreadMutex_unlock(&framework->bundleLock)) {
-                status = CELIX_FRAMEWORK_EXCEPTION;
-            }
+	celixThread_exit(NULL);
 
-            if (celixThreadMutex_unlock(&framework->bundleListenerLock)) {
-                status = CELIX_FRAMEWORK_EXCEPTION;
-            }
+	return NULL;
 
-            free(request->bundleSymbolicName);
-            free(request);
-        }
+}
 
-    }
+static void fw_dispatchRequest(struct fw_eventDispatcher *dispatcher, request_pt request) {
+	framework_pt framework = dispatcher->framework;
+	unsigned int dispatcherIdx = (unsigned int) (dispatcher - framework->dispatchers);
+	unsigned int i;
+	unsigned int count = 0;
 
-	celixThread_exit(NULL);
+	//no framework lock is held while the listeners are invoked, the references keep the listeners of this dispatcher
+	//allocated and every listener is checked for removal right before it is invoked
+	if (celixThreadMutex_lock(&framework->bundleListenerLock) != CELIX_SUCCESS) {
+		fw_log(framework->logger, OSGI_FRAMEWORK_LOG_ERROR,  "Error locking the bundle listeners.");
+	} else if (request->type == BUNDLE_EVENT_TYPE) {
+		unsigned int size = arrayList_size(framework->bundleListeners);
+		fw_bundle_listener_pt listeners[size > 0 ? size : 1];
+		for (i = 0; i < size; i++) {
+			fw_bundle_listener_pt listener = (fw_bundle_listener_pt) arrayList_get(framework->bundleListeners, i);
+			if (listener->dispatcher == dispatcherIdx) {
+				listener->use.useCount += 1;
+				listeners[count++] = listener;
+			}
+		}
 
-	return NULL;
+		for (i = 0; i < count; i++) {
+			fw_bundle_listener_pt listener = listeners[i];
+			if (fw_beginListenerDelivery(framework, &listener->use)) {
+				celixThreadMutex_unlock(&framework->bundleListenerLock);
+
+				bundle_event_pt event = (bundle_event_pt) calloc(1, sizeof(*event));
+				event->bundleId = request->bundleId;
+				event->bundleSymbolicName = strdup(request->bundleSymbolicName);
+				event->type = request->eventType;
+
+				fw_invokeBundleListener(framework, listener->listener, event, listener->bundle);
+
+				free(event->bundleSymbolicName);
+				free(event);
 
+				celixThreadMutex_lock(&framework->bundleListenerLock);
+			}
+			if (fw_endListenerDelivery(framework, &listener->use)) {
+				free(listener);
+			}
+		}
+		celixThreadMutex_unlock(&framework->bundleListenerLock);
+	} else if (request->type == FRAMEWORK_EVENT_TYPE) {
+		unsigned int size = arrayList_size(framework->frameworkListeners);
+		fw_framework_listener_pt listeners[size > 0 ? size : 1];
+		for (i = 0; i < size; i++) {
+			fw_framework_listener_pt listener = (fw_framework_listener_pt) arrayList_get(framework->frameworkListeners, i);
+			if (listener->dispatcher == dispatcherIdx) {
+				listener->use.useCount += 1;
+				listeners[count++] = listener;
+			}
+		}
+
+		for (i = 0; i < count; i++) {
+			fw_framework_listener_pt listener = listeners[i];
+			if (fw_beginListenerDelivery(framework, &listener->use)) {
+				celixThreadMutex_unlock(&framework->bundleListenerLock);
+
+				framework_event_pt event = (framework_event_pt) calloc(1, sizeof(*event));
+				event->bundleId = request->bundleId;
+				event->bundleSymbolicName = strdup(request->bundleSymbolicName);
+				event->type = request->eventType;
+				event->error = request->error;
+				event->errorCode = request->errorCode;
+
+				fw_invokeFrameworkListener(framework, listener->listener, event, listener->bundle);
+
+				free(event->bundleSymbolicName);
+				free(event);
+
+				celixThreadMutex_lock(&framework->bundleListenerLock);
+			}
+			if (fw_endListenerDelivery(framework, &listener->use)) {
+				free(listener);
+			}
+		}
+		celixThreadMutex_unlock(&framework->bundleListenerLock);
+	} else {
+		celixThreadMutex_unlock(&framework->bundleListenerLock);
+	}
 }
 
 celix_status_t fw_invokeBundleListener(framework_pt framework, bundle_listener_pt listener, bundle_event_pt event, bundle_pt bundle) {
@@ -27,23 +27,70 @@
 #include <string.h>
 #include <stdlib.h>
 #include <ctype.h>
+#include <stdint.h>
 #include "celixbool.h"
-#include "properties.h"
+#include "celix_threads.h"
+#include "properties_private.h"
 #include "utils.h"
 
 #define MALLOC_BLOCK_SIZE		5
 
 static void parseLine(const char* line, properties_pt props);
 
+//global table of interned property keys, the value is the reference count of the key
+static celix_thread_once_t keyTableOnce = PTHREAD_ONCE_INIT;
+static celix_thread_mutex_t keyTableLock;
+static hash_map_pt keyTable = NULL;
+
+static void properties_createKeyTable(void) {
+	celixThreadMutex_create(&keyTableLock, NULL);
+	keyTable = hashMap_createOpenAddressingWithCapacity(256, utils_stringHash, NULL, utils_stringEquals, NULL);
+}
+
+const char* properties_internKey(const char* key) {
+	char *interned = NULL;
+	celixThread_once(&keyTableOnce, properties_createKeyTable);
+
+	celixThreadMutex_lock(&keyTableLock);
+	hash_map_entry_pt entry = hashMap_getEntry(keyTable, key);
+	if (entry != NULL) {
+		interned = hashMapEntry_getKey(entry);
+		hashMap_put(keyTable, interned, (void *) ((uintptr_t) hashMapEntry_getValue(entry) + 1));
+	} else {
+		interned = strndup(key, 1024*10);
+		hashMap_put(keyTable, interned, (void *) (uintptr_t) 1);
+	}
+	celixThreadMutex_unlock(&keyTableLock);
+
+	return interned;
+}
+
+void properties_releaseKey(const char* key) {
+	char *toFree = NULL;
+
+	celixThreadMutex_lock(&keyTableLock);
+	uintptr_t count = (uintptr_t) hashMap_get(keyTable, key);
+	if (count > 1) {
+		hashMap_put(keyTable, (void *) key, (void *) (count - 1));
+	} else if (count == 1) {
+		hashMap_remove(keyTable, key);
+		toFree = (char *) key;
+	}
+	celixThreadMutex_unlock(&keyTableLock);
+
+	free(toFree);
+}
+
 properties_pt properties_create(void) {
-	return hashMap_create(utils_stringHash, utils_stringHash, utils_stringEquals, utils_stringEquals);
+	//small property sets are a flat array of inline slots, which grows into a hash table past the load threshold
+	return hashMap_createOpenAddressingWithCapacity(PROPERTIES_INITIAL_CAPACITY, utils_stringHash, utils_stringHash, utils_stringEquals, utils_stringEquals);
 }
 
 void properties_destroy(properties_pt properties) {
 	hash_map_iterator_pt iter = hashMapIterator_create(properties);
 	while (hashMapIterator_hasNext(iter)) {
 		hash_map_entry_pt entry = hashMapIterator_nextEntry(iter);
-		free(hashMapEntry_getKey(entry));
+		properties_releaseKey(hashMapEntry_getKey(entry));
 		free(hashMapEntry_getValue(entry));
 	}
 	hashMapIterator_destroy(iter);
@@ -175,15 +222,23 @@ void properties_set(properties_pt properties, const char* key, const char* value
 	hash_map_entry_pt entry = hashMap_getEntry(properties, key);
 	char* oldValue = NULL;
 	if (entry != NULL) {
-		char* oldKey = hashMapEntry_getKey(entry);
-		oldValue = hashMapEntry_getValue(entry);
-		hashMap_put(properties, oldKey, strndup(value, 1024*10));
+		oldValue = hashMap_put(properties, hashMapEntry_getKey(entry), strndup(value, 1024*10));
 	} else {
-		hashMap_put(properties, strndup(key, 1024*10), strndup(value, 1024*10));
+		hashMap_put(properties, (void *) properties_internKey(key), strndup(value, 1024*10));
 	}
 	free(oldValue);
 }
 
+void properties_unset(properties_pt properties, const char* key) {
+	hash_map_entry_pt entry = hashMap_getEntry(properties, key);
+	if (entry != NULL) {
+		const char* internedKey = hashMapEntry_getKey(entry);
+		char* value = hashMap_remove(properties, internedKey);
+		properties_releaseKey(internedKey);
+		free(value);
+	}
+}
+
 static void updateBuffers(char **key, char ** value, char **output, int outputPos, int *key_len, int *value_len) {
 	if (*output == *key) {
 		if (outputPos == (*key_len) - 1) {
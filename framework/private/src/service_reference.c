@@ -292,27 +292,23 @@ int serviceReference_equals2(const void* reference1, const void* reference2) {
 	return equal;
 }
 
+static void serviceReference_getIdAndRanking(service_reference_pt reference, unsigned long *id, long *ranking) {
+	//use the values cached by the registration instead of parsing the service.id and service.ranking properties
+	celixThreadRwlock_readLock(&reference->lock);
+	if (reference->registration != NULL) {
+		serviceRegistration_getServiceId(reference->registration, id);
+		serviceRegistration_getRanking(reference->registration, ranking);
+	}
+	celixThreadRwlock_unlock(&reference->lock);
+}
+
 celix_status_t serviceReference_compareTo(service_reference_pt reference, service_reference_pt compareTo, int *compare) {
 	celix_status_t status = CELIX_SUCCESS;
 
-	long id, other_id;
-	const char* id_str;
-    const char* other_id_str;
-	serviceReference_getProperty(reference, (char *) OSGI_FRAMEWORK_SERVICE_ID, &id_str);
-	serviceReference_getProperty(compareTo, (char *) OSGI_FRAMEWORK_SERVICE_ID, &other_id_str);
-
-	id = atol(id_str);
-	other_id = atol(other_id_str);
-
-
-	long rank, other_rank;
-	const char *rank_str;
-    const char* other_rank_str;
-	serviceReference_getProperty(reference, OSGI_FRAMEWORK_SERVICE_RANKING, &rank_str);
-	serviceReference_getProperty(compareTo, OSGI_FRAMEWORK_SERVICE_RANKING, &other_rank_str);
-
-	rank = rank_str == NULL ? 0 : atol(rank_str);
-	other_rank = other_rank_str == NULL ? 0 : atol(other_rank_str);
+	unsigned long id = 0, other_id = 0;
+	long rank = 0, other_rank = 0;
+	serviceReference_getIdAndRanking(reference, &id, &rank);
+	serviceReference_getIdAndRanking(compareTo, &other_id, &other_rank);
 
     *compare = utils_compareServiceIdsAndRanking(id, rank, other_id, other_rank);
 
@@ -135,6 +135,9 @@ static celix_status_t serviceRegistration_initializeProperties(service_registrat
 		properties_set(dictionary, (char *) OSGI_FRAMEWORK_OBJECTCLASS, registration->className);
 	}
 
+	const char *ranking = properties_get(dictionary, (char *) OSGI_FRAMEWORK_SERVICE_RANKING);
+	registration->ranking = ranking == NULL ? 0 : strtol(ranking, NULL, 10);
+
 	registration->properties = dictionary;
 
 	return CELIX_SUCCESS;
@@ -289,3 +292,31 @@ celix_status_t serviceRegistration_getServiceName(service_registration_pt regist
 
 	return status;
 }
+
+celix_status_t serviceRegistration_getServiceId(service_registration_pt registration, unsigned long *serviceId) {
+	celix_status_t status = CELIX_SUCCESS;
+
+	if (registration != NULL && serviceId != NULL) {
+		celixThreadRwlock_readLock(&registration->lock);
+		*serviceId = registration->serviceId;
+		celixThreadRwlock_unlock(&registration->lock);
+	} else {
+		status = CELIX_ILLEGAL_ARGUMENT;
+	}
+
+	return status;
+}
+
+celix_status_t serviceRegistration_getRanking(service_registration_pt registration, long *ranking) {
+	celix_status_t status = CELIX_SUCCESS;
+
+	if (registration != NULL && ranking != NULL) {
+		celixThreadRwlock_readLock(&registration->lock);
+		*ranking = registration->ranking;
+		celixThreadRwlock_unlock(&registration->lock);
+	} else {
+		status = CELIX_ILLEGAL_ARGUMENT;
+	}
+
+	return status;
+}
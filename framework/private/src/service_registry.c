@@ -27,6 +27,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <assert.h>
+#include <sched.h>
 
 #include "service_registry_private.h"
 #include "service_registration_private.h"
@@ -34,6 +35,7 @@
 #include "constants.h"
 #include "service_reference_private.h"
 #include "framework_private.h"
+#include "utils.h"
 
 #ifdef DEBUG
 #define CHECK_DELETED_REFERENCES true
@@ -54,6 +56,18 @@ static celix_status_t serviceRegistry_setReferenceStatus(service_registry_pt reg
                                                   bool deleted);
 static celix_status_t serviceRegistry_getUsingBundles(service_registry_pt registry, service_registration_pt reg, array_list_pt *bundles);
 static celix_status_t serviceRegistry_getServiceReference_internal(service_registry_pt registry, bundle_pt owner, service_registration_pt registration, service_reference_pt *out);
+static long serviceRegistry_getRanking(properties_pt properties);
+static long serviceRegistry_getRegistrationRanking(service_registration_pt registration);
+static void serviceRegistry_addToNameIndex(service_registry_pt registry, const char *serviceName, service_registration_pt registration, long ranking);
+static void serviceRegistry_removeFromNameIndex(service_registry_pt registry, service_registration_pt registration);
+static void serviceRegistry_resortNameIndex(service_registry_pt registry, service_registration_pt registration);
+static celix_status_t serviceRegistry_collectMatchingRegistrations(struct serviceRegistrySnapshotRegistrations *regs, filter_pt filter, array_list_pt matchingRegistrations);
+static struct serviceRegistrySnapshot * serviceRegistry_createSnapshot(unsigned int capacity);
+static struct serviceRegistrySnapshotEntry * serviceRegistry_findSnapshotEntry(struct serviceRegistrySnapshot *snapshot, const char *serviceName);
+static void serviceRegistry_insertSnapshotEntry(struct serviceRegistrySnapshot *snapshot, struct serviceRegistrySnapshotEntry *entry);
+static unsigned int serviceRegistry_enterSnapshot(service_registry_pt registry);
+static void serviceRegistry_exitSnapshot(service_registry_pt registry, unsigned int epoch);
+static void serviceRegistry_synchronizeSnapshot(service_registry_pt registry);
 
 celix_status_t serviceRegistry_create(framework_pt framework, serviceChanged_function_pt serviceChanged, service_registry_pt *out) {
 	celix_status_t status;
@@ -70,6 +84,7 @@ celix_status_t serviceRegistry_create(framework_pt framework, serviceChanged_fun
 
         reg->serviceChanged = serviceChanged;
 		reg->serviceRegistrations = hashMap_create(NULL, NULL, NULL, NULL);
+		reg->serviceRegistrationsByName = hashMap_create(utils_stringHash, NULL, utils_stringEquals, NULL);
 		reg->framework = framework;
 		reg->currentServiceId = 1UL;
 		reg->serviceReferences = hashMap_create(NULL, NULL, NULL, NULL);
@@ -79,7 +94,14 @@ celix_status_t serviceRegistry_create(framework_pt framework, serviceChanged_fun
 
 		arrayList_create(&reg->listenerHooks);
 
-		status = celixThreadRwlock_create(&reg->lock, NULL);
+		reg->snapshot = serviceRegistry_createSnapshot(16);
+		reg->snapshotEpoch = 0;
+		reg->snapshotReaders[0] = 0;
+		reg->snapshotReaders[1] = 0;
+
+		status = reg->snapshot != NULL ? CELIX_SUCCESS : CELIX_ENOMEM;
+		status = CELIX_DO_IF(status, celixThreadRwlock_create(&reg->lock, NULL));
+		status = CELIX_DO_IF(status, celixThreadRwlock_create(&reg->referencesLock, NULL));
 	}
 
 	if (status == CELIX_SUCCESS) {
@@ -99,6 +121,27 @@ celix_status_t serviceRegistry_destroy(service_registry_pt registry) {
     assert(size == 0);
     hashMap_destroy(registry->serviceRegistrations, false, false);
 
+    //destroy service name index
+    hash_map_iterator_pt iter = hashMapIterator_create(registry->serviceRegistrationsByName);
+    while (hashMapIterator_hasNext(iter)) {
+        array_list_pt regs = hashMapIterator_nextValue(iter);
+        arrayList_destroy(regs);
+    }
+    hashMapIterator_destroy(iter);
+    hashMap_destroy(registry->serviceRegistrationsByName, true, false);
+
+    //destroy published snapshot
+    unsigned int i;
+    for (i = 0; i < registry->snapshot->capacity; i += 1) {
+        struct serviceRegistrySnapshotEntry *entry = registry->snapshot->entries[i];
+        if (entry != NULL) {
+            free(entry->registrations);
+            free(entry->serviceName);
+            free(entry);
+        }
+    }
+    free(registry->snapshot);
+
     //destroy service references (double) map);
     //FIXME. The framework bundle does not (yet) call clearReferences, as result the size could be > 0 for test code.
     //size = hashMap_size(registry->serviceReferences);
@@ -112,6 +155,10 @@ celix_status_t serviceRegistry_destroy(service_registry_pt registry) {
 
     hashMap_destroy(registry->deletedServiceReferences, false, false);
 
+    celixThreadRwlock_unlock(&registry->lock);
+    celixThreadRwlock_destroy(&registry->lock);
+    celixThreadRwlock_destroy(&registry->referencesLock);
+
     free(registry);
 
     return CELIX_SUCCESS;
@@ -120,7 +167,7 @@ celix_status_t serviceRegistry_destroy(service_registry_pt registry) {
 celix_status_t serviceRegistry_getRegisteredServices(service_registry_pt registry, bundle_pt bundle, array_list_pt *services) {
 	celix_status_t status = CELIX_SUCCESS;
 
-	celixThreadRwlock_writeLock(&registry->lock);
+	celixThreadRwlock_readLock(&registry->lock);
 
 	array_list_pt regs = (array_list_pt) hashMap_get(registry->serviceRegistrations, bundle);
 	if (regs != NULL) {
@@ -131,7 +178,7 @@ celix_status_t serviceRegistry_getRegisteredServices(service_registry_pt registr
 			service_registration_pt reg = arrayList_get(regs, i);
 			if (serviceRegistration_isValid(reg)) {
 				service_reference_pt reference = NULL;
-				status = serviceRegistry_getServiceReference_internal(registry, bundle, reg, &reference);
+				status = serviceRegistry_getServiceReference(registry, bundle, reg, &reference);
 				if (status == CELIX_SUCCESS) {
 					arrayList_add(*services, reference);
 				}
@@ -178,6 +225,7 @@ static celix_status_t serviceRegistry_registerServiceInternal(service_registry_p
         hashMap_put(registry->serviceRegistrations, bundle, regs);
     }
 	arrayList_add(regs, *registration);
+	serviceRegistry_addToNameIndex(registry, serviceName, *registration, serviceRegistry_getRanking(dictionary));
 	celixThreadRwlock_unlock(&registry->lock);
 
 	if (registry->serviceChanged != NULL) {
@@ -205,6 +253,7 @@ celix_status_t serviceRegistry_unregisterService(service_registry_pt registry, b
             hashMap_remove(registry->serviceRegistrations, bundle);
         }
 	}
+	serviceRegistry_removeFromNameIndex(registry, registration);
 	celixThreadRwlock_unlock(&registry->lock);
 
 	if (registry->serviceChanged != NULL) {
@@ -212,7 +261,7 @@ celix_status_t serviceRegistry_unregisterService(service_registry_pt registry, b
 	}
 
 
-	celixThreadRwlock_readLock(&registry->lock);
+	celixThreadRwlock_readLock(&registry->referencesLock);
     //invalidate service references
     hash_map_iterator_pt iter = hashMapIterator_create(registry->serviceReferences);
     while (hashMapIterator_hasNext(iter)) {
@@ -224,7 +273,7 @@ celix_status_t serviceRegistry_unregisterService(service_registry_pt registry, b
         }
     }
     hashMapIterator_destroy(iter);
-	celixThreadRwlock_unlock(&registry->lock);
+	celixThreadRwlock_unlock(&registry->referencesLock);
 
 	serviceRegistration_invalidate(registration);
     serviceRegistration_release(registration);
@@ -254,7 +303,10 @@ celix_status_t serviceRegistry_clearServiceRegistrations(service_registry_pt reg
             serviceRegistration_unregister(reg);
         }
         else {
+            celixThreadRwlock_writeLock(&registry->lock);
+            serviceRegistry_removeFromNameIndex(registry, reg);
             arrayList_remove(registrations, 0);
+            celixThreadRwlock_unlock(&registry->lock);
         }
 
         // not removed by last unregister call?
@@ -279,10 +331,22 @@ static void serviceRegistry_logWarningServiceRegistration(service_registry_pt re
 celix_status_t serviceRegistry_getServiceReference(service_registry_pt registry, bundle_pt owner,
                                                    service_registration_pt registration, service_reference_pt *out) {
 	celix_status_t status = CELIX_SUCCESS;
+	service_reference_pt ref = NULL;
+
+	//common case: the reference already exists and only needs to be retained
+	if (celixThreadRwlock_readLock(&registry->referencesLock) == CELIX_SUCCESS) {
+	    hash_map_pt references = hashMap_get(registry->serviceReferences, owner);
+	    ref = references == NULL ? NULL : hashMap_get(references, (void*)registration->serviceId);
+	    if (ref != NULL) {
+	        serviceReference_retain(ref);
+	        *out = ref;
+	    }
+	    celixThreadRwlock_unlock(&registry->referencesLock);
+	}
 
-	if(celixThreadRwlock_writeLock(&registry->lock) == CELIX_SUCCESS) {
+	if (ref == NULL && celixThreadRwlock_writeLock(&registry->referencesLock) == CELIX_SUCCESS) {
 	    status = serviceRegistry_getServiceReference_internal(registry, owner, registration, out);
-	    celixThreadRwlock_unlock(&registry->lock);
+	    celixThreadRwlock_unlock(&registry->referencesLock);
 	}
 
 	return status;
@@ -290,7 +354,7 @@ celix_status_t serviceRegistry_getServiceReference(service_registry_pt registry,
 
 static celix_status_t serviceRegistry_getServiceReference_internal(service_registry_pt registry, bundle_pt owner,
                                                    service_registration_pt registration, service_reference_pt *out) {
-	//only call after locked registry RWlock
+	//only call after write locked registry->referencesLock
 	celix_status_t status = CELIX_SUCCESS;
 	bundle_pt bundle = NULL;
     service_reference_pt ref = NULL;
@@ -329,54 +393,33 @@ static celix_status_t serviceRegistry_getServiceReference_internal(service_regis
 
 celix_status_t serviceRegistry_getServiceReferences(service_registry_pt registry, bundle_pt owner, const char *serviceName, filter_pt filter, array_list_pt *out) {
 	celix_status_t status;
-	hash_map_iterator_pt iterator;
     array_list_pt references = NULL;
 	array_list_pt matchingRegistrations = NULL;
-    bool matchResult;
 
     status = arrayList_create(&references);
     status = CELIX_DO_IF(status, arrayList_create(&matchingRegistrations));
 
-    celixThreadRwlock_readLock(&registry->lock);
-	iterator = hashMapIterator_create(registry->serviceRegistrations);
-	while (status == CELIX_SUCCESS && hashMapIterator_hasNext(iterator)) {
-		array_list_pt regs = (array_list_pt) hashMapIterator_nextValue(iterator);
-		unsigned int regIdx;
-		for (regIdx = 0; (regs != NULL) && regIdx < arrayList_size(regs); regIdx++) {
-			service_registration_pt registration = (service_registration_pt) arrayList_get(regs, regIdx);
-			properties_pt props = NULL;
-
-			status = serviceRegistration_getProperties(registration, &props);
-			if (status == CELIX_SUCCESS) {
-				bool matched = false;
-				matchResult = false;
-				if (filter != NULL) {
-					filter_match(filter, props, &matchResult);
-				}
-				if ((serviceName == NULL) && ((filter == NULL) || matchResult)) {
-					matched = true;
-				} else if (serviceName != NULL) {
-					const char *className = NULL;
-					matchResult = false;
-					serviceRegistration_getServiceName(registration, &className);
-					if (filter != NULL) {
-						filter_match(filter, props, &matchResult);
-					}
-					if ((strcmp(className, serviceName) == 0) && ((filter == NULL) || matchResult)) {
-						matched = true;
-					}
-				}
-				if (matched) {
-					if (serviceRegistration_isValid(registration)) {
-                        serviceRegistration_retain(registration);
-                        arrayList_add(matchingRegistrations, registration);
-					}
-				}
-			}
-		}
-	}
-    celixThreadRwlock_unlock(&registry->lock);
-	hashMapIterator_destroy(iterator);
+    //lock free lookup on the published snapshot, matching registrations are retained before leaving the snapshot
+    unsigned int epoch = serviceRegistry_enterSnapshot(registry);
+    struct serviceRegistrySnapshot *snapshot = __atomic_load_n(&registry->snapshot, __ATOMIC_SEQ_CST);
+    if (status == CELIX_SUCCESS && serviceName != NULL) {
+        //only visit the registrations of the requested service name
+        struct serviceRegistrySnapshotEntry *entry = serviceRegistry_findSnapshotEntry(snapshot, serviceName);
+        if (entry != NULL) {
+            struct serviceRegistrySnapshotRegistrations *regs = __atomic_load_n(&entry->registrations, __ATOMIC_SEQ_CST);
+            status = serviceRegistry_collectMatchingRegistrations(regs, filter, matchingRegistrations);
+        }
+    } else if (status == CELIX_SUCCESS) {
+        unsigned int i;
+        for (i = 0; status == CELIX_SUCCESS && i < snapshot->capacity; i += 1) {
+            struct serviceRegistrySnapshotEntry *entry = __atomic_load_n(&snapshot->entries[i], __ATOMIC_SEQ_CST);
+            if (entry != NULL) {
+                struct serviceRegistrySnapshotRegistrations *regs = __atomic_load_n(&entry->registrations, __ATOMIC_SEQ_CST);
+                status = serviceRegistry_collectMatchingRegistrations(regs, filter, matchingRegistrations);
+            }
+        }
+    }
+    serviceRegistry_exitSnapshot(registry, epoch);
 
     if (status == CELIX_SUCCESS) {
         unsigned int i;
@@ -410,12 +453,114 @@ celix_status_t serviceRegistry_getServiceReferences(service_registry_pt registry
 	return status;
 }
 
+static celix_status_t serviceRegistry_collectMatchingRegistrations(struct serviceRegistrySnapshotRegistrations *regs, filter_pt filter, array_list_pt matchingRegistrations) {
+    //precondition entered the registry snapshot
+    celix_status_t status = CELIX_SUCCESS;
+    unsigned int regIdx;
+
+    for (regIdx = 0; status == CELIX_SUCCESS && regs != NULL && regIdx < regs->size; regIdx++) {
+        service_registration_pt registration = regs->registrations[regIdx];
+        properties_pt props = NULL;
+
+        status = serviceRegistration_getProperties(registration, &props);
+        if (status == CELIX_SUCCESS) {
+            bool matchResult = false;
+            if (filter != NULL) {
+                filter_match(filter, props, &matchResult);
+            }
+            if ((filter == NULL || matchResult) && serviceRegistration_isValid(registration)) {
+                serviceRegistration_retain(registration);
+                arrayList_add(matchingRegistrations, registration);
+            }
+        }
+    }
+
+    return status;
+}
+
+static long serviceRegistry_getRanking(properties_pt properties) {
+    const char *ranking = NULL;
+    if (properties != NULL) {
+        ranking = properties_get(properties, (char *) OSGI_FRAMEWORK_SERVICE_RANKING);
+    }
+    return ranking == NULL ? 0 : strtol(ranking, NULL, 10);
+}
+
+static long serviceRegistry_getRegistrationRanking(service_registration_pt registration) {
+    long ranking = 0;
+    serviceRegistration_getRanking(registration, &ranking);
+    return ranking;
+}
+
+static void serviceRegistry_addToNameIndex(service_registry_pt registry, const char *serviceName, service_registration_pt registration, long ranking) {
+    //precondition write locked on registry->lock
+    array_list_pt regs = hashMap_get(registry->serviceRegistrationsByName, serviceName);
+    if (regs == NULL) {
+        arrayList_create(&regs);
+        hashMap_put(registry->serviceRegistrationsByName, strdup(serviceName), regs);
+    }
+
+    //keep the list ordered on highest ranking first, lowest service id for equal rankings
+    unsigned int i;
+    unsigned int size = arrayList_size(regs);
+    for (i = 0; i < size; i += 1) {
+        service_registration_pt other = arrayList_get(regs, i);
+        long otherRanking = serviceRegistry_getRegistrationRanking(other);
+        if (utils_compareServiceIdsAndRanking(registration->serviceId, ranking, other->serviceId, otherRanking) > 0) {
+            break;
+        }
+    }
+    arrayList_addIndex(regs, i, registration);
+    serviceRegistry_publishRegistrations(registry, serviceName);
+}
+
+static void serviceRegistry_removeFromNameIndex(service_registry_pt registry, service_registration_pt registration) {
+    //precondition write locked on registry->lock
+    const char *serviceName = NULL;
+    hash_map_entry_pt entry = NULL;
+
+    serviceRegistration_getServiceName(registration, &serviceName);
+    if (serviceName != NULL) {
+        entry = hashMap_getEntry(registry->serviceRegistrationsByName, serviceName);
+    }
+
+    if (entry != NULL) {
+        char *key = hashMapEntry_getKey(entry);
+        array_list_pt regs = hashMapEntry_getValue(entry);
+        arrayList_removeElement(regs, registration);
+        if (arrayList_isEmpty(regs)) {
+            hashMap_remove(registry->serviceRegistrationsByName, key);
+            arrayList_destroy(regs);
+            serviceRegistry_publishRegistrations(registry, key);
+            free(key);
+        } else {
+            serviceRegistry_publishRegistrations(registry, key);
+        }
+    }
+}
+
+static void serviceRegistry_resortNameIndex(service_registry_pt registry, service_registration_pt registration) {
+    //precondition write locked on registry->lock
+    const char *serviceName = NULL;
+    array_list_pt regs = NULL;
+
+    serviceRegistration_getServiceName(registration, &serviceName);
+    if (serviceName != NULL) {
+        regs = hashMap_get(registry->serviceRegistrationsByName, serviceName);
+    }
+
+    //the service ranking could be changed, reinsert the registration on its (new) position
+    if (regs != NULL && arrayList_size(regs) > 1 && arrayList_removeElement(regs, registration)) {
+        serviceRegistry_addToNameIndex(registry, serviceName, registration, serviceRegistry_getRegistrationRanking(registration));
+    }
+}
+
 celix_status_t serviceRegistry_retainServiceReference(service_registry_pt registry, bundle_pt bundle, service_reference_pt reference) {
     celix_status_t status = CELIX_SUCCESS;
     reference_status_t refStatus;
     bundle_pt refBundle = NULL;
     
-    celixThreadRwlock_writeLock(&registry->lock);
+    celixThreadRwlock_readLock(&registry->referencesLock);
     serviceRegistry_checkReference(registry, reference, &refStatus);
     if (refStatus == REF_ACTIVE) {
         serviceReference_getOwner(reference, &refBundle);
@@ -428,7 +573,7 @@ celix_status_t serviceRegistry_retainServiceReference(service_registry_pt regist
     } else {
         serviceRegistry_logIllegalReference(registry, reference, refStatus);
     }
-    celixThreadRwlock_unlock(&registry->lock);
+    celixThreadRwlock_unlock(&registry->referencesLock);
 
     return status;
 }
@@ -440,7 +585,7 @@ celix_status_t serviceRegistry_ungetServiceReference(service_registry_pt registr
     size_t count = 0;
     reference_status_t refStatus;
 
-    celixThreadRwlock_writeLock(&registry->lock);
+    celixThreadRwlock_writeLock(&registry->referencesLock);
     serviceRegistry_checkReference(registry, reference, &refStatus);
     if (refStatus == REF_ACTIVE) {
         serviceReference_getUsageCount(reference, &count);
@@ -486,14 +631,14 @@ celix_status_t serviceRegistry_ungetServiceReference(service_registry_pt registr
     } else {
         serviceRegistry_logIllegalReference(registry, reference, refStatus);
     }
-    celixThreadRwlock_unlock(&registry->lock);
+    celixThreadRwlock_unlock(&registry->referencesLock);
 
     return status;
 }
 
 static celix_status_t serviceRegistry_setReferenceStatus(service_registry_pt registry, service_reference_pt reference,
                                                   bool deleted) {
-    //precondition write locked on registry->lock
+    //precondition write locked on registry->referencesLock
     if (registry->checkDeletedReferences) {
         hashMap_put(registry->deletedServiceReferences, reference, (void *) deleted);
     }
@@ -508,7 +653,7 @@ static void serviceRegistry_logIllegalReference(service_registry_pt registry __a
 
 static celix_status_t serviceRegistry_checkReference(service_registry_pt registry, service_reference_pt ref,
                                               reference_status_t *out) {
-    //precondition read or write locked on registry->lock
+    //precondition read or write locked on registry->referencesLock
     celix_status_t status = CELIX_SUCCESS;
 
     if (registry->checkDeletedReferences) {
@@ -562,7 +707,7 @@ static void serviceRegistry_logWarningServiceReferenceUsageCount(service_registr
 celix_status_t serviceRegistry_clearReferencesFor(service_registry_pt registry, bundle_pt bundle) {
     celix_status_t status = CELIX_SUCCESS;
 
-    celixThreadRwlock_writeLock(&registry->lock);
+    celixThreadRwlock_writeLock(&registry->referencesLock);
 
     hash_map_pt refsMap = hashMap_remove(registry->serviceReferences, bundle);
     if (refsMap != NULL) {
@@ -591,7 +736,7 @@ celix_status_t serviceRegistry_clearReferencesFor(service_registry_pt registry,
         hashMap_destroy(refsMap, false, false);
     }
 
-    celixThreadRwlock_unlock(&registry->lock);
+    celixThreadRwlock_unlock(&registry->referencesLock);
 
     return status;
 }
@@ -603,7 +748,7 @@ celix_status_t serviceRegistry_getServicesInUse(service_registry_pt registry, bu
     arrayList_create(&result);
 
     //LOCK
-    celixThreadRwlock_readLock(&registry->lock);
+    celixThreadRwlock_readLock(&registry->referencesLock);
 
     hash_map_pt refsMap = hashMap_get(registry->serviceReferences, bundle);
 
@@ -615,7 +760,7 @@ celix_status_t serviceRegistry_getServicesInUse(service_registry_pt registry, bu
     hashMapIterator_destroy(iter);
 
     //UNLOCK
-    celixThreadRwlock_unlock(&registry->lock);
+    celixThreadRwlock_unlock(&registry->referencesLock);
 
     *out = result;
 
@@ -631,7 +776,7 @@ celix_status_t serviceRegistry_getService(service_registry_pt registry, bundle_p
 
 
 
-    celixThreadRwlock_readLock(&registry->lock);
+    celixThreadRwlock_readLock(&registry->referencesLock);
     serviceRegistry_checkReference(registry, reference, &refStatus);
     if (refStatus == REF_ACTIVE) {
         serviceReference_getServiceRegistration(reference, &registration);
@@ -654,7 +799,7 @@ celix_status_t serviceRegistry_getService(service_registry_pt registry, bundle_p
         serviceRegistry_logIllegalReference(registry, reference, refStatus);
         status = CELIX_BUNDLE_EXCEPTION;
     }
-    celixThreadRwlock_unlock(&registry->lock);
+    celixThreadRwlock_unlock(&registry->referencesLock);
 
 	return status;
 }
@@ -667,9 +812,9 @@ celix_status_t serviceRegistry_ungetService(service_registry_pt registry, bundle
     celix_status_t subStatus = CELIX_SUCCESS;
     reference_status_t refStatus;
 
-    celixThreadRwlock_readLock(&registry->lock);
+    celixThreadRwlock_readLock(&registry->referencesLock);
     serviceRegistry_checkReference(registry, reference, &refStatus);
-    celixThreadRwlock_unlock(&registry->lock);
+    celixThreadRwlock_unlock(&registry->referencesLock);
 
     if (refStatus == REF_ACTIVE) {
         subStatus = serviceReference_decreaseUsage(reference, &count);
@@ -759,6 +904,10 @@ celix_status_t serviceRegistry_getListenerHooks(service_registry_pt registry, bu
 }
 
 celix_status_t serviceRegistry_servicePropertiesModified(service_registry_pt registry, service_registration_pt registration, properties_pt oldprops) {
+	celixThreadRwlock_writeLock(&registry->lock);
+	serviceRegistry_resortNameIndex(registry, registration);
+	celixThreadRwlock_unlock(&registry->lock);
+
 	if (registry->serviceChanged != NULL) {
 		registry->serviceChanged(registry->framework, OSGI_FRAMEWORK_SERVICE_EVENT_MODIFIED, registration, oldprops);
 	}
@@ -772,7 +921,7 @@ static celix_status_t serviceRegistry_getUsingBundles(service_registry_pt regist
 
     status = arrayList_create(&bundles);
     if (status == CELIX_SUCCESS) {
-        celixThreadRwlock_readLock(&registry->lock);
+        celixThreadRwlock_readLock(&registry->referencesLock);
         iter = hashMapIterator_create(registry->serviceReferences);
         while (hashMapIterator_hasNext(iter)) {
             hash_map_entry_pt entry = hashMapIterator_nextEntry(iter);
@@ -783,7 +932,7 @@ static celix_status_t serviceRegistry_getUsingBundles(service_registry_pt regist
             }
         }
         hashMapIterator_destroy(iter);
-        celixThreadRwlock_unlock(&registry->lock);
+        celixThreadRwlock_unlock(&registry->referencesLock);
     }
 
     if (status == CELIX_SUCCESS) {
@@ -796,3 +945,161 @@ static celix_status_t serviceRegistry_getUsingBundles(service_registry_pt regist
 
     return status;
 }
+
+static struct serviceRegistrySnapshot * serviceRegistry_createSnapshot(unsigned int capacity) {
+    struct serviceRegistrySnapshot *snapshot = calloc(1, sizeof(*snapshot) + capacity * sizeof(struct serviceRegistrySnapshotEntry *));
+    if (snapshot != NULL) {
+        snapshot->capacity = capacity;
+        snapshot->used = 0;
+    }
+    return snapshot;
+}
+
+static struct serviceRegistrySnapshotEntry * serviceRegistry_findSnapshotEntry(struct serviceRegistrySnapshot *snapshot, const char *serviceName) {
+    //precondition entered the registry snapshot or write locked registry->lock
+    unsigned int mask = snapshot->capacity - 1;
+    unsigned int index = utils_stringHash(serviceName) & mask;
+    struct serviceRegistrySnapshotEntry *entry = __atomic_load_n(&snapshot->entries[index], __ATOMIC_SEQ_CST);
+
+    //the snapshot is never more than half full, so there is always an empty slot to end the probe
+    while (entry != NULL && strcmp(entry->serviceName, serviceName) != 0) {
+        index = (index + 1) & mask;
+        entry = __atomic_load_n(&snapshot->entries[index], __ATOMIC_SEQ_CST);
+    }
+
+    return entry;
+}
+
+static void serviceRegistry_insertSnapshotEntry(struct serviceRegistrySnapshot *snapshot, struct serviceRegistrySnapshotEntry *entry) {
+    //precondition write locked registry->lock and snapshot has free slots
+    unsigned int mask = snapshot->capacity - 1;
+    unsigned int index = utils_stringHash(entry->serviceName) & mask;
+
+    while (snapshot->entries[index] != NULL) {
+        index = (index + 1) & mask;
+    }
+    __atomic_store_n(&snapshot->entries[index], entry, __ATOMIC_SEQ_CST);
+    snapshot->used += 1;
+}
+
+celix_status_t serviceRegistry_publishRegistrations(service_registry_pt registry, const char *serviceName) {
+    //precondition write locked registry->lock
+    celix_status_t status = CELIX_SUCCESS;
+    struct serviceRegistrySnapshotRegistrations *published = NULL;
+    struct serviceRegistrySnapshotRegistrations *retiredRegistrations = NULL;
+    struct serviceRegistrySnapshot *retiredSnapshot = NULL;
+    array_list_pt retiredEntries = NULL;
+
+    array_list_pt regs = hashMap_get(registry->serviceRegistrationsByName, serviceName);
+    unsigned int size = regs == NULL ? 0 : arrayList_size(regs);
+    if (size > 0) {
+        published = malloc(sizeof(*published) + size * sizeof(service_registration_pt));
+        if (published != NULL) {
+            unsigned int i;
+            published->size = size;
+            for (i = 0; i < size; i += 1) {
+                published->registrations[i] = arrayList_get(regs, i);
+            }
+        } else {
+            status = CELIX_ENOMEM;
+        }
+    }
+
+    struct serviceRegistrySnapshot *snapshot = registry->snapshot;
+    struct serviceRegistrySnapshotEntry *entry = status == CELIX_SUCCESS ? serviceRegistry_findSnapshotEntry(snapshot, serviceName) : NULL;
+    if (entry != NULL) {
+        retiredRegistrations = __atomic_exchange_n(&entry->registrations, published, __ATOMIC_SEQ_CST);
+    } else if (published != NULL) {
+        entry = calloc(1, sizeof(*entry));
+        if (entry != NULL) {
+            entry->serviceName = strdup(serviceName);
+            entry->registrations = published;
+        } else {
+            free(published);
+            status = CELIX_ENOMEM;
+        }
+
+        if (status == CELIX_SUCCESS && (snapshot->used + 1) * 2 > snapshot->capacity) {
+            //grow (or compact) the snapshot, entries without registrations are dropped
+            unsigned int i;
+            unsigned int live = 1;
+            unsigned int capacity = 16;
+            for (i = 0; i < snapshot->capacity; i += 1) {
+                if (snapshot->entries[i] != NULL && snapshot->entries[i]->registrations != NULL) {
+                    live += 1;
+                }
+            }
+            while (live * 2 > capacity) {
+                capacity *= 2;
+            }
+
+            struct serviceRegistrySnapshot *grown = serviceRegistry_createSnapshot(capacity);
+            if (grown != NULL) {
+                arrayList_create(&retiredEntries);
+                for (i = 0; i < snapshot->capacity; i += 1) {
+                    struct serviceRegistrySnapshotEntry *current = snapshot->entries[i];
+                    if (current != NULL && current->registrations != NULL) {
+                        serviceRegistry_insertSnapshotEntry(grown, current);
+                    } else if (current != NULL) {
+                        arrayList_add(retiredEntries, current);
+                    }
+                }
+                serviceRegistry_insertSnapshotEntry(grown, entry);
+                retiredSnapshot = __atomic_exchange_n(&registry->snapshot, grown, __ATOMIC_SEQ_CST);
+            } else {
+                free(entry->serviceName);
+                free(entry->registrations);
+                free(entry);
+                status = CELIX_ENOMEM;
+            }
+        } else if (status == CELIX_SUCCESS) {
+            serviceRegistry_insertSnapshotEntry(snapshot, entry);
+        }
+    }
+
+    if (retiredRegistrations != NULL || retiredSnapshot != NULL) {
+        //wait till no reader can access the retired data anymore
+        serviceRegistry_synchronizeSnapshot(registry);
+        free(retiredRegistrations);
+        free(retiredSnapshot);
+        if (retiredEntries != NULL) {
+            unsigned int i;
+            for (i = 0; i < arrayList_size(retiredEntries); i += 1) {
+                struct serviceRegistrySnapshotEntry *retired = arrayList_get(retiredEntries, i);
+                free(retired->serviceName);
+                free(retired);
+            }
+        }
+    }
+    if (retiredEntries != NULL) {
+        arrayList_destroy(retiredEntries);
+    }
+
+    framework_logIfError(logger, status, NULL, "Cannot publish service registrations");
+
+    return status;
+}
+
+static unsigned int serviceRegistry_enterSnapshot(service_registry_pt registry) {
+    unsigned int epoch = __atomic_load_n(&registry->snapshotEpoch, __ATOMIC_SEQ_CST) & 1;
+    __atomic_add_fetch(&registry->snapshotReaders[epoch], 1, __ATOMIC_SEQ_CST);
+    return epoch;
+}
+
+static void serviceRegistry_exitSnapshot(service_registry_pt registry, unsigned int epoch) {
+    __atomic_sub_fetch(&registry->snapshotReaders[epoch], 1, __ATOMIC_SEQ_CST);
+}
+
+static void serviceRegistry_synchronizeSnapshot(service_registry_pt registry) {
+    //precondition write locked registry->lock
+    //Flip the epoch twice and wait for the readers of the previous epoch each time. After this every reader which
+    //could have seen the data retired before this call has left the snapshot, regardless of the epoch it entered.
+    int i;
+    for (i = 0; i < 2; i += 1) {
+        unsigned int epoch = __atomic_load_n(&registry->snapshotEpoch, __ATOMIC_SEQ_CST) & 1;
+        __atomic_store_n(&registry->snapshotEpoch, epoch ^ 1, __ATOMIC_SEQ_CST);
+        while (__atomic_load_n(&registry->snapshotReaders[epoch], __ATOMIC_SEQ_CST) != 0) {
+            sched_yield();
+        }
+    }
+}
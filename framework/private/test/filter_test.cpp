@@ -467,6 +467,56 @@ TEST(filter, match_operators){
 	mock().checkExpectations();
 }
 
+TEST(filter, match_typed_operators){
+	char * filter_str;
+	filter_pt filter;
+	properties_pt props = properties_create();
+	properties_set(props, "long_attr", "10");
+	properties_set(props, "double_attr", "2.5");
+	properties_set(props, "version_attr", "1.10.0");
+
+	//test numeric compare (a string compare would give "10" < "9")
+	filter_str = my_strdup("(long_attr>9)");
+	filter = filter_create(filter_str);
+	bool result = false;
+	filter_match(filter, props, &result);
+	CHECK(result);
+
+	//test LESSEQUAL long against a double value
+	filter_destroy(filter);
+	free(filter_str);
+	filter_str = my_strdup("(double_attr<=3)");
+	filter = filter_create(filter_str);
+	result = false;
+	filter_match(filter, props, &result);
+	CHECK(result);
+
+	//test GREATEREQUAL double
+	filter_destroy(filter);
+	free(filter_str);
+	filter_str = my_strdup("(double_attr>=2.6)");
+	filter = filter_create(filter_str);
+	result = true;
+	filter_match(filter, props, &result);
+	CHECK_FALSE(result);
+
+	//test version compare (a string compare would give "1.10.0" < "1.9.0")
+	filter_destroy(filter);
+	free(filter_str);
+	filter_str = my_strdup("(version_attr>1.9.0)");
+	filter = filter_create(filter_str);
+	result = false;
+	filter_match(filter, props, &result);
+	CHECK(result);
+
+	//cleanup
+	properties_destroy(props);
+	filter_destroy(filter);
+	free(filter_str);
+
+	mock().checkExpectations();
+}
+
 TEST(filter, match_recursion){
 
 	char * filter_str = my_strdup("(&(test_attr1=attr1)(|(&(test_attr2=attr2)(!(&(test_attr1=attr1)(test_attr3=attr3))))(test_attr3=attr3)))");
@@ -555,3 +605,68 @@ TEST(filter, getString){
 }
 
 
+
+TEST(filter, getRequiredEqualValue){
+	const char * value = NULL;
+
+	//a single equal term
+	filter_pt filter = filter_create("(objectClass=x)");
+	LONGS_EQUAL(CELIX_SUCCESS, filter_getRequiredEqualValue(filter, "objectClass", &value));
+	STRCMP_EQUAL("x", value);
+	LONGS_EQUAL(CELIX_SUCCESS, filter_getRequiredEqualValue(filter, "other", &value));
+	POINTERS_EQUAL(NULL, value);
+	filter_destroy(filter);
+
+	//a conjunct of an and
+	filter = filter_create("(&(objectClass=x)(a=b))");
+	filter_getRequiredEqualValue(filter, "objectClass", &value);
+	STRCMP_EQUAL("x", value);
+	filter_getRequiredEqualValue(filter, "a", &value);
+	STRCMP_EQUAL("b", value);
+	filter_destroy(filter);
+
+	filter = filter_create("(&(a>=1)(&(b=2)(objectClass=x)))");
+	filter_getRequiredEqualValue(filter, "objectClass", &value);
+	STRCMP_EQUAL("x", value);
+	filter_destroy(filter);
+
+	//an or can match either value
+	filter = filter_create("(|(objectClass=x)(objectClass=y))");
+	value = "dummy";
+	filter_getRequiredEqualValue(filter, "objectClass", &value);
+	POINTERS_EQUAL(NULL, value);
+	filter_destroy(filter);
+
+	filter = filter_create("(&(|(objectClass=x)(objectClass=y))(a=b))");
+	filter_getRequiredEqualValue(filter, "objectClass", &value);
+	POINTERS_EQUAL(NULL, value);
+	filter_destroy(filter);
+
+	//substring, approx, present and not match other values as well
+	filter = filter_create("(objectClass=x*)");
+	filter_getRequiredEqualValue(filter, "objectClass", &value);
+	POINTERS_EQUAL(NULL, value);
+	filter_destroy(filter);
+
+	filter = filter_create("(objectClass~=x)");
+	filter_getRequiredEqualValue(filter, "objectClass", &value);
+	POINTERS_EQUAL(NULL, value);
+	filter_destroy(filter);
+
+	filter = filter_create("(objectClass=*)");
+	filter_getRequiredEqualValue(filter, "objectClass", &value);
+	POINTERS_EQUAL(NULL, value);
+	filter_destroy(filter);
+
+	filter = filter_create("(!(objectClass=x))");
+	filter_getRequiredEqualValue(filter, "objectClass", &value);
+	POINTERS_EQUAL(NULL, value);
+	filter_destroy(filter);
+
+	//no filter
+	value = "dummy";
+	LONGS_EQUAL(CELIX_SUCCESS, filter_getRequiredEqualValue(NULL, "objectClass", &value));
+	POINTERS_EQUAL(NULL, value);
+
+	mock().checkExpectations();
+}
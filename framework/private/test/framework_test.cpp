@@ -34,6 +34,8 @@
 extern "C" {
 #include "framework.h"
 #include "framework_private.h"
+#include "constants.h"
+#include "utils.h"
 }
 
 int main(int argc, char** argv) {
@@ -105,7 +107,204 @@ TEST(framework, installBundle){
 
 }*/
 
+//----------------SERVICE LISTENER INDEX TESTS----------------
+extern "C" {
+	static array_list_pt notified = NULL;
 
+	static celix_status_t serviceListenerIndexTest_serviceChanged(void *listener, service_event_pt event) {
+		arrayList_add(notified, listener);
+		return CELIX_SUCCESS;
+	}
+}
 
+TEST_GROUP(framework_serviceListenerIndex) {
+	framework_pt framework;
+	bundle_pt bundle;
 
+	void setup(void) {
+		framework = (framework_pt) calloc(1, sizeof(*framework));
+		framework->bundle = (bundle_pt) 0x10;
+		framework->registry = (service_registry_pt) 0x20;
+		arrayList_create(&framework->serviceListeners);
+		arrayList_create(&framework->unindexedServiceListeners);
+		framework->serviceListenersByObjectClass = hashMap_create(utils_stringHash, NULL, utils_stringEquals, NULL);
+		bundle = (bundle_pt) 0x30;
+		arrayList_create(&notified);
+	}
 
+	void teardown() {
+		hash_map_iterator_pt iter = hashMapIterator_create(framework->serviceListenersByObjectClass);
+		while (hashMapIterator_hasNext(iter)) {
+			arrayList_destroy((array_list_pt) hashMapIterator_nextValue(iter));
+		}
+		hashMapIterator_destroy(iter);
+		hashMap_destroy(framework->serviceListenersByObjectClass, true, false);
+		arrayList_destroy(framework->unindexedServiceListeners);
+		arrayList_destroy(framework->serviceListeners);
+		free(framework);
+		arrayList_destroy(notified);
+
+		mock().checkExpectations();
+		mock().clear();
+	}
+
+	void addListener(service_listener_pt listener, const char *filterStr, filter_pt filter, const char *requiredObjectClass) {
+		array_list_pt hooks = NULL;
+		bundle_context_pt context = (bundle_context_pt) 0x40;
+
+		arrayList_create(&hooks);
+		if (filterStr != NULL) {
+			mock().expectOneCall("filter_create")
+				.withParameter("filterString", filterStr)
+				.andReturnValue(filter);
+		}
+		mock().expectOneCall("filter_getRequiredEqualValue")
+			.withParameter("filter", filter)
+			.withParameter("attribute", OSGI_FRAMEWORK_OBJECTCLASS)
+			.withOutputParameterReturning("value", &requiredObjectClass, sizeof(requiredObjectClass))
+			.andReturnValue(CELIX_SUCCESS);
+		mock().expectOneCall("serviceRegistry_getListenerHooks")
+			.withParameter("registry", framework->registry)
+			.withParameter("bundle", framework->bundle)
+			.withOutputParameterReturning("hooks", &hooks, sizeof(hooks))
+			.andReturnValue(CELIX_SUCCESS);
+		mock().expectOneCall("bundle_getContext")
+			.withParameter("bundle", bundle)
+			.withOutputParameterReturning("context", &context, sizeof(context))
+			.andReturnValue(CELIX_SUCCESS);
+
+		fw_addServiceListener(framework, bundle, listener, filterStr);
+	}
+
+	void removeListener(service_listener_pt listener, filter_pt filter) {
+		array_list_pt hooks = NULL;
+		bundle_context_pt context = (bundle_context_pt) 0x40;
+		const char *filterStr = NULL;
+
+		arrayList_create(&hooks);
+		mock().expectNCalls(2, "bundle_getContext")
+			.withParameter("bundle", bundle)
+			.withOutputParameterReturning("context", &context, sizeof(context))
+			.andReturnValue(CELIX_SUCCESS);
+		mock().expectOneCall("filter_getString")
+			.withParameter("filter", filter)
+			.withOutputParameterReturning("filterStr", &filterStr, sizeof(filterStr))
+			.andReturnValue(CELIX_SUCCESS);
+		mock().expectOneCall("filter_destroy")
+			.withParameter("filter", filter);
+		mock().expectOneCall("serviceRegistry_getListenerHooks")
+			.withParameter("registry", framework->registry)
+			.withParameter("bundle", framework->bundle)
+			.withOutputParameterReturning("hooks", &hooks, sizeof(hooks))
+			.andReturnValue(CELIX_SUCCESS);
+
+		fw_removeServiceListener(framework, bundle, listener);
+	}
+
+	int indexedListeners(const char *objectClass) {
+		array_list_pt listeners = (array_list_pt) hashMap_get(framework->serviceListenersByObjectClass, objectClass);
+		return listeners == NULL ? 0 : arrayList_size(listeners);
+	}
+};
+
+TEST(framework_serviceListenerIndex, index){
+	struct serviceListener andListener = {NULL, serviceListenerIndexTest_serviceChanged};
+	struct serviceListener orListener = {NULL, serviceListenerIndexTest_serviceChanged};
+	struct serviceListener substringListener = {NULL, serviceListenerIndexTest_serviceChanged};
+	struct serviceListener noFilterListener = {NULL, serviceListenerIndexTest_serviceChanged};
+	filter_pt andFilter = (filter_pt) 0x50;
+	filter_pt orFilter = (filter_pt) 0x51;
+	filter_pt substringFilter = (filter_pt) 0x52;
+
+	//only a required objectClass is used as index
+	addListener(&andListener, "(&(objectClass=x)(a=b))", andFilter, "x");
+	addListener(&orListener, "(|(objectClass=x)(objectClass=y))", orFilter, NULL);
+	addListener(&substringListener, "(objectClass=x*)", substringFilter, NULL);
+	addListener(&noFilterListener, NULL, NULL, NULL);
+
+	LONGS_EQUAL(4, arrayList_size(framework->serviceListeners));
+	LONGS_EQUAL(1, indexedListeners("x"));
+	LONGS_EQUAL(0, indexedListeners("y"));
+	LONGS_EQUAL(3, arrayList_size(framework->unindexedServiceListeners));
+	CHECK(arrayList_contains(framework->unindexedServiceListeners, arrayList_get(framework->serviceListeners, 3)));
+
+	removeListener(&andListener, andFilter);
+	removeListener(&noFilterListener, NULL);
+	LONGS_EQUAL(0, indexedListeners("x"));
+	LONGS_EQUAL(2, arrayList_size(framework->unindexedServiceListeners));
+
+	removeListener(&orListener, orFilter);
+	removeListener(&substringListener, substringFilter);
+	LONGS_EQUAL(0, arrayList_size(framework->serviceListeners));
+	LONGS_EQUAL(0, arrayList_size(framework->unindexedServiceListeners));
+}
+
+TEST(framework_serviceListenerIndex, serviceChanged){
+	struct serviceListener indexedListener = {NULL, serviceListenerIndexTest_serviceChanged};
+	struct serviceListener noFilterListener = {NULL, serviceListenerIndexTest_serviceChanged};
+	filter_pt filter = (filter_pt) 0x50;
+	service_registration_pt registration = (service_registration_pt) 0x60;
+	service_reference_pt reference = (service_reference_pt) 0x70;
+	properties_pt props = properties_create();
+	bool match = true;
+
+	addListener(&indexedListener, "(&(objectClass=x)(a=b))", filter, "x");
+	addListener(&noFilterListener, NULL, NULL, NULL);
+
+	//a service of another objectClass only reaches the listener without filter, the indexed filter is not evaluated
+	properties_set(props, (char *) OSGI_FRAMEWORK_OBJECTCLASS, (char *) "y");
+	mock().expectOneCall("serviceRegistration_getProperties")
+		.withParameter("registration", registration)
+		.withOutputParameterReturning("properties", &props, sizeof(props))
+		.andReturnValue(CELIX_SUCCESS);
+	mock().expectOneCall("serviceRegistry_getServiceReference")
+		.withParameter("registry", framework->registry)
+		.withParameter("bundle", bundle)
+		.withParameter("registration", registration)
+		.withOutputParameterReturning("reference", &reference, sizeof(reference))
+		.andReturnValue(CELIX_SUCCESS);
+	mock().expectOneCall("serviceRegistry_ungetServiceReference")
+		.withParameter("registry", framework->registry)
+		.withParameter("bundle", bundle)
+		.withParameter("reference", reference)
+		.andReturnValue(CELIX_SUCCESS);
+
+	fw_serviceChanged(framework, OSGI_FRAMEWORK_SERVICE_EVENT_UNREGISTERING, registration, NULL);
+	mock().checkExpectations();
+	LONGS_EQUAL(1, arrayList_size(notified));
+	POINTERS_EQUAL(&noFilterListener, arrayList_get(notified, 0));
+
+	//a service of the indexed objectClass reaches both, in order of addition
+	arrayList_clear(notified);
+	properties_set(props, (char *) OSGI_FRAMEWORK_OBJECTCLASS, (char *) "x");
+	mock().expectOneCall("serviceRegistration_getProperties")
+		.withParameter("registration", registration)
+		.withOutputParameterReturning("properties", &props, sizeof(props))
+		.andReturnValue(CELIX_SUCCESS);
+	mock().expectOneCall("filter_match")
+		.withParameter("filter", filter)
+		.withParameter("properties", props)
+		.withOutputParameterReturning("result", &match, sizeof(match))
+		.andReturnValue(CELIX_SUCCESS);
+	mock().expectNCalls(2, "serviceRegistry_getServiceReference")
+		.withParameter("registry", framework->registry)
+		.withParameter("bundle", bundle)
+		.withParameter("registration", registration)
+		.withOutputParameterReturning("reference", &reference, sizeof(reference))
+		.andReturnValue(CELIX_SUCCESS);
+	mock().expectNCalls(2, "serviceRegistry_ungetServiceReference")
+		.withParameter("registry", framework->registry)
+		.withParameter("bundle", bundle)
+		.withParameter("reference", reference)
+		.andReturnValue(CELIX_SUCCESS);
+
+	fw_serviceChanged(framework, OSGI_FRAMEWORK_SERVICE_EVENT_UNREGISTERING, registration, NULL);
+	mock().checkExpectations();
+	LONGS_EQUAL(2, arrayList_size(notified));
+	POINTERS_EQUAL(&indexedListener, arrayList_get(notified, 0));
+	POINTERS_EQUAL(&noFilterListener, arrayList_get(notified, 1));
+
+	removeListener(&indexedListener, filter);
+	removeListener(&noFilterListener, NULL);
+	properties_destroy(props);
+}
@@ -32,7 +32,7 @@
 #include "CppUTestExt/MockSupport.h"
 
 extern "C" {
-#include "properties.h"
+#include "properties_private.h"
 }
 
 int main(int argc, char** argv) {
@@ -122,3 +122,58 @@ TEST(properties, getSet) {
 	properties_destroy(properties);
 }
 
+TEST(properties, unset) {
+	properties = properties_create();
+	properties_set(properties, "x", "1");
+	properties_set(properties, "y", "2");
+
+	properties_unset(properties, "x");
+	properties_unset(properties, "unknown");
+	LONGS_EQUAL(1, hashMap_size(properties));
+	POINTERS_EQUAL(NULL, properties_get(properties, "x"));
+	STRCMP_EQUAL("2", properties_get(properties, "y"));
+
+	properties_destroy(properties);
+}
+
+TEST(properties, internedKeys) {
+	properties_pt other = properties_create();
+	properties = properties_create();
+	properties_set(properties, "service.ranking", "1");
+	properties_set(other, "service.ranking", "2");
+
+	//both property sets share the same key
+	hash_map_entry_pt entry = hashMap_getEntry(properties, "service.ranking");
+	hash_map_entry_pt otherEntry = hashMap_getEntry(other, "service.ranking");
+	POINTERS_EQUAL(hashMapEntry_getKey(entry), hashMapEntry_getKey(otherEntry));
+
+	const char *key = properties_internKey("service.ranking");
+	POINTERS_EQUAL(hashMapEntry_getKey(entry), key);
+	STRCMP_EQUAL("1", properties_get(properties, key));
+	properties_releaseKey(key);
+
+	properties_destroy(properties);
+	STRCMP_EQUAL("2", properties_get(other, "service.ranking"));
+	properties_destroy(other);
+}
+
+TEST(properties, grow) {
+	char key[32];
+	char value[32];
+	int i;
+
+	properties = properties_create();
+	for (i = 0; i < 100; i++) {
+		snprintf(key, sizeof(key), "key%d", i);
+		snprintf(value, sizeof(value), "%d", i);
+		properties_set(properties, key, value);
+	}
+	LONGS_EQUAL(100, hashMap_size(properties));
+	for (i = 0; i < 100; i++) {
+		snprintf(key, sizeof(key), "key%d", i);
+		snprintf(value, sizeof(value), "%d", i);
+		STRCMP_EQUAL(value, properties_get(properties, key));
+	}
+
+	properties_destroy(properties);
+}
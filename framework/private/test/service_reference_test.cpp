@@ -531,13 +531,21 @@ TEST(service_reference, equals2) {
 	mock().checkExpectations();
 }
 
+static void serviceReferenceTest_expectIdAndRanking(service_registration_pt registration, unsigned long *id, long *ranking) {
+	mock().expectOneCall("serviceRegistration_getServiceId")
+			.withParameter("registration", registration)
+			.withOutputParameterReturning("serviceId", id, sizeof(*id));
+	mock().expectOneCall("serviceRegistration_getRanking")
+			.withParameter("registration", registration)
+			.withOutputParameterReturning("ranking", ranking, sizeof(*ranking));
+}
+
 TEST(service_reference, compareTo){
 	service_reference_pt reference = (service_reference_pt) malloc(sizeof(*reference));
 	service_registration_pt registration = (service_registration_pt) 0x10;
 	reference->registration = registration;
 	bundle_pt bundle = (bundle_pt) 0x20;
 	reference->registrationBundle = bundle;
-	properties_pt props = (properties_pt) 0x30;
 	celixThreadRwlock_create(&reference->lock, NULL);
 
 	service_reference_pt reference2 = (service_reference_pt) malloc(sizeof(*reference2));
@@ -545,150 +553,64 @@ TEST(service_reference, compareTo){
 	reference2->registration = registration2;
 	bundle_pt bundle2 = (bundle_pt) 0x50;
 	reference2->registrationBundle = bundle2;
-	properties_pt props2 = (properties_pt) 0x60;
 	celixThreadRwlock_create(&reference2->lock, NULL);
 
 	int compare;
+	unsigned long id, id2;
+	long ranking, ranking2;
 
-	mock().expectNCalls(12, "serviceRegistration_getProperties")
-			.withParameter("registration", registration)
-			.withOutputParameterReturning("properties", &props, sizeof(props));
-	mock().expectNCalls(12, "serviceRegistration_getProperties")
-			.withParameter("registration", registration2)
-			.withOutputParameterReturning("properties", &props2, sizeof(props2));
+	//service id and ranking are cached by the registration
+	serviceReferenceTest_expectIdAndRanking(registration, &id, &ranking);
+	serviceReferenceTest_expectIdAndRanking(registration2, &id2, &ranking2);
 
 	//service 1 is higher ranked and has a irrelevant ID
-	mock().expectOneCall("properties_get")
-			.withParameter("key", OSGI_FRAMEWORK_SERVICE_ID)
-			.withParameter("properties", props)
-			.andReturnValue("2");
-	mock().expectOneCall("properties_get")
-			.withParameter("key", OSGI_FRAMEWORK_SERVICE_ID)
-			.withParameter("properties", props2)
-			.andReturnValue("1");
-
-	mock().expectOneCall("properties_get")
-			.withParameter("key", OSGI_FRAMEWORK_SERVICE_RANKING)
-			.withParameter("properties", props)
-			.andReturnValue("2");
-	mock().expectOneCall("properties_get")
-			.withParameter("key", OSGI_FRAMEWORK_SERVICE_RANKING)
-			.withParameter("properties", props2)
-			.andReturnValue("1");
-
+	id = 2; ranking = 2;
+	id2 = 1; ranking2 = 1;
 	serviceReference_compareTo(reference, reference2, &compare);
 	LONGS_EQUAL(1, compare);
 
 	//service 1 is equally ranked and has a lower ID
-	mock().expectOneCall("properties_get")
-			.withParameter("key", OSGI_FRAMEWORK_SERVICE_ID)
-			.withParameter("properties", props)
-			.andReturnValue("1");
-	mock().expectOneCall("properties_get")
-			.withParameter("key", OSGI_FRAMEWORK_SERVICE_ID)
-			.withParameter("properties", props2)
-			.andReturnValue("2");
-
-	mock().expectOneCall("properties_get")
-			.withParameter("key", OSGI_FRAMEWORK_SERVICE_RANKING)
-			.withParameter("properties", props)
-			.andReturnValue("1");
-	mock().expectOneCall("properties_get")
-			.withParameter("key", OSGI_FRAMEWORK_SERVICE_RANKING)
-			.withParameter("properties", props2)
-			.andReturnValue("1");
-
+	serviceReferenceTest_expectIdAndRanking(registration, &id, &ranking);
+	serviceReferenceTest_expectIdAndRanking(registration2, &id2, &ranking2);
+	id = 1; ranking = 1;
+	id2 = 2; ranking2 = 1;
 	serviceReference_compareTo(reference, reference2, &compare);
 	LONGS_EQUAL(1, compare);
 
 	//service 1 is equally ranked and has a higher ID
-	mock().expectOneCall("properties_get")
-			.withParameter("key", OSGI_FRAMEWORK_SERVICE_ID)
-			.withParameter("properties", props)
-			.andReturnValue("2");
-	mock().expectOneCall("properties_get")
-			.withParameter("key", OSGI_FRAMEWORK_SERVICE_ID)
-			.withParameter("properties", props2)
-			.andReturnValue("1");
-
-	mock().expectOneCall("properties_get")
-			.withParameter("key", OSGI_FRAMEWORK_SERVICE_RANKING)
-			.withParameter("properties", props)
-			.andReturnValue("1");
-	mock().expectOneCall("properties_get")
-			.withParameter("key", OSGI_FRAMEWORK_SERVICE_RANKING)
-			.withParameter("properties", props2)
-			.andReturnValue("1");
-
+	serviceReferenceTest_expectIdAndRanking(registration, &id, &ranking);
+	serviceReferenceTest_expectIdAndRanking(registration2, &id2, &ranking2);
+	id = 2; ranking = 1;
+	id2 = 1; ranking2 = 1;
 	serviceReference_compareTo(reference, reference2, &compare);
 	LONGS_EQUAL(-1, compare);
 
 	//service 1 is lower ranked and has a irrelevant ID
-	mock().expectOneCall("properties_get")
-			.withParameter("key", OSGI_FRAMEWORK_SERVICE_ID)
-			.withParameter("properties", props)
-			.andReturnValue("1");
-	mock().expectOneCall("properties_get")
-			.withParameter("key", OSGI_FRAMEWORK_SERVICE_ID)
-			.withParameter("properties", props2)
-			.andReturnValue("2");
-
-	mock().expectOneCall("properties_get")
-			.withParameter("key", OSGI_FRAMEWORK_SERVICE_RANKING)
-			.withParameter("properties", props)
-			.andReturnValue("1");
-	mock().expectOneCall("properties_get")
-			.withParameter("key", OSGI_FRAMEWORK_SERVICE_RANKING)
-			.withParameter("properties", props2)
-			.andReturnValue("2");
-
+	serviceReferenceTest_expectIdAndRanking(registration, &id, &ranking);
+	serviceReferenceTest_expectIdAndRanking(registration2, &id2, &ranking2);
+	id = 1; ranking = 1;
+	id2 = 2; ranking2 = 2;
 	serviceReference_compareTo(reference, reference2, &compare);
 	LONGS_EQUAL(-1, compare);
 
 	//service 1 is equal in ID and irrelevantly ranked
-	mock().expectOneCall("properties_get")
-			.withParameter("key", OSGI_FRAMEWORK_SERVICE_ID)
-			.withParameter("properties", props)
-			.andReturnValue("1);");
-	mock().expectOneCall("properties_get")
-			.withParameter("key", OSGI_FRAMEWORK_SERVICE_ID)
-			.withParameter("properties", props2)
-			.andReturnValue("1");
-
-	mock().expectOneCall("properties_get")
-			.withParameter("key", OSGI_FRAMEWORK_SERVICE_RANKING)
-			.withParameter("properties", props)
-			.andReturnValue("1");
-	mock().expectOneCall("properties_get")
-			.withParameter("key", OSGI_FRAMEWORK_SERVICE_RANKING)
-			.withParameter("properties", props2)
-			.andReturnValue("1");
-
+	serviceReferenceTest_expectIdAndRanking(registration, &id, &ranking);
+	serviceReferenceTest_expectIdAndRanking(registration2, &id2, &ranking2);
+	id = 1; ranking = 1;
+	id2 = 1; ranking2 = 1;
 	serviceReference_compareTo(reference, reference2, &compare);
 	LONGS_EQUAL(0, compare);
 
 	//services have no rank and service 1 has a higher ID
-	mock().expectOneCall("properties_get")
-			.withParameter("key", OSGI_FRAMEWORK_SERVICE_ID)
-			.withParameter("properties", props)
-			.andReturnValue("2");
-	mock().expectOneCall("properties_get")
-			.withParameter("key", OSGI_FRAMEWORK_SERVICE_ID)
-			.withParameter("properties", props2)
-			.andReturnValue("1");
-
-	mock().expectOneCall("properties_get")
-			.withParameter("key", OSGI_FRAMEWORK_SERVICE_RANKING)
-			.withParameter("properties", props)
-			.andReturnValue((void*)NULL);
-	mock().expectOneCall("properties_get")
-			.withParameter("key", OSGI_FRAMEWORK_SERVICE_RANKING)
-			.withParameter("properties", props2)
-			.andReturnValue((void*)NULL);
-
+	serviceReferenceTest_expectIdAndRanking(registration, &id, &ranking);
+	serviceReferenceTest_expectIdAndRanking(registration2, &id2, &ranking2);
+	id = 2; ranking = 0;
+	id2 = 1; ranking2 = 0;
 	serviceReference_compareTo(reference, reference2, &compare);
 	LONGS_EQUAL(-1, compare);
 
+	celixThreadRwlock_destroy(&reference->lock);
+	celixThreadRwlock_destroy(&reference2->lock);
 	free(reference);
 	free(reference2);
 
@@ -117,6 +117,7 @@ TEST(service_registry, create) {
 	CHECK(registry->listenerHooks != NULL);
 	CHECK(registry->serviceReferences != NULL);
 	CHECK(registry->serviceRegistrations != NULL);
+	CHECK(registry->serviceRegistrationsByName != NULL);
 
 	serviceRegistry_destroy(registry);
 }
@@ -324,6 +325,12 @@ TEST(service_registry, unregisterService) {
 		.withParameter("properties", properties)
 		.withParameter("key", (char *)OSGI_FRAMEWORK_OBJECTCLASS)
 		.andReturnValue((char*)OSGI_FRAMEWORK_LISTENER_HOOK_SERVICE_NAME);
+	char *serviceName = (char *) "test";
+	mock()
+		.expectOneCall("serviceRegistration_getServiceName")
+		.withParameter("registration", registration)
+		.withOutputParameterReturning("serviceName", &serviceName, sizeof(serviceName))
+		.andReturnValue(CELIX_SUCCESS);
 
 	mock()
 		.expectOneCall("serviceRegistryTest_serviceChanged")
@@ -398,6 +405,13 @@ TEST(service_registry, clearServiceRegistrations){
 		.withParameter("registration", reg)
 		.andReturnValue(false);
 
+	//the invalid registration is removed from the service name index
+	mock()
+		.expectOneCall("serviceRegistration_getServiceName")
+		.withParameter("registration", reg)
+		.withOutputParameterReturning("serviceName", &serviceName, sizeof(serviceName))
+		.andReturnValue(CELIX_SUCCESS);
+
 	serviceRegistry_clearServiceRegistrations(registry, bundle);
 
 	//clean up
@@ -482,6 +496,12 @@ TEST(service_registry, getServiceReferences) {
 	arrayList_add(registrations, registration);
 	hashMap_put(registry->serviceRegistrations, bundle, registrations);
 
+	array_list_pt namedRegistrations = NULL;
+	arrayList_create(&namedRegistrations);
+	arrayList_add(namedRegistrations, registration);
+	hashMap_put(registry->serviceRegistrationsByName, my_strdup("test"), namedRegistrations);
+	serviceRegistry_publishRegistrations(registry, "test");
+
 	properties_pt properties = (properties_pt) 0x30;
 	filter_pt filter = (filter_pt) 0x40;
 
@@ -500,16 +520,10 @@ TEST(service_registry, getServiceReferences) {
 		.withOutputParameterReturning("properties", &properties, sizeof(properties))
 		.andReturnValue(CELIX_SUCCESS);
 	bool matchResult = true;
-	mock().expectNCalls(2, "filter_match")
+	mock().expectOneCall("filter_match")
 		.withParameter("filter", filter)
 		.withParameter("properties", properties)
 		.withOutputParameterReturning("result", &matchResult, sizeof(matchResult));
-	char *serviceName = (char *) "test";
-	mock()
-		.expectOneCall("serviceRegistration_getServiceName")
-		.withParameter("registration", registration)
-		.withOutputParameterReturning("serviceName", &serviceName, sizeof(serviceName))
-		.andReturnValue(CELIX_SUCCESS);
 	mock()
 		.expectOneCall("serviceRegistration_isValid")
 		.withParameter("registration", registration)
@@ -551,6 +565,12 @@ TEST(service_registry, getServiceReferences_noFilterOrName) {
 	arrayList_add(registrations, registration);
 	hashMap_put(registry->serviceRegistrations, bundle, registrations);
 
+	array_list_pt namedRegistrations = NULL;
+	arrayList_create(&namedRegistrations);
+	arrayList_add(namedRegistrations, registration);
+	hashMap_put(registry->serviceRegistrationsByName, my_strdup("test"), namedRegistrations);
+	serviceRegistry_publishRegistrations(registry, "test");
+
 	properties_pt properties = (properties_pt) 0x30;
 
 	hash_map_pt references = hashMap_create(NULL, NULL, NULL, NULL);
@@ -1026,6 +1046,12 @@ TEST(service_registry, servicePropertiesModified) {
 	serviceRegistry_create(framework,serviceRegistryTest_serviceChanged, &registry);
 	service_registration_pt registration = (service_registration_pt) 0x02;
 	properties_pt properties = (properties_pt) 0x03;
+	char *serviceName = (char *) "test";
+
+	mock().expectOneCall("serviceRegistration_getServiceName")
+		.withParameter("registration", registration)
+		.withOutputParameterReturning("serviceName", &serviceName, sizeof(serviceName))
+		.andReturnValue(CELIX_SUCCESS);
 
 	mock().expectOneCall("serviceRegistryTest_serviceChanged")
 		.withParameter("framework", registry->framework)
@@ -1038,6 +1064,69 @@ TEST(service_registry, servicePropertiesModified) {
 	serviceRegistry_destroy(registry);
 }
 
+TEST(service_registry, servicePropertiesModifiedRanking) {
+	service_registry_pt registry = NULL;
+	framework_pt framework = (framework_pt) 0x01;
+	serviceRegistry_create(framework,serviceRegistryTest_serviceChanged, &registry);
+	service_registration_pt registration = (service_registration_pt) calloc(1,sizeof(struct serviceRegistration));
+	registration->serviceId = 10UL;
+	service_registration_pt registration2 = (service_registration_pt) calloc(1,sizeof(struct serviceRegistration));
+	registration2->serviceId = 11UL;
+
+	array_list_pt namedRegistrations = NULL;
+	arrayList_create(&namedRegistrations);
+	arrayList_add(namedRegistrations, registration);
+	arrayList_add(namedRegistrations, registration2);
+	hashMap_put(registry->serviceRegistrationsByName, my_strdup("test"), namedRegistrations);
+
+	properties_pt properties = (properties_pt) 0x03;
+	char *serviceName = (char *) "test";
+
+	mock().expectOneCall("serviceRegistration_getServiceName")
+		.withParameter("registration", registration2)
+		.withOutputParameterReturning("serviceName", &serviceName, sizeof(serviceName))
+		.andReturnValue(CELIX_SUCCESS);
+	long ranking = 0;
+	long ranking2 = 5;
+	mock().expectOneCall("serviceRegistration_getRanking")
+		.withParameter("registration", registration)
+		.withOutputParameterReturning("ranking", &ranking, sizeof(ranking))
+		.andReturnValue(CELIX_SUCCESS);
+	mock().expectOneCall("serviceRegistration_getRanking")
+		.withParameter("registration", registration2)
+		.withOutputParameterReturning("ranking", &ranking2, sizeof(ranking2))
+		.andReturnValue(CELIX_SUCCESS);
+
+	mock().expectOneCall("serviceRegistryTest_serviceChanged")
+		.withParameter("framework", registry->framework)
+		.withParameter("eventType", OSGI_FRAMEWORK_SERVICE_EVENT_MODIFIED)
+		.withParameter("registration", registration2)
+		.withParameter("oldprops", properties);
+
+	serviceRegistry_servicePropertiesModified(registry, registration2, properties);
+
+	//higher ranking first
+	LONGS_EQUAL(2, arrayList_size(namedRegistrations));
+	POINTERS_EQUAL(registration2, arrayList_get(namedRegistrations, 0));
+	POINTERS_EQUAL(registration, arrayList_get(namedRegistrations, 1));
+
+	//the published snapshot follows the new order
+	struct serviceRegistrySnapshotEntry *entry = NULL;
+	unsigned int i;
+	for (i = 0; entry == NULL && i < registry->snapshot->capacity; i += 1) {
+		entry = registry->snapshot->entries[i];
+	}
+	CHECK(entry != NULL);
+	STRCMP_EQUAL("test", entry->serviceName);
+	LONGS_EQUAL(2, entry->registrations->size);
+	POINTERS_EQUAL(registration2, entry->registrations->registrations[0]);
+	POINTERS_EQUAL(registration, entry->registrations->registrations[1]);
+
+	serviceRegistry_destroy(registry);
+	free(registration);
+	free(registration2);
+}
+
 TEST(service_registry, getUsingBundles) {
 	service_registry_pt registry = NULL;
 	framework_pt framework = (framework_pt) 0x01;
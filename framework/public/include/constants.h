@@ -49,6 +49,7 @@ static const char * const OSGI_FRAMEWORK_BUNDLE_VERSION = "Bundle-Version";
 static const char * const OSGI_FRAMEWORK_PRIVATE_LIBRARY = "Private-Library";
 static const char * const OSGI_FRAMEWORK_EXPORT_LIBRARY = "Export-Library";
 static const char * const OSGI_FRAMEWORK_IMPORT_LIBRARY = "Import-Library";
+static const char * const CELIX_FRAMEWORK_BUNDLE_START_AFTER = "Start-After"; //symbolic names of bundles which the launcher starts first
 
 
 static const char * const OSGI_FRAMEWORK_FRAMEWORK_STORAGE = "org.osgi.framework.storage";
@@ -56,5 +57,7 @@ static const char * const OSGI_FRAMEWORK_FRAMEWORK_STORAGE_CLEAN = "org.osgi.fra
 static const char * const OSGI_FRAMEWORK_FRAMEWORK_STORAGE_CLEAN_ONFIRSTINIT = "onFirstInit";
 static const char * const OSGI_FRAMEWORK_FRAMEWORK_UUID = "org.osgi.framework.uuid";
 
+static const char * const CELIX_FRAMEWORK_EVENT_DISPATCHERS = "celix.framework.event.dispatchers";
+
 
 #endif /* CONSTANTS_H_ */
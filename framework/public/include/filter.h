@@ -41,5 +41,6 @@ FRAMEWORK_EXPORT celix_status_t filter_match(filter_pt filter, properties_pt pro
 FRAMEWORK_EXPORT celix_status_t filter_match_filter(filter_pt src, filter_pt dest, bool *result);
 
 FRAMEWORK_EXPORT celix_status_t filter_getString(filter_pt filter, const char** filterStr);
+FRAMEWORK_EXPORT celix_status_t filter_getRequiredEqualValue(filter_pt filter, const char* attribute, const char** value);
 
 #endif /* FILTER_H_ */
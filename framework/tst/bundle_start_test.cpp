@@ -0,0 +1,309 @@
+/**
+ *Licensed to the Apache Software Foundation (ASF) under one
+ *or more contributor license agreements.  See the NOTICE file
+ *distributed with this work for additional information
+ *regarding copyright ownership.  The ASF licenses this file
+ *to you under the Apache License, Version 2.0 (the
+ *"License"); you may not use this file except in compliance
+ *with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *Unless required by applicable law or agreed to in writing,
+ *software distributed under the License is distributed on an
+ *"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ *specific language governing permissions and limitations
+ *under the License.
+ */
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+extern "C" {
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "celix_launcher.h"
+#include "framework.h"
+#include "bundle.h"
+#include "bundle_context.h"
+#include "service_reference.h"
+#include "constants.h"
+
+    //framework internals used by fw_startBundle, exported by celix_framework
+    celix_status_t framework_acquireBundleLock(framework_pt framework, bundle_pt bundle, int desiredStates);
+    bool framework_releaseBundleLock(framework_pt framework, bundle_pt bundle);
+    bool framework_acquireGlobalLock(framework_pt framework);
+    celix_status_t framework_releaseGlobalLock(framework_pt framework);
+
+    //registered by the tst_* bundles when they are started, see test_bundles/start_marker_activator.c
+    #define TST_STARTED_SERVICE "tst.started"
+
+    static framework_pt framework = NULL;
+    static bundle_context_pt context = NULL;
+
+    static void launch(const char *config) {
+        bundle_pt bundle = NULL;
+
+        CHECK_EQUAL(CELIX_SUCCESS, celixLauncher_launch(config, &framework));
+        CHECK_EQUAL(CELIX_SUCCESS, framework_getFrameworkBundle(framework, &bundle));
+        CHECK_EQUAL(CELIX_SUCCESS, bundle_getContext(bundle, &context));
+    }
+
+    static void shutdown(void) {
+        celixLauncher_stop(framework);
+        celixLauncher_waitForShutdown(framework);
+        celixLauncher_destroy(framework);
+
+        context = NULL;
+        framework = NULL;
+    }
+
+    static int compareServiceIds(const void *a, const void *b) {
+        const char *idA = NULL;
+        const char *idB = NULL;
+        serviceReference_getProperty(*(service_reference_pt *) a, OSGI_FRAMEWORK_SERVICE_ID, &idA);
+        serviceReference_getProperty(*(service_reference_pt *) b, OSGI_FRAMEWORK_SERVICE_ID, &idB);
+        long diff = atol(idA) - atol(idB);
+        return diff < 0 ? -1 : (diff > 0 ? 1 : 0);
+    }
+
+    //writes the symbolic names of the started tst bundles, in the order they finished starting, space separated
+    static void startOrder(char *order, size_t size) {
+        array_list_pt refs = NULL;
+        unsigned int nrOfRefs;
+        unsigned int i;
+
+        order[0] = '\0';
+        CHECK_EQUAL(CELIX_SUCCESS, bundleContext_getServiceReferences(context, TST_STARTED_SERVICE, NULL, &refs));
+        nrOfRefs = arrayList_size(refs);
+
+        service_reference_pt sorted[nrOfRefs + 1];
+        for (i = 0; i < nrOfRefs; i++) {
+            sorted[i] = (service_reference_pt) arrayList_get(refs, i);
+        }
+        qsort(sorted, nrOfRefs, sizeof(sorted[0]), compareServiceIds);
+
+        for (i = 0; i < nrOfRefs; i++) {
+            const char *name = NULL;
+            serviceReference_getProperty(sorted[i], "bundle", &name);
+            if (i > 0) {
+                strncat(order, " ", size - strlen(order) - 1);
+            }
+            strncat(order, name, size - strlen(order) - 1);
+            bundleContext_ungetServiceReference(context, sorted[i]);
+        }
+        arrayList_destroy(refs);
+    }
+
+    static int positionOf(const char *order, const char *name) {
+        char copy[1024];
+        char *save = NULL;
+        int position = 0;
+
+        strncpy(copy, order, sizeof(copy) - 1);
+        copy[sizeof(copy) - 1] = '\0';
+        for (char *token = strtok_r(copy, " ", &save); token != NULL; token = strtok_r(NULL, " ", &save), position++) {
+            if (strcmp(token, name) == 0) {
+                return position;
+            }
+        }
+        return -1;
+    }
+
+    static unsigned int nrOfActiveBundles(void) {
+        array_list_pt bundles = NULL;
+        unsigned int active = 0;
+        unsigned int i;
+
+        CHECK_EQUAL(CELIX_SUCCESS, bundleContext_getBundles(context, &bundles));
+        for (i = 0; i < arrayList_size(bundles); i++) {
+            bundle_state_e state = OSGI_FRAMEWORK_BUNDLE_UNKNOWN;
+            bundle_getState((bundle_pt) arrayList_get(bundles, i), &state);
+            if (state == OSGI_FRAMEWORK_BUNDLE_ACTIVE) {
+                active++;
+            }
+        }
+        arrayList_destroy(bundles);
+
+        return active;
+    }
+
+    struct parallelStart {
+        pthread_barrier_t *barrier;
+        bundle_pt bundle;
+        celix_status_t status;
+    };
+
+    static void *parallelStart_run(void *data) {
+        struct parallelStart *start = (struct parallelStart *) data;
+
+        pthread_barrier_wait(start->barrier);
+        start->status = bundle_startWithOptions(start->bundle, 0);
+
+        return NULL;
+    }
+
+    //installs the bundles of the tst.bundles property and starts them all at once, each from its own thread
+    static void startInParallel(void) {
+        const char *locations = NULL;
+        struct parallelStart starts[16];
+        pthread_t threads[16];
+        pthread_barrier_t barrier;
+        unsigned int nrOfBundles = 0;
+        unsigned int i;
+
+        CHECK_EQUAL(CELIX_SUCCESS, bundleContext_getProperty(context, "tst.bundles", &locations));
+        CHECK(locations != NULL);
+
+        char *copy = strdup(locations);
+        char *save = NULL;
+        for (char *location = strtok_r(copy, " ", &save); location != NULL && nrOfBundles < 16; location = strtok_r(NULL, " ", &save)) {
+            starts[nrOfBundles].barrier = &barrier;
+            starts[nrOfBundles].bundle = NULL;
+            starts[nrOfBundles].status = CELIX_SUCCESS;
+            CHECK_EQUAL(CELIX_SUCCESS, bundleContext_installBundle(context, location, &starts[nrOfBundles].bundle));
+            nrOfBundles++;
+        }
+        free(copy);
+
+        pthread_barrier_init(&barrier, NULL, nrOfBundles);
+        for (i = 0; i < nrOfBundles; i++) {
+            pthread_create(&threads[i], NULL, parallelStart_run, &starts[i]);
+        }
+        for (i = 0; i < nrOfBundles; i++) {
+            pthread_join(threads[i], NULL);
+            CHECK_EQUAL(CELIX_SUCCESS, starts[i].status);
+        }
+        pthread_barrier_destroy(&barrier);
+    }
+    #define TST_ANY_STATE (OSGI_FRAMEWORK_BUNDLE_INSTALLED|OSGI_FRAMEWORK_BUNDLE_RESOLVED|OSGI_FRAMEWORK_BUNDLE_STARTING|OSGI_FRAMEWORK_BUNDLE_ACTIVE)
+
+    //plays a starting bundle: takes the bundle lock and then waits for the global lock
+    struct lockingStart {
+        pthread_mutex_t mutex;
+        pthread_cond_t cond;
+        bundle_pt bundle;
+        bool bundleLocked;
+        bool globalLocked;
+        bool acquiredGlobalLock;
+    };
+
+    static void *lockingStart_run(void *data) {
+        struct lockingStart *start = (struct lockingStart *) data;
+
+        CHECK_EQUAL(CELIX_SUCCESS, framework_acquireBundleLock(framework, start->bundle, TST_ANY_STATE));
+
+        pthread_mutex_lock(&start->mutex);
+        start->bundleLocked = true;
+        pthread_cond_broadcast(&start->cond);
+        while (!start->globalLocked) {
+            pthread_cond_wait(&start->cond, &start->mutex);
+        }
+        pthread_mutex_unlock(&start->mutex);
+
+        start->acquiredGlobalLock = framework_acquireGlobalLock(framework);
+        if (start->acquiredGlobalLock) {
+            framework_releaseGlobalLock(framework);
+        }
+        framework_releaseBundleLock(framework, start->bundle);
+
+        return NULL;
+    }
+}
+
+TEST_GROUP(CelixBundleStart) {
+    void setup() {
+    }
+
+    void teardown() {
+    }
+};
+
+TEST(CelixBundleStart, parallelStartOfDependentBundles) {
+    //the importers are resolved together with the exporter, which is started concurrently. Starting them must not deadlock
+    //on the global lock and the bundle locks, repeated to hit the different interleavings
+    for (int i = 0; i < 50; i++) {
+        char order[1024];
+
+        launch("parallel_start.properties");
+        startInParallel();
+        //the system bundle, the exporter and the importers
+        CHECK_EQUAL(6, nrOfActiveBundles());
+        startOrder(order, sizeof(order));
+        CHECK(positionOf(order, "tst_importer1") >= 0);
+        CHECK(positionOf(order, "tst_importer4") >= 0);
+        shutdown();
+    }
+}
+
+TEST(CelixBundleStart, globalLockWaiterIsInterrupted) {
+    //the deadlock of a parallel start made deterministic: a thread holding a bundle lock waits for the global lock,
+    //while the holder of the global lock (a resolve) needs that bundle lock. The waiter must give up the global lock
+    struct lockingStart start;
+    const char *locations = NULL;
+    pthread_t thread;
+
+    launch("parallel_start.properties");
+    CHECK_EQUAL(CELIX_SUCCESS, bundleContext_getProperty(context, "tst.bundles", &locations));
+    char *location = strndup(locations, strcspn(locations, " "));
+    start.bundle = NULL;
+    CHECK_EQUAL(CELIX_SUCCESS, bundleContext_installBundle(context, location, &start.bundle));
+    free(location);
+
+    pthread_mutex_init(&start.mutex, NULL);
+    pthread_cond_init(&start.cond, NULL);
+    start.bundleLocked = false;
+    start.globalLocked = false;
+    start.acquiredGlobalLock = true;
+    pthread_create(&thread, NULL, lockingStart_run, &start);
+
+    pthread_mutex_lock(&start.mutex);
+    while (!start.bundleLocked) {
+        pthread_cond_wait(&start.cond, &start.mutex);
+    }
+    CHECK(framework_acquireGlobalLock(framework));
+    start.globalLocked = true;
+    pthread_cond_broadcast(&start.cond);
+    pthread_mutex_unlock(&start.mutex);
+
+    CHECK_EQUAL(CELIX_SUCCESS, framework_acquireBundleLock(framework, start.bundle, TST_ANY_STATE));
+    framework_releaseBundleLock(framework, start.bundle);
+    framework_releaseGlobalLock(framework);
+
+    pthread_join(thread, NULL);
+    CHECK_FALSE(start.acquiredGlobalLock);
+    pthread_cond_destroy(&start.cond);
+    pthread_mutex_destroy(&start.mutex);
+    shutdown();
+}
+
+TEST(CelixBundleStart, runLevels) {
+    char order[1024];
+
+    //sequential start: run level by run level, in configured order within a run level
+    launch("run_levels.properties");
+    startOrder(order, sizeof(order));
+    STRCMP_EQUAL("tst_marker_c tst_marker_b tst_marker_a", order);
+    shutdown();
+}
+
+TEST(CelixBundleStart, startAfter) {
+    char order[1024];
+
+    //tst_after has "Start-After: tst_marker_b" and tst_marker_b starts slowly, the other bundles are started in parallel
+    launch("start_after.properties");
+    CHECK_EQUAL(7, nrOfActiveBundles());
+    startOrder(order, sizeof(order));
+    CHECK(positionOf(order, "tst_marker_b") >= 0);
+    CHECK(positionOf(order, "tst_after") > positionOf(order, "tst_marker_b"));
+    //a lower run level is started completely before a higher one
+    LONGS_EQUAL(5, positionOf(order, "tst_marker_a"));
+    //a Start-After cycle is broken, both bundles are started
+    CHECK(positionOf(order, "tst_cycle_a") >= 0);
+    CHECK(positionOf(order, "tst_cycle_b") >= 0);
+    shutdown();
+}
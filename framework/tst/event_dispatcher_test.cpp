@@ -0,0 +1,392 @@
+/**
+ *Licensed to the Apache Software Foundation (ASF) under one
+ *or more contributor license agreements.  See the NOTICE file
+ *distributed with this work for additional information
+ *regarding copyright ownership.  The ASF licenses this file
+ *to you under the Apache License, Version 2.0 (the
+ *"License"); you may not use this file except in compliance
+ *with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *Unless required by applicable law or agreed to in writing,
+ *software distributed under the License is distributed on an
+ *"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ *specific language governing permissions and limitations
+ *under the License.
+ */
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+extern "C" {
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "celix_launcher.h"
+#include "framework.h"
+#include "bundle.h"
+#include "bundle_context.h"
+#include "bundle_listener.h"
+
+    //fires a bundle event on the dispatchers, exported by celix_framework
+    celix_status_t fw_fireBundleEvent(framework_pt framework, bundle_event_type_e type, bundle_pt bundle);
+
+    #define MAX_EVENTS 256
+    #define TIMEOUT 10 //seconds
+
+    //records the events it receives, can be blocked in its callback and can remove itself from within it
+    struct eventRecorder {
+        struct bundle_listener listener;
+        pthread_mutex_t mutex;
+        pthread_cond_t cond;
+        bundle_event_type_e types[MAX_EVENTS];
+        unsigned int count;
+        pthread_t thread;
+        bool block;
+        bool blocked;
+        bool removeSelf;
+        celix_status_t removeStatus;
+    };
+
+    static framework_pt framework = NULL;
+    static bundle_context_pt context = NULL;
+    static bundle_pt frameworkBundle = NULL;
+
+    //the asynchronously delivered types, starting and stopping events are not dispatched
+    static const bundle_event_type_e eventTypes[] = {
+        OSGI_FRAMEWORK_BUNDLE_EVENT_INSTALLED,
+        OSGI_FRAMEWORK_BUNDLE_EVENT_RESOLVED,
+        OSGI_FRAMEWORK_BUNDLE_EVENT_STARTED,
+        OSGI_FRAMEWORK_BUNDLE_EVENT_STOPPED,
+        OSGI_FRAMEWORK_BUNDLE_EVENT_UPDATED,
+    };
+    #define NR_OF_EVENT_TYPES (sizeof(eventTypes) / sizeof(eventTypes[0]))
+
+    static void shutdown(void) {
+        celixLauncher_stop(framework);
+        celixLauncher_waitForShutdown(framework);
+        celixLauncher_destroy(framework);
+
+        frameworkBundle = NULL;
+        context = NULL;
+        framework = NULL;
+    }
+
+    static void timeoutIn(struct timespec *deadline, int seconds) {
+        clock_gettime(CLOCK_REALTIME, deadline);
+        deadline->tv_sec += seconds;
+    }
+
+    static celix_status_t eventRecorder_bundleChanged(void *listener, bundle_event_pt event) {
+        struct eventRecorder *recorder = (struct eventRecorder *) ((bundle_listener_pt) listener)->handle;
+        bool removeSelf;
+
+        pthread_mutex_lock(&recorder->mutex);
+        recorder->thread = pthread_self();
+        if (recorder->count < MAX_EVENTS) {
+            recorder->types[recorder->count] = event->type;
+        }
+        recorder->count++;
+        pthread_cond_broadcast(&recorder->cond);
+
+        while (recorder->block) {
+            recorder->blocked = true;
+            pthread_cond_broadcast(&recorder->cond);
+            pthread_cond_wait(&recorder->cond, &recorder->mutex);
+        }
+        recorder->blocked = false;
+        removeSelf = recorder->removeSelf;
+        recorder->removeSelf = false;
+        pthread_mutex_unlock(&recorder->mutex);
+
+        if (removeSelf) {
+            recorder->removeStatus = bundleContext_removeBundleListener(context, &recorder->listener);
+        }
+
+        return CELIX_SUCCESS;
+    }
+
+    static void eventRecorder_init(struct eventRecorder *recorder) {
+        memset(recorder, 0, sizeof(*recorder));
+        recorder->listener.handle = recorder;
+        recorder->listener.bundleChanged = eventRecorder_bundleChanged;
+        recorder->removeStatus = CELIX_ILLEGAL_STATE;
+        pthread_mutex_init(&recorder->mutex, NULL);
+        pthread_cond_init(&recorder->cond, NULL);
+    }
+
+    static void eventRecorder_destroy(struct eventRecorder *recorder) {
+        pthread_cond_destroy(&recorder->cond);
+        pthread_mutex_destroy(&recorder->mutex);
+    }
+
+    //returns the number of events received once there are at least count of them, or when the timeout passed
+    static unsigned int eventRecorder_waitFor(struct eventRecorder *recorder, unsigned int count) {
+        struct timespec deadline;
+        unsigned int received;
+
+        timeoutIn(&deadline, TIMEOUT);
+        pthread_mutex_lock(&recorder->mutex);
+        while (recorder->count < count && pthread_cond_timedwait(&recorder->cond, &recorder->mutex, &deadline) == 0) {
+        }
+        received = recorder->count;
+        pthread_mutex_unlock(&recorder->mutex);
+
+        return received;
+    }
+
+    static bool eventRecorder_waitForBlocked(struct eventRecorder *recorder) {
+        struct timespec deadline;
+        bool blocked;
+
+        timeoutIn(&deadline, TIMEOUT);
+        pthread_mutex_lock(&recorder->mutex);
+        while (!recorder->blocked && pthread_cond_timedwait(&recorder->cond, &recorder->mutex, &deadline) == 0) {
+        }
+        blocked = recorder->blocked;
+        pthread_mutex_unlock(&recorder->mutex);
+
+        return blocked;
+    }
+
+    static void eventRecorder_release(struct eventRecorder *recorder) {
+        pthread_mutex_lock(&recorder->mutex);
+        recorder->block = false;
+        pthread_cond_broadcast(&recorder->cond);
+        pthread_mutex_unlock(&recorder->mutex);
+    }
+
+    static unsigned int eventRecorder_count(struct eventRecorder *recorder) {
+        unsigned int count;
+
+        pthread_mutex_lock(&recorder->mutex);
+        count = recorder->count;
+        pthread_mutex_unlock(&recorder->mutex);
+
+        return count;
+    }
+
+    //waits till an event of the given type is received, returns false on a timeout
+    static bool eventRecorder_waitForType(struct eventRecorder *recorder, bundle_event_type_e type) {
+        struct timespec deadline;
+        bool received = false;
+        unsigned int i;
+
+        timeoutIn(&deadline, TIMEOUT);
+        pthread_mutex_lock(&recorder->mutex);
+        do {
+            for (i = 0; i < recorder->count && i < MAX_EVENTS && !received; i++) {
+                received = (recorder->types[i] == type);
+            }
+        } while (!received && pthread_cond_timedwait(&recorder->cond, &recorder->mutex, &deadline) == 0);
+        pthread_mutex_unlock(&recorder->mutex);
+
+        return received;
+    }
+
+    static void launch(void) {
+        struct eventRecorder probes[2];
+        unsigned int i;
+
+        CHECK_EQUAL(CELIX_SUCCESS, celixLauncher_launch("event_dispatchers.properties", &framework));
+        CHECK_EQUAL(CELIX_SUCCESS, framework_getFrameworkBundle(framework, &frameworkBundle));
+        CHECK_EQUAL(CELIX_SUCCESS, bundle_getContext(frameworkBundle, &context));
+
+        //the events of the framework start may still be queued. A probe on each dispatcher waits for a later marker
+        //event, so the listeners of a test only get the events fired by the test
+        for (i = 0; i < 2; i++) {
+            eventRecorder_init(&probes[i]);
+            CHECK_EQUAL(CELIX_SUCCESS, bundleContext_addBundleListener(context, &probes[i].listener));
+        }
+        CHECK_EQUAL(CELIX_SUCCESS, fw_fireBundleEvent(framework, OSGI_FRAMEWORK_BUNDLE_EVENT_UNINSTALLED, frameworkBundle));
+        for (i = 0; i < 2; i++) {
+            CHECK(eventRecorder_waitForType(&probes[i], OSGI_FRAMEWORK_BUNDLE_EVENT_UNINSTALLED));
+            CHECK_EQUAL(CELIX_SUCCESS, bundleContext_removeBundleListener(context, &probes[i].listener));
+            eventRecorder_destroy(&probes[i]);
+        }
+    }
+
+    static void fireEvents(unsigned int count) {
+        for (unsigned int i = 0; i < count; i++) {
+            CHECK_EQUAL(CELIX_SUCCESS, fw_fireBundleEvent(framework, eventTypes[i % NR_OF_EVENT_TYPES], frameworkBundle));
+        }
+    }
+
+    struct listenerRemoval {
+        struct eventRecorder *recorder;
+        pthread_mutex_t mutex;
+        pthread_cond_t cond;
+        bool done;
+        celix_status_t status;
+    };
+
+    static void *listenerRemoval_run(void *data) {
+        struct listenerRemoval *removal = (struct listenerRemoval *) data;
+        celix_status_t status = bundleContext_removeBundleListener(context, &removal->recorder->listener);
+
+        pthread_mutex_lock(&removal->mutex);
+        removal->status = status;
+        removal->done = true;
+        pthread_cond_broadcast(&removal->cond);
+        pthread_mutex_unlock(&removal->mutex);
+
+        return NULL;
+    }
+
+    //waits at most the given number of milliseconds for the removal to finish
+    static bool listenerRemoval_waitForDone(struct listenerRemoval *removal, long milliseconds) {
+        struct timespec deadline;
+        bool done;
+
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += milliseconds / 1000 + (deadline.tv_nsec + (milliseconds % 1000) * 1000000L) / 1000000000L;
+        deadline.tv_nsec = (deadline.tv_nsec + (milliseconds % 1000) * 1000000L) % 1000000000L;
+
+        pthread_mutex_lock(&removal->mutex);
+        while (!removal->done && pthread_cond_timedwait(&removal->cond, &removal->mutex, &deadline) == 0) {
+        }
+        done = removal->done;
+        pthread_mutex_unlock(&removal->mutex);
+
+        return done;
+    }
+}
+
+TEST_GROUP(CelixEventDispatcher) {
+    void setup() {
+        launch();
+    }
+
+    void teardown() {
+        shutdown();
+    }
+};
+
+TEST(CelixEventDispatcher, eventsAreOrderedPerListener) {
+    //the listeners are spread over both dispatchers, each of them gets the events in the order they were fired
+    struct eventRecorder recorders[4];
+    unsigned int i;
+    unsigned int j;
+
+    for (i = 0; i < 4; i++) {
+        eventRecorder_init(&recorders[i]);
+        CHECK_EQUAL(CELIX_SUCCESS, bundleContext_addBundleListener(context, &recorders[i].listener));
+    }
+
+    fireEvents(MAX_EVENTS);
+
+    for (i = 0; i < 4; i++) {
+        CHECK_EQUAL(MAX_EVENTS, eventRecorder_waitFor(&recorders[i], MAX_EVENTS));
+        for (j = 0; j < MAX_EVENTS; j++) {
+            CHECK_EQUAL(eventTypes[j % NR_OF_EVENT_TYPES], recorders[i].types[j]);
+        }
+    }
+
+    //round robin: consecutive listeners are on different dispatchers
+    CHECK_FALSE(pthread_equal(recorders[0].thread, recorders[1].thread));
+    CHECK(pthread_equal(recorders[0].thread, recorders[2].thread));
+    CHECK(pthread_equal(recorders[1].thread, recorders[3].thread));
+
+    for (i = 0; i < 4; i++) {
+        CHECK_EQUAL(CELIX_SUCCESS, bundleContext_removeBundleListener(context, &recorders[i].listener));
+        eventRecorder_destroy(&recorders[i]);
+    }
+}
+
+TEST(CelixEventDispatcher, slowListenerDoesNotBlockOtherDispatchers) {
+    struct eventRecorder slow;
+    struct eventRecorder fast;
+
+    eventRecorder_init(&slow);
+    eventRecorder_init(&fast);
+    slow.block = true;
+    CHECK_EQUAL(CELIX_SUCCESS, bundleContext_addBundleListener(context, &slow.listener));
+    CHECK_EQUAL(CELIX_SUCCESS, bundleContext_addBundleListener(context, &fast.listener));
+
+    fireEvents(10);
+
+    //the slow listener is stuck in the first event, the one on the other dispatcher still gets all of them
+    CHECK(eventRecorder_waitForBlocked(&slow));
+    CHECK_EQUAL(10, eventRecorder_waitFor(&fast, 10));
+    CHECK_EQUAL(1, eventRecorder_count(&slow));
+
+    eventRecorder_release(&slow);
+    CHECK_EQUAL(10, eventRecorder_waitFor(&slow, 10));
+
+    CHECK_EQUAL(CELIX_SUCCESS, bundleContext_removeBundleListener(context, &slow.listener));
+    CHECK_EQUAL(CELIX_SUCCESS, bundleContext_removeBundleListener(context, &fast.listener));
+    eventRecorder_destroy(&slow);
+    eventRecorder_destroy(&fast);
+}
+
+TEST(CelixEventDispatcher, removalWaitsForRunningCallback) {
+    struct eventRecorder blocked;
+    struct listenerRemoval removal;
+    pthread_t thread;
+
+    eventRecorder_init(&blocked);
+    blocked.block = true;
+    CHECK_EQUAL(CELIX_SUCCESS, bundleContext_addBundleListener(context, &blocked.listener));
+
+    fireEvents(5);
+    CHECK(eventRecorder_waitForBlocked(&blocked));
+
+    removal.recorder = &blocked;
+    removal.done = false;
+    removal.status = CELIX_ILLEGAL_STATE;
+    pthread_mutex_init(&removal.mutex, NULL);
+    pthread_cond_init(&removal.cond, NULL);
+    pthread_create(&thread, NULL, listenerRemoval_run, &removal);
+
+    //the listener may still use its state while its callback runs, so the removal does not return before it
+    CHECK_FALSE(listenerRemoval_waitForDone(&removal, 200));
+
+    eventRecorder_release(&blocked);
+    CHECK(listenerRemoval_waitForDone(&removal, TIMEOUT * 1000));
+    pthread_join(thread, NULL);
+    CHECK_EQUAL(CELIX_SUCCESS, removal.status);
+
+    //the events still queued are not delivered to the removed listener
+    fireEvents(5);
+    usleep(200000);
+    CHECK_EQUAL(1, eventRecorder_count(&blocked));
+
+    pthread_cond_destroy(&removal.cond);
+    pthread_mutex_destroy(&removal.mutex);
+    eventRecorder_destroy(&blocked);
+}
+
+TEST(CelixEventDispatcher, listenerRemovesItselfInCallback) {
+    struct eventRecorder self;
+    struct eventRecorder other;
+    struct eventRecorder sameDispatcher;
+
+    eventRecorder_init(&self);
+    eventRecorder_init(&other);
+    eventRecorder_init(&sameDispatcher);
+    self.removeSelf = true;
+    CHECK_EQUAL(CELIX_SUCCESS, bundleContext_addBundleListener(context, &self.listener));
+    CHECK_EQUAL(CELIX_SUCCESS, bundleContext_addBundleListener(context, &other.listener));
+    CHECK_EQUAL(CELIX_SUCCESS, bundleContext_addBundleListener(context, &sameDispatcher.listener));
+
+    fireEvents(5);
+
+    //the removal from within the callback does not wait for the callback itself, the dispatcher keeps going
+    CHECK_EQUAL(5, eventRecorder_waitFor(&sameDispatcher, 5));
+    CHECK_EQUAL(5, eventRecorder_waitFor(&other, 5));
+    CHECK_EQUAL(1, eventRecorder_count(&self));
+    CHECK_EQUAL(CELIX_SUCCESS, self.removeStatus);
+    CHECK(pthread_equal(self.thread, sameDispatcher.thread));
+
+    CHECK_EQUAL(CELIX_SUCCESS, bundleContext_removeBundleListener(context, &other.listener));
+    CHECK_EQUAL(CELIX_SUCCESS, bundleContext_removeBundleListener(context, &sameDispatcher.listener));
+    eventRecorder_destroy(&self);
+    eventRecorder_destroy(&other);
+    eventRecorder_destroy(&sameDispatcher);
+}
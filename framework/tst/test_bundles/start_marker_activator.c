@@ -0,0 +1,97 @@
+/**
+ *Licensed to the Apache Software Foundation (ASF) under one
+ *or more contributor license agreements.  See the NOTICE file
+ *distributed with this work for additional information
+ *regarding copyright ownership.  The ASF licenses this file
+ *to you under the Apache License, Version 2.0 (the
+ *"License"); you may not use this file except in compliance
+ *with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *Unless required by applicable law or agreed to in writing,
+ *software distributed under the License is distributed on an
+ *"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ *specific language governing permissions and limitations
+ *under the License.
+ */
+/*
+ * start_marker_activator.c
+ *
+ *  \date       Oct 17, 2026
+ *  \author     <a href="mailto:dev@celix.apache.org">Apache Celix Project Team</a>
+ *  \copyright  Apache License, Version 2.0
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "bundle_activator.h"
+#include "bundle_context.h"
+#include "bundle.h"
+#include "module.h"
+#include "service_registration.h"
+
+/*
+ * Registers a TST_STARTED_SERVICE at the end of its start. The registry hands out increasing service ids,
+ * so the tests can derive the order in which the bundles finished starting from them.
+ * The start can be delayed with the property tst.start.delay.<symbolic name> (ms).
+ */
+#define TST_STARTED_SERVICE "tst.started"
+
+struct startMarker {
+	service_registration_pt registration;
+};
+
+celix_status_t bundleActivator_create(bundle_context_pt context, void **userData) {
+	*userData = calloc(1, sizeof(struct startMarker));
+	if (*userData == NULL) {
+		return CELIX_ENOMEM;
+	}
+	return CELIX_SUCCESS;
+}
+
+celix_status_t bundleActivator_start(void * userData, bundle_context_pt context) {
+	celix_status_t status = CELIX_SUCCESS;
+	struct startMarker *marker = userData;
+	bundle_pt bundle = NULL;
+	module_pt module = NULL;
+	const char *symbolicName = NULL;
+	const char *delay = NULL;
+
+	status = CELIX_DO_IF(status, bundleContext_getBundle(context, &bundle));
+	status = CELIX_DO_IF(status, bundle_getCurrentModule(bundle, &module));
+	status = CELIX_DO_IF(status, module_getSymbolicName(module, &symbolicName));
+
+	if (status == CELIX_SUCCESS) {
+		char key[128];
+		snprintf(key, sizeof(key), "tst.start.delay.%s", symbolicName);
+		bundleContext_getProperty(context, key, &delay);
+		if (delay != NULL) {
+			usleep(atoi(delay) * 1000);
+		}
+
+		properties_pt props = properties_create();
+		properties_set(props, "bundle", symbolicName);
+		status = bundleContext_registerService(context, TST_STARTED_SERVICE, marker, props, &marker->registration);
+	}
+
+	return status;
+}
+
+celix_status_t bundleActivator_stop(void * userData, bundle_context_pt context) {
+	struct startMarker *marker = userData;
+
+	if (marker->registration != NULL) {
+		serviceRegistration_unregister(marker->registration);
+		marker->registration = NULL;
+	}
+
+	return CELIX_SUCCESS;
+}
+
+celix_status_t bundleActivator_destroy(void * userData, bundle_context_pt context) {
+	free(userData);
+	return CELIX_SUCCESS;
+}
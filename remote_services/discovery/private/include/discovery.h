@@ -39,6 +39,18 @@
 #define DISCOVERY_SERVER_PATH 		"DISCOVERY_CFG_SERVER_PATH"
 #define DISCOVERY_POLL_ENDPOINTS 	"DISCOVERY_CFG_POLL_ENDPOINTS"
 #define DISCOVERY_SERVER_MAX_EP	"DISCOVERY_CFG_SERVER_MAX_EP"
+#define DISCOVERY_SERVER_THREADS	"DISCOVERY_CFG_SERVER_THREADS"
+#define DISCOVERY_POLL_WAIT		"DISCOVERY_CFG_POLL_WAIT"
+
+// conditional polling: the server tags its endpoint list with an ETag, "<path>?since=<etag>" returns the changes since then
+#define DISCOVERY_SINCE_PARAMETER	"since"
+#define DISCOVERY_DELTA_HEADER		"X-Celix-Endpoints-Delta"
+#define DISCOVERY_REMOVED_HEADER	"X-Celix-Endpoints-Removed"
+// long polling: with "&wait=<seconds>" the server holds the request until the endpoints change, the header marks such responses
+#define DISCOVERY_WAIT_PARAMETER	"wait"
+#define DISCOVERY_LONG_POLL_HEADER	"X-Celix-Long-Poll"
+// pollers accepting this content type get the compact binary form of the endpoints instead of XML
+#define DISCOVERY_BINARY_CONTENT_TYPE	"application/x-celix-endpoints"
 
 typedef struct discovery *discovery_pt;
 
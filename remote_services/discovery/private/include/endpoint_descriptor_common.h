@@ -58,4 +58,17 @@ static const xmlChar* NAME = (const xmlChar*) "name";
 static const xmlChar* VALUE = (const xmlChar*) "value";
 static const xmlChar* VALUE_TYPE = (const xmlChar*) "value-type";
 
+/*
+ * Compact binary form of a list of endpoint descriptions (DISCOVERY_BINARY_CONTENT_TYPE):
+ *
+ *   "CXEP" <version, 1 byte> { <property count> { <name length> <name> <value length> <value> }* }*
+ *
+ * Counts and lengths are 32 bit big endian, names and values are not '\0' terminated. The endpoints follow each
+ * other until the end of the document, so a reader can decode every endpoint as soon as it has been received.
+ */
+#define ENDPOINT_BINARY_MAGIC "CXEP"
+#define ENDPOINT_BINARY_MAGIC_LENGTH 4
+#define ENDPOINT_BINARY_VERSION 1
+#define ENDPOINT_BINARY_HEADER_LENGTH (ENDPOINT_BINARY_MAGIC_LENGTH + 1)
+
 #endif /* ENDPOINT_DESCRIPTOR_COMMON_H_ */
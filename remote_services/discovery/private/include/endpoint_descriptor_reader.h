@@ -27,6 +27,8 @@
 #ifndef ENDPOINT_DESCRIPTOR_READER_H_
 #define ENDPOINT_DESCRIPTOR_READER_H_
 
+#include <stddef.h>
+
 #include "endpoint_discovery_poller.h"
 #include "celix_errno.h"
 #include "array_list.h"
@@ -38,5 +40,10 @@ celix_status_t endpointDescriptorReader_destroy(endpoint_descriptor_reader_pt re
 
 celix_status_t endpointDescriptorReader_parseDocument(endpoint_descriptor_reader_pt reader, char *document, array_list_pt *endpoints);
 
+// decodes the compact binary form incrementally: every fully received endpoint is added to endpoints
+celix_status_t endpointDescriptorReader_feed(endpoint_descriptor_reader_pt reader, const char *data, size_t length, array_list_pt endpoints);
+// fails if the data fed so far does not end with a complete endpoint
+celix_status_t endpointDescriptorReader_finish(endpoint_descriptor_reader_pt reader);
+
 
 #endif /* ENDPOINT_DESCRIPTOR_READER_H_ */
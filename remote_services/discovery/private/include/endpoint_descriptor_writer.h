@@ -27,6 +27,8 @@
 #ifndef ENDPOINT_DESCRIPTOR_WRITER_H_
 #define ENDPOINT_DESCRIPTOR_WRITER_H_
 
+#include <stddef.h>
+
 #include "celix_errno.h"
 #include "array_list.h"
 
@@ -35,5 +37,7 @@ typedef struct endpoint_descriptor_writer *endpoint_descriptor_writer_pt;
 celix_status_t endpointDescriptorWriter_create(endpoint_descriptor_writer_pt *writer);
 celix_status_t endpointDescriptorWriter_destroy(endpoint_descriptor_writer_pt writer);
 celix_status_t endpointDescriptorWriter_writeDocument(endpoint_descriptor_writer_pt writer, array_list_pt endpoints, char **document);
+// writes the compact binary form, the document is owned by the writer
+celix_status_t endpointDescriptorWriter_writeBinary(endpoint_descriptor_writer_pt writer, array_list_pt endpoints, char **document, size_t *length);
 
 #endif /* ENDPOINT_DESCRIPTOR_WRITER_H_ */
@@ -40,6 +40,7 @@ struct endpoint_discovery_poller {
     celix_thread_t pollerThread;
 
     unsigned int poll_interval;
+    unsigned int poll_wait;
     volatile bool running;
 };
 
@@ -38,14 +38,21 @@
 struct endpoint_descriptor_reader {
     xmlTextReaderPtr reader;
     log_helper_pt* loghelper;
+
+    // binary form: the received data which does not hold a complete endpoint yet
+    bool headerRead;
+    char *pending;
+    size_t pendingSize;
+    size_t pendingCapacity;
 };
 
 static valueType valueTypeFromString(char *name);
+static celix_status_t endpointDescriptorReader_decode(endpoint_descriptor_reader_pt reader, const char *data, size_t length, size_t *consumed, array_list_pt endpoints);
 
 celix_status_t endpointDescriptorReader_create(endpoint_discovery_poller_pt poller, endpoint_descriptor_reader_pt *reader) {
     celix_status_t status = CELIX_SUCCESS;
 
-    *reader = malloc(sizeof(**reader));
+    *reader = calloc(1, sizeof(**reader));
     if (!*reader) {
         status = CELIX_ENOMEM;
     } else {
@@ -61,6 +68,7 @@ celix_status_t endpointDescriptorReader_destroy(endpoint_descriptor_reader_pt re
 
     reader->loghelper = NULL;
 
+    free(reader->pending);
     free(reader);
 
     return status;
@@ -271,6 +279,158 @@ celix_status_t endpointDescriptorReader_parseDocument(endpoint_descriptor_reader
     return status;
 }
 
+celix_status_t endpointDescriptorReader_feed(endpoint_descriptor_reader_pt reader, const char *data, size_t length, array_list_pt endpoints) {
+    celix_status_t status = CELIX_SUCCESS;
+    size_t consumed = 0;
+
+    if (reader->pendingSize == 0) {
+        // the common case: decode straight from the received data and only keep the incomplete rest
+        status = endpointDescriptorReader_decode(reader, data, length, &consumed, endpoints);
+        data += consumed;
+        length -= consumed;
+        consumed = 0;
+    }
+
+    if (status == CELIX_SUCCESS && length > 0) {
+        if (reader->pendingSize + length > reader->pendingCapacity) {
+            size_t capacity = reader->pendingSize + length;
+            char *pending = realloc(reader->pending, capacity);
+
+            if (pending == NULL) {
+                return CELIX_ENOMEM;
+            }
+            reader->pending = pending;
+            reader->pendingCapacity = capacity;
+        }
+        memcpy(reader->pending + reader->pendingSize, data, length);
+        reader->pendingSize += length;
+
+        if (reader->pendingSize > length) {
+            status = endpointDescriptorReader_decode(reader, reader->pending, reader->pendingSize, &consumed, endpoints);
+            memmove(reader->pending, reader->pending + consumed, reader->pendingSize - consumed);
+            reader->pendingSize -= consumed;
+        }
+    }
+
+    return status;
+}
+
+celix_status_t endpointDescriptorReader_finish(endpoint_descriptor_reader_pt reader) {
+    celix_status_t status = CELIX_SUCCESS;
+
+    if (!reader->headerRead || reader->pendingSize > 0) {
+        logHelper_log(*reader->loghelper, OSGI_LOGSERVICE_ERROR, "ENDPOINT_DESCRIPTOR_READER: Incomplete endpoint descriptions");
+        status = CELIX_BUNDLE_EXCEPTION;
+    }
+
+    reader->headerRead = false;
+    reader->pendingSize = 0;
+
+    return status;
+}
+
+static bool endpointDescriptorReader_decodeLength(const char *data, size_t length, size_t *offset, size_t *value) {
+    const unsigned char *encoded = (const unsigned char *) data + *offset;
+
+    if (length - *offset < 4) {
+        return false;
+    }
+
+    *value = ((size_t) encoded[0] << 24) | ((size_t) encoded[1] << 16) | ((size_t) encoded[2] << 8) | (size_t) encoded[3];
+    *offset += 4;
+
+    return true;
+}
+
+static bool endpointDescriptorReader_decodeString(const char *data, size_t length, size_t *offset, const char **value, size_t *valueLength) {
+    size_t next = *offset;
+
+    if (!endpointDescriptorReader_decodeLength(data, length, &next, valueLength) || length - next < *valueLength) {
+        return false;
+    }
+
+    *value = data + next;
+    *offset = next + *valueLength;
+
+    return true;
+}
+
+/*
+ * Decodes the complete endpoints at the start of data, consumed is set to the number of bytes used by them.
+ * An endpoint is only decoded once all of its properties are available.
+ */
+static celix_status_t endpointDescriptorReader_decode(endpoint_descriptor_reader_pt reader, const char *data, size_t length, size_t *consumed, array_list_pt endpoints) {
+    size_t offset = 0;
+
+    *consumed = 0;
+
+    if (!reader->headerRead) {
+        if (length < ENDPOINT_BINARY_HEADER_LENGTH) {
+            return CELIX_SUCCESS;
+        }
+        if (memcmp(data, ENDPOINT_BINARY_MAGIC, ENDPOINT_BINARY_MAGIC_LENGTH) != 0 || data[ENDPOINT_BINARY_MAGIC_LENGTH] != ENDPOINT_BINARY_VERSION) {
+            logHelper_log(*reader->loghelper, OSGI_LOGSERVICE_ERROR, "ENDPOINT_DESCRIPTOR_READER: Unsupported endpoint descriptions");
+            return CELIX_BUNDLE_EXCEPTION;
+        }
+        reader->headerRead = true;
+        offset = ENDPOINT_BINARY_HEADER_LENGTH;
+        *consumed = offset;
+    }
+
+    while (offset < length) {
+        size_t count = 0;
+
+        if (!endpointDescriptorReader_decodeLength(data, length, &offset, &count)) {
+            break;
+        }
+
+        // first check that the endpoint is complete, so properties are only created once
+        size_t end = offset;
+        size_t i;
+        for (i = 0; i < count * 2; i++) {
+            const char *value = NULL;
+            size_t valueLength = 0;
+
+            if (!endpointDescriptorReader_decodeString(data, length, &end, &value, &valueLength)) {
+                break;
+            }
+        }
+        if (i < count * 2) {
+            break;
+        }
+
+        properties_pt endpointProperties = properties_create();
+        for (i = 0; i < count; i++) {
+            const char *name = NULL;
+            const char *value = NULL;
+            size_t nameLength = 0;
+            size_t valueLength = 0;
+
+            endpointDescriptorReader_decodeString(data, length, &offset, &name, &nameLength);
+            endpointDescriptorReader_decodeString(data, length, &offset, &value, &valueLength);
+
+            char *propertyName = strndup(name, nameLength);
+            char *propertyValue = strndup(value, valueLength);
+            if (propertyName != NULL && propertyValue != NULL) {
+                properties_set(endpointProperties, propertyName, propertyValue);
+            }
+            free(propertyName);
+            free(propertyValue);
+        }
+
+        endpoint_description_pt endpointDescription = NULL;
+        if (endpointDescription_create(endpointProperties, &endpointDescription) == CELIX_SUCCESS) {
+            arrayList_add(endpoints, endpointDescription);
+        } else {
+            properties_destroy(endpointProperties);
+        }
+
+        *consumed = offset;
+    }
+
+    return CELIX_SUCCESS;
+}
+
 static valueType valueTypeFromString(char *name) {
     if (name == NULL || strcmp(name, "") == 0 || strcmp(name, "String") == 0) {
         return VALUE_TYPE_STRING;
@@ -37,16 +37,22 @@
 struct endpoint_descriptor_writer {
     xmlBufferPtr buffer;
     xmlTextWriterPtr writer;
+
+    char *binary;
+    size_t binarySize;
+    size_t binaryCapacity;
 };
 
 static celix_status_t endpointDescriptorWriter_writeEndpoint(endpoint_descriptor_writer_pt writer, endpoint_description_pt endpoint);
+static celix_status_t endpointDescriptorWriter_append(endpoint_descriptor_writer_pt writer, const void *data, size_t length);
+static celix_status_t endpointDescriptorWriter_appendLength(endpoint_descriptor_writer_pt writer, size_t length);
 
 static char* valueTypeToString(valueType type);
 
 celix_status_t endpointDescriptorWriter_create(endpoint_descriptor_writer_pt *writer) {
     celix_status_t status = CELIX_SUCCESS;
 
-    *writer = malloc(sizeof(**writer));
+    *writer = calloc(1, sizeof(**writer));
     if (!*writer) {
         status = CELIX_ENOMEM;
     } else {
@@ -67,6 +73,7 @@ celix_status_t endpointDescriptorWriter_create(endpoint_descriptor_writer_pt *wr
 celix_status_t endpointDescriptorWriter_destroy(endpoint_descriptor_writer_pt writer) {
     xmlFreeTextWriter(writer->writer);
     xmlBufferFree(writer->buffer);
+    free(writer->binary);
     free(writer);
     return CELIX_SUCCESS;
 }
@@ -107,6 +114,77 @@ celix_status_t endpointDescriptorWriter_writeDocument(endpoint_descriptor_writer
     return status;
 }
 
+celix_status_t endpointDescriptorWriter_writeBinary(endpoint_descriptor_writer_pt writer, array_list_pt endpoints, char **document, size_t *length) {
+    celix_status_t status = CELIX_SUCCESS;
+    unsigned char version = ENDPOINT_BINARY_VERSION;
+
+    writer->binarySize = 0;
+    status = endpointDescriptorWriter_append(writer, ENDPOINT_BINARY_MAGIC, ENDPOINT_BINARY_MAGIC_LENGTH);
+    if (status == CELIX_SUCCESS) {
+        status = endpointDescriptorWriter_append(writer, &version, 1);
+    }
+
+    for (unsigned int i = 0; status == CELIX_SUCCESS && i < arrayList_size(endpoints); i++) {
+        endpoint_description_pt endpoint = arrayList_get(endpoints, i);
+
+        status = endpointDescriptorWriter_appendLength(writer, hashMap_size(endpoint->properties));
+
+        hash_map_iterator_pt iter = hashMapIterator_create(endpoint->properties);
+        while (status == CELIX_SUCCESS && hashMapIterator_hasNext(iter)) {
+            hash_map_entry_pt entry = hashMapIterator_nextEntry(iter);
+            const char *name = hashMapEntry_getKey(entry);
+            const char *value = hashMapEntry_getValue(entry);
+
+            status = endpointDescriptorWriter_appendLength(writer, strlen(name));
+            if (status == CELIX_SUCCESS) {
+                status = endpointDescriptorWriter_append(writer, name, strlen(name));
+            }
+            if (status == CELIX_SUCCESS) {
+                status = endpointDescriptorWriter_appendLength(writer, strlen(value));
+            }
+            if (status == CELIX_SUCCESS) {
+                status = endpointDescriptorWriter_append(writer, value, strlen(value));
+            }
+        }
+        hashMapIterator_destroy(iter);
+    }
+
+    if (status == CELIX_SUCCESS) {
+        *document = writer->binary;
+        *length = writer->binarySize;
+    }
+
+    return status;
+}
+
+static celix_status_t endpointDescriptorWriter_append(endpoint_descriptor_writer_pt writer, const void *data, size_t length) {
+    if (writer->binarySize + length > writer->binaryCapacity) {
+        size_t capacity = (writer->binaryCapacity > 0) ? writer->binaryCapacity : 4096;
+
+        while (capacity < writer->binarySize + length) {
+            capacity *= 2;
+        }
+
+        char *binary = realloc(writer->binary, capacity);
+        if (binary == NULL) {
+            return CELIX_ENOMEM;
+        }
+        writer->binary = binary;
+        writer->binaryCapacity = capacity;
+    }
+
+    memcpy(writer->binary + writer->binarySize, data, length);
+    writer->binarySize += length;
+
+    return CELIX_SUCCESS;
+}
+
+static celix_status_t endpointDescriptorWriter_appendLength(endpoint_descriptor_writer_pt writer, size_t length) {
+    unsigned char encoded[4] = { (length >> 24) & 0xff, (length >> 16) & 0xff, (length >> 8) & 0xff, length & 0xff };
+
+    return endpointDescriptorWriter_append(writer, encoded, sizeof(encoded));
+}
+
 static celix_status_t endpointDescriptorWriter_writeArrayValue(xmlTextWriterPtr writer, const xmlChar* value) {
     xmlTextWriterStartElement(writer, ARRAY);
     xmlTextWriterStartElement(writer, VALUE);
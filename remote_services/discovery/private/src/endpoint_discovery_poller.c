@@ -27,6 +27,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <strings.h>
 #include <unistd.h>
 
 #include <curl/curl.h>
@@ -42,12 +43,60 @@
 
 #define DISCOVERY_POLL_INTERVAL "DISCOVERY_CFG_POLL_INTERVAL"
 #define DEFAULT_POLL_INTERVAL "10"
+// how long a server supporting long polls may hold a poll, 0 disables long polling
+#define DEFAULT_POLL_WAIT "30"
 
 
+typedef struct poll_request *poll_request_pt;
+
+// state of a polled discovery endpoint
+struct poll_entry {
+	array_list_pt endpoints;
+	char *etag; // of the last applied response, NULL when the server does not send one
+
+	poll_request_pt request; // the poll in progress, if any
+	time_t nextPoll;
+};
+
+typedef struct poll_entry *poll_entry_pt;
+
+struct MemoryStruct {
+	char *memory;
+	size_t size;
+};
+
+// a single poll of a discovery endpoint, performed without holding the poller lock
+struct poll_request {
+	char *url;
+	char *etag; // the entry's etag when the request was made
+
+	CURL *curl;
+	struct curl_slist *headers;
+	CURLcode result;
+	long responseCode;
+	struct MemoryStruct chunk;
+
+	char *responseEtag;
+	bool delta;
+	bool longPoll;
+	char *removed;
+
+	// a response in the binary form is decoded while it is received
+	bool binary;
+	endpoint_descriptor_reader_pt reader;
+	array_list_pt decoded;
+};
+
 static void *endpointDiscoveryPoller_performPeriodicPoll(void *data);
-celix_status_t endpointDiscoveryPoller_poll(endpoint_discovery_poller_pt poller, char *url, array_list_pt currentEndpoints);
-static celix_status_t endpointDiscoveryPoller_getEndpoints(endpoint_discovery_poller_pt poller, char *url, array_list_pt *updatedEndpoints);
+static poll_request_pt endpointDiscoveryPoller_createRequest(endpoint_discovery_poller_pt poller, char *url, poll_entry_pt entry);
+static void endpointDiscoveryPoller_destroyRequest(poll_request_pt request);
+static celix_status_t endpointDiscoveryPoller_startRequest(endpoint_discovery_poller_pt poller, CURLM *multi, poll_request_pt request);
+static void endpointDiscoveryPoller_finishRequests(endpoint_discovery_poller_pt poller, CURLM *multi, array_list_pt requests, bool remove);
+static celix_status_t endpointDiscoveryPoller_fetch(endpoint_discovery_poller_pt poller, array_list_pt requests);
+static celix_status_t endpointDiscoveryPoller_apply(endpoint_discovery_poller_pt poller, poll_entry_pt entry, poll_request_pt request);
+static void endpointDiscoveryPoller_completed(endpoint_discovery_poller_pt poller, poll_request_pt request);
 static celix_status_t endpointDiscoveryPoller_endpointDescriptionEquals(const void *endpointPtr, const void *comparePtr, bool *equals);
+static void endpointDiscoveryPoller_waitForNextPoll(endpoint_discovery_poller_pt poller);
 
 /**
  * Allocates memory and initializes a new endpoint_discovery_poller instance.
@@ -73,6 +122,12 @@ celix_status_t endpointDiscoveryPoller_create(discovery_pt discovery, bundle_con
 		interval = DEFAULT_POLL_INTERVAL;
 	}
 
+	const char* wait = NULL;
+	bundleContext_getProperty(context, DISCOVERY_POLL_WAIT, &wait);
+	if (!wait) {
+		wait = DEFAULT_POLL_WAIT;
+	}
+
 	const char* endpointsProp = NULL;
 	status = bundleContext_getProperty(context, DISCOVERY_POLL_ENDPOINTS, &endpointsProp);
 	if (!endpointsProp) {
@@ -82,6 +137,7 @@ celix_status_t endpointDiscoveryPoller_create(discovery_pt discovery, bundle_con
 	char* endpoints = strdup(endpointsProp);
 
 	(*poller)->poll_interval = atoi(interval);
+	(*poller)->poll_wait = atoi(wait);
 	(*poller)->discovery = discovery;
 	(*poller)->running = false;
 	(*poller)->entries = hashMap_create(utils_stringHash, NULL, utils_stringEquals, NULL);
@@ -140,7 +196,7 @@ celix_status_t endpointDiscoveryPoller_destroy(endpoint_discovery_poller_pt poll
 		return CELIX_BUNDLE_EXCEPTION;
 	}
 
-	hashMap_destroy(poller->entries, true, false);
+	hashMap_destroy(poller->entries, true, true);
 
 	status = celixThreadMutex_unlock(&poller->pollerLock);
 
@@ -175,6 +231,7 @@ celix_status_t endpointDiscoveryPoller_getDiscoveryEndpoints(endpoint_discovery_
  */
 celix_status_t endpointDiscoveryPoller_addDiscoveryEndpoint(endpoint_discovery_poller_pt poller, char *url) {
 	celix_status_t status;
+	poll_request_pt request = NULL;
 
 	status = celixThreadMutex_lock(&(poller)->pollerLock);
 	if (status != CELIX_SUCCESS) {
@@ -182,19 +239,39 @@ celix_status_t endpointDiscoveryPoller_addDiscoveryEndpoint(endpoint_discovery_p
 	}
 
 	// Avoid memory leaks when adding an already existing URL...
-	array_list_pt endpoints = hashMap_get(poller->entries, url);
-	if (endpoints == NULL) {
-		status = arrayList_createWithEquals(endpointDiscoveryPoller_endpointDescriptionEquals, &endpoints);
+	poll_entry_pt entry = hashMap_get(poller->entries, url);
+	if (entry == NULL) {
+		entry = calloc(1, sizeof(*entry));
+
+		if (entry == NULL) {
+			status = CELIX_ENOMEM;
+		} else {
+			status = arrayList_createWithEquals(endpointDiscoveryPoller_endpointDescriptionEquals, &entry->endpoints);
+		}
 
 		if (status == CELIX_SUCCESS) {
 			logHelper_log(*poller->loghelper, OSGI_LOGSERVICE_DEBUG, "ENDPOINT_POLLER: add new discovery endpoint with url %s", url);
-			hashMap_put(poller->entries, strdup(url), endpoints);
-			endpointDiscoveryPoller_poll(poller, url, endpoints);
+			hashMap_put(poller->entries, strdup(url), entry);
+			request = endpointDiscoveryPoller_createRequest(poller, url, entry);
+			entry->request = request;
+		} else {
+			free(entry);
 		}
 	}
 
 	status = celixThreadMutex_unlock(&poller->pollerLock);
 
+	// the initial poll is done right away, but without blocking the other endpoints
+	if (request != NULL) {
+		array_list_pt requests = NULL;
+
+		arrayList_create(&requests);
+		arrayList_add(requests, request);
+		endpointDiscoveryPoller_fetch(poller, requests);
+		endpointDiscoveryPoller_completed(poller, request);
+		arrayList_destroy(requests);
+	}
+
 	return status;
 }
 
@@ -216,9 +293,11 @@ celix_status_t endpointDiscoveryPoller_removeDiscoveryEndpoint(endpoint_discover
 
 			logHelper_log(*poller->loghelper, OSGI_LOGSERVICE_DEBUG, "ENDPOINT_POLLER: remove discovery endpoint with url %s", url);
 
-			array_list_pt entries = hashMap_remove(poller->entries, url);
+			poll_entry_pt pollEntry = hashMap_remove(poller->entries, url);
+
+			if (pollEntry != NULL) {
+				array_list_pt entries = pollEntry->endpoints;
 
-			if (entries != NULL) {
 				for (unsigned int i = arrayList_size(entries); i > 0; i--) {
 					endpoint_description_pt endpoint = arrayList_get(entries, i - 1);
 					discovery_removeDiscoveredEndpoint(poller->discovery, endpoint);
@@ -226,6 +305,8 @@ celix_status_t endpointDiscoveryPoller_removeDiscoveryEndpoint(endpoint_discover
 					endpointDescription_destroy(endpoint);
 				}
 				arrayList_destroy(entries);
+				free(pollEntry->etag);
+				free(pollEntry);
 			}
 
 			free(origKey);
@@ -236,21 +317,76 @@ celix_status_t endpointDiscoveryPoller_removeDiscoveryEndpoint(endpoint_discover
 	return status;
 }
 
+static celix_status_t endpointDiscoveryPoller_removeEndpointWithId(endpoint_discovery_poller_pt poller, array_list_pt currentEndpoints, const char *id) {
+	celix_status_t status = CELIX_SUCCESS;
+
+	for (unsigned int i = arrayList_size(currentEndpoints); i > 0; i--) {
+		endpoint_description_pt endpoint = arrayList_get(currentEndpoints, i - 1);
 
+		if (strcmp(endpoint->id, id) == 0) {
+			status = discovery_removeDiscoveredEndpoint(poller->discovery, endpoint);
+			arrayList_remove(currentEndpoints, i - 1);
+			endpointDescription_destroy(endpoint);
+		}
+	}
 
+	return status;
+}
 
-celix_status_t endpointDiscoveryPoller_poll(endpoint_discovery_poller_pt poller, char *url, array_list_pt currentEndpoints) {
-	celix_status_t status;
+/**
+ * Applies the response of a poll to the endpoints of the entry, must be called with the poller lock held.
+ */
+static celix_status_t endpointDiscoveryPoller_apply(endpoint_discovery_poller_pt poller, poll_entry_pt entry, poll_request_pt request) {
+	celix_status_t status = CELIX_SUCCESS;
+	array_list_pt currentEndpoints = entry->endpoints;
 	array_list_pt updatedEndpoints = NULL;
 
-	// create an arraylist with a custom equality test to ensure we can find endpoints properly...
-	arrayList_createWithEquals(endpointDiscoveryPoller_endpointDescriptionEquals, &updatedEndpoints);
-	status = endpointDiscoveryPoller_getEndpoints(poller, url, &updatedEndpoints);
+	if (request->result != CURLE_OK) {
+		logHelper_log(*poller->loghelper, OSGI_LOGSERVICE_ERROR, "ENDPOINT_POLLER: unable to read endpoints from %s, reason: %s", request->url, curl_easy_strerror(request->result));
+		return CELIX_BUNDLE_EXCEPTION;
+	} else if (request->responseCode == 304) {
+		// nothing changed since the last poll
+		return CELIX_SUCCESS;
+	} else if (request->responseCode != 200) {
+		logHelper_log(*poller->loghelper, OSGI_LOGSERVICE_ERROR, "ENDPOINT_POLLER: unable to read endpoints from %s, response code: %ld", request->url, request->responseCode);
+		return CELIX_BUNDLE_EXCEPTION;
+	} else if ((entry->etag == NULL) != (request->etag == NULL) || (entry->etag != NULL && strcmp(entry->etag, request->etag) != 0)) {
+		// a concurrent poll was applied in the meantime, this response may be older
+		return CELIX_SUCCESS;
+	}
 
-	if (status != CELIX_SUCCESS) {
-		celixThreadMutex_unlock(&poller->pollerLock);
+	if (request->binary) {
+		// already decoded while it was received
+		status = endpointDescriptorReader_finish(request->reader);
+		if (status == CELIX_SUCCESS) {
+			updatedEndpoints = request->decoded;
+			request->decoded = NULL;
+		}
 	} else {
-		if (updatedEndpoints) {
+		// create an arraylist with a custom equality test to ensure we can find endpoints properly...
+		arrayList_createWithEquals(endpointDiscoveryPoller_endpointDescriptionEquals, &updatedEndpoints);
+
+		endpoint_descriptor_reader_pt reader = NULL;
+		status = endpointDescriptorReader_create(poller, &reader);
+		if (status == CELIX_SUCCESS) {
+			status = endpointDescriptorReader_parseDocument(reader, request->chunk.memory, &updatedEndpoints);
+		}
+		if (reader) {
+			endpointDescriptorReader_destroy(reader);
+		}
+	}
+
+	if (status == CELIX_SUCCESS && updatedEndpoints) {
+		if (request->delta) {
+			// only the changes since our etag, removed endpoints are listed by id
+			char *save_ptr = NULL;
+			char *id = (request->removed != NULL) ? strtok_r(request->removed, ",", &save_ptr) : NULL;
+
+			while (id != NULL) {
+				endpointDiscoveryPoller_removeEndpointWithId(poller, currentEndpoints, utils_stringTrim(id));
+				id = strtok_r(NULL, ",", &save_ptr);
+			}
+		} else {
 			for (unsigned int i = arrayList_size(currentEndpoints); i > 0; i--) {
 				endpoint_description_pt endpoint = arrayList_get(currentEndpoints, i - 1);
 
@@ -260,19 +396,22 @@ celix_status_t endpointDiscoveryPoller_poll(endpoint_discovery_poller_pt poller,
 					endpointDescription_destroy(endpoint);
 				}
 			}
+		}
 
-			for (int i = arrayList_size(updatedEndpoints); i > 0; i--) {
-				endpoint_description_pt endpoint = arrayList_remove(updatedEndpoints, 0);
+		for (int i = arrayList_size(updatedEndpoints); i > 0; i--) {
+			endpoint_description_pt endpoint = arrayList_remove(updatedEndpoints, 0);
 
-				if (!arrayList_contains(currentEndpoints, endpoint)) {
-					arrayList_add(currentEndpoints, endpoint);
-					status = discovery_addDiscoveredEndpoint(poller->discovery, endpoint);
-				} else {
-					endpointDescription_destroy(endpoint);
+			if (!arrayList_contains(currentEndpoints, endpoint)) {
+				arrayList_add(currentEndpoints, endpoint);
+				status = discovery_addDiscoveredEndpoint(poller->discovery, endpoint);
+			} else {
+				endpointDescription_destroy(endpoint);
 
-				}
 			}
 		}
+
+		free(entry->etag);
+		entry->etag = (request->responseEtag != NULL) ? strdup(request->responseEtag) : NULL;
 	}
 
 	if (updatedEndpoints) {
@@ -282,47 +421,152 @@ celix_status_t endpointDiscoveryPoller_poll(endpoint_discovery_poller_pt poller,
 	return status;
 }
 
+/**
+ * Applies a finished poll to its entry (if that still exists) and schedules the next poll, then destroys the request.
+ * A server which supports long polls holds the next poll until something changes, so it is started right away.
+ */
+static void endpointDiscoveryPoller_completed(endpoint_discovery_poller_pt poller, poll_request_pt request) {
+	if (celixThreadMutex_lock(&poller->pollerLock) == CELIX_SUCCESS) {
+		poll_entry_pt entry = hashMap_get(poller->entries, request->url);
+
+		// the endpoint may have been removed (and added again) during the poll
+		if (entry != NULL) {
+			celix_status_t status = endpointDiscoveryPoller_apply(poller, entry, request);
+
+			if (entry->request == request) {
+				// after the first poll of a server sending etags, try whether it holds polls
+				bool longPoll = (status == CELIX_SUCCESS && poller->poll_wait > 0
+						&& (request->longPoll || (request->etag == NULL && request->responseEtag != NULL)));
+
+				entry->request = NULL;
+				entry->nextPoll = time(NULL) + (longPoll ? 0 : poller->poll_interval);
+			}
+		}
+		celixThreadMutex_unlock(&poller->pollerLock);
+	}
+
+	endpointDiscoveryPoller_destroyRequest(request);
+}
+
+/**
+ * Sleeps until the next poll of an endpoint is due, at most a second to notice new endpoints and a stop in time.
+ */
+static void endpointDiscoveryPoller_waitForNextPoll(endpoint_discovery_poller_pt poller) {
+	unsigned int delay = 1;
+
+	if (celixThreadMutex_lock(&poller->pollerLock) == CELIX_SUCCESS) {
+		time_t now = time(NULL);
+		hash_map_iterator_pt iterator = hashMapIterator_create(poller->entries);
+
+		while (hashMapIterator_hasNext(iterator)) {
+			poll_entry_pt entry = hashMapIterator_nextValue(iterator);
+
+			if (entry->request == NULL && entry->nextPoll <= now) {
+				delay = 0;
+			}
+		}
+
+		hashMapIterator_destroy(iterator);
+		celixThreadMutex_unlock(&poller->pollerLock);
+	}
+
+	if (delay > 0 && poller->running) {
+		sleep(delay);
+	}
+}
+
 static void *endpointDiscoveryPoller_performPeriodicPoll(void *data) {
 	endpoint_discovery_poller_pt poller = (endpoint_discovery_poller_pt) data;
+	CURLM *multi = curl_multi_init();
+	array_list_pt requests = NULL; // in progress
+
+	if (!multi) {
+		logHelper_log(*poller->loghelper, OSGI_LOGSERVICE_ERROR, "ENDPOINT_POLLER: unable to initialize polling");
+		return NULL;
+	}
 
-	useconds_t interval = (useconds_t) (poller->poll_interval * 1000000L);
+	arrayList_create(&requests);
 
 	while (poller->running) {
-		usleep(interval);
 		celix_status_t status = celixThreadMutex_lock(&poller->pollerLock);
 
 		if (status != CELIX_SUCCESS) {
 			logHelper_log(*poller->loghelper, OSGI_LOGSERVICE_WARNING, "ENDPOINT_POLLER: failed to obtain lock; retrying...");
 		} else {
+			time_t now = time(NULL);
 			hash_map_iterator_pt iterator = hashMapIterator_create(poller->entries);
 
+			// start the polls which are due, all endpoints are polled concurrently
 			while (hashMapIterator_hasNext(iterator)) {
-				hash_map_entry_pt entry = hashMapIterator_nextEntry(iterator);
+				hash_map_entry_pt mapEntry = hashMapIterator_nextEntry(iterator);
+				poll_entry_pt entry = hashMapEntry_getValue(mapEntry);
+
+				if (entry->request == NULL && entry->nextPoll <= now) {
+					poll_request_pt request = endpointDiscoveryPoller_createRequest(poller, hashMapEntry_getKey(mapEntry), entry);
+
+					if (request == NULL) {
+						entry->nextPoll = now + poller->poll_interval;
+						continue;
+					}
+
+					if (endpointDiscoveryPoller_startRequest(poller, multi, request) == CELIX_SUCCESS) {
+						entry->request = request;
+						arrayList_add(requests, request);
+					} else {
+						entry->nextPoll = now + poller->poll_interval;
+						endpointDiscoveryPoller_destroyRequest(request);
+					}
+				}
+			}
 
-				char *url = hashMapEntry_getKey(entry);
-				array_list_pt currentEndpoints = hashMapEntry_getValue(entry);
+			hashMapIterator_destroy(iterator);
 
-				endpointDiscoveryPoller_poll(poller, url, currentEndpoints);
+			status = celixThreadMutex_unlock(&poller->pollerLock);
+			if (status != CELIX_SUCCESS) {
+				logHelper_log(*poller->loghelper, OSGI_LOGSERVICE_WARNING, "ENDPOINT_POLLER: failed to release lock; retrying...");
 			}
+		}
 
-			hashMapIterator_destroy(iterator);
+		// the polls are performed without holding the lock, the timeout bounds the reaction time to new and stopped polls
+		int running = 0;
+		curl_multi_perform(multi, &running);
+		if (running > 0) {
+			curl_multi_wait(multi, NULL, 0, 1000, NULL);
+			curl_multi_perform(multi, &running);
 		}
 
-		status = celixThreadMutex_unlock(&poller->pollerLock);
-		if (status != CELIX_SUCCESS) {
-			logHelper_log(*poller->loghelper, OSGI_LOGSERVICE_WARNING, "ENDPOINT_POLLER: failed to release lock; retrying...");
+		array_list_pt finished = NULL;
+		arrayList_create(&finished);
+		endpointDiscoveryPoller_finishRequests(poller, multi, finished, false);
+
+		for (unsigned int i = 0; i < arrayList_size(finished); i++) {
+			poll_request_pt request = arrayList_get(finished, i);
+
+			arrayList_removeElement(requests, request);
+			endpointDiscoveryPoller_completed(poller, request);
 		}
-	}
+		arrayList_destroy(finished);
 
-	return NULL;
-}
+		// curl_multi_wait returns at once when there are no transfers
+		if (arrayList_isEmpty(requests)) {
+			endpointDiscoveryPoller_waitForNextPoll(poller);
+		}
+	}
 
+	// abort the polls still in progress
+	for (unsigned int i = 0; i < arrayList_size(requests); i++) {
+		poll_request_pt request = arrayList_get(requests, i);
 
+		curl_multi_remove_handle(multi, request->curl);
+		curl_easy_cleanup(request->curl);
+		curl_slist_free_all(request->headers);
+		endpointDiscoveryPoller_destroyRequest(request);
+	}
+	arrayList_destroy(requests);
+	curl_multi_cleanup(multi);
 
-struct MemoryStruct {
-	char *memory;
-	size_t size;
-};
+	return NULL;
+}
 
 static size_t endpointDiscoveryPoller_writeMemory(void *contents, size_t size, size_t nmemb, void *memoryPtr) {
 	size_t realsize = size * nmemb;
@@ -341,53 +585,239 @@ static size_t endpointDiscoveryPoller_writeMemory(void *contents, size_t size, s
 	return realsize;
 }
 
-static celix_status_t endpointDiscoveryPoller_getEndpoints(endpoint_discovery_poller_pt poller, char *url, array_list_pt *updatedEndpoints) {
+static size_t endpointDiscoveryPoller_writeBody(void *contents, size_t size, size_t nmemb, void *requestPtr) {
+	size_t realsize = size * nmemb;
+	poll_request_pt request = (poll_request_pt) requestPtr;
+
+	if (!request->binary) {
+		return endpointDiscoveryPoller_writeMemory(contents, size, nmemb, &request->chunk);
+	}
+
+	if (request->decoded == NULL) {
+		arrayList_createWithEquals(endpointDiscoveryPoller_endpointDescriptionEquals, &request->decoded);
+	}
+
+	// returning less than was received aborts the transfer
+	if (endpointDescriptorReader_feed(request->reader, contents, realsize, request->decoded) != CELIX_SUCCESS) {
+		return 0;
+	}
+
+	return realsize;
+}
+
+// returns a copy of the value of the header line if it has the given name
+static char *endpointDiscoveryPoller_headerValue(const char *line, size_t length, const char *name) {
+	size_t nameLength = strlen(name);
+	char *value = NULL;
+
+	if (length > nameLength && strncasecmp(line, name, nameLength) == 0 && line[nameLength] == ':') {
+		value = strndup(line + nameLength + 1, length - nameLength - 1);
+		value = utils_stringTrim(value);
+	}
+
+	return value;
+}
+
+static size_t endpointDiscoveryPoller_writeHeader(char *buffer, size_t size, size_t nitems, void *requestPtr) {
+	size_t realsize = size * nitems;
+	poll_request_pt request = (poll_request_pt) requestPtr;
+	char *value = NULL;
+
+	if ((value = endpointDiscoveryPoller_headerValue(buffer, realsize, "ETag")) != NULL) {
+		// strip the quotes of the (strong) etag
+		size_t length = strlen(value);
+		if (length >= 2 && value[0] == '"' && value[length - 1] == '"') {
+			memmove(value, value + 1, length - 2);
+			value[length - 2] = '\0';
+		}
+		free(request->responseEtag);
+		request->responseEtag = value;
+	} else if ((value = endpointDiscoveryPoller_headerValue(buffer, realsize, DISCOVERY_DELTA_HEADER)) != NULL) {
+		request->delta = (strcmp(value, "true") == 0);
+		free(value);
+	} else if ((value = endpointDiscoveryPoller_headerValue(buffer, realsize, DISCOVERY_LONG_POLL_HEADER)) != NULL) {
+		request->longPoll = (strcmp(value, "true") == 0);
+		free(value);
+	} else if ((value = endpointDiscoveryPoller_headerValue(buffer, realsize, DISCOVERY_REMOVED_HEADER)) != NULL) {
+		free(request->removed);
+		request->removed = value;
+	} else if ((value = endpointDiscoveryPoller_headerValue(buffer, realsize, "Content-Type")) != NULL) {
+		request->binary = (request->reader != NULL && strncasecmp(value, DISCOVERY_BINARY_CONTENT_TYPE, strlen(DISCOVERY_BINARY_CONTENT_TYPE)) == 0);
+		free(value);
+	}
+
+	return realsize;
+}
+
+/**
+ * Creates a poll of the given url, must be called with the poller lock held.
+ */
+static poll_request_pt endpointDiscoveryPoller_createRequest(endpoint_discovery_poller_pt poller, char *url, poll_entry_pt entry) {
+	poll_request_pt request = calloc(1, sizeof(*request));
+
+	if (request != NULL) {
+		request->url = strdup(url);
+		request->etag = (entry->etag != NULL) ? strdup(entry->etag) : NULL;
+		request->chunk.memory = malloc(1);
+		request->chunk.size = 0;
+		request->result = CURLE_FAILED_INIT;
+		// without a reader only XML is accepted
+		endpointDescriptorReader_create(poller, &request->reader);
+	}
+
+	return request;
+}
+
+static void endpointDiscoveryPoller_destroyRequest(poll_request_pt request) {
+	free(request->url);
+	free(request->etag);
+	free(request->chunk.memory);
+	free(request->responseEtag);
+	if (request->decoded != NULL) {
+		for (unsigned int i = 0; i < arrayList_size(request->decoded); i++) {
+			endpointDescription_destroy(arrayList_get(request->decoded, i));
+		}
+		arrayList_destroy(request->decoded);
+	}
+	if (request->reader != NULL) {
+		endpointDescriptorReader_destroy(request->reader);
+	}
+	free(request->removed);
+	free(request);
+}
+
+/**
+ * Adds the transfer of a poll to the multi handle. A poll with an etag only asks for the changes since then,
+ * and asks servers supporting it to hold the poll until something changes.
+ */
+static celix_status_t endpointDiscoveryPoller_startRequest(endpoint_discovery_poller_pt poller, CURLM *multi, poll_request_pt request) {
 	celix_status_t status = CELIX_SUCCESS;
+	long timeout = 10L;
 
+	request->curl = curl_easy_init();
+	if (!request->curl) {
+		return CELIX_ILLEGAL_STATE;
+	}
 
-	CURL *curl = NULL;
-	CURLcode res = CURLE_OK;
+	if (request->etag != NULL) {
+		char *url = NULL;
+		char header[128];
 
-	struct MemoryStruct chunk;
-	chunk.memory = malloc(1);
-	chunk.size = 0;
+		if (asprintf(&url, "%s%c%s=%s&%s=%u", request->url, (strchr(request->url, '?') != NULL) ? '&' : '?', DISCOVERY_SINCE_PARAMETER, request->etag,
+				DISCOVERY_WAIT_PARAMETER, poller->poll_wait) > 0) {
+			curl_easy_setopt(request->curl, CURLOPT_URL, url);
+			free(url);
+		} else {
+			curl_easy_setopt(request->curl, CURLOPT_URL, request->url);
+		}
+
+		snprintf(header, sizeof(header), "If-None-Match: \"%s\"", request->etag);
+		request->headers = curl_slist_append(request->headers, header);
 
-	curl = curl_easy_init();
-	if (!curl) {
-		status = CELIX_ILLEGAL_STATE;
+		timeout += poller->poll_wait;
 	} else {
-		curl_easy_setopt(curl, CURLOPT_URL, url);
-		curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1);
-		curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, endpointDiscoveryPoller_writeMemory);
-		curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&chunk);
-		curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 5L);
-		curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L);
-		res = curl_easy_perform(curl);
+		curl_easy_setopt(request->curl, CURLOPT_URL, request->url);
+	}
 
-		curl_easy_cleanup(curl);
+	if (request->reader != NULL) {
+		request->headers = curl_slist_append(request->headers, "Accept: " DISCOVERY_BINARY_CONTENT_TYPE ", application/xml;q=0.5");
+	}
+	curl_easy_setopt(request->curl, CURLOPT_HTTPHEADER, request->headers);
+	curl_easy_setopt(request->curl, CURLOPT_PRIVATE, request);
+	curl_easy_setopt(request->curl, CURLOPT_NOSIGNAL, 1);
+	curl_easy_setopt(request->curl, CURLOPT_WRITEFUNCTION, endpointDiscoveryPoller_writeBody);
+	curl_easy_setopt(request->curl, CURLOPT_WRITEDATA, (void *) request);
+	curl_easy_setopt(request->curl, CURLOPT_HEADERFUNCTION, endpointDiscoveryPoller_writeHeader);
+	curl_easy_setopt(request->curl, CURLOPT_HEADERDATA, (void *) request);
+	curl_easy_setopt(request->curl, CURLOPT_CONNECTTIMEOUT, 5L);
+	curl_easy_setopt(request->curl, CURLOPT_TIMEOUT, timeout);
+
+	if (curl_multi_add_handle(multi, request->curl) != CURLM_OK) {
+		curl_easy_cleanup(request->curl);
+		request->curl = NULL;
+		curl_slist_free_all(request->headers);
+		request->headers = NULL;
+		status = CELIX_BUNDLE_EXCEPTION;
 	}
 
-	// process endpoints file
-	if (res == CURLE_OK) {
-		endpoint_descriptor_reader_pt reader = NULL;
+	return status;
+}
 
-		status = endpointDescriptorReader_create(poller, &reader);
-		if (status == CELIX_SUCCESS) {
-			status = endpointDescriptorReader_parseDocument(reader, chunk.memory, updatedEndpoints);
+/**
+ * Collects the finished polls of the multi handle in requests and cleans up their transfers.
+ */
+static void endpointDiscoveryPoller_finishRequests(endpoint_discovery_poller_pt poller, CURLM *multi, array_list_pt requests, bool remove) {
+	CURLMsg *message = NULL;
+	int remaining = 0;
+
+	while ((message = curl_multi_info_read(multi, &remaining)) != NULL) {
+		if (message->msg == CURLMSG_DONE) {
+			poll_request_pt request = NULL;
+
+			curl_easy_getinfo(message->easy_handle, CURLINFO_PRIVATE, (char **) &request);
+			request->result = message->data.result;
+			curl_easy_getinfo(message->easy_handle, CURLINFO_RESPONSE_CODE, &request->responseCode);
+
+			curl_multi_remove_handle(multi, request->curl);
+			curl_easy_cleanup(request->curl);
+			request->curl = NULL;
+			curl_slist_free_all(request->headers);
+			request->headers = NULL;
+
+			if (!remove) {
+				arrayList_add(requests, request);
+			}
 		}
+	}
+}
 
-		if (reader) {
-			endpointDescriptorReader_destroy(reader);
+/**
+ * Performs the given polls concurrently and blocks until all of them are finished.
+ */
+static celix_status_t endpointDiscoveryPoller_fetch(endpoint_discovery_poller_pt poller, array_list_pt requests) {
+	celix_status_t status = CELIX_SUCCESS;
+	CURLM *multi = curl_multi_init();
+
+	if (!multi) {
+		return CELIX_ILLEGAL_STATE;
+	}
+
+	for (unsigned int i = 0; i < arrayList_size(requests); i++) {
+		endpointDiscoveryPoller_startRequest(poller, multi, arrayList_get(requests, i));
+	}
+
+	int running = 0;
+	CURLMcode rc = CURLM_OK;
+
+	do {
+		rc = curl_multi_perform(multi, &running);
+		if (rc == CURLM_OK && running > 0) {
+			rc = curl_multi_wait(multi, NULL, 0, 1000, NULL);
 		}
-	} else {
-		logHelper_log(*poller->loghelper, OSGI_LOGSERVICE_ERROR, "ENDPOINT_POLLER: unable to read endpoints from %s, reason: %s", url, curl_easy_strerror(res));
+	} while (rc == CURLM_OK && running > 0);
+
+	if (rc != CURLM_OK) {
+		logHelper_log(*poller->loghelper, OSGI_LOGSERVICE_ERROR, "ENDPOINT_POLLER: polling failed, reason: %s", curl_multi_strerror(rc));
+		status = CELIX_BUNDLE_EXCEPTION;
 	}
 
-	// clean up endpoints file
-	if (chunk.memory) {
-		free(chunk.memory);
+	endpointDiscoveryPoller_finishRequests(poller, multi, requests, true);
+
+	// transfers which did not finish
+	for (unsigned int i = 0; i < arrayList_size(requests); i++) {
+		poll_request_pt request = arrayList_get(requests, i);
+
+		if (request->curl != NULL) {
+			curl_multi_remove_handle(multi, request->curl);
+			curl_easy_cleanup(request->curl);
+			request->curl = NULL;
+		}
+		curl_slist_free_all(request->headers);
+		request->headers = NULL;
 	}
 
+	curl_multi_cleanup(multi);
+
 	return status;
 }
 
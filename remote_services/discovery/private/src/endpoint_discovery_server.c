@@ -25,6 +25,9 @@
  */
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
 #include <arpa/inet.h>
 #include <netdb.h>
 #ifndef ANDROID
@@ -41,16 +44,35 @@
 
 // defines how often the webserver is restarted (with an increased port number)
 #define MAX_NUMBER_OF_RESTARTS 	15
-#define DEFAULT_SERVER_THREADS "1"
+// long polls occupy a server thread each, one thread is always kept for other requests
+#define DEFAULT_SERVER_THREADS "5"
+#define MAX_WAIT_SECONDS 300
 
 #define CIVETWEB_REQUEST_NOT_HANDLED 0
 #define CIVETWEB_REQUEST_HANDLED 1
 
+// number of changes remembered for delta requests, older pollers get the full list
+#define MAX_NUMBER_OF_CHANGES 256
+#define MAX_ETAG_LENGTH 64
+
 static const char *response_headers =
 		"HTTP/1.1 200 OK\r\n"
 		"Cache: no-cache\r\n"
-		"Content-Type: application/xml;charset=utf-8\r\n"
-		"\r\n";
+		"Vary: Accept\r\n";
+
+static const char *xml_content_type = "application/xml;charset=utf-8";
+
+static const char *not_modified_headers =
+		"HTTP/1.1 304 Not Modified\r\n"
+		"Cache: no-cache\r\n";
+
+struct endpoint_change {
+	unsigned long version;
+	bool added;
+	char* endpointId;
+};
+
+typedef struct endpoint_change *endpoint_change_pt;
 
 struct endpoint_discovery_server {
 	log_helper_pt* loghelper;
@@ -58,6 +80,19 @@ struct endpoint_discovery_server {
 
 	celix_thread_mutex_t serverLock;
 
+	// every change of the entries increments the version, the epoch distinguishes restarts of the server
+	unsigned long epoch;
+	unsigned long version;
+	// the changes after version truncated, oldest first
+	array_list_pt changes;
+	unsigned long truncated;
+
+	// signaled on every change, long polls wait for it
+	celix_thread_cond_t changed;
+	unsigned int waiters;
+	unsigned int maxWaiters;
+	bool stopping;
+
 	const char* path;
 	const char *port;
 	const char* ip;
@@ -66,6 +101,7 @@ struct endpoint_discovery_server {
 
 // Forward declarations...
 static int endpointDiscoveryServer_callback(struct mg_connection *conn);
+static void endpointDiscoveryServer_addChange(endpoint_discovery_server_pt server, const char* endpointId, bool added);
 static char* format_path(const char* path);
 
 #ifndef ANDROID
@@ -80,6 +116,7 @@ celix_status_t endpointDiscoveryServer_create(discovery_pt discovery, bundle_con
 	char *detectedIp = NULL;
 	const char *path = NULL;
 	const char *retries = NULL;
+	const char *threads = NULL;
 
 	int max_ep_num = MAX_NUMBER_OF_RESTARTS;
 
@@ -99,6 +136,19 @@ celix_status_t endpointDiscoveryServer_create(discovery_pt discovery, bundle_con
 		return CELIX_BUNDLE_EXCEPTION;
 	}
 
+	(*server)->epoch = ((unsigned long) time(NULL) << 16) ^ (unsigned long) getpid();
+	(*server)->version = 0;
+	(*server)->truncated = 0;
+	(*server)->waiters = 0;
+	(*server)->maxWaiters = 0;
+	(*server)->stopping = false;
+	if (celixThreadCondition_init(&(*server)->changed, NULL) != CELIX_SUCCESS) {
+		return CELIX_BUNDLE_EXCEPTION;
+	}
+	if (arrayList_create(&(*server)->changes) != CELIX_SUCCESS) {
+		return CELIX_ENOMEM;
+	}
+
 	bundleContext_getProperty(context, DISCOVERY_SERVER_IP, &ip);
 #ifndef ANDROID
 	if (ip == NULL) {
@@ -149,6 +199,12 @@ celix_status_t endpointDiscoveryServer_create(discovery_pt discovery, bundle_con
 		}
 	}
 
+	bundleContext_getProperty(context, DISCOVERY_SERVER_THREADS, &threads);
+	if (threads == NULL || atoi(threads) <= 0) {
+		threads = DEFAULT_SERVER_THREADS;
+	}
+	(*server)->maxWaiters = atoi(threads) - 1;
+
 	(*server)->path = format_path(path);
 
 	const struct mg_callbacks callbacks = {
@@ -161,7 +217,7 @@ celix_status_t endpointDiscoveryServer_create(discovery_pt discovery, bundle_con
 	do {
 		const char *options[] = {
 				"listening_ports", port,
-				"num_threads", DEFAULT_SERVER_THREADS,
+				"num_threads", threads,
 				NULL
 		};
 
@@ -210,6 +266,13 @@ celix_status_t endpointDiscoveryServer_getUrl(endpoint_discovery_server_pt serve
 celix_status_t endpointDiscoveryServer_destroy(endpoint_discovery_server_pt server) {
 	celix_status_t status;
 
+	// wake up the long polls, otherwise stopping waits for them to time out
+	if (celixThreadMutex_lock(&server->serverLock) == CELIX_SUCCESS) {
+		server->stopping = true;
+		celixThreadCondition_broadcast(&server->changed);
+		celixThreadMutex_unlock(&server->serverLock);
+	}
+
 	// stop & block until the actual server is shut down...
 	if (server->ctx != NULL) {
 		mg_stop(server->ctx);
@@ -220,8 +283,16 @@ celix_status_t endpointDiscoveryServer_destroy(endpoint_discovery_server_pt serv
 
 	hashMap_destroy(server->entries, true /* freeKeys */, false /* freeValues */);
 
+	for (unsigned int i = 0; i < arrayList_size(server->changes); i++) {
+		endpoint_change_pt change = arrayList_get(server->changes, i);
+		free(change->endpointId);
+		free(change);
+	}
+	arrayList_destroy(server->changes);
+
 	status = celixThreadMutex_unlock(&server->serverLock);
 	status = celixThreadMutex_destroy(&server->serverLock);
+	celixThreadCondition_destroy(&server->changed);
 
 	free((void*) server->path);
 	free((void*) server->port);
@@ -247,6 +318,9 @@ celix_status_t endpointDiscoveryServer_addEndpoint(endpoint_discovery_server_pt
 		logHelper_log(*server->loghelper, OSGI_LOGSERVICE_INFO, "exposing new endpoint \"%s\"...", endpointId);
 
 		hashMap_put(server->entries, endpointId, endpoint);
+		endpointDiscoveryServer_addChange(server, endpointId, true);
+	} else {
+		free(endpointId);
 	}
 
 	status = celixThreadMutex_unlock(&server->serverLock);
@@ -272,6 +346,7 @@ celix_status_t endpointDiscoveryServer_removeEndpoint(endpoint_discovery_server_
 		logHelper_log(*server->loghelper, OSGI_LOGSERVICE_INFO, "removing endpoint \"%s\"...\n", key);
 
 		hashMap_remove(server->entries, key);
+		endpointDiscoveryServer_addChange(server, key, false);
 
 		// we've made this key, see _addEnpoint above...
 		free((void*) key);
@@ -324,19 +399,116 @@ static celix_status_t endpointDiscoveryServer_getEndpoints(endpoint_discovery_se
 	return status;
 }
 
-static int endpointDiscoveryServer_writeEndpoints(struct mg_connection* conn, array_list_pt endpoints) {
+// to be called with the server lock held
+static void endpointDiscoveryServer_addChange(endpoint_discovery_server_pt server, const char* endpointId, bool added) {
+	endpoint_change_pt change = calloc(1, sizeof(*change));
+
+	server->version++;
+
+	if (change != NULL) {
+		change->version = server->version;
+		change->added = added;
+		change->endpointId = strdup(endpointId);
+		arrayList_add(server->changes, change);
+	} else {
+		// without a record no delta can cover this change
+		server->truncated = server->version;
+	}
+
+	while (arrayList_size(server->changes) > MAX_NUMBER_OF_CHANGES) {
+		endpoint_change_pt oldest = arrayList_remove(server->changes, 0);
+
+		server->truncated = oldest->version;
+		free(oldest->endpointId);
+		free(oldest);
+	}
+
+	celixThreadCondition_broadcast(&server->changed);
+}
+
+static void endpointDiscoveryServer_getETag(endpoint_discovery_server_pt server, char* etag) {
+	snprintf(etag, MAX_ETAG_LENGTH, "%lx-%lu", server->epoch, server->version);
+}
+
+/*
+ * Collects the endpoints added and the ids of the endpoints removed since the given ETag. An endpoint
+ * removed and added again is reported in both lists. Fails if the changes are no longer known.
+ */
+static celix_status_t endpointDiscoveryServer_getChanges(endpoint_discovery_server_pt server, const char* since, array_list_pt added, array_list_pt removed) {
+	unsigned long epoch = 0;
+	unsigned long version = 0;
+
+	if (sscanf(since, "%lx-%lu", &epoch, &version) != 2 || epoch != server->epoch || version < server->truncated || version > server->version) {
+		return CELIX_ILLEGAL_ARGUMENT;
+	}
+
+	hash_map_pt seen = hashMap_create(&utils_stringHash, NULL, &utils_stringEquals, NULL);
+
+	for (unsigned int i = 0; i < arrayList_size(server->changes); i++) {
+		endpoint_change_pt change = arrayList_get(server->changes, i);
+
+		if (change->version > version && !change->added && !hashMap_containsKey(seen, change->endpointId)) {
+			hashMap_put(seen, change->endpointId, change);
+			arrayList_add(removed, change->endpointId);
+		}
+	}
+	hashMap_clear(seen, false, false);
+
+	for (unsigned int i = 0; i < arrayList_size(server->changes); i++) {
+		endpoint_change_pt change = arrayList_get(server->changes, i);
+		endpoint_description_pt endpoint = NULL;
+
+		if (change->version > version && change->added && !hashMap_containsKey(seen, change->endpointId)
+				&& (endpoint = hashMap_get(server->entries, change->endpointId)) != NULL) {
+			hashMap_put(seen, change->endpointId, change);
+			arrayList_add(added, endpoint);
+		}
+	}
+
+	hashMap_destroy(seen, false, false);
+
+	return CELIX_SUCCESS;
+}
+
+static int endpointDiscoveryServer_writeEndpoints(struct mg_connection* conn, array_list_pt endpoints, const char* etag, array_list_pt removed, bool longPoll) {
 	celix_status_t status;
 	int rv = CIVETWEB_REQUEST_NOT_HANDLED;
 
+	// pollers which accept it get the compact binary form, the others XML
+	const char* accept = mg_get_header(conn, "Accept");
+	bool binary = (accept != NULL && strstr(accept, DISCOVERY_BINARY_CONTENT_TYPE) != NULL);
+
 	endpoint_descriptor_writer_pt writer = NULL;
 	status = endpointDescriptorWriter_create(&writer);
 	if (status == CELIX_SUCCESS) {
 
 		char *buffer = NULL;
-		status = endpointDescriptorWriter_writeDocument(writer, endpoints, &buffer);
-		if (buffer) {
+		size_t length = 0;
+		if (binary) {
+			status = endpointDescriptorWriter_writeBinary(writer, endpoints, &buffer, &length);
+		} else {
+			status = endpointDescriptorWriter_writeDocument(writer, endpoints, &buffer);
+			length = (buffer != NULL) ? strlen(buffer) : 0;
+		}
+		if (status == CELIX_SUCCESS && buffer) {
 			mg_write(conn, response_headers, strlen(response_headers));
-			mg_write(conn, buffer, strlen(buffer));
+			mg_printf(conn, "Content-Type: %s\r\n", binary ? DISCOVERY_BINARY_CONTENT_TYPE : xml_content_type);
+			if (etag != NULL) {
+				mg_printf(conn, "ETag: \"%s\"\r\n", etag);
+			}
+			if (longPoll) {
+				mg_printf(conn, "%s: true\r\n", DISCOVERY_LONG_POLL_HEADER);
+			}
+			if (removed != NULL) {
+				// a delta only holds the added endpoints, the removed ones are listed by id
+				mg_printf(conn, "%s: true\r\n%s: ", DISCOVERY_DELTA_HEADER, DISCOVERY_REMOVED_HEADER);
+				for (unsigned int i = 0; i < arrayList_size(removed); i++) {
+					mg_printf(conn, "%s%s", (i > 0) ? "," : "", (char*) arrayList_get(removed, i));
+				}
+				mg_printf(conn, "\r\n");
+			}
+			mg_write(conn, "\r\n", 2);
+			mg_write(conn, buffer, length);
 		}
 
 		rv = CIVETWEB_REQUEST_HANDLED;
@@ -349,20 +521,86 @@ static int endpointDiscoveryServer_writeEndpoints(struct mg_connection* conn, ar
 	return rv;
 }
 
-// returns all endpoints as XML...
-static int endpointDiscoveryServer_returnAllEndpoints(endpoint_discovery_server_pt server, struct mg_connection* conn) {
+/*
+ * Holds a request for the current version until the endpoints change, the server stops or the given number of
+ * seconds passed. Must be called with the server lock held. Returns false if too many requests are already waiting.
+ */
+static bool endpointDiscoveryServer_waitForChange(endpoint_discovery_server_pt server, long seconds) {
+	unsigned long version = server->version;
+	time_t deadline = time(NULL) + seconds;
+	time_t now;
+
+	if (server->waiters >= server->maxWaiters) {
+		return false;
+	}
+
+	server->waiters++;
+	while (server->version == version && !server->stopping && (now = time(NULL)) < deadline) {
+		if (celixThreadCondition_timedwaitRelative(&server->changed, &server->serverLock, deadline - now, 0) == ETIMEDOUT) {
+			break;
+		}
+	}
+	server->waiters--;
+
+	return true;
+}
+
+// returns all endpoints (as XML or in the binary form), or only the changes / 304 when the poller knows an earlier version...
+static int endpointDiscoveryServer_returnAllEndpoints(endpoint_discovery_server_pt server, struct mg_connection* conn, const char* query) {
 	int status = CIVETWEB_REQUEST_NOT_HANDLED;
 
 	array_list_pt endpoints = NULL;
 
 	if (celixThreadMutex_lock(&server->serverLock) == CELIX_SUCCESS) {
-		endpointDiscoveryServer_getEndpoints(server, NULL, &endpoints);
-		if (endpoints) {
-			status = endpointDiscoveryServer_writeEndpoints(conn, endpoints);
+		const char* ifNoneMatch = mg_get_header(conn, "If-None-Match");
+		char etag[MAX_ETAG_LENGTH];
+		char since[MAX_ETAG_LENGTH];
+		char wait[16];
+		bool hasSince = (query != NULL && mg_get_var(query, strlen(query), DISCOVERY_SINCE_PARAMETER, since, sizeof(since)) > 0);
+		bool longPoll = false;
+
+		endpointDiscoveryServer_getETag(server, etag);
+
+		// a long poll for the current version is answered as soon as something changes
+		if (hasSince && mg_get_var(query, strlen(query), DISCOVERY_WAIT_PARAMETER, wait, sizeof(wait)) > 0 && atol(wait) > 0) {
+			long seconds = atol(wait) < MAX_WAIT_SECONDS ? atol(wait) : MAX_WAIT_SECONDS;
+
+			if (strcmp(since, etag) != 0) {
+				longPoll = true;
+			} else if (endpointDiscoveryServer_waitForChange(server, seconds)) {
+				longPoll = true;
+				endpointDiscoveryServer_getETag(server, etag);
+			}
+		}
 
+		if (ifNoneMatch != NULL && strlen(ifNoneMatch) == strlen(etag) + 2 && strncmp(ifNoneMatch + 1, etag, strlen(etag)) == 0) {
+			mg_printf(conn, "%sETag: \"%s\"\r\n", not_modified_headers, etag);
+			if (longPoll) {
+				mg_printf(conn, "%s: true\r\n", DISCOVERY_LONG_POLL_HEADER);
+			}
+			mg_write(conn, "\r\n", 2);
+			status = CIVETWEB_REQUEST_HANDLED;
+		} else if (hasSince) {
+			array_list_pt removed = NULL;
+
+			arrayList_create(&endpoints);
+			arrayList_create(&removed);
+			if (endpointDiscoveryServer_getChanges(server, since, endpoints, removed) == CELIX_SUCCESS) {
+				status = endpointDiscoveryServer_writeEndpoints(conn, endpoints, etag, removed, longPoll);
+			}
+			arrayList_destroy(removed);
 			arrayList_destroy(endpoints);
+			endpoints = NULL;
 		}
 
+		if (status == CIVETWEB_REQUEST_NOT_HANDLED) {
+			endpointDiscoveryServer_getEndpoints(server, NULL, &endpoints);
+			if (endpoints) {
+				status = endpointDiscoveryServer_writeEndpoints(conn, endpoints, etag, NULL, longPoll);
+
+				arrayList_destroy(endpoints);
+			}
+		}
 
 		celixThreadMutex_unlock(&server->serverLock);
 	}
@@ -370,7 +608,7 @@ static int endpointDiscoveryServer_returnAllEndpoints(endpoint_discovery_server_
 	return status;
 }
 
-// returns a single endpoint as XML...
+// returns a single endpoint as XML or in the binary form...
 static int endpointDiscoveryServer_returnEndpoint(endpoint_discovery_server_pt server, struct mg_connection* conn, const char* endpoint_id) {
 	int status = CIVETWEB_REQUEST_NOT_HANDLED;
 
@@ -379,7 +617,7 @@ static int endpointDiscoveryServer_returnEndpoint(endpoint_discovery_server_pt s
 	if (celixThreadMutex_lock(&server->serverLock) == CELIX_SUCCESS) {
 		endpointDiscoveryServer_getEndpoints(server, endpoint_id, &endpoints);
 		if (endpoints) {
-			status = endpointDiscoveryServer_writeEndpoints(conn, endpoints);
+			status = endpointDiscoveryServer_writeEndpoints(conn, endpoints, NULL, NULL, false);
 
 			arrayList_destroy(endpoints);
 		}
@@ -404,7 +642,7 @@ static int endpointDiscoveryServer_callback(struct mg_connection* conn) {
 		if (strncmp(server->path, uri, strlen(server->path)) == 0) {
 			// Be lenient when it comes to the trailing slash...
 			if (path_len == uri_len || (uri_len == (path_len + 1) && uri[path_len] == '/')) {
-				status = endpointDiscoveryServer_returnAllEndpoints(server, conn);
+				status = endpointDiscoveryServer_returnAllEndpoints(server, conn, request_info->query_string);
 			} else {
 				const char* endpoint_id = uri + path_len + 1; // right after the slash...
 
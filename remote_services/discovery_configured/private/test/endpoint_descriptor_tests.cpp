@@ -0,0 +1,331 @@
+/**
+ *Licensed to the Apache Software Foundation (ASF) under one
+ *or more contributor license agreements.  See the NOTICE file
+ *distributed with this work for additional information
+ *regarding copyright ownership.  The ASF licenses this file
+ *to you under the Apache License, Version 2.0 (the
+ *"License"); you may not use this file except in compliance
+ *with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *Unless required by applicable law or agreed to in writing,
+ *software distributed under the License is distributed on an
+ *"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ *specific language governing permissions and limitations
+ *under the License.
+ */
+#include <CppUTest/TestHarness.h>
+#include "CppUTest/CommandLineTestRunner.h"
+
+extern "C" {
+
+	#include <stdio.h>
+	#include <stdlib.h>
+	#include <string.h>
+
+	#include "constants.h"
+	#include "remote_constants.h"
+	#include "log_helper.h"
+	#include "endpoint_description.h"
+	#include "endpoint_descriptor_reader.h"
+	#include "endpoint_descriptor_writer.h"
+
+	#define NR_OF_ENDPOINTS 3
+	#define MAX_DOCUMENT_LENGTH 4096
+
+	static log_helper_pt loghelper = NULL;
+	static struct endpoint_discovery_poller poller;
+
+	static endpoint_descriptor_writer_pt writer = NULL;
+	static endpoint_descriptor_reader_pt reader = NULL;
+
+	static array_list_pt endpoints = NULL;
+	static array_list_pt decoded = NULL;
+
+	// the binary form of the endpoints and the offsets at which each of them is complete
+	static char document[MAX_DOCUMENT_LENGTH];
+	static size_t documentLength = 0;
+	static size_t ends[NR_OF_ENDPOINTS + 1];
+
+	static endpoint_description_pt createEndpoint(const char *id, const char *serviceId, const char *service) {
+		endpoint_description_pt endpoint = NULL;
+		properties_pt properties = properties_create();
+
+		if (id != NULL) {
+			properties_set(properties, OSGI_RSA_ENDPOINT_ID, id);
+		}
+		if (service != NULL) {
+			properties_set(properties, OSGI_FRAMEWORK_OBJECTCLASS, service);
+		}
+		properties_set(properties, OSGI_RSA_ENDPOINT_SERVICE_ID, serviceId);
+		properties_set(properties, OSGI_RSA_ENDPOINT_FRAMEWORK_UUID, "2983D849-93B1-4C2C-AC6D-5BCDA93ACB96");
+		properties_set(properties, "service.imported.configs", "org.amdatu.remote.admin.http");
+
+		CHECK_EQUAL(CELIX_SUCCESS, endpointDescription_create(properties, &endpoint));
+
+		return endpoint;
+	}
+
+	static void clearDecoded(void) {
+		for (unsigned int i = 0; i < arrayList_size(decoded); i++) {
+			endpointDescription_destroy((endpoint_description_pt) arrayList_get(decoded, i));
+		}
+		arrayList_clear(decoded);
+	}
+
+	static void checkDecoded(unsigned int count) {
+		LONGS_EQUAL(count, arrayList_size(decoded));
+
+		for (unsigned int i = 0; i < count; i++) {
+			endpoint_description_pt expected = (endpoint_description_pt) arrayList_get(endpoints, i);
+			endpoint_description_pt actual = (endpoint_description_pt) arrayList_get(decoded, i);
+
+			STRCMP_EQUAL(expected->id, actual->id);
+			STRCMP_EQUAL(expected->service, actual->service);
+			LONGS_EQUAL(expected->serviceId, actual->serviceId);
+			LONGS_EQUAL(hashMap_size(expected->properties), hashMap_size(actual->properties));
+
+			hash_map_iterator_pt iter = hashMapIterator_create(expected->properties);
+			while (hashMapIterator_hasNext(iter)) {
+				hash_map_entry_pt entry = hashMapIterator_nextEntry(iter);
+
+				STRCMP_EQUAL((const char *) hashMapEntry_getValue(entry), properties_get(actual->properties, (const char *) hashMapEntry_getKey(entry)));
+			}
+			hashMapIterator_destroy(iter);
+		}
+	}
+
+	// appends a 32 bit big endian length to a hand made document
+	static void appendLength(char *data, size_t *length, size_t value) {
+		data[(*length)++] = (char) ((value >> 24) & 0xff);
+		data[(*length)++] = (char) ((value >> 16) & 0xff);
+		data[(*length)++] = (char) ((value >> 8) & 0xff);
+		data[(*length)++] = (char) (value & 0xff);
+	}
+
+	static void appendString(char *data, size_t *length, const char *value) {
+		appendLength(data, length, strlen(value));
+		memcpy(data + *length, value, strlen(value));
+		*length += strlen(value);
+	}
+
+	static void appendProperty(char *data, size_t *length, const char *name, const char *value) {
+		appendString(data, length, name);
+		appendString(data, length, value);
+	}
+
+	static void setupEndpoints(void) {
+		char *binary = NULL;
+		size_t length = 0;
+		char longValue[1024];
+
+		logHelper_create(NULL, &loghelper);
+		memset(&poller, 0, sizeof(poller));
+		poller.loghelper = &loghelper;
+
+		CHECK_EQUAL(CELIX_SUCCESS, endpointDescriptorWriter_create(&writer));
+		CHECK_EQUAL(CELIX_SUCCESS, endpointDescriptorReader_create(&poller, &reader));
+
+		arrayList_create(&endpoints);
+		arrayList_create(&decoded);
+
+		// lengths above 255 need more than the lowest byte of the length fields
+		memset(longValue, 'x', sizeof(longValue) - 1);
+		longValue[sizeof(longValue) - 1] = '\0';
+
+		arrayList_add(endpoints, createEndpoint("11111111-1111-1111-1111-111111111111", "5", "org.apache.celix.calc.api.Calculator"));
+		arrayList_add(endpoints, createEndpoint("22222222-2222-2222-2222-222222222222", "6", longValue));
+		arrayList_add(endpoints, createEndpoint("33333333-3333-3333-3333-333333333333", "7", "org.apache.celix.Example"));
+		properties_set(((endpoint_description_pt) arrayList_get(endpoints, 2))->properties, "empty", "");
+
+		// each prefix of the list is written the same way, so its length is where the next endpoint starts
+		array_list_pt prefix = NULL;
+		arrayList_create(&prefix);
+		for (unsigned int i = 0; i <= NR_OF_ENDPOINTS; i++) {
+			CHECK_EQUAL(CELIX_SUCCESS, endpointDescriptorWriter_writeBinary(writer, prefix, &binary, &length));
+			ends[i] = length;
+			if (i < NR_OF_ENDPOINTS) {
+				arrayList_add(prefix, arrayList_get(endpoints, i));
+			}
+		}
+		arrayList_destroy(prefix);
+
+		CHECK(length <= MAX_DOCUMENT_LENGTH);
+		memcpy(document, binary, length);
+		documentLength = length;
+	}
+
+	static void teardownEndpoints(void) {
+		clearDecoded();
+		arrayList_destroy(decoded);
+
+		for (unsigned int i = 0; i < arrayList_size(endpoints); i++) {
+			endpointDescription_destroy((endpoint_description_pt) arrayList_get(endpoints, i));
+		}
+		arrayList_destroy(endpoints);
+
+		endpointDescriptorReader_destroy(reader);
+		endpointDescriptorWriter_destroy(writer);
+		logHelper_destroy(&loghelper);
+	}
+
+	static void testRoundTrip(void) {
+		CHECK_EQUAL(CELIX_SUCCESS, endpointDescriptorReader_feed(reader, document, documentLength, decoded));
+		CHECK_EQUAL(CELIX_SUCCESS, endpointDescriptorReader_finish(reader));
+		checkDecoded(NR_OF_ENDPOINTS);
+	}
+
+	static void testSplitAtEveryByte(void) {
+		for (size_t split = 0; split <= documentLength; split++) {
+			CHECK_EQUAL(CELIX_SUCCESS, endpointDescriptorReader_feed(reader, document, split, decoded));
+			CHECK_EQUAL(CELIX_SUCCESS, endpointDescriptorReader_feed(reader, document + split, documentLength - split, decoded));
+			CHECK_EQUAL(CELIX_SUCCESS, endpointDescriptorReader_finish(reader));
+			checkDecoded(NR_OF_ENDPOINTS);
+			clearDecoded();
+		}
+	}
+
+	static void testBytewiseFeed(void) {
+		unsigned int complete = 0;
+
+		// an endpoint has to be decoded as soon as its last byte arrived, and not earlier
+		for (size_t i = 0; i < documentLength; i++) {
+			CHECK_EQUAL(CELIX_SUCCESS, endpointDescriptorReader_feed(reader, document + i, 1, decoded));
+			while (complete < NR_OF_ENDPOINTS && ends[complete + 1] <= i + 1) {
+				complete++;
+			}
+			checkDecoded(complete);
+		}
+		CHECK_EQUAL(CELIX_SUCCESS, endpointDescriptorReader_finish(reader));
+		checkDecoded(NR_OF_ENDPOINTS);
+	}
+
+	static void testEmptyList(void) {
+		array_list_pt none = NULL;
+		char *binary = NULL;
+		size_t length = 0;
+
+		arrayList_create(&none);
+		CHECK_EQUAL(CELIX_SUCCESS, endpointDescriptorWriter_writeBinary(writer, none, &binary, &length));
+		arrayList_destroy(none);
+
+		CHECK_EQUAL(CELIX_SUCCESS, endpointDescriptorReader_feed(reader, binary, length, decoded));
+		CHECK_EQUAL(CELIX_SUCCESS, endpointDescriptorReader_finish(reader));
+		checkDecoded(0);
+
+		// without even the header nothing was received
+		CHECK_EQUAL(CELIX_BUNDLE_EXCEPTION, endpointDescriptorReader_finish(reader));
+	}
+
+	static void testTruncated(void) {
+		unsigned int complete = 0;
+
+		for (size_t length = 0; length < documentLength; length++) {
+			bool atBoundary = false;
+
+			while (complete < NR_OF_ENDPOINTS && ends[complete + 1] <= length) {
+				complete++;
+			}
+			for (unsigned int i = 0; i <= NR_OF_ENDPOINTS; i++) {
+				atBoundary |= (ends[i] == length);
+			}
+
+			CHECK_EQUAL(CELIX_SUCCESS, endpointDescriptorReader_feed(reader, document, length, decoded));
+			CHECK_EQUAL(atBoundary ? CELIX_SUCCESS : CELIX_BUNDLE_EXCEPTION, endpointDescriptorReader_finish(reader));
+			checkDecoded(complete);
+			clearDecoded();
+		}
+	}
+
+	static void testMalformed(void) {
+		char data[MAX_DOCUMENT_LENGTH];
+		size_t length = 0;
+
+		// unknown magic
+		memcpy(data, document, documentLength);
+		data[0] = 'X';
+		CHECK_EQUAL(CELIX_BUNDLE_EXCEPTION, endpointDescriptorReader_feed(reader, data, documentLength, decoded));
+		checkDecoded(0);
+		endpointDescriptorReader_finish(reader);
+
+		// unknown version, also when the header arrives in pieces
+		memcpy(data, document, documentLength);
+		data[4] = 2;
+		CHECK_EQUAL(CELIX_SUCCESS, endpointDescriptorReader_feed(reader, data, 3, decoded));
+		CHECK_EQUAL(CELIX_BUNDLE_EXCEPTION, endpointDescriptorReader_feed(reader, data + 3, documentLength - 3, decoded));
+		checkDecoded(0);
+		endpointDescriptorReader_finish(reader);
+
+		// endpoints without an id or an objectClass are skipped, the ones after them are still decoded
+		memcpy(data, document, ends[0]);
+		length = ends[0];
+		appendLength(data, &length, 2);
+		appendProperty(data, &length, OSGI_FRAMEWORK_OBJECTCLASS, "org.apache.celix.NoId");
+		appendProperty(data, &length, OSGI_RSA_ENDPOINT_FRAMEWORK_UUID, "2983D849-93B1-4C2C-AC6D-5BCDA93ACB96");
+		appendLength(data, &length, 2);
+		appendProperty(data, &length, OSGI_RSA_ENDPOINT_ID, "44444444-4444-4444-4444-444444444444");
+		appendProperty(data, &length, OSGI_RSA_ENDPOINT_FRAMEWORK_UUID, "2983D849-93B1-4C2C-AC6D-5BCDA93ACB96");
+		memcpy(data + length, document + ends[0], ends[1] - ends[0]);
+		length += ends[1] - ends[0];
+
+		CHECK_EQUAL(CELIX_SUCCESS, endpointDescriptorReader_feed(reader, data, length, decoded));
+		CHECK_EQUAL(CELIX_SUCCESS, endpointDescriptorReader_finish(reader));
+		checkDecoded(1);
+		clearDecoded();
+
+		// counts and lengths beyond the received data never complete an endpoint
+		memcpy(data, document, ends[0]);
+		length = ends[0];
+		appendLength(data, &length, 0xffffffff);
+		appendProperty(data, &length, OSGI_RSA_ENDPOINT_ID, "55555555-5555-5555-5555-555555555555");
+		CHECK_EQUAL(CELIX_SUCCESS, endpointDescriptorReader_feed(reader, data, length, decoded));
+		CHECK_EQUAL(CELIX_BUNDLE_EXCEPTION, endpointDescriptorReader_finish(reader));
+		checkDecoded(0);
+
+		length = ends[0];
+		appendLength(data, &length, 1);
+		appendLength(data, &length, 0xfffffff0);
+		CHECK_EQUAL(CELIX_SUCCESS, endpointDescriptorReader_feed(reader, data, length, decoded));
+		CHECK_EQUAL(CELIX_BUNDLE_EXCEPTION, endpointDescriptorReader_finish(reader));
+		checkDecoded(0);
+
+		// the reader is usable again after a failed document
+		testRoundTrip();
+	}
+}
+
+TEST_GROUP(EndpointDescriptorTests) {
+	void setup() {
+		setupEndpoints();
+	}
+
+	void teardown() {
+		teardownEndpoints();
+	}
+};
+
+TEST(EndpointDescriptorTests, binaryRoundTrip) {
+	testRoundTrip();
+}
+
+TEST(EndpointDescriptorTests, binarySplitAtEveryByte) {
+	testSplitAtEveryByte();
+}
+
+TEST(EndpointDescriptorTests, binaryBytewiseFeed) {
+	testBytewiseFeed();
+}
+
+TEST(EndpointDescriptorTests, binaryEmptyList) {
+	testEmptyList();
+}
+
+TEST(EndpointDescriptorTests, binaryTruncated) {
+	testTruncated();
+}
+
+TEST(EndpointDescriptorTests, binaryMalformed) {
+	testMalformed();
+}
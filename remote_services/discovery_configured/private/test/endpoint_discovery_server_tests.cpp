@@ -0,0 +1,612 @@
+/**
+ *Licensed to the Apache Software Foundation (ASF) under one
+ *or more contributor license agreements.  See the NOTICE file
+ *distributed with this work for additional information
+ *regarding copyright ownership.  The ASF licenses this file
+ *to you under the Apache License, Version 2.0 (the
+ *"License"); you may not use this file except in compliance
+ *with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *Unless required by applicable law or agreed to in writing,
+ *software distributed under the License is distributed on an
+ *"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ *specific language governing permissions and limitations
+ *under the License.
+ */
+#include <CppUTest/TestHarness.h>
+#include "CppUTest/CommandLineTestRunner.h"
+
+extern "C" {
+
+	#include <stdio.h>
+	#include <stdlib.h>
+	#include <string.h>
+	#include <time.h>
+	#include <unistd.h>
+	#include <pthread.h>
+	#include <sys/socket.h>
+	#include <netinet/in.h>
+	#include <arpa/inet.h>
+
+	#include "celix_launcher.h"
+	#include "framework.h"
+	#include "bundle.h"
+	#include "constants.h"
+	#include "remote_constants.h"
+	#include "discovery.h"
+	#include "discovery_impl.h"
+	#include "endpoint_descriptor_reader.h"
+
+	#define SERVER_PATH "/org.apache.celix.discovery.configured"
+	// see endpoint_discovery_server.c
+	#define MAX_NUMBER_OF_CHANGES 256
+
+	#define MAX_RESPONSE_LENGTH 65536
+	#define MAX_HEADER_LENGTH 1024
+
+	struct response {
+		int code;
+		char etag[MAX_HEADER_LENGTH];
+		bool delta;
+		char removed[MAX_HEADER_LENGTH];
+		bool longPoll;
+		array_list_pt endpoints;
+	};
+
+	struct long_poll {
+		pthread_t thread;
+		char query[MAX_HEADER_LENGTH];
+		struct response response;
+		double duration; //seconds
+	};
+
+	static framework_pt framework = NULL;
+	static bundle_context_pt context = NULL;
+
+	static struct discovery discovery;
+	static struct endpoint_discovery_poller poller;
+	static endpoint_discovery_server_pt server = NULL;
+	static int port = 0;
+
+	static endpoint_description_pt endpointA = NULL;
+	static endpoint_description_pt endpointB = NULL;
+
+	static double now(void) {
+		struct timespec time;
+		clock_gettime(CLOCK_MONOTONIC, &time);
+		return time.tv_sec + time.tv_nsec / 1e9;
+	}
+
+	static endpoint_description_pt createEndpoint(const char *id, const char *serviceId) {
+		endpoint_description_pt endpoint = NULL;
+		properties_pt properties = properties_create();
+
+		properties_set(properties, OSGI_RSA_ENDPOINT_ID, id);
+		properties_set(properties, OSGI_RSA_ENDPOINT_SERVICE_ID, serviceId);
+		properties_set(properties, OSGI_RSA_ENDPOINT_FRAMEWORK_UUID, "2983D849-93B1-4C2C-AC6D-5BCDA93ACB96");
+		properties_set(properties, OSGI_FRAMEWORK_OBJECTCLASS, "org.apache.celix.calc.api.Calculator");
+
+		CHECK_EQUAL(CELIX_SUCCESS, endpointDescription_create(properties, &endpoint));
+
+		return endpoint;
+	}
+
+	static void setupServer(void) {
+		bundle_pt bundle = NULL;
+		char url[1024];
+
+		CHECK_EQUAL(CELIX_SUCCESS, celixLauncher_launch("server.properties", &framework));
+		CHECK_EQUAL(CELIX_SUCCESS, framework_getFrameworkBundle(framework, &bundle));
+		CHECK_EQUAL(CELIX_SUCCESS, bundle_getContext(bundle, &context));
+
+		memset(&discovery, 0, sizeof(discovery));
+		discovery.context = context;
+		CHECK_EQUAL(CELIX_SUCCESS, logHelper_create(context, &discovery.loghelper));
+
+		memset(&poller, 0, sizeof(poller));
+		poller.discovery = &discovery;
+		poller.loghelper = &discovery.loghelper;
+
+		CHECK_EQUAL(CELIX_SUCCESS, endpointDiscoveryServer_create(&discovery, context, &server));
+
+		// the server moves to the next port when the configured one is taken
+		CHECK_EQUAL(CELIX_SUCCESS, endpointDiscoveryServer_getUrl(server, url));
+		CHECK_EQUAL(1, sscanf(url, "http://127.0.0.1:%d", &port));
+
+		endpointA = createEndpoint("11111111-1111-1111-1111-111111111111", "5");
+		endpointB = createEndpoint("22222222-2222-2222-2222-222222222222", "6");
+	}
+
+	static void teardownServer(void) {
+		if (server != NULL) {
+			endpointDiscoveryServer_destroy(server);
+			server = NULL;
+		}
+
+		endpointDescription_destroy(endpointA);
+		endpointDescription_destroy(endpointB);
+
+		logHelper_destroy(&discovery.loghelper);
+
+		celixLauncher_stop(framework);
+		celixLauncher_waitForShutdown(framework);
+		celixLauncher_destroy(framework);
+		framework = NULL;
+		context = NULL;
+	}
+
+	// copies the value of the given response header, the headers start after the status line
+	static bool getHeader(const char *headers, const char *name, char *value) {
+		char key[MAX_HEADER_LENGTH];
+		snprintf(key, sizeof(key), "\r\n%s: ", name);
+
+		const char *start = strstr(headers, key);
+		if (start == NULL) {
+			return false;
+		}
+		start += strlen(key);
+
+		size_t length = strcspn(start, "\r\n");
+		CHECK(length < MAX_HEADER_LENGTH);
+		memcpy(value, start, length);
+		value[length] = '\0';
+
+		return true;
+	}
+
+	/*
+	 * Requests the endpoint list in the binary form. The query and If-None-Match ETag are optional, the endpoints
+	 * of the response are decoded into response->endpoints, which has to be released with releaseResponse.
+	 */
+	static void get(const char *query, const char *etag, struct response *response) {
+		char request[2048];
+		char *received = (char *) malloc(MAX_RESPONSE_LENGTH + 1);
+		size_t length = 0;
+		ssize_t rv;
+
+		memset(response, 0, sizeof(*response));
+		arrayList_create(&response->endpoints);
+
+		int length_written = snprintf(request, sizeof(request),
+				"GET %s%s%s HTTP/1.1\r\nHost: 127.0.0.1\r\nConnection: close\r\nAccept: %s\r\n",
+				SERVER_PATH, (query != NULL) ? "?" : "", (query != NULL) ? query : "", DISCOVERY_BINARY_CONTENT_TYPE);
+		if (etag != NULL) {
+			length_written += snprintf(request + length_written, sizeof(request) - length_written, "If-None-Match: \"%s\"\r\n", etag);
+		}
+		snprintf(request + length_written, sizeof(request) - length_written, "\r\n");
+
+		struct sockaddr_in address;
+		memset(&address, 0, sizeof(address));
+		address.sin_family = AF_INET;
+		address.sin_port = htons(port);
+		address.sin_addr.s_addr = inet_addr("127.0.0.1");
+
+		int fd = socket(AF_INET, SOCK_STREAM, 0);
+		CHECK(fd >= 0);
+		CHECK_EQUAL(0, connect(fd, (struct sockaddr *) &address, sizeof(address)));
+		CHECK_EQUAL((ssize_t) strlen(request), write(fd, request, strlen(request)));
+
+		// the server closes the connection after the response
+		while ((rv = read(fd, received + length, MAX_RESPONSE_LENGTH - length)) > 0) {
+			length += rv;
+		}
+		close(fd);
+		received[length] = '\0';
+
+		CHECK_EQUAL(1, sscanf(received, "HTTP/1.1 %d", &response->code));
+
+		char *body = strstr(received, "\r\n\r\n");
+		CHECK(body != NULL);
+		*body = '\0';
+		body += 4;
+
+		char value[MAX_HEADER_LENGTH];
+		if (getHeader(received, "ETag", value)) {
+			// strip the quotes
+			CHECK(strlen(value) >= 2);
+			strncpy(response->etag, value + 1, strlen(value) - 2);
+		}
+		response->delta = getHeader(received, DISCOVERY_DELTA_HEADER, value);
+		getHeader(received, DISCOVERY_REMOVED_HEADER, response->removed);
+		response->longPoll = getHeader(received, DISCOVERY_LONG_POLL_HEADER, value);
+
+		size_t bodyLength = length - (body - received);
+		if (response->code == 200) {
+			endpoint_descriptor_reader_pt reader = NULL;
+
+			CHECK_EQUAL(CELIX_SUCCESS, endpointDescriptorReader_create(&poller, &reader));
+			CHECK_EQUAL(CELIX_SUCCESS, endpointDescriptorReader_feed(reader, body, bodyLength, response->endpoints));
+			CHECK_EQUAL(CELIX_SUCCESS, endpointDescriptorReader_finish(reader));
+			endpointDescriptorReader_destroy(reader);
+		} else {
+			LONGS_EQUAL(0, bodyLength);
+		}
+
+		free(received);
+	}
+
+	static void releaseResponse(struct response *response) {
+		for (unsigned int i = 0; i < arrayList_size(response->endpoints); i++) {
+			endpointDescription_destroy((endpoint_description_pt) arrayList_get(response->endpoints, i));
+		}
+		arrayList_destroy(response->endpoints);
+		response->endpoints = NULL;
+	}
+
+	static bool containsEndpoint(struct response *response, endpoint_description_pt endpoint) {
+		for (unsigned int i = 0; i < arrayList_size(response->endpoints); i++) {
+			if (strcmp(((endpoint_description_pt) arrayList_get(response->endpoints, i))->id, endpoint->id) == 0) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	static void sinceQuery(const char *etag, char *query, size_t size) {
+		snprintf(query, size, "%s=%s", DISCOVERY_SINCE_PARAMETER, etag);
+	}
+
+	static void longPollQuery(const char *etag, int seconds, char *query, size_t size) {
+		snprintf(query, size, "%s=%s&%s=%d", DISCOVERY_SINCE_PARAMETER, etag, DISCOVERY_WAIT_PARAMETER, seconds);
+	}
+
+	static void *longPollThread(void *handle) {
+		struct long_poll *poll = (struct long_poll *) handle;
+		double start = now();
+
+		get(poll->query, NULL, &poll->response);
+		poll->duration = now() - start;
+
+		return NULL;
+	}
+
+	static void startLongPoll(struct long_poll *poll, const char *etag, int seconds) {
+		memset(poll, 0, sizeof(*poll));
+		longPollQuery(etag, seconds, poll->query, sizeof(poll->query));
+		CHECK_EQUAL(0, pthread_create(&poll->thread, NULL, longPollThread, poll));
+	}
+
+	static void testNotModified(void) {
+		struct response first;
+		struct response second;
+		struct response third;
+
+		get(NULL, NULL, &first);
+		LONGS_EQUAL(200, first.code);
+		CHECK(strlen(first.etag) > 0);
+		CHECK_FALSE(first.delta);
+		LONGS_EQUAL(0, arrayList_size(first.endpoints));
+
+		// nothing changed, the ETag is still current
+		get(NULL, first.etag, &second);
+		LONGS_EQUAL(304, second.code);
+		STRCMP_EQUAL(first.etag, second.etag);
+		releaseResponse(&second);
+
+		endpointDiscoveryServer_addEndpoint(server, endpointA);
+
+		get(NULL, first.etag, &second);
+		LONGS_EQUAL(200, second.code);
+		CHECK(strcmp(first.etag, second.etag) != 0);
+		LONGS_EQUAL(1, arrayList_size(second.endpoints));
+		CHECK(containsEndpoint(&second, endpointA));
+
+		// adding an exposed endpoint again is not a change
+		endpointDiscoveryServer_addEndpoint(server, endpointA);
+		get(NULL, second.etag, &third);
+		LONGS_EQUAL(304, third.code);
+
+		releaseResponse(&third);
+		releaseResponse(&second);
+		releaseResponse(&first);
+	}
+
+	static void testDelta(void) {
+		struct response initial;
+		struct response added;
+		struct response removed;
+		struct response unchanged;
+		char query[MAX_HEADER_LENGTH];
+
+		get(NULL, NULL, &initial);
+
+		endpointDiscoveryServer_addEndpoint(server, endpointA);
+		endpointDiscoveryServer_addEndpoint(server, endpointB);
+
+		sinceQuery(initial.etag, query, sizeof(query));
+		get(query, NULL, &added);
+		LONGS_EQUAL(200, added.code);
+		CHECK(added.delta);
+		STRCMP_EQUAL("", added.removed);
+		LONGS_EQUAL(2, arrayList_size(added.endpoints));
+		CHECK(containsEndpoint(&added, endpointA));
+		CHECK(containsEndpoint(&added, endpointB));
+
+		endpointDiscoveryServer_removeEndpoint(server, endpointA);
+
+		sinceQuery(added.etag, query, sizeof(query));
+		get(query, NULL, &removed);
+		LONGS_EQUAL(200, removed.code);
+		CHECK(removed.delta);
+		STRCMP_EQUAL(endpointA->id, removed.removed);
+		LONGS_EQUAL(0, arrayList_size(removed.endpoints));
+
+		// a delta since the current version is empty
+		sinceQuery(removed.etag, query, sizeof(query));
+		get(query, NULL, &unchanged);
+		LONGS_EQUAL(200, unchanged.code);
+		CHECK(unchanged.delta);
+		STRCMP_EQUAL("", unchanged.removed);
+		LONGS_EQUAL(0, arrayList_size(unchanged.endpoints));
+		STRCMP_EQUAL(removed.etag, unchanged.etag);
+
+		releaseResponse(&unchanged);
+		releaseResponse(&removed);
+		releaseResponse(&added);
+		releaseResponse(&initial);
+	}
+
+	static void testRemovedThenReAdded(void) {
+		struct response initial;
+		struct response readded;
+		struct response removed;
+		char query[MAX_HEADER_LENGTH];
+
+		endpointDiscoveryServer_addEndpoint(server, endpointA);
+		endpointDiscoveryServer_addEndpoint(server, endpointB);
+		get(NULL, NULL, &initial);
+		LONGS_EQUAL(2, arrayList_size(initial.endpoints));
+
+		// the poller applies the removals first, so the endpoint ends up being exposed again
+		endpointDiscoveryServer_removeEndpoint(server, endpointA);
+		endpointDiscoveryServer_addEndpoint(server, endpointA);
+
+		sinceQuery(initial.etag, query, sizeof(query));
+		get(query, NULL, &readded);
+		LONGS_EQUAL(200, readded.code);
+		CHECK(readded.delta);
+		STRCMP_EQUAL(endpointA->id, readded.removed);
+		LONGS_EQUAL(1, arrayList_size(readded.endpoints));
+		CHECK(containsEndpoint(&readded, endpointA));
+
+		// added and removed again is only a removal
+		endpointDiscoveryServer_removeEndpoint(server, endpointB);
+		endpointDiscoveryServer_addEndpoint(server, endpointB);
+		endpointDiscoveryServer_removeEndpoint(server, endpointB);
+
+		sinceQuery(readded.etag, query, sizeof(query));
+		get(query, NULL, &removed);
+		LONGS_EQUAL(200, removed.code);
+		CHECK(removed.delta);
+		STRCMP_EQUAL(endpointB->id, removed.removed);
+		LONGS_EQUAL(0, arrayList_size(removed.endpoints));
+
+		releaseResponse(&removed);
+		releaseResponse(&readded);
+		releaseResponse(&initial);
+	}
+
+	static void testTruncatedChanges(void) {
+		struct response initial;
+		struct response recent;
+		struct response full;
+		struct response delta;
+		char query[MAX_HEADER_LENGTH];
+		char etag[MAX_HEADER_LENGTH];
+
+		endpointDiscoveryServer_addEndpoint(server, endpointA);
+		get(NULL, NULL, &initial);
+
+		// one change more than remembered, the last one leaves endpointB exposed
+		for (int i = 0; i <= MAX_NUMBER_OF_CHANGES; i++) {
+			if (i % 2 == 0) {
+				endpointDiscoveryServer_addEndpoint(server, endpointB);
+			} else {
+				endpointDiscoveryServer_removeEndpoint(server, endpointB);
+			}
+			if (i == 1) {
+				get(NULL, NULL, &recent);
+			}
+		}
+
+		// the changes since the initial version are no longer known, so the full list is returned
+		sinceQuery(initial.etag, query, sizeof(query));
+		get(query, NULL, &full);
+		LONGS_EQUAL(200, full.code);
+		CHECK_FALSE(full.delta);
+		LONGS_EQUAL(2, arrayList_size(full.endpoints));
+		CHECK(containsEndpoint(&full, endpointA));
+		CHECK(containsEndpoint(&full, endpointB));
+
+		// the ones since a later version still are
+		sinceQuery(recent.etag, query, sizeof(query));
+		get(query, NULL, &delta);
+		LONGS_EQUAL(200, delta.code);
+		CHECK(delta.delta);
+		LONGS_EQUAL(1, arrayList_size(delta.endpoints));
+		CHECK(containsEndpoint(&delta, endpointB));
+		STRCMP_EQUAL(endpointB->id, delta.removed);
+		releaseResponse(&delta);
+
+		// ETags of another server instance or from the future get the full list as well
+		snprintf(etag, sizeof(etag), "0-1");
+		sinceQuery(etag, query, sizeof(query));
+		get(query, NULL, &delta);
+		CHECK_FALSE(delta.delta);
+		LONGS_EQUAL(2, arrayList_size(delta.endpoints));
+		releaseResponse(&delta);
+
+		snprintf(etag, sizeof(etag), "%s0", full.etag);
+		sinceQuery(etag, query, sizeof(query));
+		get(query, NULL, &delta);
+		CHECK_FALSE(delta.delta);
+		LONGS_EQUAL(2, arrayList_size(delta.endpoints));
+		releaseResponse(&delta);
+
+		releaseResponse(&full);
+		releaseResponse(&recent);
+		releaseResponse(&initial);
+	}
+
+	static void testLongPollWakeUp(void) {
+		struct response initial;
+		struct long_poll poll;
+
+		get(NULL, NULL, &initial);
+
+		startLongPoll(&poll, initial.etag, 30);
+		usleep(200000);
+		endpointDiscoveryServer_addEndpoint(server, endpointA);
+		pthread_join(poll.thread, NULL);
+
+		// answered right after the change instead of after the wait time
+		CHECK(poll.duration >= 0.15);
+		CHECK(poll.duration < 10);
+		LONGS_EQUAL(200, poll.response.code);
+		CHECK(poll.response.longPoll);
+		CHECK(poll.response.delta);
+		LONGS_EQUAL(1, arrayList_size(poll.response.endpoints));
+		CHECK(containsEndpoint(&poll.response, endpointA));
+		CHECK(strcmp(initial.etag, poll.response.etag) != 0);
+		releaseResponse(&poll.response);
+
+		// a poller which missed changes gets them without waiting
+		startLongPoll(&poll, initial.etag, 30);
+		pthread_join(poll.thread, NULL);
+		CHECK(poll.duration < 10);
+		LONGS_EQUAL(200, poll.response.code);
+		CHECK(poll.response.longPoll);
+		CHECK(containsEndpoint(&poll.response, endpointA));
+		releaseResponse(&poll.response);
+
+		releaseResponse(&initial);
+	}
+
+	static void testLongPollTimeout(void) {
+		struct response initial;
+		struct response timedOut;
+		char query[MAX_HEADER_LENGTH];
+		double start = now();
+
+		get(NULL, NULL, &initial);
+
+		// without changes the poll ends after the wait time, as not modified for a current ETag
+		longPollQuery(initial.etag, 1, query, sizeof(query));
+		get(query, initial.etag, &timedOut);
+		CHECK(now() - start >= 0.9);
+		LONGS_EQUAL(304, timedOut.code);
+		CHECK(timedOut.longPoll);
+		STRCMP_EQUAL(initial.etag, timedOut.etag);
+
+		releaseResponse(&timedOut);
+		releaseResponse(&initial);
+	}
+
+	static void testLongPollWaiterLimit(void) {
+		struct response initial;
+		struct response rejected;
+		struct long_poll polls[2];
+		char query[MAX_HEADER_LENGTH];
+
+		get(NULL, NULL, &initial);
+
+		// server.properties configures three server threads, so two requests can wait
+		startLongPoll(&polls[0], initial.etag, 30);
+		startLongPoll(&polls[1], initial.etag, 30);
+		usleep(500000);
+
+		// the next one is answered at once, so the server keeps a thread for other requests
+		double start = now();
+		longPollQuery(initial.etag, 30, query, sizeof(query));
+		get(query, NULL, &rejected);
+		CHECK(now() - start < 10);
+		LONGS_EQUAL(200, rejected.code);
+		CHECK_FALSE(rejected.longPoll);
+		CHECK(rejected.delta);
+		LONGS_EQUAL(0, arrayList_size(rejected.endpoints));
+		STRCMP_EQUAL(initial.etag, rejected.etag);
+
+		endpointDiscoveryServer_addEndpoint(server, endpointA);
+
+		for (int i = 0; i < 2; i++) {
+			pthread_join(polls[i].thread, NULL);
+			CHECK(polls[i].duration < 10);
+			LONGS_EQUAL(200, polls[i].response.code);
+			CHECK(polls[i].response.longPoll);
+			CHECK(containsEndpoint(&polls[i].response, endpointA));
+			releaseResponse(&polls[i].response);
+		}
+
+		releaseResponse(&rejected);
+		releaseResponse(&initial);
+	}
+
+	static void testLongPollStopsWithServer(void) {
+		struct response initial;
+		struct long_poll poll;
+
+		get(NULL, NULL, &initial);
+
+		startLongPoll(&poll, initial.etag, 30);
+		usleep(200000);
+
+		// stopping the server does not wait for the wait time of the poll
+		double start = now();
+		endpointDiscoveryServer_destroy(server);
+		server = NULL;
+		CHECK(now() - start < 10);
+
+		pthread_join(poll.thread, NULL);
+		CHECK(poll.duration < 10);
+		LONGS_EQUAL(200, poll.response.code);
+		LONGS_EQUAL(0, arrayList_size(poll.response.endpoints));
+
+		releaseResponse(&poll.response);
+		releaseResponse(&initial);
+	}
+}
+
+TEST_GROUP(EndpointDiscoveryServerTests) {
+	void setup() {
+		setupServer();
+	}
+
+	void teardown() {
+		teardownServer();
+	}
+};
+
+TEST(EndpointDiscoveryServerTests, notModified) {
+	testNotModified();
+}
+
+TEST(EndpointDiscoveryServerTests, delta) {
+	testDelta();
+}
+
+TEST(EndpointDiscoveryServerTests, removedThenReAdded) {
+	testRemovedThenReAdded();
+}
+
+TEST(EndpointDiscoveryServerTests, truncatedChanges) {
+	testTruncatedChanges();
+}
+
+TEST(EndpointDiscoveryServerTests, longPollWakeUp) {
+	testLongPollWakeUp();
+}
+
+TEST(EndpointDiscoveryServerTests, longPollTimeout) {
+	testLongPollTimeout();
+}
+
+TEST(EndpointDiscoveryServerTests, longPollWaiterLimit) {
+	testLongPollWaiterLimit();
+}
+
+TEST(EndpointDiscoveryServerTests, longPollStopsWithServer) {
+	testLongPollStopsWithServer();
+}
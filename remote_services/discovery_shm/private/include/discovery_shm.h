@@ -38,18 +38,30 @@
 // defines the time-to-live in seconds
 #define SHM_ENTRY_DEFAULT_TTL		60
 
-// we currently support 64 separate discovery instances
-#define SHM_DATA_MAX_ENTRIES		64
+// default number of separate discovery instances, can be set with DISCOVERY_SHM_CAPACITY
+#define SHM_DATA_DEFAULT_CAPACITY	256
+#define SHM_DATA_MAX_CAPACITY		65536
+#define DISCOVERY_SHM_CAPACITY		"DISCOVERY_SHM_CAPACITY"
 
 typedef struct shmData* shmData_pt;
 
-/* creates a new shared memory block */
-celix_status_t discoveryShm_create(shmData_pt* data);
+/* creates a new shared memory block for (at least) capacity entries, at most SHM_DATA_MAX_CAPACITY */
+celix_status_t discoveryShm_create(shmData_pt* data, unsigned int capacity);
+/* attaches to an existing block, fails if its layout does not match */
 celix_status_t discoveryShm_attach(shmData_pt* data);
+/* arrays passed to getKeys and getEntries need room for this number of entries */
+unsigned int discoveryShm_getCapacity(shmData_pt data);
 celix_status_t discoveryShm_set(shmData_pt data, char *key, char* value);
 celix_status_t discoveryShm_get(shmData_pt data, char* key, char* value);
 celix_status_t discoveryShm_getKeys(shmData_pt data, char** keys, int* size);
 celix_status_t discoveryShm_remove(shmData_pt data, char* key);
+
+/* lock free snapshot: copies the keys of all entries; values are only copied for entries changed after generation since (otherwise empty) */
+celix_status_t discoveryShm_getEntries(shmData_pt data, unsigned int since, char** keys, char** values, int* size, unsigned int* generation);
+/* blocks until the entries changed after generation seen, or timeout seconds passed, or discoveryShm_wakeUp is called */
+celix_status_t discoveryShm_waitForChange(shmData_pt data, unsigned int seen, unsigned int timeout);
+celix_status_t discoveryShm_wakeUp(shmData_pt data);
+
 celix_status_t discoveryShm_detach(shmData_pt data);
 celix_status_t discoveryShm_destroy(shmData_pt data);
 
@@ -26,75 +26,244 @@
  */
 
 
-
+#include <errno.h>
 #include <stdio.h>
 #include <pthread.h>
+#include <sched.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <unistd.h>
 
 #include <sys/types.h>
 #include <sys/sem.h>
 #include <sys/shm.h>
 
+#ifdef __linux__
+#include <limits.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+
 #include <celix_errno.h>
 #include <celix_threads.h>
 
+#include "utils.h"
 #include "discovery_shm.h"
 
-#define DISCOVERY_SHM_MEMSIZE 262144
 #define DISCOVERY_SHM_FILENAME "/dev/null"
 #define DISCOVERY_SHM_FTOK_ID 50
 #define DISCOVERY_SEM_FILENAME "/dev/null"
 #define DISCOVERY_SEM_FTOK_ID 54
 
+#define DISCOVERY_SHM_MAGIC 0x44534844
+#define DISCOVERY_SHM_VERSION 2
+
+// a seqlocked read is retried this often before the entry is reported as busy
+#define DISCOVERY_SHM_READ_RETRIES 1000
+// a segment created concurrently by another framework is waited for this often (10 ms apart) to be initialized
+#define DISCOVERY_SHM_ATTACH_RETRIES 100
+
+#define SHM_ENTRY_EMPTY 0
+#define SHM_ENTRY_USED 1
+#define SHM_ENTRY_DELETED 2
+
+/*
+ * The table is an open addressing hash table with linear probing. Writers serialize on the global
+ * lock, readers never take it: every entry is protected by a sequence lock (odd while the entry is
+ * written), so readers copy an entry and retry when the sequence changed in the meantime. Entries are
+ * never moved, removed entries become tombstones which are reused by later inserts.
+ */
 struct shmEntry {
+    unsigned int sequence;
+    unsigned int state;
+    unsigned int hash;
+    // generation in which the value was last changed
+    unsigned int revision;
+    time_t expires;
+
     char key[SHM_ENTRY_MAX_KEY_LENGTH];
     char value[SHM_ENTRY_MAX_VALUE_LENGTH];
-
-    time_t expires;
 };
 
 typedef struct shmEntry shmEntry;
 
 struct shmData {
-    shmEntry entries[SHM_DATA_MAX_ENTRIES];
+    unsigned int magic;
+    unsigned int version;
+    // number of entries, a power of two
+    unsigned int capacity;
     int numOfEntries;
     int shmId;
 
+    // incremented (and waiters woken up) on every change of the entries
+    unsigned int generation;
+    unsigned int waiters;
+
     celix_thread_mutex_t globalLock;
+
+    shmEntry entries[];
 };
 
-void* shmAdress;
+static void discoveryShm_notify(shmData_pt data) {
+#ifdef __linux__
+    if (__atomic_load_n(&data->waiters, __ATOMIC_SEQ_CST) > 0) {
+        syscall(SYS_futex, &data->generation, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+    }
+#endif
+}
+
+/* to be called with the global lock held, returns the new generation */
+static unsigned int discoveryShm_changed(shmData_pt data) {
+    unsigned int generation = __atomic_add_fetch(&data->generation, 1, __ATOMIC_SEQ_CST);
+
+    discoveryShm_notify(data);
+
+    return generation;
+}
+
+static inline void discoveryShm_beginWrite(shmEntry* entry) {
+    __atomic_store_n(&entry->sequence, entry->sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void discoveryShm_endWrite(shmEntry* entry) {
+    __atomic_store_n(&entry->sequence, entry->sequence + 1, __ATOMIC_RELEASE);
+}
+
+/* copies a consistent version of the entry, without blocking the writers */
+static celix_status_t discoveryShm_readEntry(shmEntry* entry, shmEntry* copy) {
+    int retries;
+
+    for (retries = 0; retries < DISCOVERY_SHM_READ_RETRIES; retries++) {
+        unsigned int sequence = __atomic_load_n(&entry->sequence, __ATOMIC_ACQUIRE);
+
+        if ((sequence & 1) == 0) {
+            memcpy(copy, entry, sizeof(*copy));
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+            if (__atomic_load_n(&entry->sequence, __ATOMIC_RELAXED) == sequence) {
+                copy->key[SHM_ENTRY_MAX_KEY_LENGTH - 1] = '\0';
+                copy->value[SHM_ENTRY_MAX_VALUE_LENGTH - 1] = '\0';
+                return CELIX_SUCCESS;
+            }
+        }
+        sched_yield();
+    }
+
+    return CELIX_ILLEGAL_STATE;
+}
+
+/*
+ * Locks the table for writing. When a framework died while holding the (robust) lock, the entry it was
+ * writing is dropped and the lock is made consistent again, otherwise the lock could never be taken again.
+ */
+static celix_status_t discoveryShm_lock(shmData_pt data) {
+    celix_status_t status = celixThreadMutex_lock(&data->globalLock);
+
+#ifdef __linux__
+    if (status == EOWNERDEAD) {
+        unsigned int i;
+        int numOfEntries = 0;
+
+        for (i = 0; i < data->capacity; i++) {
+            shmEntry* entry = &data->entries[i];
 
-static celix_status_t discoveryShm_removeWithIndex(shmData_pt data, int index);
+            if ((entry->sequence & 1) != 0) {
+                entry->state = SHM_ENTRY_DELETED;
+                discoveryShm_endWrite(entry);
+            }
+            if (entry->state == SHM_ENTRY_USED) {
+                numOfEntries++;
+            }
+        }
+        data->numOfEntries = numOfEntries;
+        discoveryShm_changed(data);
+
+        status = pthread_mutex_consistent(&data->globalLock);
+    }
+#endif
+
+    return status;
+}
+
+static size_t discoveryShm_size(unsigned int capacity) {
+    return sizeof(struct shmData) + (size_t) capacity * sizeof(shmEntry);
+}
 
 /* returns the ftok key to identify shared memory*/
 static key_t discoveryShm_getKey() {
     return ftok(DISCOVERY_SHM_FILENAME, DISCOVERY_SHM_FTOK_ID);
 }
 
-/* creates a new shared memory block */
-celix_status_t discoveryShm_create(shmData_pt* data) {
-    celix_status_t status;
-
-    shmData_pt shmData = calloc(1, sizeof(*shmData));
+/*
+ * Creates the segment exclusively. When it already exists, another framework created it concurrently and
+ * attaching is retried until that framework published the magic. A segment which never becomes valid
+ * (its creator died, or it has the layout of another version) is removed and created again.
+ * Returns the id of the created segment, or -1 when attached to the segment of another framework (*data is set) or failed.
+ */
+static int discoveryShm_createSegment(shmData_pt* data, size_t size) {
     key_t shmKey = discoveryShm_getKey();
+    int retries = 0;
+    int shmId;
 
-    if (!shmData) {
-        status = CELIX_ENOMEM;
-    } else if ((shmData->shmId = shmget(shmKey, DISCOVERY_SHM_MEMSIZE, IPC_CREAT | 0666)) < 0) {
-        status = CELIX_BUNDLE_EXCEPTION;
-    } else if ((shmAdress = shmat(shmData->shmId, 0, 0)) == (char*) -1) {
+    while ((shmId = shmget(shmKey, size, IPC_CREAT | IPC_EXCL | 0666)) < 0 && errno == EEXIST
+            && retries < 2 * DISCOVERY_SHM_ATTACH_RETRIES) {
+        if (discoveryShm_attach(data) == CELIX_SUCCESS) {
+            break;
+        }
+
+        if (++retries == DISCOVERY_SHM_ATTACH_RETRIES) {
+            int staleId = shmget(shmKey, 0, 0666);
+
+            if (staleId >= 0) {
+                shmctl(staleId, IPC_RMID, 0);
+            }
+        } else {
+            usleep(10000);
+        }
+    }
+
+    return shmId;
+}
+
+/* creates a new shared memory block, or attaches to the one created concurrently by another framework */
+celix_status_t discoveryShm_create(shmData_pt* data, unsigned int capacity) {
+    celix_status_t status = CELIX_SUCCESS;
+    shmData_pt shmData = NULL;
+    unsigned int slots = 1;
+    int shmId = -1;
+
+    if (capacity == 0 || capacity > SHM_DATA_MAX_CAPACITY) {
+        return CELIX_ILLEGAL_ARGUMENT;
+    }
+
+    while (slots < capacity) {
+        slots *= 2;
+    }
+
+    *data = NULL;
+    if ((shmId = discoveryShm_createSegment(data, discoveryShm_size(slots))) < 0) {
+        status = (*data != NULL) ? CELIX_SUCCESS : CELIX_BUNDLE_EXCEPTION;
+    } else if ((shmData = shmat(shmId, 0, 0)) == (void*) -1) {
         status = CELIX_BUNDLE_EXCEPTION;
     } else {
         celix_thread_mutexattr_t threadAttr;
 
+        memset(shmData, 0, discoveryShm_size(slots));
+        shmData->version = DISCOVERY_SHM_VERSION;
+        shmData->capacity = slots;
         shmData->numOfEntries = 0;
+        shmData->shmId = shmId;
 
         status = celixThreadMutexAttr_create(&threadAttr);
 
-#ifdef LINUX
+        if (status == CELIX_SUCCESS) {
+            // the lock is shared by all attached frameworks
+            status = pthread_mutexattr_setpshared(&threadAttr, PTHREAD_PROCESS_SHARED);
+        }
+
+#ifdef __linux__
         if (status == CELIX_SUCCESS) {
             // This is Linux specific
             status = pthread_mutexattr_setrobust(&threadAttr, PTHREAD_MUTEX_ROBUST);
@@ -106,122 +275,209 @@ celix_status_t discoveryShm_create(shmData_pt* data) {
         }
 
         if (status == CELIX_SUCCESS) {
-            memcpy(shmAdress, shmData, sizeof(struct shmData));
-            (*data) = shmAdress;
+            __atomic_store_n(&shmData->magic, DISCOVERY_SHM_MAGIC, __ATOMIC_RELEASE);
+            (*data) = shmData;
+        } else {
+            shmdt(shmData);
         }
     }
 
-    free(shmData);
-
     return status;
 }
 
 celix_status_t discoveryShm_attach(shmData_pt* data) {
     celix_status_t status = CELIX_SUCCESS;
-    key_t shmKey = ftok(DISCOVERY_SHM_FILENAME, DISCOVERY_SHM_FTOK_ID);
+    key_t shmKey = discoveryShm_getKey();
+    struct shmid_ds shmInfo;
     int shmId = -1;
 
-    if ((shmId = shmget(shmKey, DISCOVERY_SHM_MEMSIZE, 0666)) < 0) {
+    if ((shmId = shmget(shmKey, 0, 0666)) < 0 || shmctl(shmId, IPC_STAT, &shmInfo) != 0 || shmInfo.shm_segsz < sizeof(struct shmData)) {
         status = CELIX_BUNDLE_EXCEPTION;
-    }
-
-    /* shmat has a curious return value of (void*)-1 in case of error */
-    void *mem=shmat(shmId, 0, 0);
-    if(mem==((void*)-1)){
-	status = CELIX_BUNDLE_EXCEPTION;
-    }
-    else{
-	(*data)=mem;
+    } else {
+        /* shmat has a curious return value of (void*)-1 in case of error */
+        shmData_pt mem = shmat(shmId, 0, 0);
+
+        if (mem == ((void*) -1)) {
+            status = CELIX_BUNDLE_EXCEPTION;
+        } else if (__atomic_load_n(&mem->magic, __ATOMIC_ACQUIRE) != DISCOVERY_SHM_MAGIC || mem->version != DISCOVERY_SHM_VERSION
+                || discoveryShm_size(mem->capacity) > shmInfo.shm_segsz) {
+            // a segment of another layout, e.g. left by an older version
+            shmdt(mem);
+            status = CELIX_ILLEGAL_STATE;
+        } else {
+            (*data) = mem;
+        }
     }
 
     return status;
 }
 
-static celix_status_t discoveryShm_getwithIndex(shmData_pt data, char* key, char* value, int* index) {
-    celix_status_t status = CELIX_BUNDLE_EXCEPTION;
-    time_t currentTime = time(NULL);
+unsigned int discoveryShm_getCapacity(shmData_pt data) {
+    return data->capacity;
+}
+
+/* lock free lookup, returns the index of the entry or -1 */
+static int discoveryShm_find(shmData_pt data, char* key, shmEntry* copy) {
+    unsigned int hash = utils_stringHash(key);
+    unsigned int mask = data->capacity - 1;
     unsigned int i;
 
-    for (i = 0; i < data->numOfEntries && status != CELIX_SUCCESS; i++) {
-        shmEntry entry = data->entries[i];
-        // check if entry is still valid
-        if (data->entries[i].expires < currentTime) {
-            discoveryShm_removeWithIndex(data, i);
-        } else if (strcmp(entry.key, key) == 0) {
-            if (value) {
-                strcpy(value, entry.value);
-            }
-            if (index) {
-                (*index) = i;
-            }
-            status = CELIX_SUCCESS;
+    for (i = 0; i < data->capacity; i++) {
+        unsigned int index = (hash + i) & mask;
+
+        if (discoveryShm_readEntry(&data->entries[index], copy) != CELIX_SUCCESS || copy->state == SHM_ENTRY_EMPTY) {
+            break;
+        } else if (copy->state == SHM_ENTRY_USED && copy->hash == hash && strcmp(copy->key, key) == 0) {
+            return (int) index;
         }
     }
 
-    return status;
+    return -1;
 }
 
-celix_status_t discoveryShm_getKeys(shmData_pt data, char** keys, int* size) {
-    celix_status_t status;
+/* to be called with the global lock held */
+static void discoveryShm_removeWithIndex(shmData_pt data, unsigned int index) {
+    unsigned int mask = data->capacity - 1;
+    shmEntry* entry = &data->entries[index];
 
-    status = celixThreadMutex_lock(&data->globalLock);
+    discoveryShm_beginWrite(entry);
+    entry->state = SHM_ENTRY_DELETED;
+    discoveryShm_endWrite(entry);
+    data->numOfEntries--;
 
-    if (status == CELIX_SUCCESS) {
-    	unsigned int i = 0;
-        for (i = 0; i < data->numOfEntries; i++) {
-            shmEntry entry = data->entries[i];
+    // a tombstone in front of an empty entry ends every probe sequence anyway
+    while (entry->state == SHM_ENTRY_DELETED && data->entries[(index + 1) & mask].state == SHM_ENTRY_EMPTY) {
+        discoveryShm_beginWrite(entry);
+        entry->state = SHM_ENTRY_EMPTY;
+        discoveryShm_endWrite(entry);
 
-            if (strlen(entry.key)>0) {
-                snprintf(keys[i], SHM_ENTRY_MAX_KEY_LENGTH, "%s", entry.key);
-            }
+        index = (index - 1) & mask;
+        entry = &data->entries[index];
+    }
+
+    discoveryShm_changed(data);
+}
+
+/* to be called with the global lock held */
+static void discoveryShm_removeExpired(shmData_pt data) {
+    time_t currentTime = time(NULL);
+    unsigned int i;
+
+    for (i = 0; i < data->capacity; i++) {
+        if (data->entries[i].state == SHM_ENTRY_USED && data->entries[i].expires < currentTime) {
+            discoveryShm_removeWithIndex(data, i);
         }
+    }
+}
 
-        (*size) = i;
+celix_status_t discoveryShm_getKeys(shmData_pt data, char** keys, int* size) {
+    celix_status_t status = CELIX_SUCCESS;
+    time_t currentTime = time(NULL);
+    shmEntry entry;
+    unsigned int i;
+    int found = 0;
 
-        celixThreadMutex_unlock(&data->globalLock);
+    for (i = 0; i < data->capacity; i++) {
+        if (discoveryShm_readEntry(&data->entries[i], &entry) == CELIX_SUCCESS && entry.state == SHM_ENTRY_USED && entry.expires >= currentTime) {
+            snprintf(keys[found++], SHM_ENTRY_MAX_KEY_LENGTH, "%s", entry.key);
+        }
     }
 
+    (*size) = found;
+
     return status;
 }
 
 celix_status_t discoveryShm_set(shmData_pt data, char *key, char* value) {
     celix_status_t status;
-    int index = -1;
 
-    if (data->numOfEntries >= SHM_DATA_MAX_ENTRIES) {
-        status = CELIX_ILLEGAL_STATE;
-    } else {
-        status = celixThreadMutex_lock(&data->globalLock);
+    status = discoveryShm_lock(data);
 
-        if (status == CELIX_SUCCESS) {
-            // check if key already there
-            status = discoveryShm_getwithIndex(data, key, NULL, &index);
-            if (status != CELIX_SUCCESS) {
-                index = data->numOfEntries;
+    if (status == CELIX_SUCCESS) {
+        shmEntry copy;
+        int index;
 
-                snprintf(data->entries[index].key, SHM_ENTRY_MAX_KEY_LENGTH, "%s", key);
-                data->numOfEntries++;
+        discoveryShm_removeExpired(data);
 
-                 status = CELIX_SUCCESS;
+        if ((index = discoveryShm_find(data, key, &copy)) < 0) {
+            // insert at the first free entry of the probe sequence, the key is known to be absent
+            unsigned int hash = utils_stringHash(key);
+            unsigned int mask = data->capacity - 1;
+            unsigned int i;
+
+            for (i = 0; i < data->capacity && index < 0; i++) {
+                if (data->entries[(hash + i) & mask].state != SHM_ENTRY_USED) {
+                    index = (int) ((hash + i) & mask);
+                }
             }
 
-            snprintf(data->entries[index].value, SHM_ENTRY_MAX_VALUE_LENGTH, "%s", value);
-            data->entries[index].expires = (time(NULL) + SHM_ENTRY_DEFAULT_TTL);
+            if (index < 0) {
+                status = CELIX_ILLEGAL_STATE;
+            } else {
+                shmEntry* entry = &data->entries[index];
+
+                discoveryShm_beginWrite(entry);
+                entry->state = SHM_ENTRY_USED;
+                entry->hash = hash;
+                entry->expires = time(NULL) + SHM_ENTRY_DEFAULT_TTL;
+                entry->revision = __atomic_load_n(&data->generation, __ATOMIC_RELAXED) + 1;
+                snprintf(entry->key, SHM_ENTRY_MAX_KEY_LENGTH, "%s", key);
+                snprintf(entry->value, SHM_ENTRY_MAX_VALUE_LENGTH, "%s", value);
+                discoveryShm_endWrite(entry);
 
-            celixThreadMutex_unlock(&data->globalLock);
+                data->numOfEntries++;
+                discoveryShm_changed(data);
+            }
+        } else {
+            shmEntry* entry = &data->entries[index];
+
+            discoveryShm_beginWrite(entry);
+            entry->expires = time(NULL) + SHM_ENTRY_DEFAULT_TTL;
+            // refreshing an entry only extends its ttl, watchers are not woken up for that
+            if (strncmp(entry->value, value, SHM_ENTRY_MAX_VALUE_LENGTH - 1) != 0) {
+                snprintf(entry->value, SHM_ENTRY_MAX_VALUE_LENGTH, "%s", value);
+                entry->revision = __atomic_load_n(&data->generation, __ATOMIC_RELAXED) + 1;
+                discoveryShm_endWrite(entry);
+                discoveryShm_changed(data);
+            } else {
+                discoveryShm_endWrite(entry);
+            }
         }
+
+        celixThreadMutex_unlock(&data->globalLock);
     }
 
     return status;
 }
 
 celix_status_t discoveryShm_get(shmData_pt data, char* key, char* value) {
+    celix_status_t status = CELIX_BUNDLE_EXCEPTION;
+    shmEntry entry;
+
+    if (discoveryShm_find(data, key, &entry) >= 0 && entry.expires >= time(NULL)) {
+        if (value) {
+            strcpy(value, entry.value);
+        }
+        status = CELIX_SUCCESS;
+    }
+
+    return status;
+}
+
+celix_status_t discoveryShm_remove(shmData_pt data, char* key) {
     celix_status_t status;
 
-    status = celixThreadMutex_lock(&data->globalLock);
+    status = discoveryShm_lock(data);
 
     if (status == CELIX_SUCCESS) {
-        status = discoveryShm_getwithIndex(data, key, value, NULL);
+        shmEntry entry;
+        int index = discoveryShm_find(data, key, &entry);
+
+        if (index >= 0) {
+            discoveryShm_removeWithIndex(data, (unsigned int) index);
+        } else {
+            status = CELIX_BUNDLE_EXCEPTION;
+        }
 
         celixThreadMutex_unlock(&data->globalLock);
     }
@@ -229,43 +485,69 @@ celix_status_t discoveryShm_get(shmData_pt data, char* key, char* value) {
     return status;
 }
 
-static celix_status_t discoveryShm_removeWithIndex(shmData_pt data, int index) {
+celix_status_t discoveryShm_getEntries(shmData_pt data, unsigned int since, char** keys, char** values, int* size, unsigned int* generation) {
     celix_status_t status = CELIX_SUCCESS;
-
-    data->numOfEntries--;
-    if (index < data->numOfEntries) {
-        memcpy((void*) &data->entries[index], (void*) &data->entries[index + 1], ((data->numOfEntries - index) * sizeof(struct shmEntry)));
+    time_t currentTime = time(NULL);
+    shmEntry entry;
+    unsigned int i;
+    int found = 0;
+
+    // read before the entries, a change during the snapshot is picked up by the next one
+    (*generation) = __atomic_load_n(&data->generation, __ATOMIC_SEQ_CST);
+
+    for (i = 0; i < data->capacity; i++) {
+        if (discoveryShm_readEntry(&data->entries[i], &entry) == CELIX_SUCCESS && entry.state == SHM_ENTRY_USED && entry.expires >= currentTime) {
+            snprintf(keys[found], SHM_ENTRY_MAX_KEY_LENGTH, "%s", entry.key);
+            if (entry.revision > since) {
+                snprintf(values[found], SHM_ENTRY_MAX_VALUE_LENGTH, "%s", entry.value);
+            } else {
+                values[found][0] = '\0';
+            }
+            found++;
+        }
     }
 
+    (*size) = found;
+
     return status;
 }
 
-celix_status_t discoveryShm_remove(shmData_pt data, char* key) {
-    celix_status_t status;
-    int index = -1;
+celix_status_t discoveryShm_waitForChange(shmData_pt data, unsigned int seen, unsigned int timeout) {
+    celix_status_t status = CELIX_SUCCESS;
 
-    status = celixThreadMutex_lock(&data->globalLock);
+#ifdef __linux__
+    if (__atomic_load_n(&data->generation, __ATOMIC_SEQ_CST) == seen) {
+        struct timespec waitTime = { timeout, 0 };
 
-    if (status == CELIX_SUCCESS) {
-        status = discoveryShm_getwithIndex(data, key, NULL, &index);
-
-        if (status == CELIX_SUCCESS) {
-            status = discoveryShm_removeWithIndex(data, index);
-        }
+        __atomic_add_fetch(&data->waiters, 1, __ATOMIC_SEQ_CST);
+        syscall(SYS_futex, &data->generation, FUTEX_WAIT, seen, &waitTime, NULL, 0);
+        __atomic_sub_fetch(&data->waiters, 1, __ATOMIC_SEQ_CST);
+    }
+#else
+    // no cross-process wait available, poll the generation instead
+    time_t until = time(NULL) + timeout;
 
-        celixThreadMutex_unlock(&data->globalLock);
+    while (__atomic_load_n(&data->generation, __ATOMIC_SEQ_CST) == seen && time(NULL) < until) {
+        sleep(1);
     }
+#endif
 
     return status;
 }
 
+celix_status_t discoveryShm_wakeUp(shmData_pt data) {
+    discoveryShm_notify(data);
+
+    return CELIX_SUCCESS;
+}
+
 celix_status_t discoveryShm_detach(shmData_pt data) {
     celix_status_t status = CELIX_BUNDLE_EXCEPTION;
 
     if (data->numOfEntries == 0) {
         status = discoveryShm_destroy(data);
     }
-    else if (shmdt(shmAdress) == 0) {
+    else if (shmdt(data) == 0) {
         status = CELIX_SUCCESS;
     }
 
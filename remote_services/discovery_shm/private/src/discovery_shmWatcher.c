@@ -24,15 +24,19 @@
  * \copyright  Apache License, Version 2.0
  */
 
+#include <errno.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
 #include <stdio.h>
+#include <time.h>
 
 
 #include "celix_log.h"
 #include "constants.h"
+#include "hash_map.h"
+#include "utils.h"
 #include "discovery_impl.h"
 
 #include "discovery_shm.h"
@@ -40,11 +44,18 @@
 
 #include "endpoint_discovery_poller.h"
 
+// the local registration is refreshed well within its time-to-live
+#define DISCOVERY_SHM_REFRESH_INTERVAL (SHM_ENTRY_DEFAULT_TTL / 3)
+
 struct shm_watcher {
     shmData_pt shmData;
     celix_thread_t watcherThread;
     celix_thread_mutex_t watcherLock;
 
+    // discovery endpoints added to the poller by this watcher, shm key -> url
+    hash_map_pt endpoints;
+    unsigned int generation;
+
     volatile bool running;
 };
 
@@ -79,68 +90,78 @@ static celix_status_t discoveryShmWatcher_getLocalNodePath(bundle_context_pt con
     return status;
 }
 
-/* retrieves all endpoints from shm and syncs them with the ones already available */
+/* retrieves the endpoints changed in shm since the last sync and applies them to the poller */
 static celix_status_t discoveryShmWatcher_syncEndpoints(discovery_pt discovery) {
     celix_status_t status = CELIX_SUCCESS;
     shm_watcher_pt watcher = discovery->watcher;
-    char** shmKeyArr = calloc(SHM_DATA_MAX_ENTRIES, sizeof(*shmKeyArr));
-    array_list_pt registeredKeyArr = NULL;
+    unsigned int capacity = discoveryShm_getCapacity(watcher->shmData);
+    char** shmKeyArr = calloc(capacity, sizeof(*shmKeyArr));
+    char** shmValueArr = calloc(capacity, sizeof(*shmValueArr));
+    unsigned int generation = 0;
 
-    int i, j, shmSize;
+    int i, shmSize = 0;
 
-    for (i = 0; i < SHM_DATA_MAX_ENTRIES; i++) {
+    for (i = 0; i < capacity; i++) {
         shmKeyArr[i] = calloc(SHM_ENTRY_MAX_KEY_LENGTH, sizeof(*shmKeyArr[i]));
+        shmValueArr[i] = calloc(SHM_ENTRY_MAX_VALUE_LENGTH, sizeof(*shmValueArr[i]));
     }
 
-    arrayList_create(&registeredKeyArr);
+    status = discoveryShm_getEntries(watcher->shmData, watcher->generation, shmKeyArr, shmValueArr, &shmSize, &generation);
 
-    // get all urls available in shm
-    discoveryShm_getKeys(watcher->shmData, shmKeyArr, &shmSize);
+    if (status == CELIX_SUCCESS) {
+        hash_map_pt present = hashMap_create(utils_stringHash, NULL, utils_stringEquals, NULL);
 
-    // get all locally registered endpoints
-    endpointDiscoveryPoller_getDiscoveryEndpoints(discovery->poller, registeredKeyArr);
+        // add or update the discovery points changed since the last sync
+        for (i = 0; i < shmSize; i++) {
+            char* url = shmValueArr[i];
 
-    // add discovery points which are in shm, but not local yet
-    for (i = 0; i < shmSize; i++) {
-        char url[SHM_ENTRY_MAX_VALUE_LENGTH];
+            hashMap_put(present, shmKeyArr[i], shmKeyArr[i]);
 
-        if (discoveryShm_get(watcher->shmData, shmKeyArr[i], &url[0]) == CELIX_SUCCESS) {
-            bool elementFound = false;
+            if (strlen(url) > 0) {
+                hash_map_entry_pt entry = hashMap_getEntry(watcher->endpoints, shmKeyArr[i]);
 
-            for (j = 0; j < arrayList_size(registeredKeyArr) && elementFound == false; j++) {
+                if (entry == NULL) {
+                    hashMap_put(watcher->endpoints, strdup(shmKeyArr[i]), strdup(url));
+                    endpointDiscoveryPoller_addDiscoveryEndpoint(discovery->poller, url);
+                } else if (strcmp(hashMapEntry_getValue(entry), url) != 0) {
+                    char* key = hashMapEntry_getKey(entry);
+                    char* oldUrl = hashMap_put(watcher->endpoints, key, strdup(url));
 
-                if (strcmp(url, (char*) arrayList_get(registeredKeyArr, j)) == 0) {
-                    free(arrayList_remove(registeredKeyArr, j));
-                    elementFound = true;
+                    endpointDiscoveryPoller_removeDiscoveryEndpoint(discovery->poller, oldUrl);
+                    endpointDiscoveryPoller_addDiscoveryEndpoint(discovery->poller, url);
+                    free(oldUrl);
                 }
             }
-
-            if (elementFound == false) {
-                endpointDiscoveryPoller_addDiscoveryEndpoint(discovery->poller, url);
-            }
         }
-    }
 
-    // remove those which are not in shm
-    for (i = 0; i < arrayList_size(registeredKeyArr); i++) {
-        char* regUrl = arrayList_get(registeredKeyArr, i);
+        // remove those which are no longer in shm
+        hash_map_iterator_pt iter = hashMapIterator_create(watcher->endpoints);
+        while (hashMapIterator_hasNext(iter)) {
+            hash_map_entry_pt entry = hashMapIterator_nextEntry(iter);
+            char* key = hashMapEntry_getKey(entry);
 
-        if (regUrl != NULL) {
-            endpointDiscoveryPoller_removeDiscoveryEndpoint(discovery->poller, regUrl);
+            if (!hashMap_containsKey(present, key)) {
+                char* url = hashMapEntry_getValue(entry);
+
+                endpointDiscoveryPoller_removeDiscoveryEndpoint(discovery->poller, url);
+                hashMapIterator_remove(iter);
+                free(key);
+                free(url);
+            }
         }
+        hashMapIterator_destroy(iter);
+        hashMap_destroy(present, false, false);
+
+        watcher->generation = generation;
     }
 
-    for (i = 0; i < SHM_DATA_MAX_ENTRIES; i++) {
+    for (i = 0; i < capacity; i++) {
         free(shmKeyArr[i]);
+        free(shmValueArr[i]);
     }
 
     free(shmKeyArr);
-
-    for (j = 0; j < arrayList_size(registeredKeyArr); j++) {
-        free(arrayList_get(registeredKeyArr, j));
-    }
-
-    arrayList_destroy(registeredKeyArr);
+    free(shmValueArr);
 
     return status;
 }
@@ -150,6 +171,7 @@ static void* discoveryShmWatcher_run(void* data) {
     shm_watcher_pt watcher = discovery->watcher;
     char localNodePath[MAX_LOCALNODE_LENGTH];
     char url[MAX_LOCALNODE_LENGTH];
+    time_t nextRefresh = 0;
 
     if (discoveryShmWatcher_getLocalNodePath(discovery->context, &localNodePath[0]) != CELIX_SUCCESS) {
         logHelper_log(discovery->loghelper, OSGI_LOGSERVICE_WARNING, "Cannot retrieve local discovery path.");
@@ -160,13 +182,22 @@ static void* discoveryShmWatcher_run(void* data) {
     }
 
     while (watcher->running) {
-        // register own framework
-        if (discoveryShm_set(watcher->shmData, localNodePath, url) != CELIX_SUCCESS) {
-            logHelper_log(discovery->loghelper, OSGI_LOGSERVICE_WARNING, "Cannot set local discovery registration.");
+        time_t now = time(NULL);
+
+        // register own framework, refreshing it does not wake up the other watchers
+        if (now >= nextRefresh) {
+            if (discoveryShm_set(watcher->shmData, localNodePath, url) != CELIX_SUCCESS) {
+                logHelper_log(discovery->loghelper, OSGI_LOGSERVICE_WARNING, "Cannot set local discovery registration.");
+            }
+            nextRefresh = now + DISCOVERY_SHM_REFRESH_INTERVAL;
         }
 
         discoveryShmWatcher_syncEndpoints(discovery);
-        sleep(5);
+
+        // sleep until another node changes the table or the registration needs a refresh
+        if (watcher->running) {
+            discoveryShm_waitForChange(watcher->shmData, watcher->generation, (unsigned int) (nextRefresh > now ? nextRefresh - now : 1));
+        }
     }
 
     return NULL;
@@ -186,7 +217,24 @@ celix_status_t discoveryShmWatcher_create(discovery_pt discovery) {
         if (status != CELIX_SUCCESS) {
             logHelper_log(discovery->loghelper, OSGI_LOGSERVICE_DEBUG, "Attaching to Shared Memory Failed. Trying to create.");
 
-            status = discoveryShm_create(&(watcher->shmData));
+            const char* capacityProp = NULL;
+            unsigned long capacity = SHM_DATA_DEFAULT_CAPACITY;
+
+            bundleContext_getProperty(discovery->context, DISCOVERY_SHM_CAPACITY, &capacityProp);
+            if (capacityProp != NULL) {
+                char* end = NULL;
+
+                errno = 0;
+                capacity = strtoul(capacityProp, &end, 10);
+                if (errno != 0 || end == capacityProp || *end != '\0' || strchr(capacityProp, '-') != NULL
+                        || capacity == 0 || capacity > SHM_DATA_MAX_CAPACITY) {
+                    logHelper_log(discovery->loghelper, OSGI_LOGSERVICE_WARNING, "Invalid %s '%s', expected 1..%d. Using %d.",
+                            DISCOVERY_SHM_CAPACITY, capacityProp, SHM_DATA_MAX_CAPACITY, SHM_DATA_DEFAULT_CAPACITY);
+                    capacity = SHM_DATA_DEFAULT_CAPACITY;
+                }
+            }
+
+            status = discoveryShm_create(&(watcher->shmData), (unsigned int) capacity);
 
             if (status != CELIX_SUCCESS) {
                 logHelper_log(discovery->loghelper, OSGI_LOGSERVICE_ERROR, "Failed to create Shared Memory Segment.");
@@ -204,6 +252,9 @@ celix_status_t discoveryShmWatcher_create(discovery_pt discovery) {
     }
 
     if (status == CELIX_SUCCESS) {
+        watcher->endpoints = hashMap_create(utils_stringHash, NULL, utils_stringEquals, NULL);
+        watcher->generation = 0;
+
         status += celixThreadMutex_create(&watcher->watcherLock, NULL);
         status += celixThreadMutex_lock(&watcher->watcherLock);
         watcher->running = true;
@@ -223,6 +274,7 @@ celix_status_t discoveryShmWatcher_destroy(discovery_pt discovery) {
     watcher->running = false;
     celixThreadMutex_unlock(&watcher->watcherLock);
 
+    discoveryShm_wakeUp(watcher->shmData);
     celixThread_join(watcher->watcherThread, NULL);
 
     // remove own framework
@@ -234,6 +286,7 @@ celix_status_t discoveryShmWatcher_destroy(discovery_pt discovery) {
 
     if (status == CELIX_SUCCESS) {
         discoveryShm_detach(watcher->shmData);
+        hashMap_destroy(watcher->endpoints, true, true);
         free(watcher);
     }
     else {
@@ -49,7 +49,8 @@ celix_status_t endpointDescription_create(properties_pt properties, endpoint_des
     ep->properties = properties;
     ep->frameworkUUID = (char*)properties_get(properties, OSGI_RSA_ENDPOINT_FRAMEWORK_UUID);
     ep->id = (char*)properties_get(properties, OSGI_RSA_ENDPOINT_ID);
-    ep->service = strndup(properties_get(properties, OSGI_FRAMEWORK_OBJECTCLASS), 1024*10);
+    const char *service = properties_get(properties, OSGI_FRAMEWORK_OBJECTCLASS);
+    ep->service = (service != NULL) ? strndup(service, 1024*10) : NULL;
     ep->serviceId = serviceId;
 
     if (!(ep->frameworkUUID) || !(ep->id) || !(ep->service) ) {
@@ -62,6 +63,7 @@ celix_status_t endpointDescription_create(properties_pt properties, endpoint_des
     }
     else{
 	*endpointDescription = NULL;
+	free(ep->service);
 	free(ep);
     }
 
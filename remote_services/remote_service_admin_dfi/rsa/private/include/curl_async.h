@@ -0,0 +1,42 @@
+/**
+ *Licensed to the Apache Software Foundation (ASF) under one
+ *or more contributor license agreements.  See the NOTICE file
+ *distributed with this work for additional information
+ *regarding copyright ownership.  The ASF licenses this file
+ *to you under the Apache License, Version 2.0 (the
+ *"License"); you may not use this file except in compliance
+ *with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *Unless required by applicable law or agreed to in writing,
+ *software distributed under the License is distributed on an
+ *"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ *specific language governing permissions and limitations
+ *under the License.
+ */
+#ifndef CURL_ASYNC_H_
+#define CURL_ASYNC_H_
+
+#include <curl/curl.h>
+#include "celix_errno.h"
+
+/*
+ * Runs curl easy handles concurrently on a single I/O thread using a curl multi handle.
+ * The done callback is called on that I/O thread, so it should not block.
+ */
+typedef struct curl_async *curl_async_pt;
+
+typedef void (*curl_async_done_fn)(void *data, CURL *handle, CURLcode result);
+
+celix_status_t curlAsync_create(curl_async_pt *out);
+//stops the I/O thread, transfers still running are aborted and their done callback is called with CURLE_ABORTED_BY_CALLBACK
+void curlAsync_stop(curl_async_pt async);
+//stops (if needed) and frees
+void curlAsync_destroy(curl_async_pt async);
+
+//the handle must be fully configured; it is owned by the caller again when done is called
+celix_status_t curlAsync_add(curl_async_pt async, CURL *handle, curl_async_done_fn done, void *data);
+
+#endif /* CURL_ASYNC_H_ */
@@ -0,0 +1,41 @@
+/**
+ *Licensed to the Apache Software Foundation (ASF) under one
+ *or more contributor license agreements.  See the NOTICE file
+ *distributed with this work for additional information
+ *regarding copyright ownership.  The ASF licenses this file
+ *to you under the Apache License, Version 2.0 (the
+ *"License"); you may not use this file except in compliance
+ *with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *Unless required by applicable law or agreed to in writing,
+ *software distributed under the License is distributed on an
+ *"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ *specific language governing permissions and limitations
+ *under the License.
+ */
+#ifndef CURL_POOL_H_
+#define CURL_POOL_H_
+
+#include <stdbool.h>
+#include <curl/curl.h>
+#include "celix_errno.h"
+
+/*
+ * Keeps idle curl easy handles per endpoint url, so the connection (and keep-alive)
+ * of a handle is reused by the next call to the same endpoint.
+ */
+typedef struct curl_pool *curl_pool_pt;
+
+celix_status_t curlPool_create(unsigned int maxIdlePerEndpoint, unsigned int idleTimeoutInSeconds, curl_pool_pt *out);
+void curlPool_destroy(curl_pool_pt pool);
+
+//returns a pooled handle (reset to default options) or a new one
+celix_status_t curlPool_acquire(curl_pool_pt pool, const char *url, CURL **handle);
+//reusable should be false when the handle's connection is in an unknown state (e.g. after a failed transfer)
+void curlPool_release(curl_pool_pt pool, const char *url, CURL *handle, bool reusable);
+void curlPool_removeEndpoint(curl_pool_pt pool, const char *url);
+
+#endif /* CURL_POOL_H_ */
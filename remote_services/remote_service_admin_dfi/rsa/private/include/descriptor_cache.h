@@ -0,0 +1,41 @@
+/**
+ *Licensed to the Apache Software Foundation (ASF) under one
+ *or more contributor license agreements.  See the NOTICE file
+ *distributed with this work for additional information
+ *regarding copyright ownership.  The ASF licenses this file
+ *to you under the Apache License, Version 2.0 (the
+ *"License"); you may not use this file except in compliance
+ *with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *Unless required by applicable law or agreed to in writing,
+ *software distributed under the License is distributed on an
+ *"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ *specific language governing permissions and limitations
+ *under the License.
+ */
+#ifndef DESCRIPTOR_CACHE_H_
+#define DESCRIPTOR_CACHE_H_
+
+#include "bundle.h"
+#include "bundle_context.h"
+#include "celix_errno.h"
+#include "dyn_interface.h"
+
+/*
+ * Parsed interface descriptors shared between the import and export registrations.
+ * Descriptors are keyed on the descriptor file (which is specific for a bundle revision) and
+ * reparsed when the file changed. Unused descriptors are kept until the cache is destroyed.
+ */
+typedef struct descriptor_cache *descriptor_cache_pt;
+
+celix_status_t descriptorCache_create(descriptor_cache_pt *out);
+void descriptorCache_destroy(descriptor_cache_pt cache);
+
+//the returned interface must not be changed and is released with descriptorCache_release instead of dynInterface_destroy
+celix_status_t descriptorCache_acquire(descriptor_cache_pt cache, bundle_context_pt context, bundle_pt bundle, const char *name, dyn_interface_type **intf);
+void descriptorCache_release(descriptor_cache_pt cache, dyn_interface_type *intf);
+
+#endif /* DESCRIPTOR_CACHE_H_ */
@@ -26,5 +26,7 @@
 
 
 celix_status_t dfi_findDescriptor(bundle_context_pt context, bundle_pt bundle, const char *name, FILE **out);
+//the path of the descriptor file for name, to be freed by the caller
+celix_status_t dfi_findDescriptorPath(bundle_context_pt context, bundle_pt bundle, const char *name, char **out);
 
 #endif
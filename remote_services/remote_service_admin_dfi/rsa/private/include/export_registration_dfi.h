@@ -24,15 +24,21 @@
 #include "export_registration.h"
 #include "log_helper.h"
 #include "endpoint_description.h"
+#include "remote_service_admin_dfi_constants.h"
+#include "descriptor_cache.h"
 
-celix_status_t exportRegistration_create(log_helper_pt helper, service_reference_pt reference, endpoint_description_pt endpoint, bundle_context_pt context, export_registration_pt *registration);
+celix_status_t exportRegistration_create(log_helper_pt helper, service_reference_pt reference, endpoint_description_pt endpoint, bundle_context_pt context, descriptor_cache_pt descriptors, export_registration_pt *registration);
 celix_status_t exportRegistration_close(export_registration_pt registration);
 void exportRegistration_destroy(export_registration_pt registration);
 
 celix_status_t exportRegistration_start(export_registration_pt registration);
 celix_status_t exportRegistration_stop(export_registration_pt registration);
 
-celix_status_t exportRegistration_call(export_registration_pt export, char *data, int datalength, char **response, int *responseLength);
+//keeps the registration from being destroyed while a request is handled outside the admin lock
+void exportRegistration_retain(export_registration_pt registration);
+void exportRegistration_release(export_registration_pt registration);
+
+celix_status_t exportRegistration_call(export_registration_pt export, rsa_dfi_serialization_type serialization, char *data, int datalength, char **response, int *responseLength);
 
 
 #endif //CELIX_EXPORT_REGISTRATION_DFI_H
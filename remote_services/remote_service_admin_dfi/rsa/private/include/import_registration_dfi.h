@@ -22,12 +22,18 @@
 
 #include "import_registration.h"
 #include "dfi_utils.h"
+#include "remote_service_admin_dfi_constants.h"
+#include "descriptor_cache.h"
 
 #include <celix_errno.h>
 
-typedef void (*send_func_type)(void *handle, endpoint_description_pt endpointDescription, char *request, char **reply, int* replyStatus);
+typedef void (*send_func_type)(void *handle, endpoint_description_pt endpointDescription, rsa_dfi_serialization_type serialization, char *request, size_t requestLength, char **reply, size_t *replyLength, int* replyStatus);
+//called from the send thread, the reply is owned by the callee
+typedef void (*send_done_func_type)(void *data, char *reply, size_t replyLength, int replyStatus);
+//on success the request is owned by the async send and done is called exactly once
+typedef celix_status_t (*send_async_func_type)(void *handle, endpoint_description_pt endpointDescription, rsa_dfi_serialization_type serialization, char *request, size_t requestLength, send_done_func_type done, void *data);
 
-celix_status_t importRegistration_create(bundle_context_pt context, endpoint_description_pt description, const char *classObject, const char* serviceVersion,
+celix_status_t importRegistration_create(bundle_context_pt context, endpoint_description_pt description, const char *classObject, const char* serviceVersion, descriptor_cache_pt descriptors,
                                          import_registration_pt *import);
 celix_status_t importRegistration_close(import_registration_pt import);
 void importRegistration_destroy(import_registration_pt import);
@@ -35,6 +41,13 @@ void importRegistration_destroy(import_registration_pt import);
 celix_status_t importRegistration_setSendFn(import_registration_pt reg,
                                             send_func_type,
                                             void *handle);
+celix_status_t importRegistration_setSendAsyncFn(import_registration_pt reg,
+                                                 send_async_func_type,
+                                                 void *handle);
+celix_status_t importRegistration_setSerialization(import_registration_pt reg, rsa_dfi_serialization_type serialization);
+//calls issued within the window (in microseconds) are sent as one json batch, 0 disables batching
+celix_status_t importRegistration_setBatchWindow(import_registration_pt reg, unsigned int batchWindow);
+celix_status_t importRegistration_getEndpoint(import_registration_pt reg, endpoint_description_pt *endpoint);
 celix_status_t importRegistration_start(import_registration_pt import);
 celix_status_t importRegistration_stop(import_registration_pt import);
 
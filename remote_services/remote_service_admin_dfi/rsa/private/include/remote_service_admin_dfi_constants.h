@@ -0,0 +1,78 @@
+/**
+ *Licensed to the Apache Software Foundation (ASF) under one
+ *or more contributor license agreements.  See the NOTICE file
+ *distributed with this work for additional information
+ *regarding copyright ownership.  The ASF licenses this file
+ *to you under the Apache License, Version 2.0 (the
+ *"License"); you may not use this file except in compliance
+ *with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *Unless required by applicable law or agreed to in writing,
+ *software distributed under the License is distributed on an
+ *"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ *specific language governing permissions and limitations
+ *under the License.
+ */
+#ifndef REMOTE_SERVICE_ADMIN_DFI_CONSTANTS_H_
+#define REMOTE_SERVICE_ADMIN_DFI_CONSTANTS_H_
+
+/*
+ * Endpoint property listing the serializations (comma separated) an exported endpoint accepts.
+ * Endpoints without it only accept json. Also read as framework property on both sides to
+ * restrict what is offered/used, e.g. RSA_DFI_SERIALIZATION=json disables the binary format.
+ */
+#define RSA_DFI_ENDPOINT_SERIALIZATION      "org.apache.celix.rsa.dfi.serialization"
+#define RSA_DFI_SERIALIZATION               "RSA_DFI_SERIALIZATION"
+
+#define RSA_DFI_SERIALIZATION_JSON          "json"
+#define RSA_DFI_SERIALIZATION_BINARY        "binary"
+#define RSA_DFI_SERIALIZATION_DEFAULT       "binary,json"
+
+#define RSA_DFI_JSON_CONTENT_TYPE           "application/json"
+#define RSA_DFI_BINARY_CONTENT_TYPE         "application/octet-stream"
+
+/*
+ * Idle curl handles (and so their keep-alive connection) kept per imported endpoint and
+ * the nr of seconds an idle handle is kept. A pool size of 0 disables connection reuse.
+ */
+#define RSA_DFI_CONNECTION_POOL_SIZE            "RSA_DFI_CONNECTION_POOL_SIZE"
+#define RSA_DFI_CONNECTION_POOL_SIZE_DEFAULT    4
+#define RSA_DFI_CONNECTION_IDLE_TIMEOUT         "RSA_DFI_CONNECTION_IDLE_TIMEOUT"
+#define RSA_DFI_CONNECTION_IDLE_TIMEOUT_DEFAULT 10
+
+//nr of webserver threads, a kept-alive connection occupies a thread while it is open
+#define RSA_DFI_NUM_THREADS                     "RSA_DFI_NUM_THREADS"
+#define RSA_DFI_NUM_THREADS_DEFAULT             "50"
+
+/*
+ * Service property declaring how many remote calls an exported service can handle concurrently:
+ * a positive number or "unbounded". Without it calls are handled one at a time.
+ */
+#define RSA_DFI_REMOTE_CONCURRENCY              "remote.concurrency"
+#define RSA_DFI_REMOTE_CONCURRENCY_UNBOUNDED    "unbounded"
+
+/*
+ * Endpoint property set (to "true") by exporters that handle batches of json invocations.
+ * With RSA_DFI_BATCH_WINDOW (in microseconds, default 0 = disabled) set, an importer collects the calls
+ * issued within that window on an import that supports it and sends them as one batch request.
+ * Batched imports always use json.
+ */
+#define RSA_DFI_ENDPOINT_BATCH                  "org.apache.celix.rsa.dfi.batch"
+#define RSA_DFI_BATCH_WINDOW                    "RSA_DFI_BATCH_WINDOW"
+#define RSA_DFI_BATCH_WINDOW_DEFAULT            0
+
+/*
+ * Endpoint property with the method ids (comma separated) of an exported interface, in descriptor order.
+ * Importers use it to call methods by their (compact) index instead of their id.
+ */
+#define RSA_DFI_ENDPOINT_METHODS                "org.apache.celix.rsa.dfi.methods"
+
+typedef enum rsa_dfi_serialization {
+    RSA_DFI_SERIALIZATION_TYPE_JSON,
+    RSA_DFI_SERIALIZATION_TYPE_BINARY
+} rsa_dfi_serialization_type;
+
+#endif /* REMOTE_SERVICE_ADMIN_DFI_CONSTANTS_H_ */
@@ -0,0 +1,233 @@
+/**
+ *Licensed to the Apache Software Foundation (ASF) under one
+ *or more contributor license agreements.  See the NOTICE file
+ *distributed with this work for additional information
+ *regarding copyright ownership.  The ASF licenses this file
+ *to you under the Apache License, Version 2.0 (the
+ *"License"); you may not use this file except in compliance
+ *with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *Unless required by applicable law or agreed to in writing,
+ *software distributed under the License is distributed on an
+ *"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ *specific language governing permissions and limitations
+ *under the License.
+ */
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "curl_async.h"
+#include "celix_threads.h"
+#include "array_list.h"
+
+//max time (ms) the I/O thread waits for socket activity before checking curl timeouts
+#define CURL_ASYNC_WAIT_TIMEOUT 1000
+
+struct curl_async {
+    CURLM *multi; //only used on the I/O thread
+    celix_thread_t thread;
+    int wakeupPipe[2]; //written to wake up the I/O thread
+
+    celix_thread_mutex_t mutex; //protects running, stopped & pending
+    bool running;
+    bool stopped; //thread joined
+    array_list_pt pending; //transfers added, but not yet handed to the multi handle
+    array_list_pt active; //transfers in the multi handle, only used on the I/O thread
+};
+
+struct curl_async_transfer {
+    CURL *handle;
+    curl_async_done_fn done;
+    void *data;
+};
+
+static void *curlAsync_run(void *data);
+static void curlAsync_wakeup(curl_async_pt async);
+static void curlAsync_complete(curl_async_pt async, struct curl_async_transfer *transfer, CURLcode result);
+
+celix_status_t curlAsync_create(curl_async_pt *out) {
+    celix_status_t status = CELIX_SUCCESS;
+    curl_async_pt async = calloc(1, sizeof(*async));
+
+    if (async == NULL) {
+        status = CELIX_ENOMEM;
+    } else {
+        async->wakeupPipe[0] = -1;
+        async->wakeupPipe[1] = -1;
+        async->multi = curl_multi_init();
+        if (async->multi == NULL || pipe(async->wakeupPipe) != 0) {
+            status = CELIX_BUNDLE_EXCEPTION;
+        }
+    }
+
+    if (status == CELIX_SUCCESS) {
+        fcntl(async->wakeupPipe[0], F_SETFL, O_NONBLOCK);
+        fcntl(async->wakeupPipe[1], F_SETFL, O_NONBLOCK);
+        arrayList_create(&async->pending);
+        arrayList_create(&async->active);
+        celixThreadMutex_create(&async->mutex, NULL);
+        async->running = true;
+        status = celixThread_create(&async->thread, NULL, curlAsync_run, async);
+        if (status != CELIX_SUCCESS) {
+            arrayList_destroy(async->pending);
+            arrayList_destroy(async->active);
+            celixThreadMutex_destroy(&async->mutex);
+        }
+    }
+
+    if (status == CELIX_SUCCESS) {
+        *out = async;
+    } else if (async != NULL) {
+        if (async->multi != NULL) {
+            curl_multi_cleanup(async->multi);
+        }
+        if (async->wakeupPipe[0] >= 0) {
+            close(async->wakeupPipe[0]);
+            close(async->wakeupPipe[1]);
+        }
+        free(async);
+    }
+
+    return status;
+}
+
+void curlAsync_stop(curl_async_pt async) {
+    celixThreadMutex_lock(&async->mutex);
+    bool join = !async->stopped;
+    async->running = false;
+    async->stopped = true;
+    celixThreadMutex_unlock(&async->mutex);
+
+    if (join) {
+        curlAsync_wakeup(async);
+        celixThread_join(async->thread, NULL);
+
+        //thread is stopped and no transfers can be added anymore, abort what is left
+        int i;
+        for (i = 0; i < arrayList_size(async->active); i += 1) {
+            struct curl_async_transfer *transfer = arrayList_get(async->active, i);
+            curl_multi_remove_handle(async->multi, transfer->handle);
+            curlAsync_complete(async, transfer, CURLE_ABORTED_BY_CALLBACK);
+        }
+        arrayList_clear(async->active);
+        for (i = 0; i < arrayList_size(async->pending); i += 1) {
+            curlAsync_complete(async, arrayList_get(async->pending, i), CURLE_ABORTED_BY_CALLBACK);
+        }
+        arrayList_clear(async->pending);
+    }
+}
+
+void curlAsync_destroy(curl_async_pt async) {
+    if (async != NULL) {
+        curlAsync_stop(async);
+
+        arrayList_destroy(async->active);
+        arrayList_destroy(async->pending);
+
+        curl_multi_cleanup(async->multi);
+        close(async->wakeupPipe[0]);
+        close(async->wakeupPipe[1]);
+        celixThreadMutex_destroy(&async->mutex);
+        free(async);
+    }
+}
+
+celix_status_t curlAsync_add(curl_async_pt async, CURL *handle, curl_async_done_fn done, void *data) {
+    celix_status_t status = CELIX_SUCCESS;
+    struct curl_async_transfer *transfer = calloc(1, sizeof(*transfer));
+
+    if (transfer == NULL) {
+        status = CELIX_ENOMEM;
+    } else {
+        transfer->handle = handle;
+        transfer->done = done;
+        transfer->data = data;
+        curl_easy_setopt(handle, CURLOPT_PRIVATE, transfer);
+
+        celixThreadMutex_lock(&async->mutex);
+        if (async->running) {
+            arrayList_add(async->pending, transfer);
+        } else {
+            status = CELIX_ILLEGAL_STATE;
+        }
+        celixThreadMutex_unlock(&async->mutex);
+
+        if (status == CELIX_SUCCESS) {
+            curlAsync_wakeup(async);
+        } else {
+            free(transfer);
+        }
+    }
+
+    return status;
+}
+
+static void curlAsync_wakeup(curl_async_pt async) {
+    char c = 0;
+    if (write(async->wakeupPipe[1], &c, 1) < 0) {
+        //pipe full, the I/O thread is already woken up
+    }
+}
+
+static void curlAsync_complete(curl_async_pt async, struct curl_async_transfer *transfer, CURLcode result) {
+    transfer->done(transfer->data, transfer->handle, result);
+    free(transfer);
+}
+
+static void *curlAsync_run(void *data) {
+    curl_async_pt async = data;
+    bool running = true;
+
+    while (running) {
+        char buf[64];
+        while (read(async->wakeupPipe[0], buf, sizeof(buf)) > 0) {
+            //drain wake ups
+        }
+
+        celixThreadMutex_lock(&async->mutex);
+        running = async->running;
+        int i;
+        for (i = 0; running && i < arrayList_size(async->pending); i += 1) {
+            struct curl_async_transfer *transfer = arrayList_get(async->pending, i);
+            arrayList_add(async->active, transfer);
+            curl_multi_add_handle(async->multi, transfer->handle);
+        }
+        if (running) {
+            arrayList_clear(async->pending);
+        }
+        celixThreadMutex_unlock(&async->mutex);
+
+        if (running) {
+            int stillRunning = 0;
+            curl_multi_perform(async->multi, &stillRunning);
+
+            CURLMsg *msg = NULL;
+            int msgsLeft = 0;
+            while ((msg = curl_multi_info_read(async->multi, &msgsLeft)) != NULL) {
+                if (msg->msg == CURLMSG_DONE) {
+                    CURL *handle = msg->easy_handle;
+                    CURLcode result = msg->data.result;
+                    struct curl_async_transfer *transfer = NULL;
+                    curl_easy_getinfo(handle, CURLINFO_PRIVATE, (char **) &transfer);
+                    curl_multi_remove_handle(async->multi, handle);
+                    arrayList_removeElement(async->active, transfer);
+                    curlAsync_complete(async, transfer, result);
+                }
+            }
+
+            struct curl_waitfd wakeup;
+            wakeup.fd = async->wakeupPipe[0];
+            wakeup.events = CURL_WAIT_POLLIN;
+            wakeup.revents = 0;
+            curl_multi_wait(async->multi, &wakeup, 1, CURL_ASYNC_WAIT_TIMEOUT, NULL);
+        }
+    }
+
+    return NULL;
+}
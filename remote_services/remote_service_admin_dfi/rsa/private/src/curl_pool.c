@@ -0,0 +1,190 @@
+/**
+ *Licensed to the Apache Software Foundation (ASF) under one
+ *or more contributor license agreements.  See the NOTICE file
+ *distributed with this work for additional information
+ *regarding copyright ownership.  The ASF licenses this file
+ *to you under the Apache License, Version 2.0 (the
+ *"License"); you may not use this file except in compliance
+ *with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *Unless required by applicable law or agreed to in writing,
+ *software distributed under the License is distributed on an
+ *"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ *specific language governing permissions and limitations
+ *under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "curl_pool.h"
+#include "celix_threads.h"
+#include "hash_map.h"
+#include "array_list.h"
+#include "utils.h"
+
+struct curl_pool {
+    unsigned int maxIdlePerEndpoint;
+    unsigned int idleTimeoutInSeconds;
+
+    celix_thread_mutex_t mutex; //protects endpoints
+    hash_map_pt endpoints; //key -> url (owned), value -> array_list of pooled handles, most recently used last
+};
+
+struct pooled_handle {
+    CURL *handle;
+    time_t lastUsed;
+};
+
+static time_t curlPool_now(void);
+static void curlPool_destroyHandles(array_list_pt handles);
+
+celix_status_t curlPool_create(unsigned int maxIdlePerEndpoint, unsigned int idleTimeoutInSeconds, curl_pool_pt *out) {
+    celix_status_t status = CELIX_SUCCESS;
+    curl_pool_pt pool = calloc(1, sizeof(*pool));
+
+    if (pool == NULL) {
+        status = CELIX_ENOMEM;
+    } else {
+        pool->maxIdlePerEndpoint = maxIdlePerEndpoint;
+        pool->idleTimeoutInSeconds = idleTimeoutInSeconds;
+        pool->endpoints = hashMap_create(utils_stringHash, NULL, utils_stringEquals, NULL);
+        celixThreadMutex_create(&pool->mutex, NULL);
+        *out = pool;
+    }
+
+    return status;
+}
+
+void curlPool_destroy(curl_pool_pt pool) {
+    if (pool != NULL) {
+        celixThreadMutex_lock(&pool->mutex);
+        hash_map_iterator_pt iter = hashMapIterator_create(pool->endpoints);
+        while (hashMapIterator_hasNext(iter)) {
+            hash_map_entry_pt entry = hashMapIterator_nextEntry(iter);
+            curlPool_destroyHandles(hashMapEntry_getValue(entry));
+            free(hashMapEntry_getKey(entry));
+        }
+        hashMapIterator_destroy(iter);
+        hashMap_destroy(pool->endpoints, false, false);
+        celixThreadMutex_unlock(&pool->mutex);
+
+        celixThreadMutex_destroy(&pool->mutex);
+        free(pool);
+    }
+}
+
+celix_status_t curlPool_acquire(curl_pool_pt pool, const char *url, CURL **out) {
+    celix_status_t status = CELIX_SUCCESS;
+    CURL *handle = NULL;
+    array_list_pt expired = NULL;
+
+    celixThreadMutex_lock(&pool->mutex);
+    array_list_pt handles = hashMap_get(pool->endpoints, url);
+    if (handles != NULL) {
+        time_t now = curlPool_now();
+        //oldest first, so expired handles are all at the front
+        while (arrayList_size(handles) > 0) {
+            struct pooled_handle *pooled = arrayList_get(handles, 0);
+            if (now - pooled->lastUsed < (time_t) pool->idleTimeoutInSeconds) {
+                break;
+            }
+            if (expired == NULL) {
+                arrayList_create(&expired);
+            }
+            arrayList_add(expired, arrayList_remove(handles, 0));
+        }
+
+        int size = arrayList_size(handles);
+        if (size > 0) {
+            struct pooled_handle *pooled = arrayList_remove(handles, size - 1);
+            handle = pooled->handle;
+            free(pooled);
+        }
+    }
+    celixThreadMutex_unlock(&pool->mutex);
+
+    //closing connections outside the lock
+    curlPool_destroyHandles(expired);
+
+    if (handle != NULL) {
+        curl_easy_reset(handle);
+    } else {
+        handle = curl_easy_init();
+    }
+
+    if (handle != NULL) {
+        *out = handle;
+    } else {
+        status = CELIX_ILLEGAL_STATE;
+    }
+
+    return status;
+}
+
+void curlPool_release(curl_pool_pt pool, const char *url, CURL *handle, bool reusable) {
+    struct pooled_handle *pooled = NULL;
+    if (reusable && pool->maxIdlePerEndpoint > 0) {
+        pooled = calloc(1, sizeof(*pooled));
+    }
+
+    if (pooled != NULL) {
+        pooled->handle = handle;
+        pooled->lastUsed = curlPool_now();
+
+        celixThreadMutex_lock(&pool->mutex);
+        array_list_pt handles = hashMap_get(pool->endpoints, url);
+        if (handles == NULL) {
+            arrayList_create(&handles);
+            hashMap_put(pool->endpoints, strdup(url), handles);
+        }
+        if (arrayList_size(handles) < pool->maxIdlePerEndpoint) {
+            arrayList_add(handles, pooled);
+            pooled = NULL;
+            handle = NULL;
+        }
+        celixThreadMutex_unlock(&pool->mutex);
+    }
+
+    free(pooled);
+    if (handle != NULL) {
+        curl_easy_cleanup(handle);
+    }
+}
+
+void curlPool_removeEndpoint(curl_pool_pt pool, const char *url) {
+    celixThreadMutex_lock(&pool->mutex);
+    hash_map_entry_pt entry = hashMap_getEntry(pool->endpoints, url);
+    char *key = NULL;
+    array_list_pt handles = NULL;
+    if (entry != NULL) {
+        key = hashMapEntry_getKey(entry);
+        handles = hashMap_remove(pool->endpoints, url);
+    }
+    celixThreadMutex_unlock(&pool->mutex);
+
+    curlPool_destroyHandles(handles);
+    free(key);
+}
+
+static void curlPool_destroyHandles(array_list_pt handles) {
+    if (handles != NULL) {
+        int i;
+        for (i = 0; i < arrayList_size(handles); i += 1) {
+            struct pooled_handle *pooled = arrayList_get(handles, i);
+            curl_easy_cleanup(pooled->handle);
+            free(pooled);
+        }
+        arrayList_destroy(handles);
+    }
+}
+
+static time_t curlPool_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec;
+}
@@ -0,0 +1,191 @@
+/**
+ *Licensed to the Apache Software Foundation (ASF) under one
+ *or more contributor license agreements.  See the NOTICE file
+ *distributed with this work for additional information
+ *regarding copyright ownership.  The ASF licenses this file
+ *to you under the Apache License, Version 2.0 (the
+ *"License"); you may not use this file except in compliance
+ *with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *Unless required by applicable law or agreed to in writing,
+ *software distributed under the License is distributed on an
+ *"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ *specific language governing permissions and limitations
+ *under the License.
+ */
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "descriptor_cache.h"
+#include "dfi_utils.h"
+#include "celix_threads.h"
+#include "hash_map.h"
+#include "utils.h"
+
+struct descriptor_cache {
+    celix_thread_mutex_t mutex; //protects descriptors & interfaces
+    hash_map_pt descriptors; //key -> descriptor path (owned by the entry), value -> cached_descriptor
+    hash_map_pt interfaces; //key -> dyn_interface_type, value -> cached_descriptor. Also contains replaced descriptors still in use
+};
+
+struct cached_descriptor {
+    char *path;
+    time_t modified;
+    off_t size;
+    dyn_interface_type *intf;
+    unsigned int refCount;
+    bool replaced; //a newer version of the file is cached, destroy when no longer used
+};
+
+static void descriptorCache_destroyEntry(struct cached_descriptor *entry);
+
+celix_status_t descriptorCache_create(descriptor_cache_pt *out) {
+    celix_status_t status = CELIX_SUCCESS;
+    descriptor_cache_pt cache = calloc(1, sizeof(*cache));
+
+    if (cache == NULL) {
+        status = CELIX_ENOMEM;
+    } else {
+        cache->descriptors = hashMap_create(utils_stringHash, NULL, utils_stringEquals, NULL);
+        cache->interfaces = hashMap_create(NULL, NULL, NULL, NULL);
+        celixThreadMutex_create(&cache->mutex, NULL);
+        *out = cache;
+    }
+
+    return status;
+}
+
+void descriptorCache_destroy(descriptor_cache_pt cache) {
+    if (cache != NULL) {
+        celixThreadMutex_lock(&cache->mutex);
+        hash_map_iterator_pt iter = hashMapIterator_create(cache->interfaces);
+        while (hashMapIterator_hasNext(iter)) {
+            descriptorCache_destroyEntry(hashMapIterator_nextValue(iter));
+        }
+        hashMapIterator_destroy(iter);
+        hashMap_destroy(cache->interfaces, false, false);
+        hashMap_destroy(cache->descriptors, false, false);
+        celixThreadMutex_unlock(&cache->mutex);
+
+        celixThreadMutex_destroy(&cache->mutex);
+        free(cache);
+    }
+}
+
+celix_status_t descriptorCache_acquire(descriptor_cache_pt cache, bundle_context_pt context, bundle_pt bundle, const char *name, dyn_interface_type **out) {
+    char *path = NULL;
+    struct stat st;
+    celix_status_t status = dfi_findDescriptorPath(context, bundle, name, &path);
+
+    if (status == CELIX_SUCCESS && stat(path, &st) != 0) {
+        status = CELIX_FILE_IO_EXCEPTION;
+    }
+
+    dyn_interface_type *intf = NULL;
+    if (status == CELIX_SUCCESS) {
+        celixThreadMutex_lock(&cache->mutex);
+        struct cached_descriptor *entry = hashMap_get(cache->descriptors, path);
+        if (entry != NULL && entry->modified == st.st_mtime && entry->size == st.st_size) {
+            entry->refCount += 1;
+            intf = entry->intf;
+        }
+        celixThreadMutex_unlock(&cache->mutex);
+    }
+
+    struct cached_descriptor *parsed = NULL;
+    if (status == CELIX_SUCCESS && intf == NULL) {
+        //not cached (or changed), parse outside the lock
+        FILE *descriptor = fopen(path, "r");
+        if (descriptor == NULL) {
+            status = CELIX_FILE_IO_EXCEPTION;
+        }
+
+        if (status == CELIX_SUCCESS) {
+            parsed = calloc(1, sizeof(*parsed));
+            if (parsed == NULL) {
+                status = CELIX_ENOMEM;
+            } else if (dynInterface_parse(descriptor, &parsed->intf) != 0 || parsed->intf == NULL) {
+                status = CELIX_BUNDLE_EXCEPTION;
+            }
+            fclose(descriptor);
+        }
+
+        if (status == CELIX_SUCCESS) {
+            parsed->path = path;
+            path = NULL;
+            parsed->modified = st.st_mtime;
+            parsed->size = st.st_size;
+            parsed->refCount = 1;
+        } else {
+            descriptorCache_destroyEntry(parsed);
+            parsed = NULL;
+        }
+    }
+
+    struct cached_descriptor *unused = NULL;
+    if (status == CELIX_SUCCESS && intf == NULL) {
+        celixThreadMutex_lock(&cache->mutex);
+        struct cached_descriptor *entry = hashMap_get(cache->descriptors, parsed->path);
+        if (entry != NULL && entry->modified == parsed->modified && entry->size == parsed->size) {
+            //parsed concurrently by someone else, use that one
+            entry->refCount += 1;
+            intf = entry->intf;
+            unused = parsed;
+        } else {
+            if (entry != NULL) {
+                hashMap_remove(cache->descriptors, entry->path);
+                if (entry->refCount == 0) {
+                    hashMap_remove(cache->interfaces, entry->intf);
+                    unused = entry;
+                } else {
+                    entry->replaced = true;
+                }
+            }
+            hashMap_put(cache->descriptors, parsed->path, parsed);
+            hashMap_put(cache->interfaces, parsed->intf, parsed);
+            intf = parsed->intf;
+        }
+        celixThreadMutex_unlock(&cache->mutex);
+    }
+
+    descriptorCache_destroyEntry(unused);
+    free(path);
+
+    if (status == CELIX_SUCCESS) {
+        *out = intf;
+    }
+
+    return status;
+}
+
+void descriptorCache_release(descriptor_cache_pt cache, dyn_interface_type *intf) {
+    struct cached_descriptor *unused = NULL;
+
+    celixThreadMutex_lock(&cache->mutex);
+    struct cached_descriptor *entry = hashMap_get(cache->interfaces, intf);
+    if (entry != NULL && entry->refCount > 0) {
+        entry->refCount -= 1;
+        if (entry->refCount == 0 && entry->replaced) {
+            hashMap_remove(cache->interfaces, intf);
+            unused = entry;
+        }
+    }
+    celixThreadMutex_unlock(&cache->mutex);
+
+    descriptorCache_destroyEntry(unused);
+}
+
+static void descriptorCache_destroyEntry(struct cached_descriptor *entry) {
+    if (entry != NULL) {
+        if (entry->intf != NULL) {
+            dynInterface_destroy(entry->intf);
+        }
+        free(entry->path);
+        free(entry);
+    }
+}
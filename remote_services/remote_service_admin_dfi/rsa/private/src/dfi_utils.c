@@ -19,9 +19,10 @@
 
 #include "dfi_utils.h"
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
-static celix_status_t dfi_findFileForFramework(bundle_context_pt context, const char *fileName, FILE **out) {
+static celix_status_t dfi_findFileForFramework(bundle_context_pt context, const char *fileName, char **out) {
     celix_status_t  status;
 
     char pwd[1024];
@@ -37,18 +38,17 @@ static celix_status_t dfi_findFileForFramework(bundle_context_pt context, const
     snprintf(path, sizeof(path), "%s/%s", extPath, fileName);
 
     if (status == CELIX_SUCCESS) {
-        FILE *df = fopen(path, "r");
-        if (df == NULL) {
+        if (access(path, R_OK) != 0) {
             status = CELIX_FILE_IO_EXCEPTION;
         } else {
-            *out = df;
+            *out = strdup(path);
         }
     }
 
     return status;
 }
 
-static celix_status_t dfi_findFileForBundle(bundle_pt bundle, const char *fileName, FILE **out) {
+static celix_status_t dfi_findFileForBundle(bundle_pt bundle, const char *fileName, char **out) {
     celix_status_t  status;
 
     char *path = NULL;
@@ -62,11 +62,11 @@ static celix_status_t dfi_findFileForBundle(bundle_pt bundle, const char *fileNa
     }
 
     if (status == CELIX_SUCCESS && path != NULL) {
-        FILE *df = fopen(path, "r");
-        if (df == NULL) {
+        if (access(path, R_OK) != 0) {
             status = CELIX_FILE_IO_EXCEPTION;
         } else {
-            *out = df;
+            *out = path;
+            path = NULL;
         }
 
     }
@@ -75,7 +75,7 @@ static celix_status_t dfi_findFileForBundle(bundle_pt bundle, const char *fileNa
     return status;
 }
 
-celix_status_t dfi_findDescriptor(bundle_context_pt context, bundle_pt bundle, const char *name, FILE **out) {
+celix_status_t dfi_findDescriptorPath(bundle_context_pt context, bundle_pt bundle, const char *name, char **out) {
     celix_status_t  status;
     char fileName[128];
 
@@ -96,3 +96,20 @@ celix_status_t dfi_findDescriptor(bundle_context_pt context, bundle_pt bundle, c
 
     return status;
 }
+
+celix_status_t dfi_findDescriptor(bundle_context_pt context, bundle_pt bundle, const char *name, FILE **out) {
+    char *path = NULL;
+    celix_status_t status = dfi_findDescriptorPath(context, bundle, name, &path);
+
+    if (status == CELIX_SUCCESS && path != NULL) {
+        FILE *df = fopen(path, "r");
+        if (df == NULL) {
+            status = CELIX_FILE_IO_EXCEPTION;
+        } else {
+            *out = df;
+        }
+    }
+
+    free(path);
+    return status;
+}
@@ -25,7 +25,9 @@
 #include <service_tracker_customizer.h>
 #include <service_tracker.h>
 #include <json_rpc.h>
+#include <binary_rpc.h>
 #include "constants.h"
+#include "remote_service_admin_dfi_constants.h"
 #include "export_registration_dfi.h"
 #include "dfi_utils.h"
 
@@ -38,11 +40,16 @@ struct export_registration {
     bundle_context_pt  context;
     struct export_reference exportReference;
     char *servId;
-    dyn_interface_type *intf; //owner
+    descriptor_cache_pt descriptors;
+    dyn_interface_type *intf; //shared, acquired from descriptors
     service_tracker_pt tracker;
 
     celix_thread_mutex_t mutex;
+    celix_thread_cond_t cond; //signalled when a call finishes
     void *service; //protected by mutex
+    unsigned int maxConcurrentCalls; //0 is unbounded
+    unsigned int runningCalls; //protected by mutex
+    unsigned int retainCount; //protected by mutex
 
     //TODO add tracker and lock
     bool closed;
@@ -50,8 +57,10 @@ struct export_registration {
 
 static void exportRegistration_addServ(export_registration_pt reg, service_reference_pt ref, void *service);
 static void exportRegistration_removeServ(export_registration_pt reg, service_reference_pt ref, void *service);
+static unsigned int exportRegistration_parseConcurrency(log_helper_pt helper, const char *concurrency);
+static celix_status_t exportRegistration_setMethodsProperty(export_registration_pt reg, endpoint_description_pt endpoint);
 
-celix_status_t exportRegistration_create(log_helper_pt helper, service_reference_pt reference, endpoint_description_pt endpoint, bundle_context_pt context, export_registration_pt *out) {
+celix_status_t exportRegistration_create(log_helper_pt helper, service_reference_pt reference, endpoint_description_pt endpoint, bundle_context_pt context, descriptor_cache_pt descriptors, export_registration_pt *out) {
     celix_status_t status = CELIX_SUCCESS;
 
     const char *servId = NULL;
@@ -71,11 +80,17 @@ celix_status_t exportRegistration_create(log_helper_pt helper, service_reference
 
     if (status == CELIX_SUCCESS) {
         reg->context = context;
+        reg->descriptors = descriptors;
         reg->exportReference.endpoint = endpoint;
         reg->exportReference.reference = reference;
         reg->closed = false;
 
         celixThreadMutex_create(&reg->mutex, NULL);
+        celixThreadCondition_init(&reg->cond, NULL);
+
+        const char *concurrency = NULL;
+        serviceReference_getProperty(reference, (char *) RSA_DFI_REMOTE_CONCURRENCY, &concurrency);
+        reg->maxConcurrentCalls = exportRegistration_parseConcurrency(helper, concurrency);
     }
 
     const char *exports = NULL;
@@ -84,24 +99,16 @@ celix_status_t exportRegistration_create(log_helper_pt helper, service_reference
     bundle_pt bundle = NULL;
     CELIX_DO_IF(status, serviceReference_getBundle(reference, &bundle));
 
-    FILE *descriptor = NULL;
-    if (status == CELIX_SUCCESS) {
-        status = dfi_findDescriptor(context, bundle, exports, &descriptor);
-    }
-
-    if (status != CELIX_SUCCESS || descriptor == NULL) {
-        status = CELIX_BUNDLE_EXCEPTION;
-        logHelper_log(helper, OSGI_LOGSERVICE_ERROR, "Cannot find/open descriptor for '%s'", exports);
-    }
-
     if (status == CELIX_SUCCESS) {
-        int rc = dynInterface_parse(descriptor, &reg->intf);
-        fclose(descriptor);
-        if (rc != 0) {
-            status = CELIX_BUNDLE_EXCEPTION;
+        status = descriptorCache_acquire(descriptors, context, bundle, exports, &reg->intf);
+        if (status == CELIX_BUNDLE_EXCEPTION) {
             logHelper_log(helper, OSGI_LOGSERVICE_WARNING, "RSA: Error parsing service descriptor.");
+        } else if (status != CELIX_SUCCESS) {
+            status = CELIX_BUNDLE_EXCEPTION;
+            logHelper_log(helper, OSGI_LOGSERVICE_ERROR, "Cannot find/open descriptor for '%s'", exports);
         }
-        else{
+
+        if (status == CELIX_SUCCESS) {
             /* Add the interface version as a property in the properties_map */
             char* intfVersion = NULL;
             dynInterface_getVersionString(reg->intf, &intfVersion);
@@ -114,6 +121,7 @@ celix_status_t exportRegistration_create(log_helper_pt helper, service_reference
             else{
             	properties_set(endpoint->properties, (char*) CELIX_FRAMEWORK_SERVICE_VERSION, intfVersion);
             }
+            status = exportRegistration_setMethodsProperty(reg, endpoint);
         }
     } 
 
@@ -138,25 +146,110 @@ celix_status_t exportRegistration_create(log_helper_pt helper, service_reference
     return status;
 }
 
-celix_status_t exportRegistration_call(export_registration_pt export, char *data, int datalength, char **responseOut, int *responseLength) {
+celix_status_t exportRegistration_call(export_registration_pt export, rsa_dfi_serialization_type serialization, char *data, int datalength, char **responseOut, int *responseLength) {
     int status = CELIX_SUCCESS;
 
     //printf("calling for '%s'\n");
 
     *responseLength = -1;
     celixThreadMutex_lock(&export->mutex);
-    status = jsonRpc_call(export->intf, export->service, data, responseOut);
+    while (export->maxConcurrentCalls != 0 && export->runningCalls >= export->maxConcurrentCalls) {
+        celixThreadCondition_wait(&export->cond, &export->mutex);
+    }
+    void *service = export->service;
+    export->runningCalls += 1;
+    celixThreadMutex_unlock(&export->mutex);
+
+    if (service == NULL) {
+        status = CELIX_ILLEGAL_STATE;
+    } else if (serialization == RSA_DFI_SERIALIZATION_TYPE_BINARY) {
+        size_t size = 0;
+        status = binaryRpc_call(export->intf, service, data, (size_t) datalength, responseOut, &size);
+        if (status == CELIX_SUCCESS) {
+            *responseLength = (int) size;
+        }
+    } else {
+        status = jsonRpc_call(export->intf, service, data, responseOut);
+    }
+
+    celixThreadMutex_lock(&export->mutex);
+    export->runningCalls -= 1;
+    celixThreadCondition_broadcast(&export->cond);
     celixThreadMutex_unlock(&export->mutex);
 
     return status;
 }
 
+void exportRegistration_retain(export_registration_pt reg) {
+    celixThreadMutex_lock(&reg->mutex);
+    reg->retainCount += 1;
+    celixThreadMutex_unlock(&reg->mutex);
+}
+
+void exportRegistration_release(export_registration_pt reg) {
+    celixThreadMutex_lock(&reg->mutex);
+    reg->retainCount -= 1;
+    celixThreadCondition_broadcast(&reg->cond);
+    celixThreadMutex_unlock(&reg->mutex);
+}
+
+static unsigned int exportRegistration_parseConcurrency(log_helper_pt helper, const char *concurrency) {
+    unsigned int result = 1;
+    if (concurrency != NULL) {
+        char *endptr = NULL;
+        unsigned long n = strtoul(concurrency, &endptr, 10);
+        if (strcmp(concurrency, RSA_DFI_REMOTE_CONCURRENCY_UNBOUNDED) == 0) {
+            result = 0;
+        } else if (endptr != concurrency && *endptr == '\0' && n > 0) {
+            result = (unsigned int) n;
+        } else {
+            logHelper_log(helper, OSGI_LOGSERVICE_WARNING, "RSA: Invalid %s value '%s', calls are serialized", RSA_DFI_REMOTE_CONCURRENCY, concurrency);
+        }
+    }
+    return result;
+}
+
+static celix_status_t exportRegistration_setMethodsProperty(export_registration_pt reg, endpoint_description_pt endpoint) {
+    celix_status_t status = CELIX_SUCCESS;
+    struct methods_head *methods = NULL;
+    dynInterface_methods(reg->intf, &methods);
+
+    size_t length = 1;
+    struct method_entry *entry = NULL;
+    TAILQ_FOREACH(entry, methods, entries) {
+        length += strlen(entry->id) + 1;
+    }
+
+    char *ids = calloc(1, length);
+    if (ids != NULL) {
+        TAILQ_FOREACH(entry, methods, entries) {
+            if (entry != TAILQ_FIRST(methods)) {
+                strcat(ids, ",");
+            }
+            strcat(ids, entry->id);
+        }
+        properties_set(endpoint->properties, RSA_DFI_ENDPOINT_METHODS, ids);
+        free(ids);
+    } else {
+        status = CELIX_ENOMEM;
+    }
+
+    return status;
+}
+
 void exportRegistration_destroy(export_registration_pt reg) {
     if (reg != NULL) {
+        //wait for requests still using this registration
+        celixThreadMutex_lock(&reg->mutex);
+        while (reg->retainCount > 0) {
+            celixThreadCondition_wait(&reg->cond, &reg->mutex);
+        }
+        celixThreadMutex_unlock(&reg->mutex);
+
         if (reg->intf != NULL) {
             dyn_interface_type *intf = reg->intf;
             reg->intf = NULL;
-            dynInterface_destroy(intf);
+            descriptorCache_release(reg->descriptors, intf);
         }
 
         if (reg->exportReference.endpoint != NULL) {
@@ -167,6 +260,7 @@ void exportRegistration_destroy(export_registration_pt reg) {
         if (reg->tracker != NULL) {
             serviceTracker_destroy(reg->tracker);
         }
+        celixThreadCondition_destroy(&reg->cond);
         celixThreadMutex_destroy(&reg->mutex);
 
         free(reg);
@@ -201,6 +295,10 @@ static void exportRegistration_removeServ(export_registration_pt reg, service_re
     if (reg->service == service) {
         reg->service = NULL;
     }
+    //running calls may still use the removed service
+    while (reg->runningCalls > 0) {
+        celixThreadCondition_wait(&reg->cond, &reg->mutex);
+    }
     celixThreadMutex_unlock(&reg->mutex);
 }
 
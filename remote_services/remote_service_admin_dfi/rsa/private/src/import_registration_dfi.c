@@ -18,24 +18,36 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 #include <jansson.h>
 #include <json_rpc.h>
+#include <binary_rpc.h>
 #include <assert.h>
+#include <unistd.h>
 #include "version.h"
 #include "json_serializer.h"
 #include "dyn_interface.h"
 #include "import_registration.h"
 #include "import_registration_dfi.h"
+#include "remote_call_completion.h"
 
 struct import_registration {
     bundle_context_pt context;
     endpoint_description_pt  endpoint; //TODO owner? -> free when destroyed
     const char *classObject; //NOTE owned by endpoint
     version_pt version;
+    descriptor_cache_pt descriptors;
 
-    celix_thread_mutex_t mutex; //protects send & sendhandle
+    celix_thread_mutex_t mutex; //protects send, sendhandle, sendAsync, sendAsyncHandle & runningSends
+    celix_thread_cond_t cond; //signalled when a send finishes
     send_func_type send;
     void *sendHandle;
+    send_async_func_type sendAsync;
+    void *sendAsyncHandle;
+    rsa_dfi_serialization_type serialization;
+    unsigned int runningSends;
+    unsigned int batchWindow; //in microseconds, 0 disables batching
+    array_list_pt batch; //calls collected for the next batch request, NULL when no batch is open
 
     service_factory_pt factory;
     service_registration_pt factoryReg;
@@ -45,18 +57,61 @@ struct import_registration {
 };
 
 struct service_proxy {
-    dyn_interface_type *intf;
+    dyn_interface_type *intf; //shared, acquired from the descriptor cache
     void *service;
+    struct proxy_method *methods;
+    dyn_closure_type **closures;
     size_t count;
+    unsigned int runningSends; //calls through this proxy waiting for their reply, protected by the import mutex
+};
+
+//user data of a proxy function
+struct proxy_method {
+    struct service_proxy *proxy;
+    struct method_entry *entry;
+    int remoteIndex; //index of the method in the exported interface, -1 when unknown
+};
+
+//a call waiting for its reply in a batch request
+struct batch_call {
+    char *request;
+    char *reply;
+    size_t replyLength;
+    int replyStatus;
+    bool done;
+};
+
+//an asynchronous call in flight, keeps the output pointers of the call
+struct async_call {
+    import_registration_pt import;
+    struct service_proxy *proxy;
+    struct method_entry *entry;
+    rsa_dfi_serialization_type serialization;
+    remote_call_completion_pt completion;
+    void **args; //only the output arguments are set
+    void **values;
 };
 
 static celix_status_t importRegistration_createProxy(import_registration_pt import, bundle_pt bundle,
                                               struct service_proxy **proxy);
 static void importRegistration_proxyFunc(void *userData, void *args[], void *returnVal);
-static void importRegistration_destroyProxy(struct service_proxy *proxy);
+static int importRegistration_remoteMethodIndex(const char *methods, const char *id);
+static void importRegistration_destroyProxy(import_registration_pt import, struct service_proxy *proxy);
+static remote_call_completion_pt importRegistration_getCompletion(dyn_function_type *func, void *args[]);
+static int importRegistration_sendAsync(import_registration_pt import, struct proxy_method *method, rsa_dfi_serialization_type serialization, void *args[], remote_call_completion_pt completion, char *request, size_t requestLength);
+static void importRegistration_asyncDone(void *data, char *reply, size_t replyLength, int replyStatus);
+static void importRegistration_waitForRunningSends(import_registration_pt import);
+static void importRegistration_waitForProxySends(import_registration_pt import, struct service_proxy *proxy);
+static void importRegistration_send(import_registration_pt import, send_func_type send, void *sendHandle, rsa_dfi_serialization_type serialization, char *request, size_t requestLength, char **reply, size_t *replyLength, int *replyStatus);
+static void importRegistration_sendBatch(import_registration_pt import, send_func_type send, void *sendHandle, array_list_pt calls);
+celix_status_t importRegistration_getEndpoint(import_registration_pt reg, endpoint_description_pt *endpoint) {
+    *endpoint = reg->endpoint;
+    return CELIX_SUCCESS;
+}
+
 static void importRegistration_clearProxies(import_registration_pt import);
 
-celix_status_t importRegistration_create(bundle_context_pt context, endpoint_description_pt endpoint, const char *classObject, const char* serviceVersion,
+celix_status_t importRegistration_create(bundle_context_pt context, endpoint_description_pt endpoint, const char *classObject, const char* serviceVersion, descriptor_cache_pt descriptors,
                                          import_registration_pt *out) {
     celix_status_t status = CELIX_SUCCESS;
     import_registration_pt reg = calloc(1, sizeof(*reg));
@@ -69,9 +124,11 @@ celix_status_t importRegistration_create(bundle_context_pt context, endpoint_des
         reg->context = context;
         reg->endpoint = endpoint;
         reg->classObject = classObject;
+        reg->descriptors = descriptors;
         reg->proxies = hashMap_create(NULL, NULL, NULL, NULL);
 
         celixThreadMutex_create(&reg->mutex, NULL);
+        celixThreadCondition_init(&reg->cond, NULL);
         celixThreadMutex_create(&reg->proxiesMutex, NULL);
         status = version_createVersionFromString((char*)serviceVersion,&(reg->version));
 
@@ -105,15 +162,60 @@ celix_status_t importRegistration_setSendFn(import_registration_pt reg,
     return CELIX_SUCCESS;
 }
 
+celix_status_t importRegistration_setSendAsyncFn(import_registration_pt reg,
+                                                 send_async_func_type sendAsync,
+                                                 void *handle) {
+    celixThreadMutex_lock(&reg->mutex);
+    reg->sendAsync = sendAsync;
+    reg->sendAsyncHandle = handle;
+    celixThreadMutex_unlock(&reg->mutex);
+
+    return CELIX_SUCCESS;
+}
+
+celix_status_t importRegistration_setSerialization(import_registration_pt reg, rsa_dfi_serialization_type serialization) {
+    celixThreadMutex_lock(&reg->mutex);
+    reg->serialization = serialization;
+    celixThreadMutex_unlock(&reg->mutex);
+
+    return CELIX_SUCCESS;
+}
+
+celix_status_t importRegistration_setBatchWindow(import_registration_pt reg, unsigned int batchWindow) {
+    celixThreadMutex_lock(&reg->mutex);
+    reg->batchWindow = batchWindow;
+    celixThreadMutex_unlock(&reg->mutex);
+
+    return CELIX_SUCCESS;
+}
+
+static void importRegistration_waitForRunningSends(import_registration_pt import) {
+    celixThreadMutex_lock(&import->mutex);
+    while (import->runningSends > 0) {
+        celixThreadCondition_wait(&import->cond, &import->mutex);
+    }
+    celixThreadMutex_unlock(&import->mutex);
+}
+
+static void importRegistration_waitForProxySends(import_registration_pt import, struct service_proxy *proxy) {
+    celixThreadMutex_lock(&import->mutex);
+    while (proxy->runningSends > 0) {
+        celixThreadCondition_wait(&import->cond, &import->mutex);
+    }
+    celixThreadMutex_unlock(&import->mutex);
+}
+
 static void importRegistration_clearProxies(import_registration_pt import) {
     if (import != NULL) {
+        //running (async) calls still use the method entries of the proxies
+        importRegistration_waitForRunningSends(import);
         pthread_mutex_lock(&import->proxiesMutex);
         if (import->proxies != NULL) {
             hash_map_iterator_pt iter = hashMapIterator_create(import->proxies);
             while (hashMapIterator_hasNext(iter)) {
                 hash_map_entry_pt  entry = hashMapIterator_nextEntry(iter);
                 struct service_proxy *proxy = hashMapEntry_getValue(entry);
-                importRegistration_destroyProxy(proxy);
+                importRegistration_destroyProxy(import, proxy);
             }
             hashMapIterator_destroy(iter);
         }
@@ -128,6 +230,10 @@ void importRegistration_destroy(import_registration_pt import) {
             import->proxies = NULL;
         }
 
+        //wait for calls still sending through this registration
+        importRegistration_waitForRunningSends(import);
+
+        celixThreadCondition_destroy(&import->cond);
         pthread_mutex_destroy(&import->mutex);
         pthread_mutex_destroy(&import->proxiesMutex);
 
@@ -201,24 +307,17 @@ celix_status_t importRegistration_getService(import_registration_pt import, bund
 static celix_status_t importRegistration_createProxy(import_registration_pt import, bundle_pt bundle, struct service_proxy **out) {
     celix_status_t  status;
     dyn_interface_type* intf = NULL;
-    FILE *descriptor = NULL;
 
-    status = dfi_findDescriptor(import->context, bundle, import->classObject, &descriptor);
+    status = descriptorCache_acquire(import->descriptors, import->context, bundle, import->classObject, &intf);
 
-    if (status != CELIX_SUCCESS || descriptor == NULL) {
+    if (status == CELIX_BUNDLE_EXCEPTION) {
+        return status;
+    } else if (status != CELIX_SUCCESS) {
         //TODO use log helper logHelper_log(helper, OSGI_LOGSERVICE_ERROR, "Cannot find/open descriptor for '%s'", import->classObject);
         fprintf(stderr, "RSA_DFI: Cannot find/open descriptor for '%s'", import->classObject);
         return CELIX_BUNDLE_EXCEPTION;
     }
 
-    if (status == CELIX_SUCCESS) {
-        int rc = dynInterface_parse(descriptor, &intf);
-        fclose(descriptor);
-        if (rc != 0 || intf==NULL) {
-            return CELIX_BUNDLE_EXCEPTION;
-        }
-    }
-
     /* Check if the imported service version is compatible with the one in the consumer descriptor */
     version_pt consumerVersion = NULL;
     bool isCompatible = false;
@@ -231,7 +330,7 @@ static celix_status_t importRegistration_createProxy(import_registration_pt impo
     	version_toString(consumerVersion,&cVerString);
     	version_toString(import->version,&pVerString);
     	printf("Service version mismatch: consumer has %s, provider has %s. NOT creating proxy.\n",cVerString,pVerString);
-    	dynInterface_destroy(intf);
+    	descriptorCache_release(import->descriptors, intf);
     	free(cVerString);
     	free(pVerString);
     	status = CELIX_SERVICE_EXCEPTION;
@@ -241,6 +340,7 @@ static celix_status_t importRegistration_createProxy(import_registration_pt impo
     if (status == CELIX_SUCCESS) {
         proxy = calloc(1, sizeof(*proxy));
         if (proxy == NULL) {
+            descriptorCache_release(import->descriptors, intf);
             status = CELIX_ENOMEM;
         }
     }
@@ -249,7 +349,9 @@ static celix_status_t importRegistration_createProxy(import_registration_pt impo
     	proxy->intf = intf;
         size_t count = dynInterface_nrOfMethods(proxy->intf);
         proxy->service = calloc(1 + count, sizeof(void *));
-        if (proxy->service == NULL) {
+        proxy->methods = calloc(count, sizeof(*proxy->methods));
+        proxy->closures = calloc(count, sizeof(*proxy->closures));
+        if (proxy->service == NULL || ((proxy->methods == NULL || proxy->closures == NULL) && count > 0)) {
             status = CELIX_ENOMEM;
         }
     }
@@ -258,13 +360,20 @@ static celix_status_t importRegistration_createProxy(import_registration_pt impo
         void **serv = proxy->service;
         serv[0] = import;
 
+        const char *remoteMethods = properties_get(import->endpoint->properties, RSA_DFI_ENDPOINT_METHODS);
+
         struct methods_head *list = NULL;
         dynInterface_methods(proxy->intf, &list);
         struct method_entry *entry = NULL;
         void (*fn)(void) = NULL;
         int index = 0;
         TAILQ_FOREACH(entry, list, entries) {
-            int rc = dynFunction_createClosure(entry->dynFunc, importRegistration_proxyFunc, entry, &fn);
+            struct proxy_method *method = &proxy->methods[index];
+            method->proxy = proxy;
+            method->entry = entry;
+            method->remoteIndex = importRegistration_remoteMethodIndex(remoteMethods, entry->id);
+            //the closures are owned by the proxy, the interface is shared
+            int rc = dynFunction_allocClosure(entry->dynFunc, importRegistration_proxyFunc, method, &proxy->closures[index], &fn);
             serv[index + 1] = fn;
             index += 1;
 
@@ -278,20 +387,35 @@ static celix_status_t importRegistration_createProxy(import_registration_pt impo
     if (status == CELIX_SUCCESS) {
         *out = proxy;
     } else if (proxy != NULL) {
-        if (proxy->intf != NULL) {
-            dynInterface_destroy(proxy->intf);
-            proxy->intf = NULL;
-        }
-        free(proxy->service);
-        free(proxy);
+        importRegistration_destroyProxy(import, proxy);
     }
 
     return status;
 }
 
+static int importRegistration_remoteMethodIndex(const char *methods, const char *id) {
+    int result = -1;
+    size_t len = strlen(id);
+    int index = 0;
+    const char *token = methods;
+    while (token != NULL) {
+        if (strncmp(token, id, len) == 0 && (token[len] == ',' || token[len] == '\0')) {
+            result = index;
+            break;
+        }
+        token = strchr(token, ',');
+        if (token != NULL) {
+            token += 1;
+            index += 1;
+        }
+    }
+    return result;
+}
+
 static void importRegistration_proxyFunc(void *userData, void *args[], void *returnVal) {
     int  status = CELIX_SUCCESS;
-    struct method_entry *entry = userData;
+    struct proxy_method *method = userData;
+    struct method_entry *entry = method->entry;
     import_registration_pt import = *((void **)args[0]);
 
     if (import == NULL || import->send == NULL) {
@@ -299,32 +423,78 @@ static void importRegistration_proxyFunc(void *userData, void *args[], void *ret
     }
 
 
-    char *invokeRequest = NULL;
+    rsa_dfi_serialization_type serialization = RSA_DFI_SERIALIZATION_TYPE_JSON;
+    if (status == CELIX_SUCCESS) {
+        celixThreadMutex_lock(&import->mutex);
+        serialization = import->serialization;
+        celixThreadMutex_unlock(&import->mutex);
+    }
+
+    remote_call_completion_pt completion = NULL;
     if (status == CELIX_SUCCESS) {
-        status = jsonRpc_prepareInvokeRequest(entry->dynFunc, entry->id, args, &invokeRequest);
+        completion = importRegistration_getCompletion(entry->dynFunc, args);
+    }
+
+    char *invokeRequest = NULL;
+    size_t invokeRequestLength = 0;
+    //the compact method index is used when the exporter told us its method order
+    if (status == CELIX_SUCCESS && serialization == RSA_DFI_SERIALIZATION_TYPE_BINARY && method->remoteIndex >= 0) {
+        status = binaryRpc_prepareInvokeRequestForIndex(entry->dynFunc, method->remoteIndex, args, &invokeRequest, &invokeRequestLength);
+    } else if (status == CELIX_SUCCESS && serialization == RSA_DFI_SERIALIZATION_TYPE_BINARY) {
+        status = binaryRpc_prepareInvokeRequest(entry->dynFunc, entry->id, args, &invokeRequest, &invokeRequestLength);
+    } else if (status == CELIX_SUCCESS) {
+        if (method->remoteIndex >= 0) {
+            status = jsonRpc_prepareInvokeRequestForIndex(entry->dynFunc, method->remoteIndex, args, &invokeRequest);
+        } else {
+            status = jsonRpc_prepareInvokeRequest(entry->dynFunc, entry->id, args, &invokeRequest);
+        }
         //printf("Need to send following json '%s'\n", invokeRequest);
+        if (status == CELIX_SUCCESS) {
+            invokeRequestLength = strlen(invokeRequest);
+        }
     }
 
 
-    if (status == CELIX_SUCCESS) {
+    if (status == CELIX_SUCCESS && completion != NULL) {
+        *(int *) returnVal = importRegistration_sendAsync(import, method, serialization, args, completion, invokeRequest, invokeRequestLength);
+    } else if (status == CELIX_SUCCESS) {
         char *reply = NULL;
+        size_t replyLength = 0;
         int rc = 0;
         //printf("sending request\n");
+        //no lock held during the round trip, calls through the same import are sent concurrently
         celixThreadMutex_lock(&import->mutex);
-        if (import->send != NULL) {
-            import->send(import->sendHandle, import->endpoint, invokeRequest, &reply, &rc);
+        send_func_type send = import->send;
+        void *sendHandle = import->sendHandle;
+        if (send != NULL) {
+            import->runningSends += 1;
+            method->proxy->runningSends += 1;
         }
         celixThreadMutex_unlock(&import->mutex);
+
+        if (send != NULL) {
+            importRegistration_send(import, send, sendHandle, serialization, invokeRequest, invokeRequestLength, &reply, &replyLength, &rc);
+        }
         //printf("request sended. got reply '%s' with status %i\n", reply, rc);
 
-        if (rc == 0) {
+        if (rc == 0 && serialization == RSA_DFI_SERIALIZATION_TYPE_BINARY) {
+            status = binaryRpc_handleReply(entry->dynFunc, reply, replyLength, args);
+        } else if (rc == 0) {
             //fjprintf("Handling reply '%s'\n", reply);
             status = jsonRpc_handleReply(entry->dynFunc, reply, args);
         }
 
+        if (send != NULL) {
+            celixThreadMutex_lock(&import->mutex);
+            import->runningSends -= 1;
+            method->proxy->runningSends -= 1;
+            celixThreadCondition_broadcast(&import->cond);
+            celixThreadMutex_unlock(&import->mutex);
+        }
+
         *(int *) returnVal = rc;
 
-        free(invokeRequest); //Allocated by json_dumps in jsonRpc_prepareInvokeRequest
+        free(invokeRequest); //Allocated by json_dumps or the binary buffer in the rpc prepareInvokeRequest
         free(reply); //Allocated by json_dumps in remoteServiceAdmin_send through curl call
     }
 
@@ -333,6 +503,216 @@ static void importRegistration_proxyFunc(void *userData, void *args[], void *ret
     }
 }
 
+static void importRegistration_send(import_registration_pt import, send_func_type send, void *sendHandle, rsa_dfi_serialization_type serialization, char *request, size_t requestLength, char **reply, size_t *replyLength, int *replyStatus) {
+    celixThreadMutex_lock(&import->mutex);
+    unsigned int batchWindow = import->batchWindow;
+    celixThreadMutex_unlock(&import->mutex);
+
+    if (batchWindow == 0 || serialization != RSA_DFI_SERIALIZATION_TYPE_JSON) {
+        send(sendHandle, import->endpoint, serialization, request, requestLength, reply, replyLength, replyStatus);
+        return;
+    }
+
+    struct batch_call call;
+    memset(&call, 0, sizeof(call));
+    call.request = request;
+
+    //the first call opens the batch and sends it when the window is passed
+    celixThreadMutex_lock(&import->mutex);
+    bool sendsBatch = import->batch == NULL;
+    if (sendsBatch) {
+        arrayList_create(&import->batch);
+    }
+    arrayList_add(import->batch, &call);
+    celixThreadMutex_unlock(&import->mutex);
+
+    if (sendsBatch) {
+        usleep(batchWindow);
+
+        celixThreadMutex_lock(&import->mutex);
+        array_list_pt calls = import->batch;
+        import->batch = NULL;
+        celixThreadMutex_unlock(&import->mutex);
+
+        importRegistration_sendBatch(import, send, sendHandle, calls);
+
+        celixThreadMutex_lock(&import->mutex);
+        int i;
+        for (i = 0; i < arrayList_size(calls); i += 1) {
+            struct batch_call *batched = arrayList_get(calls, i);
+            batched->done = true;
+        }
+        celixThreadCondition_broadcast(&import->cond);
+        celixThreadMutex_unlock(&import->mutex);
+        arrayList_destroy(calls);
+    } else {
+        celixThreadMutex_lock(&import->mutex);
+        while (!call.done) {
+            celixThreadCondition_wait(&import->cond, &import->mutex);
+        }
+        celixThreadMutex_unlock(&import->mutex);
+    }
+
+    *reply = call.reply;
+    *replyLength = call.replyLength;
+    *replyStatus = call.replyStatus;
+}
+
+static void importRegistration_sendBatch(import_registration_pt import, send_func_type send, void *sendHandle, array_list_pt calls) {
+    int size = arrayList_size(calls);
+    int i;
+
+    if (size == 1) {
+        struct batch_call *call = arrayList_get(calls, 0);
+        send(sendHandle, import->endpoint, RSA_DFI_SERIALIZATION_TYPE_JSON, call->request, strlen(call->request), &call->reply, &call->replyLength, &call->replyStatus);
+        return;
+    }
+
+    char *requests[size];
+    char *replies[size];
+    for (i = 0; i < size; i += 1) {
+        struct batch_call *call = arrayList_get(calls, i);
+        requests[i] = call->request;
+    }
+
+    char *batchRequest = NULL;
+    char *batchReply = NULL;
+    size_t batchReplyLength = 0;
+    int rc = 0;
+    int status = jsonRpc_prepareBatchRequest(requests, size, &batchRequest);
+    if (status == 0) {
+        send(sendHandle, import->endpoint, RSA_DFI_SERIALIZATION_TYPE_JSON, batchRequest, strlen(batchRequest), &batchReply, &batchReplyLength, &rc);
+        if (rc == 0) {
+            status = jsonRpc_splitBatchReply(batchReply, size, replies);
+        }
+    }
+
+    for (i = 0; i < size; i += 1) {
+        struct batch_call *call = arrayList_get(calls, i);
+        if (status != 0) {
+            call->replyStatus = CELIX_BUNDLE_EXCEPTION;
+        } else if (rc != 0) {
+            call->replyStatus = rc;
+        } else {
+            call->reply = replies[i];
+            call->replyLength = strlen(replies[i]);
+        }
+    }
+
+    free(batchRequest);
+    free(batchReply);
+}
+
+static remote_call_completion_pt importRegistration_getCompletion(dyn_function_type *func, void *args[]) {
+    remote_call_completion_pt completion = NULL;
+    int nrOfArgs = dynFunction_nrOfArguments(func);
+    int i;
+    for (i = 0; i < nrOfArgs; i += 1) {
+        if (dynFunction_argumentMetaForIndex(func, i) == DYN_FUNCTION_ARGUMENT_META__ASYNC) {
+            completion = *(remote_call_completion_pt *) args[i];
+            break;
+        }
+    }
+    return completion;
+}
+
+static int importRegistration_sendAsync(import_registration_pt import, struct proxy_method *method, rsa_dfi_serialization_type serialization, void *args[], remote_call_completion_pt completion, char *request, size_t requestLength) {
+    celix_status_t status = CELIX_SUCCESS;
+    struct method_entry *entry = method->entry;
+    int nrOfArgs = dynFunction_nrOfArguments(entry->dynFunc);
+
+    struct async_call *call = calloc(1, sizeof(*call));
+    if (call != NULL) {
+        call->args = calloc(nrOfArgs, sizeof(void *));
+        call->values = calloc(nrOfArgs, sizeof(void *));
+    }
+    if (call == NULL || call->args == NULL || call->values == NULL) {
+        status = CELIX_ENOMEM;
+    }
+
+    if (status == CELIX_SUCCESS) {
+        call->import = import;
+        call->proxy = method->proxy;
+        call->entry = entry;
+        call->serialization = serialization;
+        call->completion = completion;
+
+        //the closure arguments are gone when the reply arrives, keep the output pointers
+        int i;
+        for (i = 0; i < nrOfArgs; i += 1) {
+            enum dyn_function_argument_meta meta = dynFunction_argumentMetaForIndex(entry->dynFunc, i);
+            if (meta == DYN_FUNCTION_ARGUMENT_META__PRE_ALLOCATED_OUTPUT || meta == DYN_FUNCTION_ARGUMENT_META__OUTPUT) {
+                call->values[i] = *(void **) args[i];
+                call->args[i] = &call->values[i];
+            }
+        }
+    }
+
+    send_async_func_type sendAsync = NULL;
+    void *sendAsyncHandle = NULL;
+    if (status == CELIX_SUCCESS) {
+        celixThreadMutex_lock(&import->mutex);
+        sendAsync = import->sendAsync;
+        sendAsyncHandle = import->sendAsyncHandle;
+        if (sendAsync != NULL) {
+            import->runningSends += 1;
+            method->proxy->runningSends += 1;
+        } else {
+            status = CELIX_ILLEGAL_STATE;
+        }
+        celixThreadMutex_unlock(&import->mutex);
+    }
+
+    if (status == CELIX_SUCCESS) {
+        status = sendAsync(sendAsyncHandle, import->endpoint, serialization, request, requestLength, importRegistration_asyncDone, call);
+        if (status != CELIX_SUCCESS) {
+            celixThreadMutex_lock(&import->mutex);
+            import->runningSends -= 1;
+            method->proxy->runningSends -= 1;
+            celixThreadCondition_broadcast(&import->cond);
+            celixThreadMutex_unlock(&import->mutex);
+        }
+    }
+
+    if (status != CELIX_SUCCESS) {
+        free(request);
+        if (call != NULL) {
+            free(call->args);
+            free(call->values);
+            free(call);
+        }
+    }
+
+    return status;
+}
+
+static void importRegistration_asyncDone(void *data, char *reply, size_t replyLength, int replyStatus) {
+    struct async_call *call = data;
+    import_registration_pt import = call->import;
+    struct service_proxy *proxy = call->proxy;
+    remote_call_completion_pt completion = call->completion;
+
+    int status = replyStatus;
+    if (status == 0 && call->serialization == RSA_DFI_SERIALIZATION_TYPE_BINARY) {
+        status = binaryRpc_handleReply(call->entry->dynFunc, reply, replyLength, call->args);
+    } else if (status == 0) {
+        status = jsonRpc_handleReply(call->entry->dynFunc, reply, call->args);
+    }
+    free(reply);
+    free(call->args);
+    free(call->values);
+    free(call);
+
+    //done with the method entry, the proxy may go now
+    celixThreadMutex_lock(&import->mutex);
+    import->runningSends -= 1;
+    proxy->runningSends -= 1;
+    celixThreadCondition_broadcast(&import->cond);
+    celixThreadMutex_unlock(&import->mutex);
+
+    completion->done(completion->handle, status);
+}
+
 celix_status_t importRegistration_ungetService(import_registration_pt import, bundle_pt bundle, service_registration_pt registration, void **out) {
     celix_status_t  status = CELIX_SUCCESS;
 
@@ -342,6 +722,7 @@ celix_status_t importRegistration_ungetService(import_registration_pt import, bu
     pthread_mutex_lock(&import->proxiesMutex);
 
     struct service_proxy *proxy = hashMap_get(import->proxies, bundle);
+    struct service_proxy *removed = NULL;
     if (proxy != NULL) {
         if (*out == proxy->service) {
             proxy->count -= 1;
@@ -351,23 +732,38 @@ celix_status_t importRegistration_ungetService(import_registration_pt import, bu
 
         if (proxy->count == 0) {
             hashMap_remove(import->proxies, bundle);
-            importRegistration_destroyProxy(proxy);
+            removed = proxy;
         }
     }
 
     pthread_mutex_unlock(&import->proxiesMutex);
 
+    //running (async) calls through the proxy still use its method entries, other bundles can go on meanwhile
+    if (removed != NULL) {
+        importRegistration_waitForProxySends(import, removed);
+        importRegistration_destroyProxy(import, removed);
+    }
+
     return status;
 }
 
-static void importRegistration_destroyProxy(struct service_proxy *proxy) {
+static void importRegistration_destroyProxy(import_registration_pt import, struct service_proxy *proxy) {
     if (proxy != NULL) {
         if (proxy->intf != NULL) {
-            dynInterface_destroy(proxy->intf);
+            if (proxy->closures != NULL) {
+                size_t i;
+                size_t count = dynInterface_nrOfMethods(proxy->intf);
+                for (i = 0; i < count; i += 1) {
+                    dynFunction_freeClosure(proxy->closures[i]);
+                }
+            }
+            descriptorCache_release(import->descriptors, proxy->intf);
         }
         if (proxy->service != NULL) {
             free(proxy->service);
         }
+        free(proxy->methods);
+        free(proxy->closures);
         free(proxy);
     }
 }
@@ -45,6 +45,11 @@
 #include "remote_service_admin_dfi.h"
 #include "dyn_interface.h"
 #include "json_rpc.h"
+#include "binary_serializer.h"
+#include "binary_rpc.h"
+#include "remote_service_admin_dfi_constants.h"
+#include "curl_pool.h"
+#include "curl_async.h"
 
 #include "remote_constants.h"
 #include "constants.h"
@@ -77,6 +82,11 @@ struct remote_service_admin {
     char *ip;
 
     struct mg_context *ctx;
+
+    curl_pool_pt curlPool;
+    curl_async_pt curlAsync;
+
+    descriptor_cache_pt descriptors; //parsed descriptors shared by the imports and exports
 };
 
 struct post {
@@ -89,6 +99,21 @@ struct get {
     int size;
 };
 
+//state of a single http post to an imported endpoint
+struct post_call {
+    char *serviceUrl;
+    CURL *curl;
+    struct curl_slist *headers;
+    struct post post;
+    struct get get;
+
+    //only used for asynchronous calls
+    remote_service_admin_pt rsa;
+    char *request;
+    send_done_func_type done;
+    void *data;
+};
+
 #define OSGI_RSA_REMOTE_PROXY_FACTORY 	"remote_proxy_factory"
 #define OSGI_RSA_REMOTE_PROXY_TIMEOUT   "remote_proxy_timeout"
 
@@ -96,10 +121,19 @@ static const char *data_response_headers =
         "HTTP/1.1 200 OK\r\n"
                 "Cache: no-cache\r\n"
                 "Content-Type: application/json\r\n"
+                "Content-Length: %i\r\n"
+                "\r\n";
+
+static const char *binary_data_response_headers =
+        "HTTP/1.1 200 OK\r\n"
+                "Cache: no-cache\r\n"
+                "Content-Type: " RSA_DFI_BINARY_CONTENT_TYPE "\r\n"
+                "Content-Length: %i\r\n"
                 "\r\n";
 
 static const char *no_content_response_headers =
-        "HTTP/1.1 204 OK\r\n";
+        "HTTP/1.1 204 OK\r\n"
+                "\r\n";
 
 // TODO do we need to specify a non-Amdatu specific configuration type?!
 static const char * const CONFIGURATION_TYPE = "org.amdatu.remote.admin.http";
@@ -112,10 +146,30 @@ static const unsigned int DEFAULT_TIMEOUT = 0;
 
 static int remoteServiceAdmin_callback(struct mg_connection *conn);
 static celix_status_t remoteServiceAdmin_createEndpointDescription(remote_service_admin_pt admin, service_reference_pt reference, properties_pt props, char *interface, endpoint_description_pt *description);
-static celix_status_t remoteServiceAdmin_send(void *handle, endpoint_description_pt endpointDescription, char *request, char **reply, int* replyStatus);
+static celix_status_t remoteServiceAdmin_send(void *handle, endpoint_description_pt endpointDescription, rsa_dfi_serialization_type serialization, char *request, size_t requestLength, char **reply, size_t *replyLength, int* replyStatus);
+static celix_status_t remoteServiceAdmin_sendAsync(void *handle, endpoint_description_pt endpointDescription, rsa_dfi_serialization_type serialization, char *request, size_t requestLength, send_done_func_type done, void *data);
+static celix_status_t remoteServiceAdmin_preparePost(remote_service_admin_pt rsa, endpoint_description_pt endpointDescription, rsa_dfi_serialization_type serialization, char *request, size_t requestLength, struct post_call *call);
+static void remoteServiceAdmin_finishPost(remote_service_admin_pt rsa, struct post_call *call, CURLcode res);
+static void remoteServiceAdmin_asyncDone(void *data, CURL *handle, CURLcode res);
+static bool remoteServiceAdmin_supportsSerialization(const char *serializations, const char *serialization);
 static celix_status_t remoteServiceAdmin_getIpAdress(char* interface, char** ip);
+static unsigned int remoteServiceAdmin_getUIntProperty(bundle_context_pt context, const char *name, unsigned int defaultValue);
 static size_t remoteServiceAdmin_readCallback(void *ptr, size_t size, size_t nmemb, void *userp);
 static size_t remoteServiceAdmin_write(void *contents, size_t size, size_t nmemb, void *userp);
+static unsigned int remoteServiceAdmin_getUIntProperty(bundle_context_pt context, const char *name, unsigned int defaultValue) {
+    unsigned int result = defaultValue;
+    const char *value = NULL;
+    bundleContext_getProperty(context, name, &value);
+    if (value != NULL) {
+        char *endptr = NULL;
+        unsigned long parsed = strtoul(value, &endptr, 10);
+        if (endptr != value && *endptr == '\0') {
+            result = (unsigned int) parsed;
+        }
+    }
+    return result;
+}
+
 static void remoteServiceAdmin_log(remote_service_admin_pt admin, int level, const char *file, int line, const char *msg, ...);
 
 celix_status_t remoteServiceAdmin_create(bundle_context_pt context, remote_service_admin_pt *admin) {
@@ -145,6 +199,8 @@ celix_status_t remoteServiceAdmin_create(bundle_context_pt context, remote_servi
             dynInterface_logSetup((void *)remoteServiceAdmin_log, *admin, 1);
             jsonSerializer_logSetup((void *)remoteServiceAdmin_log, *admin, 1);
             jsonRpc_logSetup((void *)remoteServiceAdmin_log, *admin, 1);
+            binarySerializer_logSetup((void *)remoteServiceAdmin_log, *admin, 1);
+            binaryRpc_logSetup((void *)remoteServiceAdmin_log, *admin, 1);
         }
 
         bundleContext_getProperty(context, "RSA_PORT", &port);
@@ -181,6 +237,22 @@ celix_status_t remoteServiceAdmin_create(bundle_context_pt context, remote_servi
             free(detectedIp);
         }
 
+        unsigned int poolSize = remoteServiceAdmin_getUIntProperty(context, RSA_DFI_CONNECTION_POOL_SIZE, RSA_DFI_CONNECTION_POOL_SIZE_DEFAULT);
+        unsigned int idleTimeout = remoteServiceAdmin_getUIntProperty(context, RSA_DFI_CONNECTION_IDLE_TIMEOUT, RSA_DFI_CONNECTION_IDLE_TIMEOUT_DEFAULT);
+        status = curlPool_create(poolSize, idleTimeout, &(*admin)->curlPool);
+        if (status == CELIX_SUCCESS) {
+            status = curlAsync_create(&(*admin)->curlAsync);
+        }
+        if (status == CELIX_SUCCESS) {
+            status = descriptorCache_create(&(*admin)->descriptors);
+        }
+
+        const char *numThreads = NULL;
+        bundleContext_getProperty(context, RSA_DFI_NUM_THREADS, &numThreads);
+        if (numThreads == NULL) {
+            numThreads = RSA_DFI_NUM_THREADS_DEFAULT;
+        }
+
         // Prepare callbacks structure. We have only one callback, the rest are NULL.
         struct mg_callbacks callbacks;
         memset(&callbacks, 0, sizeof(callbacks));
@@ -190,7 +262,7 @@ celix_status_t remoteServiceAdmin_create(bundle_context_pt context, remote_servi
 
         do {
 
-            const char *options[] = { "listening_ports", port, "num_threads", "5", NULL};
+            const char *options[] = { "listening_ports", port, "num_threads", numThreads, "enable_keep_alive", "yes", NULL};
 
             (*admin)->ctx = mg_start(&callbacks, (*admin), options);
 
@@ -259,6 +331,9 @@ celix_status_t remoteServiceAdmin_stop(remote_service_admin_pt admin) {
     hashMapIterator_destroy(iter);
     celixThreadMutex_unlock(&admin->exportedServicesLock);
 
+    //aborts the async calls still running, so imports do not wait for them
+    curlAsync_stop(admin->curlAsync);
+
     celixThreadMutex_lock(&admin->importedServicesLock);
     int i;
     int size = arrayList_size(admin->importedServices);
@@ -280,6 +355,13 @@ celix_status_t remoteServiceAdmin_stop(remote_service_admin_pt admin) {
     hashMap_destroy(admin->exportedServices, false, false);
     arrayList_destroy(admin->importedServices);
 
+    curlAsync_destroy(admin->curlAsync);
+    admin->curlAsync = NULL;
+    curlPool_destroy(admin->curlPool);
+    admin->curlPool = NULL;
+    descriptorCache_destroy(admin->descriptors);
+    admin->descriptors = NULL;
+
     logHelper_stop(admin->loghelper);
     logHelper_destroy(&admin->loghelper);
 
@@ -340,6 +422,12 @@ static int remoteServiceAdmin_callback(struct mg_connection *conn) {
             }
             hashMapIterator_destroy(iter);
 
+            //the call itself is done outside the lock, so exports can be called concurrently
+            if (export != NULL) {
+                exportRegistration_retain(export);
+            }
+            celixThreadMutex_unlock(&rsa->exportedServicesLock);
+
             if (export != NULL) {
 
                 uint64_t datalength = request_info->content_length;
@@ -347,16 +435,26 @@ static int remoteServiceAdmin_callback(struct mg_connection *conn) {
                 mg_read(conn, data, datalength);
                 data[datalength] = '\0';
 
+                const char *contentType = mg_get_header(conn, "Content-Type");
+                rsa_dfi_serialization_type serialization = RSA_DFI_SERIALIZATION_TYPE_JSON;
+                if (contentType != NULL && strcmp(contentType, RSA_DFI_BINARY_CONTENT_TYPE) == 0) {
+                    serialization = RSA_DFI_SERIALIZATION_TYPE_BINARY;
+                }
+
                 char *response = NULL;
                 int responceLength = 0;
-                int rc = exportRegistration_call(export, data, -1, &response, &responceLength);
+                int rc = exportRegistration_call(export, serialization, data, (int) datalength, &response, &responceLength);
                 if (rc != CELIX_SUCCESS) {
                     RSA_LOG_ERROR(rsa, "Error trying to invoke remove service, got error %i\n", rc);
                 }
 
                 if (rc == CELIX_SUCCESS && response != NULL) {
-                    mg_write(conn, data_response_headers, strlen(data_response_headers));
-                    mg_write(conn, response, strlen(response));
+                    if (serialization != RSA_DFI_SERIALIZATION_TYPE_BINARY) {
+                        responceLength = strlen(response);
+                    }
+                    //content length is needed to keep the connection alive
+                    mg_printf(conn, serialization == RSA_DFI_SERIALIZATION_TYPE_BINARY ? binary_data_response_headers : data_response_headers, responceLength);
+                    mg_write(conn, response, responceLength);
                     free(response);
                 } else {
                     mg_write(conn, no_content_response_headers, strlen(no_content_response_headers));
@@ -364,13 +462,11 @@ static int remoteServiceAdmin_callback(struct mg_connection *conn) {
                 result = 1;
 
                 free(data);
+                exportRegistration_release(export);
             } else {
                 result = 0;
                 RSA_LOG_WARNING(rsa, "NO export registration found for service id %lu", serviceId);
             }
-
-            celixThreadMutex_unlock(&rsa->exportedServicesLock);
-
         }
     }
 
@@ -428,7 +524,7 @@ celix_status_t remoteServiceAdmin_exportService(remote_service_admin_pt admin, c
 
         remoteServiceAdmin_createEndpointDescription(admin, reference, properties, (char*)interface, &endpoint);
         //TODO precheck if descriptor exists
-        status = exportRegistration_create(admin->loghelper, reference, endpoint, admin->context, &registration);
+        status = exportRegistration_create(admin->loghelper, reference, endpoint, admin->context, admin->descriptors, &registration);
         if (status == CELIX_SUCCESS) {
             status = exportRegistration_start(registration);
             if (status == CELIX_SUCCESS) {
@@ -504,10 +600,8 @@ static celix_status_t remoteServiceAdmin_createEndpointDescription(remote_servic
         }
     }
 
-    hash_map_entry_pt entry = hashMap_getEntry(endpointProperties, (void *) OSGI_FRAMEWORK_SERVICE_ID);
-
-    char* key = hashMapEntry_getKey(entry);
-    char *serviceId = (char *) hashMap_remove(endpointProperties, (void *) OSGI_FRAMEWORK_SERVICE_ID);
+    char *serviceId = strdup(properties_get(endpointProperties, (char *) OSGI_FRAMEWORK_SERVICE_ID));
+    properties_unset(endpointProperties, (char *) OSGI_FRAMEWORK_SERVICE_ID);
     const char *uuid = NULL;
 
     char buf[512];
@@ -539,6 +633,13 @@ static celix_status_t remoteServiceAdmin_createEndpointDescription(remote_servic
         hashMapIterator_destroy(propIter);
     }
 
+    if (properties_get(endpointProperties, RSA_DFI_ENDPOINT_SERIALIZATION) == NULL) {
+        const char *serializations = NULL;
+        bundleContext_getProperty(admin->context, RSA_DFI_SERIALIZATION, &serializations);
+        properties_set(endpointProperties, RSA_DFI_ENDPOINT_SERIALIZATION, serializations != NULL ? serializations : RSA_DFI_SERIALIZATION_DEFAULT);
+    }
+    properties_set(endpointProperties, RSA_DFI_ENDPOINT_BATCH, "true");
+
     *endpoint = calloc(1, sizeof(**endpoint));
     if (!*endpoint) {
         status = CELIX_ENOMEM;
@@ -552,7 +653,6 @@ static celix_status_t remoteServiceAdmin_createEndpointDescription(remote_servic
         (*endpoint)->properties = endpointProperties;
     }
 
-    free(key);
     free(serviceId);
     free(keys);
 
@@ -624,10 +724,28 @@ celix_status_t remoteServiceAdmin_importService(remote_service_admin_pt admin, e
     logHelper_log(admin->loghelper, OSGI_LOGSERVICE_INFO, "Registering service factory (proxy) for service '%s'\n", objectClass);
 
     if (objectClass != NULL) {
-        status = importRegistration_create(admin->context, endpointDescription, objectClass, serviceVersion, &import);
+        status = importRegistration_create(admin->context, endpointDescription, objectClass, serviceVersion, admin->descriptors, &import);
     }
     if (status == CELIX_SUCCESS && import != NULL) {
         importRegistration_setSendFn(import, (send_func_type) remoteServiceAdmin_send, admin);
+        importRegistration_setSendAsyncFn(import, remoteServiceAdmin_sendAsync, admin);
+
+        //binary only when the exporter accepts it and it is not disabled locally
+        const char *offered = properties_get(endpointDescription->properties, RSA_DFI_ENDPOINT_SERIALIZATION);
+        const char *accepted = NULL;
+        bundleContext_getProperty(admin->context, RSA_DFI_SERIALIZATION, &accepted);
+        if (accepted == NULL) {
+            accepted = RSA_DFI_SERIALIZATION_DEFAULT;
+        }
+        //batching (json only) is preferred over binary when configured
+        unsigned int batchWindow = remoteServiceAdmin_getUIntProperty(admin->context, RSA_DFI_BATCH_WINDOW, RSA_DFI_BATCH_WINDOW_DEFAULT);
+        const char *batch = properties_get(endpointDescription->properties, RSA_DFI_ENDPOINT_BATCH);
+        if (batchWindow > 0 && batch != NULL && strcmp(batch, "true") == 0) {
+            importRegistration_setBatchWindow(import, batchWindow);
+        } else if (remoteServiceAdmin_supportsSerialization(offered, RSA_DFI_SERIALIZATION_BINARY)
+                && remoteServiceAdmin_supportsSerialization(accepted, RSA_DFI_SERIALIZATION_BINARY)) {
+            importRegistration_setSerialization(import, RSA_DFI_SERIALIZATION_TYPE_BINARY);
+        }
     }
 
     if (status == CELIX_SUCCESS && import != NULL) {
@@ -657,6 +775,12 @@ celix_status_t remoteServiceAdmin_removeImportedService(remote_service_admin_pt
     for (i = 0; i < size; i += 1) {
         current = arrayList_get(admin->importedServices, i);
         if (current == registration) {
+            endpoint_description_pt endpoint = NULL;
+            importRegistration_getEndpoint(current, &endpoint);
+            const char *url = endpoint != NULL ? properties_get(endpoint->properties, (char*) ENDPOINT_URL) : NULL;
+            if (url != NULL) {
+                curlPool_removeEndpoint(admin->curlPool, url);
+            }
             arrayList_remove(admin->importedServices, i);
             importRegistration_close(current);
             importRegistration_destroy(current);
@@ -669,19 +793,92 @@ celix_status_t remoteServiceAdmin_removeImportedService(remote_service_admin_pt
 }
 
 
-static celix_status_t remoteServiceAdmin_send(void *handle, endpoint_description_pt endpointDescription, char *request, char **reply, int* replyStatus) {
+static bool remoteServiceAdmin_supportsSerialization(const char *serializations, const char *serialization) {
+    bool supported = false;
+    size_t len = strlen(serialization);
+    const char *token = serializations;
+    while (token != NULL && !supported) {
+        while (*token == ' ' || *token == ',') {
+            token++;
+        }
+        supported = strncmp(token, serialization, len) == 0 && (token[len] == '\0' || token[len] == ',' || token[len] == ' ');
+        token = strchr(token, ',');
+    }
+    return supported;
+}
+
+static celix_status_t remoteServiceAdmin_send(void *handle, endpoint_description_pt endpointDescription, rsa_dfi_serialization_type serialization, char *request, size_t requestLength, char **reply, size_t *replyLength, int* replyStatus) {
     remote_service_admin_pt  rsa = handle;
-    struct post post;
-    post.readptr = request;
-    post.size = strlen(request);
+    struct post_call call;
+    memset(&call, 0, sizeof(call));
 
-    struct get get;
-    get.size = 0;
-    get.writeptr = malloc(1);
+    celix_status_t status = remoteServiceAdmin_preparePost(rsa, endpointDescription, serialization, request, requestLength, &call);
+    if (status == CELIX_SUCCESS) {
+        logHelper_log(rsa->loghelper, OSGI_LOGSERVICE_DEBUG, "RSA: Performing curl post\n");
+        CURLcode res = curl_easy_perform(call.curl);
+
+        *reply = call.get.writeptr;
+        *replyLength = call.get.size;
+        *replyStatus = res;
+        call.get.writeptr = NULL;
+
+        remoteServiceAdmin_finishPost(rsa, &call, res);
+    }
+
+    return status;
+}
+
+static celix_status_t remoteServiceAdmin_sendAsync(void *handle, endpoint_description_pt endpointDescription, rsa_dfi_serialization_type serialization, char *request, size_t requestLength, send_done_func_type done, void *data) {
+    remote_service_admin_pt  rsa = handle;
+    celix_status_t status = CELIX_SUCCESS;
+    struct post_call *call = calloc(1, sizeof(*call));
+
+    if (call == NULL) {
+        status = CELIX_ENOMEM;
+    } else {
+        status = remoteServiceAdmin_preparePost(rsa, endpointDescription, serialization, request, requestLength, call);
+    }
+
+    if (status == CELIX_SUCCESS) {
+        call->rsa = rsa;
+        call->request = request;
+        call->done = done;
+        call->data = data;
+        logHelper_log(rsa->loghelper, OSGI_LOGSERVICE_DEBUG, "RSA: Queueing async curl post\n");
+        status = curlAsync_add(rsa->curlAsync, call->curl, remoteServiceAdmin_asyncDone, call);
+        if (status != CELIX_SUCCESS) {
+            remoteServiceAdmin_finishPost(rsa, call, CURLE_ABORTED_BY_CALLBACK);
+        }
+    }
 
-    char *serviceUrl = (char*)properties_get(endpointDescription->properties, (char*) ENDPOINT_URL);
-    char url[256];
-    snprintf(url, 256, "%s", serviceUrl);
+    if (status != CELIX_SUCCESS) {
+        free(call);
+    }
+
+    return status;
+}
+
+static void remoteServiceAdmin_asyncDone(void *data, CURL *handle, CURLcode res) {
+    struct post_call *call = data;
+    char *reply = call->get.writeptr;
+    size_t replyLength = call->get.size;
+    call->get.writeptr = NULL;
+
+    remoteServiceAdmin_finishPost(call->rsa, call, res);
+    free(call->request);
+
+    call->done(call->data, reply, replyLength, res);
+    free(call);
+}
+
+static celix_status_t remoteServiceAdmin_preparePost(remote_service_admin_pt rsa, endpoint_description_pt endpointDescription, rsa_dfi_serialization_type serialization, char *request, size_t requestLength, struct post_call *call) {
+    call->post.readptr = request;
+    call->post.size = requestLength;
+
+    call->get.size = 0;
+    call->get.writeptr = malloc(1);
+
+    call->serviceUrl = strdup(properties_get(endpointDescription->properties, (char*) ENDPOINT_URL));
 
     // assume the default timeout
     int timeout = DEFAULT_TIMEOUT;
@@ -699,46 +896,54 @@ static celix_status_t remoteServiceAdmin_send(void *handle, endpoint_description
         timeout = atoi(timeoutStr);
     }
 
-    celix_status_t status = CELIX_SUCCESS;
-    CURL *curl;
-    CURLcode res;
-
-    curl = curl_easy_init();
-    if(!curl) {
-        status = CELIX_ILLEGAL_STATE;
-    } else {
+    celix_status_t status = curlPool_acquire(rsa->curlPool, call->serviceUrl, &call->curl);
+    if (status == CELIX_SUCCESS) {
+        CURL *curl = call->curl;
         curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1);
+        curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
         curl_easy_setopt(curl, CURLOPT_TIMEOUT, timeout);
-        curl_easy_setopt(curl, CURLOPT_URL, url);
+        curl_easy_setopt(curl, CURLOPT_URL, call->serviceUrl);
         curl_easy_setopt(curl, CURLOPT_POST, 1L);
         curl_easy_setopt(curl, CURLOPT_READFUNCTION, remoteServiceAdmin_readCallback);
-        curl_easy_setopt(curl, CURLOPT_READDATA, &post);
+        curl_easy_setopt(curl, CURLOPT_READDATA, &call->post);
         curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, remoteServiceAdmin_write);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&get);
-        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, (curl_off_t)post.size);
-        logHelper_log(rsa->loghelper, OSGI_LOGSERVICE_DEBUG, "RSA: Performing curl post\n");
-        res = curl_easy_perform(curl);
-
-        *reply = get.writeptr;
-        *replyStatus = res;
-
-        curl_easy_cleanup(curl);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&call->get);
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, (curl_off_t)call->post.size);
+        //no 100-continue round trip for larger requests
+        call->headers = curl_slist_append(call->headers, "Expect:");
+        if (serialization == RSA_DFI_SERIALIZATION_TYPE_BINARY) {
+            call->headers = curl_slist_append(call->headers, "Content-Type: " RSA_DFI_BINARY_CONTENT_TYPE);
+        }
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, call->headers);
+    } else {
+        free(call->get.writeptr);
+        free(call->serviceUrl);
     }
 
     return status;
 }
 
+static void remoteServiceAdmin_finishPost(remote_service_admin_pt rsa, struct post_call *call, CURLcode res) {
+    curlPool_release(rsa->curlPool, call->serviceUrl, call->curl, res == CURLE_OK);
+    curl_slist_free_all(call->headers);
+    free(call->get.writeptr);
+    free(call->serviceUrl);
+}
+
 static size_t remoteServiceAdmin_readCallback(void *ptr, size_t size, size_t nmemb, void *userp) {
     struct post *post = userp;
+    size_t len = size * nmemb;
 
-    if (post->size) {
-        *(char *) ptr = post->readptr[0];
-        post->readptr++;
-        post->size--;
-        return 1;
+    if (len > (size_t) post->size) {
+        len = post->size;
+    }
+    if (len > 0) {
+        memcpy(ptr, post->readptr, len);
+        post->readptr += len;
+        post->size -= len;
     }
 
-    return 0;
+    return len;
 }
 
 static size_t remoteServiceAdmin_write(void *contents, size_t size, size_t nmemb, void *userp) {
@@ -0,0 +1,45 @@
+/**
+ *Licensed to the Apache Software Foundation (ASF) under one
+ *or more contributor license agreements.  See the NOTICE file
+ *distributed with this work for additional information
+ *regarding copyright ownership.  The ASF licenses this file
+ *to you under the Apache License, Version 2.0 (the
+ *"License"); you may not use this file except in compliance
+ *with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *Unless required by applicable law or agreed to in writing,
+ *software distributed under the License is distributed on an
+ *"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ *specific language governing permissions and limitations
+ *under the License.
+ */
+#ifndef REMOTE_CALL_COMPLETION_H_
+#define REMOTE_CALL_COMPLETION_H_
+
+/*
+ * Completion for asynchronous calls on imported (DFI) services.
+ *
+ * A method whose descriptor ends with an async argument, e.g.
+ *   add(DD)D=add(#am=handle;PDD#am=pre;*D#am=async;P)N
+ * returns as soon as the request is sent when a completion is given.
+ * Output arguments are filled in when the reply arrives and then done is called with the
+ * call status (0 on success) from the RSA I/O thread. Output arguments and the completion
+ * must stay valid until done is called. When NULL is given the call is done synchronously.
+ *
+ * done runs on the RSA I/O thread, which also completes all other asynchronous calls. It must not
+ * block and must not release the imported service (ungetService): releasing the last reference of a bundle
+ * waits for its calls still in progress, which can only complete on this same thread, and so deadlocks.
+ * Release the service from another thread instead, for example after done signaled it.
+ * An exported service is always called synchronously: its async argument is a NULL completion.
+ */
+struct remote_call_completion {
+    void *handle;
+    void (*done)(void *handle, int status);
+};
+
+typedef struct remote_call_completion *remote_call_completion_pt;
+
+#endif /* REMOTE_CALL_COMPLETION_H_ */
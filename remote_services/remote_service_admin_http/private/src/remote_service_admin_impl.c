@@ -517,10 +517,8 @@ celix_status_t remoteServiceAdmin_installEndpoint(remote_service_admin_pt admin,
         }
 	}
 
-	hash_map_entry_pt entry = hashMap_getEntry(endpointProperties, (void *) OSGI_FRAMEWORK_SERVICE_ID);
-
-	char* key = hashMapEntry_getKey(entry);
-	char *serviceId = (char *) hashMap_remove(endpointProperties, (void *) OSGI_FRAMEWORK_SERVICE_ID);
+	char *serviceId = strdup(properties_get(endpointProperties, (char *) OSGI_FRAMEWORK_SERVICE_ID));
+	properties_unset(endpointProperties, (char *) OSGI_FRAMEWORK_SERVICE_ID);
 	const char *uuid = NULL;
 
 	char buf[512];
@@ -547,7 +545,6 @@ celix_status_t remoteServiceAdmin_installEndpoint(remote_service_admin_pt admin,
 	remoteServiceAdmin_createEndpointDescription(admin, reference, endpointProperties, interface, &endpointDescription);
 	exportRegistration_setEndpointDescription(registration, endpointDescription);
 
-	free(key);
 	free(serviceId);
 	free(keys);
 
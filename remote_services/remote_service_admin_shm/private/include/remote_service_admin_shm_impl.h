@@ -29,16 +29,20 @@
 
 #include "remote_service_admin_impl.h"
 #include "log_helper.h"
+#include "shm_ring.h"
 
-#define RSA_SHM_MEMSIZE 1310720
 #define RSA_SHM_PATH_PROPERTYNAME "shmPath"
-#define RSA_SEM_PATH_PROPERTYNAME "semPath"
 #define RSA_SHM_FTOK_ID_PROPERTYNAME "shmFtokId"
-#define RSA_SEM_FTOK_ID_PROPERTYNAME "semFtokId"
+#define RSA_SHM_SIZE_PROPERTYNAME "shmSize"
+#define RSA_SHM_MAX_SIZE_PROPERTYNAME "shmMaxSize"
 #define RSA_SHM_DEFAULTPATH "/dev/null"
-#define RSA_SEM_DEFAULTPATH "/dev/null"
 #define RSA_SHM_DEFAULT_FTOK_ID "52"
-#define RSA_SEM_DEFAULT_FTOK_ID "54"
+
+// framework properties for the initial and maximum segment size of exported endpoints
+#define RSA_SHM_SIZE_CONFIG "RSA_SHM_SIZE"
+#define RSA_SHM_MAX_SIZE_CONFIG "RSA_SHM_MAX_SIZE"
+#define RSA_SHM_DEFAULT_SIZE "262144"
+#define RSA_SHM_DEFAULT_MAX_SIZE "67108864"
 
 #define RSA_FILEPATH_LENGTH 255
 
@@ -47,22 +51,16 @@
 #define P_tmpdir "/tmp"
 #endif
 
-union semun {
-    int val; /* Value for SETVAL */
-    struct semid_ds *buf; /* Buffer for IPC_STAT, IPC_SET */
-    unsigned short *array; /* Array for GETALL, SETALL */
-    struct seminfo *__buf; /* Buffer for IPC_INFO */
-};
-
 struct recv_shm_thread {
     remote_service_admin_pt admin;
     endpoint_description_pt endpointDescription;
 };
 
 struct ipc_segment {
-    int semId;
     int shmId;
     void *shmBaseAdress;
+    size_t shmSize;
+    shm_ring_pt ring;
 };
 
 struct remote_service_admin {
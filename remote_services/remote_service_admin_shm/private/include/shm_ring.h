@@ -0,0 +1,104 @@
+/**
+ *Licensed to the Apache Software Foundation (ASF) under one
+ *or more contributor license agreements.  See the NOTICE file
+ *distributed with this work for additional information
+ *regarding copyright ownership.  The ASF licenses this file
+ *to you under the Apache License, Version 2.0 (the
+ *"License"); you may not use this file except in compliance
+ *with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *Unless required by applicable law or agreed to in writing,
+ *software distributed under the License is distributed on an
+ *"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ *specific language governing permissions and limitations
+ *under the License.
+ */
+/*
+ * shm_ring.h
+ *
+ *  \date       Oct 17, 2026
+ *  \author     <a href="mailto:dev@celix.apache.org">Apache Celix Project Team</a>
+ *  \copyright  Apache License, Version 2.0
+ */
+
+#ifndef SHM_RING_H_
+#define SHM_RING_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "celix_errno.h"
+
+/*
+ * Transport layout of a shared memory segment used for remote calls.
+ *
+ * The segment holds a request ring and a reply ring, both made of fixed size slots with
+ * atomic head/tail positions. Callers claim consecutive request slots for their message (a
+ * message larger than a slot spans several slots), so any number of calls can be in flight
+ * until the ring is full. The receiver answers a request by writing the reply into the reply
+ * ring and handing the reply position back through the first request slot. Blocking is done
+ * with futexes on words inside the segment, so it works between processes.
+ *
+ * The payload of a message is contiguous in the segment (a message never wraps around the end of
+ * a ring), so both sides can use it in place: callers and receivers can build their message
+ * directly in the claimed slots (shmRing_beginCall / shmRing_beginReply) and receivers get the
+ * request without copying it out. Payloads are aligned on SHM_RING_ALIGN bytes.
+ *
+ * A ring can grow up to the maximum size given to shmRing_create. When a message does not fit,
+ * the receiver creates a larger segment (the next generation) and links it from the current one.
+ * Both sides follow the chain of generations transparently; the generations stay mapped until
+ * the ring is destroyed.
+ */
+#define SHM_RING_MAGIC 0x43524e47
+#define SHM_RING_VERSION 4
+#define SHM_RING_ALIGN 64
+#define SHM_RING_DEFAULT_SLOT_SIZE 4096
+
+typedef struct shm_ring *shm_ring_pt;
+typedef struct shm_ring_request *shm_ring_request_pt;
+typedef struct shm_ring_call *shm_ring_call_pt;
+
+//formats the segment; the number of slots is derived from the segment and slot size. Messages which
+//do not fit in size bytes let the ring grow into new segments of at most maxSize bytes
+celix_status_t shmRing_create(void *base, size_t size, size_t maxSize, size_t slotSize, shm_ring_pt *ring);
+//attaches to a segment formatted by shmRing_create, fails if the layout does not match
+celix_status_t shmRing_attach(void *base, size_t size, shm_ring_pt *ring);
+void shmRing_destroy(shm_ring_pt ring);
+
+//slot count, generation and segment size of the latest generation
+unsigned int shmRing_getSlotCount(shm_ring_pt ring);
+unsigned int shmRing_getGeneration(shm_ring_pt ring);
+size_t shmRing_getSize(shm_ring_pt ring);
+//the largest message the ring can grow to
+size_t shmRing_getMaxMessageSize(shm_ring_pt ring);
+
+//caller side, blocks until the reply is available. The reply is allocated and must be freed by the caller
+celix_status_t shmRing_call(shm_ring_pt ring, const char *request, size_t length, char **reply, size_t *replyLength);
+
+//zero copy caller side: claims room for a request of at most capacity bytes which is written in buffer
+celix_status_t shmRing_beginCall(shm_ring_pt ring, size_t capacity, shm_ring_call_pt *call, char **buffer);
+//publishes the request and blocks until the reply is available, the reply can be used in place until shmRing_endCall
+celix_status_t shmRing_commitCall(shm_ring_pt ring, shm_ring_call_pt call, size_t length, const char **reply, size_t *replyLength);
+//releases the slots of the call (an uncommitted call is skipped by the receiver)
+void shmRing_endCall(shm_ring_pt ring, shm_ring_call_pt call);
+
+//receiver side, blocks until a request is available or the ring is closed (CELIX_ILLEGAL_STATE)
+celix_status_t shmRing_receive(shm_ring_pt ring, shm_ring_request_pt *request);
+//the request data is in place in the segment ('\0' terminated) and valid until the request is answered
+char *shmRing_requestData(shm_ring_request_pt request);
+size_t shmRing_requestLength(shm_ring_request_pt request);
+//answers and destroys the request, a NULL reply fails the call
+celix_status_t shmRing_reply(shm_ring_pt ring, shm_ring_request_pt request, const char *reply, size_t length);
+
+//zero copy receiver side: claims room for a reply of at most capacity bytes which is written in buffer
+celix_status_t shmRing_beginReply(shm_ring_pt ring, shm_ring_request_pt request, size_t capacity, char **buffer);
+//answers the request with the first length bytes of the buffer and destroys the request
+celix_status_t shmRing_commitReply(shm_ring_pt ring, shm_ring_request_pt request, size_t length);
+
+//wakes up and stops all receivers of the segment
+void shmRing_close(shm_ring_pt ring);
+
+#endif /* SHM_RING_H_ */
@@ -29,7 +29,6 @@
 #include <dirent.h>
 #include <sys/stat.h>
 #include <sys/types.h>
-#include <sys/sem.h>
 #include <sys/ipc.h>
 #include <sys/shm.h>
 #include <unistd.h>
@@ -48,10 +47,6 @@
 #include "service_reference.h"
 #include "service_registration.h"
 
-static celix_status_t remoteServiceAdmin_lock(int semId, int semNr);
-static celix_status_t remoteServiceAdmin_unlock(int semId, int semNr);
-static int remoteServiceAdmin_getCount(int semId, int semNr);
-
 celix_status_t remoteServiceAdmin_installEndpoint(remote_service_admin_pt admin, export_registration_pt registration, service_reference_pt reference, char *interface);
 celix_status_t remoteServiceAdmin_createEndpointDescription(remote_service_admin_pt admin, service_reference_pt reference, properties_pt endpointProperties, char *interface, endpoint_description_pt *description);
 
@@ -159,11 +154,11 @@ celix_status_t remoteServiceAdmin_stop(remote_service_admin_pt admin) {
 	}
 	hashMapIterator_destroy(iter);
 
-	// release lock
+	// wake up the receiving threads
 	iter = hashMapIterator_create(admin->exportedIpcSegment);
 	while (hashMapIterator_hasNext(iter)) {
 		ipc_segment_pt ipc = hashMapIterator_nextValue(iter);
-		remoteServiceAdmin_unlock(ipc->semId, 1);
+		shmRing_close(ipc->ring);
 	}
 	hashMapIterator_destroy(iter);
 
@@ -201,96 +196,18 @@ celix_status_t remoteServiceAdmin_stop(remote_service_admin_pt admin) {
 	return status;
 }
 
-static int remoteServiceAdmin_getCount(int semId, int semNr) {
-	int token = -1;
-	unsigned short semVals[3];
-	union semun semArg;
-
-	semArg.array = semVals;
-
-	if (semctl(semId, 0, GETALL, semArg) == 0) {
-		token = semArg.array[semNr];
-	}
-
-	return token;
-}
-
-static celix_status_t remoteServiceAdmin_lock(int semId, int semNr) {
-	celix_status_t status = CELIX_SUCCESS;
-	int semOpStatus = 0;
-	struct sembuf semOperation;
-
-	semOperation.sem_num = semNr;
-	semOperation.sem_op = -1;
-	semOperation.sem_flg = 0;
-
-	do {
-		status = CELIX_SUCCESS;
-
-		if ((semOpStatus = semop(semId, &semOperation, 1)) != 0) {
-			status = CELIX_BUNDLE_EXCEPTION;
-		}
-	} while (semOpStatus == -1 && errno == EINTR);
-
-	return status;
-}
-
-static celix_status_t remoteServiceAdmin_unlock(int semId, int semNr) {
-	celix_status_t status = CELIX_SUCCESS;
-	int semOpStatus = 0;
-	struct sembuf semOperation;
-
-	semOperation.sem_num = semNr;
-	semOperation.sem_op = 1;
-	semOperation.sem_flg = 0;
-
-	do {
-		status = CELIX_SUCCESS;
-
-		if ((semOpStatus = semop(semId, &semOperation, 1)) != 0) {
-			status = CELIX_BUNDLE_EXCEPTION;
-		}
-	} while (semOpStatus == -1 && errno == EINTR);
-
-	return status;
-}
-
 celix_status_t remoteServiceAdmin_send(remote_service_admin_pt admin, endpoint_description_pt recpEndpoint, char *request, char **reply, int *replyStatus) {
 	celix_status_t status = CELIX_SUCCESS;
 	ipc_segment_pt ipc = NULL;
 
 	if ((ipc = hashMap_get(admin->importedIpcSegment, recpEndpoint->service)) != NULL) {
-		int semid = ipc->semId;
-
-		/* lock critical area */
-		remoteServiceAdmin_lock(semid, 0);
+		// calls of several threads are in flight at the same time, the ring blocks only when it is full
+		status = shmRing_call(ipc->ring, request, strlen(request), reply, NULL);
+		*replyStatus = status;
 
-		/* write method and data */
-		strcpy(ipc->shmBaseAdress, request);
-
-		/* Check the status of the send-receive semaphore and reset them if not correct */
-		if (remoteServiceAdmin_getCount(ipc->semId, 1) > 0) {
-			semctl(semid, 1, SETVAL, (int) 0);
-		}
-		if (remoteServiceAdmin_getCount(ipc->semId, 2) > 0) {
-			semctl(semid, 2, SETVAL, (int) 0);
+		if (status != CELIX_SUCCESS) {
+			logHelper_log(admin->loghelper, OSGI_LOGSERVICE_ERROR, "send : call to %s failed (%d).", recpEndpoint->service, status);
 		}
-
-		/* Inform receiver we are invoking the remote service */
-		remoteServiceAdmin_unlock(semid, 1);
-
-		/* Wait until the receiver finished his operations */
-		remoteServiceAdmin_lock(semid, 2);
-
-		/* read reply */
-		*reply = strdup(ipc->shmBaseAdress);
-
-		/* TODO: fix replyStatus */
-		*replyStatus = 0;
-
-		/* release critical area */
-		remoteServiceAdmin_unlock(semid, 0);
-
 	} else {
 		status = CELIX_ILLEGAL_STATE; /* could not find ipc segment */
 	}
@@ -308,49 +225,41 @@ static void * remoteServiceAdmin_receiveFromSharedMemory(void *data) {
 
 	if ((ipc = hashMap_get(admin->exportedIpcSegment, exportedEndpointDesc->service)) != NULL) {
 		bool *pollThreadRunning = hashMap_get(admin->pollThreadRunning, exportedEndpointDesc);
+		shm_ring_request_pt request = NULL;
 
-		while (*pollThreadRunning == true) {
-			if ((remoteServiceAdmin_lock(ipc->semId, 1) == CELIX_SUCCESS) && (*pollThreadRunning == true)) {
-
-				// TODO: align data size
-				char *data = calloc(1024, sizeof(*data));
-				strcpy(data, ipc->shmBaseAdress);
-
-				hash_map_iterator_pt iter = hashMapIterator_create(admin->exportedServices);
-
-				while (hashMapIterator_hasNext(iter)) {
-					hash_map_entry_pt entry = hashMapIterator_nextEntry(iter);
-					array_list_pt exports = hashMapEntry_getValue(entry);
-					int expIt = 0;
+		while (*pollThreadRunning == true && shmRing_receive(ipc->ring, &request) == CELIX_SUCCESS) {
+			char *reply = NULL;
 
-					for (expIt = 0; expIt < arrayList_size(exports); expIt++) {
-						export_registration_pt export = arrayList_get(exports, expIt);
+			hash_map_iterator_pt iter = hashMapIterator_create(admin->exportedServices);
 
-						if ((strcmp(exportedEndpointDesc->service, export->endpointDescription->service) == 0) && (export->endpoint != NULL)) {
-							char *reply = NULL;
+			while (hashMapIterator_hasNext(iter)) {
+				hash_map_entry_pt entry = hashMapIterator_nextEntry(iter);
+				array_list_pt exports = hashMapEntry_getValue(entry);
+				int expIt = 0;
 
-							/* TODO: fix handling of handleRequest return value*/
-									export->endpoint->handleRequest(export->endpoint->endpoint, data, &reply);
+				for (expIt = 0; expIt < arrayList_size(exports); expIt++) {
+					export_registration_pt export = arrayList_get(exports, expIt);
 
-									if (reply != NULL) {
-										if ((strlen(reply) * sizeof(char)) >= RSA_SHM_MEMSIZE) {
-											logHelper_log(admin->loghelper, OSGI_LOGSERVICE_ERROR, "receiveFromSharedMemory : size of message bigger than shared memory message. NOT SENDING.");
-										} else {
-											strcpy(ipc->shmBaseAdress, reply);
-										}
-										free(reply);
-									}
-						} else {
-							logHelper_log(admin->loghelper, OSGI_LOGSERVICE_ERROR, "receiveFromSharedMemory : No endpoint set for %s.", export->endpointDescription->service);
-						}
+					if ((strcmp(exportedEndpointDesc->service, export->endpointDescription->service) == 0) && (export->endpoint != NULL)) {
+						/* TODO: fix handling of handleRequest return value*/
+						// the request is not copied out of the segment, it is valid until it is answered
+						export->endpoint->handleRequest(export->endpoint->endpoint, shmRing_requestData(request), &reply);
+					} else {
+						logHelper_log(admin->loghelper, OSGI_LOGSERVICE_ERROR, "receiveFromSharedMemory : No endpoint set for %s.", export->endpointDescription->service);
 					}
 				}
-				hashMapIterator_destroy(iter);
-				free(data);
-
-				remoteServiceAdmin_unlock(ipc->semId, 2);
+			}
+			hashMapIterator_destroy(iter);
 
+			if (reply != NULL && strlen(reply) > shmRing_getMaxMessageSize(ipc->ring)) {
+				logHelper_log(admin->loghelper, OSGI_LOGSERVICE_ERROR, "receiveFromSharedMemory : size of message bigger than shared memory message. NOT SENDING.");
+				free(reply);
+				reply = NULL;
 			}
+
+			// a missing reply fails the call instead of leaving the caller waiting
+			shmRing_reply(ipc->ring, request, reply, reply != NULL ? strlen(reply) : 0);
+			free(reply);
 		}
 	}
 
@@ -592,14 +501,13 @@ celix_status_t remoteServiceAdmin_removeExportedService(remote_service_admin_pt
 			if ((ipc = hashMap_get(admin->exportedIpcSegment, registration->endpointDescription->service)) != NULL) {
 				celix_thread_t* pollThread;
 
-				remoteServiceAdmin_unlock(ipc->semId, 1);
+				shmRing_close(ipc->ring);
 
 				if ((pollThread = hashMap_get(admin->pollThread, registration->endpointDescription)) != NULL) {
 					status = celixThread_join(*pollThread, NULL);
 
 					if (status == CELIX_SUCCESS) {
-						semctl(ipc->semId, 1 , IPC_RMID);
-						shmctl(ipc->shmId, IPC_RMID, 0);
+						remoteServiceAdmin_deleteIpcSegment(ipc);
 
 						remoteServiceAdmin_removeSharedIdentityFile(admin, registration->endpointDescription->frameworkUUID, registration->endpointDescription->service);
 
@@ -633,11 +541,16 @@ celix_status_t remoteServiceAdmin_getIpcSegment(remote_service_admin_pt admin, e
 }
 
 celix_status_t remoteServiceAdmin_detachIpcSegment(ipc_segment_pt ipc) {
+	shmRing_destroy(ipc->ring);
+	ipc->ring = NULL;
+
 	return (shmdt(ipc->shmBaseAdress) != -1) ? CELIX_SUCCESS : CELIX_BUNDLE_EXCEPTION;
 }
 
 celix_status_t remoteServiceAdmin_deleteIpcSegment(ipc_segment_pt ipc) {
-	return ((semctl(ipc->semId, 1 /*ignored*/, IPC_RMID) != -1) && (shmctl(ipc->shmId, IPC_RMID, 0) != -1)) ? CELIX_SUCCESS : CELIX_BUNDLE_EXCEPTION;
+	celix_status_t status = remoteServiceAdmin_detachIpcSegment(ipc);
+
+	return ((shmctl(ipc->shmId, IPC_RMID, 0) != -1) && status == CELIX_SUCCESS) ? CELIX_SUCCESS : CELIX_BUNDLE_EXCEPTION;
 }
 
 celix_status_t remoteServiceAdmin_createOrAttachShm(hash_map_pt ipcSegment, remote_service_admin_pt admin, endpoint_description_pt endpointDescription, bool createIfNotFound) {
@@ -651,33 +564,42 @@ celix_status_t remoteServiceAdmin_createOrAttachShm(hash_map_pt ipcSegment, remo
 	char *shmPath = NULL;
 	char *shmFtokId = NULL;
 
-	char *semPath = NULL;
-	char *semFtokId = NULL;
-
 	if ((shmPath = (char*)properties_get(endpointProperties, (char *) RSA_SHM_PATH_PROPERTYNAME)) == NULL) {
 		logHelper_log(admin->loghelper, OSGI_LOGSERVICE_DEBUG, "No value found for key %s in endpointProperties.", RSA_SHM_PATH_PROPERTYNAME);
 		status = CELIX_BUNDLE_EXCEPTION;
 	} else if ((shmFtokId = (char*)properties_get(endpointProperties, (char *) RSA_SHM_FTOK_ID_PROPERTYNAME)) == NULL) {
 		logHelper_log(admin->loghelper, OSGI_LOGSERVICE_DEBUG, "No value found for key %s in endpointProperties.", RSA_SHM_FTOK_ID_PROPERTYNAME);
 		status = CELIX_BUNDLE_EXCEPTION;
-	} else if ((semPath = (char*)properties_get(endpointProperties, (char *) RSA_SEM_PATH_PROPERTYNAME)) == NULL) {
-		logHelper_log(admin->loghelper, OSGI_LOGSERVICE_DEBUG, "No value found for key %s in endpointProperties.", RSA_SEM_PATH_PROPERTYNAME);
-		status = CELIX_BUNDLE_EXCEPTION;
-	} else if ((semFtokId = (char*)properties_get(endpointProperties, (char *) RSA_SEM_FTOK_ID_PROPERTYNAME)) == NULL) {
-		logHelper_log(admin->loghelper, OSGI_LOGSERVICE_DEBUG, "No value found for key %s in endpointProperties.", RSA_SEM_FTOK_ID_PROPERTYNAME);
-		status = CELIX_BUNDLE_EXCEPTION;
 	} else {
 		key_t shmKey = ftok(shmPath, atoi(shmFtokId));
+		size_t shmSize = strtoul(properties_getWithDefault(endpointProperties, RSA_SHM_SIZE_PROPERTYNAME, RSA_SHM_DEFAULT_SIZE), NULL, 10);
+		struct shmid_ds shmInfo;
+
 		ipc = calloc(1, sizeof(*ipc));
 		if(ipc == NULL){
 			return CELIX_ENOMEM;
 		}
 
-		if ((ipc->shmId = shmget(shmKey, RSA_SHM_MEMSIZE, 0666)) < 0) {
+		// the size is taken from the segment itself, so importers do not depend on the endpoint properties
+		if ((ipc->shmId = shmget(shmKey, 0, 0666)) >= 0 && shmctl(ipc->shmId, IPC_STAT, &shmInfo) == 0) {
+			ipc->shmSize = shmInfo.shm_segsz;
+		} else {
+			ipc->shmId = -1;
+		}
+
+		// a segment of an earlier export with another size cannot be reused
+		if (ipc->shmId >= 0 && createIfNotFound == true && ipc->shmSize != shmSize) {
+			logHelper_log(admin->loghelper, OSGI_LOGSERVICE_DEBUG, "removing stale shared memory segment of %zu bytes.", ipc->shmSize);
+			shmctl(ipc->shmId, IPC_RMID, 0);
+			ipc->shmId = -1;
+		}
+
+		if (ipc->shmId < 0) {
 			logHelper_log(admin->loghelper, OSGI_LOGSERVICE_WARNING, "Could not attach to shared memory");
 
 			if (createIfNotFound == true) {
-				if ((ipc->shmId = shmget(shmKey, RSA_SHM_MEMSIZE, IPC_CREAT | 0666)) < 0) {
+				ipc->shmSize = shmSize;
+				if ((ipc->shmId = shmget(shmKey, shmSize, IPC_CREAT | 0666)) < 0) {
 					logHelper_log(admin->loghelper, OSGI_LOGSERVICE_ERROR, "Creation of shared memory segment failed.");
 					status = CELIX_BUNDLE_EXCEPTION;
 				} else if ((ipc->shmBaseAdress = shmat(ipc->shmId, 0, 0)) == (char *) -1) {
@@ -686,6 +608,8 @@ celix_status_t remoteServiceAdmin_createOrAttachShm(hash_map_pt ipcSegment, remo
 				} else {
 					logHelper_log(admin->loghelper, OSGI_LOGSERVICE_INFO, "shared memory segment sucessfully created at %p.", ipc->shmBaseAdress);
 				}
+			} else {
+				status = CELIX_BUNDLE_EXCEPTION;
 			}
 		} else if ((ipc->shmBaseAdress = shmat(ipc->shmId, 0, 0)) == (char *) -1) {
 			logHelper_log(admin->loghelper, OSGI_LOGSERVICE_ERROR, "Attaching to shared memory segment failed.");
@@ -696,24 +620,20 @@ celix_status_t remoteServiceAdmin_createOrAttachShm(hash_map_pt ipcSegment, remo
 	}
 
 	if(ipc != NULL && status == CELIX_SUCCESS){
+		// the exporting side (re)formats the segment, importers only accept a matching layout
+		if (createIfNotFound == true) {
+			size_t shmMaxSize = strtoul(properties_getWithDefault(endpointProperties, RSA_SHM_MAX_SIZE_PROPERTYNAME, RSA_SHM_DEFAULT_MAX_SIZE), NULL, 10);
+			status = shmRing_create(ipc->shmBaseAdress, ipc->shmSize, shmMaxSize, SHM_RING_DEFAULT_SLOT_SIZE, &ipc->ring);
+		} else {
+			status = shmRing_attach(ipc->shmBaseAdress, ipc->shmSize, &ipc->ring);
+		}
 
-		key_t semkey = ftok(semPath, atoi(semFtokId));
-		int semflg = (createIfNotFound == true) ? (0666 | IPC_CREAT) : (0666);
-		int semid = semget(semkey, 3, semflg);
-
-		if (semid != -1) {
-			// only reset semaphores if a create was supposed
-			if ((createIfNotFound == true) && ((semctl(semid, 0, SETVAL, (int) 1) == -1) || (semctl(semid, 1, SETVAL, (int) 0) == -1) || (semctl(semid, 2, SETVAL, (int) 0) == -1))) {
-				logHelper_log(admin->loghelper, OSGI_LOGSERVICE_ERROR, "error while initialize semaphores.");
-			}
-
-			logHelper_log(admin->loghelper, OSGI_LOGSERVICE_DEBUG, "semaphores w/ key %s and id %i added.", endpointDescription->service, semid);
-			ipc->semId = semid;
-
+		if (status == CELIX_SUCCESS) {
+			logHelper_log(admin->loghelper, OSGI_LOGSERVICE_DEBUG, "ring with %u slots of %zu bytes (generation %u) for %s set up.", shmRing_getSlotCount(ipc->ring), ipc->shmSize, shmRing_getGeneration(ipc->ring), endpointDescription->service);
 			hashMap_put(ipcSegment, endpointDescription->service, ipc);
 		} else {
-			logHelper_log(admin->loghelper, OSGI_LOGSERVICE_ERROR, "error getting semaphores.");
-			status = CELIX_BUNDLE_EXCEPTION;
+			logHelper_log(admin->loghelper, OSGI_LOGSERVICE_ERROR, "error while setting up the shared memory ring for %s.", endpointDescription->service);
+			shmdt(ipc->shmBaseAdress);
 		}
 	}
 
@@ -741,10 +661,8 @@ celix_status_t remoteServiceAdmin_installEndpoint(remote_service_admin_pt admin,
 		}
 	}
 
-	hash_map_entry_pt entry = hashMap_getEntry(endpointProperties, (void *) OSGI_FRAMEWORK_SERVICE_ID);
-
-	char* key = hashMapEntry_getKey(entry);
-	char *serviceId = (char *) hashMap_remove(endpointProperties, (void *) OSGI_FRAMEWORK_SERVICE_ID);
+	char *serviceId = strdup(properties_get(endpointProperties, (char *) OSGI_FRAMEWORK_SERVICE_ID));
+	properties_unset(endpointProperties, (char *) OSGI_FRAMEWORK_SERVICE_ID);
 	const char *uuid = NULL;
 
 	uuid_t endpoint_uid;
@@ -772,24 +690,22 @@ celix_status_t remoteServiceAdmin_installEndpoint(remote_service_admin_pt admin,
 	if (properties_get(endpointProperties, (char *) RSA_SHM_FTOK_ID_PROPERTYNAME) == NULL) {
 		properties_set(endpointProperties, (char *) RSA_SHM_FTOK_ID_PROPERTYNAME, (char *) RSA_SHM_DEFAULT_FTOK_ID);
 	}
-	if (properties_get(endpointProperties, (char *) RSA_SEM_PATH_PROPERTYNAME) == NULL) {
-		char sharedIdentifierFile[RSA_FILEPATH_LENGTH];
-
-		if (remoteServiceAdmin_getSharedIdentifierFile(admin, (char*)uuid, interface, sharedIdentifierFile) == CELIX_SUCCESS) {
-			properties_set(endpointProperties, (char *) RSA_SEM_PATH_PROPERTYNAME, sharedIdentifierFile);
-		} else {
-			properties_set(endpointProperties, (char *) RSA_SEM_PATH_PROPERTYNAME, (char *) RSA_SEM_DEFAULTPATH);
-		}
+	// the segment size is negotiated per endpoint, importers attach to whatever the exporter created
+	if (properties_get(endpointProperties, (char *) RSA_SHM_SIZE_PROPERTYNAME) == NULL) {
+		const char *shmSize = NULL;
+		bundleContext_getProperty(admin->context, RSA_SHM_SIZE_CONFIG, &shmSize);
+		properties_set(endpointProperties, (char *) RSA_SHM_SIZE_PROPERTYNAME, (shmSize != NULL) ? shmSize : RSA_SHM_DEFAULT_SIZE);
 	}
-	if (properties_get(endpointProperties, (char *) RSA_SEM_FTOK_ID_PROPERTYNAME) == NULL) {
-		properties_set(endpointProperties, (char *) RSA_SEM_FTOK_ID_PROPERTYNAME, (char *) RSA_SEM_DEFAULT_FTOK_ID);
+	if (properties_get(endpointProperties, (char *) RSA_SHM_MAX_SIZE_PROPERTYNAME) == NULL) {
+		const char *shmMaxSize = NULL;
+		bundleContext_getProperty(admin->context, RSA_SHM_MAX_SIZE_CONFIG, &shmMaxSize);
+		properties_set(endpointProperties, (char *) RSA_SHM_MAX_SIZE_PROPERTYNAME, (shmMaxSize != NULL) ? shmMaxSize : RSA_SHM_DEFAULT_MAX_SIZE);
 	}
 
 	endpoint_description_pt endpointDescription = NULL;
 	remoteServiceAdmin_createEndpointDescription(admin, reference, endpointProperties, interface, &endpointDescription);
 	exportRegistration_setEndpointDescription(registration, endpointDescription);
 
-	free(key);
 	free(serviceId);
 	free(keys);
 
@@ -0,0 +1,887 @@
+/**
+ *Licensed to the Apache Software Foundation (ASF) under one
+ *or more contributor license agreements.  See the NOTICE file
+ *distributed with this work for additional information
+ *regarding copyright ownership.  The ASF licenses this file
+ *to you under the Apache License, Version 2.0 (the
+ *"License"); you may not use this file except in compliance
+ *with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *Unless required by applicable law or agreed to in writing,
+ *software distributed under the License is distributed on an
+ *"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ *specific language governing permissions and limitations
+ *under the License.
+ */
+/*
+ * shm_ring.c
+ *
+ *  \date       Oct 17, 2026
+ *  \author     <a href="mailto:dev@celix.apache.org">Apache Celix Project Team</a>
+ *  \copyright  Apache License, Version 2.0
+ */
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include "celix_threads.h"
+#include "shm_ring.h"
+
+#define SHM_RING_CACHELINE 64
+#define SHM_RING_SLOT_HEADER_SIZE 64
+#define SHM_RING_SPIN_COUNT 2000
+#define SHM_RING_WAIT_TIMEOUT_NS 100000000
+
+#define SHM_RING_STATE_PENDING 0
+#define SHM_RING_STATE_REPLIED 1
+#define SHM_RING_STATE_FAILED 2
+
+#define SHM_RING_FLAG_PADDING 0x1
+
+/*
+ * Everything below lives in the shared segment. A slot is free for position pos when its seq
+ * equals pos, published when it equals pos + 1 and released (free for the next lap) when it
+ * equals pos + slotCount. The slot count is a power of two so positions can wrap around.
+ * The slot headers are kept apart from the payloads, so the payload of a message spanning
+ * several slots is contiguous. Where a message would wrap around, the slots up to the end of
+ * the ring are skipped with a padding message.
+ */
+struct shm_ring_event {
+	uint32_t value; //futex word
+	uint32_t waiters;
+};
+
+struct shm_ring_slot {
+	uint32_t seq;
+	//only set in the first slot of a message
+	uint32_t flags;
+	uint32_t count;
+	uint32_t length;
+	uint32_t replyGeneration;
+	uint32_t replyPos;
+	uint32_t replyCount;
+	uint32_t replyLength;
+	struct shm_ring_event state;
+};
+
+struct shm_ring_queue {
+	uint32_t head __attribute__((aligned(SHM_RING_CACHELINE)));
+	uint32_t tail __attribute__((aligned(SHM_RING_CACHELINE)));
+	struct shm_ring_event published __attribute__((aligned(SHM_RING_CACHELINE)));
+	struct shm_ring_event released __attribute__((aligned(SHM_RING_CACHELINE)));
+	uint32_t offset; //slot headers
+	uint32_t dataOffset;
+};
+
+/*
+ * Growth: a caller which needs a larger message than the segment can hold raises requestedCapacity.
+ * The receiver then creates the next generation (a private SysV segment) and announces it through
+ * successor and moved. New calls go to the successor while the receiver drains the requests already
+ * in the old segment; replies which do not fit in the old segment are put in the successor as well.
+ * Old generations stay attached until the ring is destroyed, so every process follows the chain at
+ * its own pace. A failed growth is announced through failedCapacity and growFailures; only callers
+ * which were waiting for that attempt give up, later callers request growth again.
+ */
+struct shm_ring_header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t slotCount;
+	uint32_t slotSize;
+	uint32_t size;
+	uint32_t maxSize;
+	uint32_t generation;
+	uint32_t closed;
+	uint32_t requestedCapacity;
+	uint32_t failedCapacity; //capacity of the last failed growth attempt
+	uint32_t growFailures; //number of failed growth attempts
+	int32_t successor; //shm id of the next generation
+	uint32_t moved;
+	struct shm_ring_event movedEvent;
+	struct shm_ring_queue requests;
+	struct shm_ring_queue replies;
+};
+
+struct shm_ring_generation {
+	char *base;
+	struct shm_ring_header *header;
+	uint32_t mask;
+	size_t slotSize;
+	int shmId; //-1 for the segment given to shmRing_create/shmRing_attach
+	struct shm_ring_generation *next;
+};
+
+struct shm_ring {
+	bool receiver;
+	celix_thread_mutex_t lock; //attaching and creating generations
+	struct shm_ring_generation *first;
+	struct shm_ring_generation *latest; //where new calls go
+	struct shm_ring_generation *receiving; //the generation the receiver drains
+};
+
+struct shm_ring_request {
+	struct shm_ring_generation *gen;
+	uint32_t pos;
+	size_t length;
+	char *data;
+	struct shm_ring_generation *replyGen;
+	uint32_t replyPos;
+	uint32_t replyCount;
+	size_t replyCapacity;
+};
+
+struct shm_ring_call {
+	struct shm_ring_generation *gen;
+	uint32_t pos;
+	uint32_t count;
+	size_t capacity;
+	bool committed;
+	struct shm_ring_generation *replyGen;
+	uint32_t replyPos;
+	uint32_t replyCount;
+};
+
+static celix_status_t shmRing_format(void *base, size_t size, size_t maxSize, size_t slotSize, uint32_t generation);
+static celix_status_t shmRing_initGeneration(void *base, size_t size, int shmId, struct shm_ring_generation **gen);
+static struct shm_ring_generation *shmRing_next(shm_ring_pt ring, struct shm_ring_generation *gen);
+static struct shm_ring_generation *shmRing_latest(shm_ring_pt ring);
+static celix_status_t shmRing_grow(shm_ring_pt ring, struct shm_ring_generation *gen, size_t capacity);
+static celix_status_t shmRing_requestGrowth(struct shm_ring_generation *gen, size_t capacity);
+static celix_status_t shmRing_claim(struct shm_ring_generation *gen, struct shm_ring_queue *queue, uint32_t count, bool requests, uint32_t *pos, bool *moved);
+static void shmRing_publish(struct shm_ring_generation *gen, struct shm_ring_queue *queue, uint32_t pos, uint32_t count, uint32_t flags, size_t length);
+static void shmRing_release(struct shm_ring_generation *gen, struct shm_ring_queue *queue, uint32_t pos, uint32_t count);
+static void shmRing_answer(shm_ring_request_pt request, uint32_t state, size_t length);
+
+static inline struct shm_ring_slot *shmRing_slot(struct shm_ring_generation *gen, struct shm_ring_queue *queue, uint32_t pos) {
+	return (struct shm_ring_slot *) (gen->base + queue->offset + (size_t) (pos & gen->mask) * SHM_RING_SLOT_HEADER_SIZE);
+}
+
+static inline char *shmRing_data(struct shm_ring_generation *gen, struct shm_ring_queue *queue, uint32_t pos) {
+	return gen->base + queue->dataOffset + (size_t) (pos & gen->mask) * gen->slotSize;
+}
+
+//room for the '\0' terminator is always reserved
+static inline uint32_t shmRing_slotsFor(size_t slotSize, size_t capacity) {
+	return (uint32_t) ((capacity + slotSize) / slotSize);
+}
+
+static inline size_t shmRing_maxMessage(struct shm_ring_generation *gen) {
+	return (gen->mask + 1) * gen->slotSize - 1;
+}
+
+static inline size_t shmRing_headerSize(void) {
+	return (sizeof(struct shm_ring_header) + SHM_RING_ALIGN - 1) & ~((size_t) SHM_RING_ALIGN - 1);
+}
+
+//segment size needed for a message of capacity bytes
+static size_t shmRing_sizeFor(size_t slotSize, size_t capacity) {
+	size_t slotCount = 2;
+	while (slotCount < shmRing_slotsFor(slotSize, capacity)) {
+		slotCount *= 2;
+	}
+	return shmRing_headerSize() + 2 * slotCount * (SHM_RING_SLOT_HEADER_SIZE + slotSize);
+}
+
+static inline bool shmRing_isClosed(struct shm_ring_generation *gen) {
+	return __atomic_load_n(&gen->header->closed, __ATOMIC_ACQUIRE) != 0;
+}
+
+static inline bool shmRing_isMoved(struct shm_ring_generation *gen) {
+	return __atomic_load_n(&gen->header->moved, __ATOMIC_SEQ_CST) != 0;
+}
+
+static inline void shmRing_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#else
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+#endif
+}
+
+static inline uint32_t shmRing_eventValue(struct shm_ring_event *event) {
+	return __atomic_load_n(&event->value, __ATOMIC_SEQ_CST);
+}
+
+static void shmRing_eventNotify(struct shm_ring_event *event) {
+	if (__atomic_load_n(&event->waiters, __ATOMIC_SEQ_CST) > 0) {
+		syscall(SYS_futex, &event->value, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+	}
+}
+
+static void shmRing_eventSignal(struct shm_ring_event *event) {
+	__atomic_add_fetch(&event->value, 1, __ATOMIC_SEQ_CST);
+	shmRing_eventNotify(event);
+}
+
+//spins for a while before sleeping, the timeout makes sure a closed ring is noticed
+static void shmRing_eventWait(struct shm_ring_event *event, uint32_t seen, unsigned int *spins) {
+	if (*spins < SHM_RING_SPIN_COUNT) {
+		(*spins)++;
+		shmRing_relax();
+	} else {
+		struct timespec timeout = { 0, SHM_RING_WAIT_TIMEOUT_NS };
+		__atomic_add_fetch(&event->waiters, 1, __ATOMIC_SEQ_CST);
+		syscall(SYS_futex, &event->value, FUTEX_WAIT, seen, &timeout, NULL, 0);
+		__atomic_sub_fetch(&event->waiters, 1, __ATOMIC_SEQ_CST);
+	}
+}
+
+static void shmRing_initQueue(char *base, struct shm_ring_queue *queue, uint32_t slotCount, size_t offset, size_t dataOffset) {
+	queue->offset = (uint32_t) offset;
+	queue->dataOffset = (uint32_t) dataOffset;
+	for (uint32_t i = 0; i < slotCount; i++) {
+		struct shm_ring_slot *slot = (struct shm_ring_slot *) (base + offset + (size_t) i * SHM_RING_SLOT_HEADER_SIZE);
+		memset(slot, 0, SHM_RING_SLOT_HEADER_SIZE);
+		slot->seq = i;
+	}
+}
+
+static celix_status_t shmRing_format(void *base, size_t size, size_t maxSize, size_t slotSize, uint32_t generation) {
+	celix_status_t status = CELIX_SUCCESS;
+	size_t headerSize = shmRing_headerSize();
+	uint32_t slotCount = 0;
+
+	if (base == NULL || ((uintptr_t) base % SHM_RING_ALIGN) != 0 || slotSize == 0 || slotSize % SHM_RING_ALIGN != 0
+			|| size < headerSize || size > UINT32_MAX) {
+		status = CELIX_ILLEGAL_ARGUMENT;
+	} else {
+		size_t available = (size - headerSize) / (2 * (SHM_RING_SLOT_HEADER_SIZE + slotSize));
+		slotCount = 1;
+		while ((size_t) slotCount * 2 <= available) {
+			slotCount *= 2;
+		}
+		if (available < 2) {
+			status = CELIX_ILLEGAL_ARGUMENT;
+		}
+	}
+
+	if (status == CELIX_SUCCESS) {
+		struct shm_ring_header *header = base;
+		size_t headers = (size_t) slotCount * SHM_RING_SLOT_HEADER_SIZE;
+		size_t data = (size_t) slotCount * slotSize;
+
+		memset(header, 0, headerSize);
+		header->version = SHM_RING_VERSION;
+		header->slotCount = slotCount;
+		header->slotSize = (uint32_t) slotSize;
+		header->size = (uint32_t) size;
+		header->maxSize = (uint32_t) (maxSize > UINT32_MAX ? UINT32_MAX : (maxSize < size ? size : maxSize));
+		header->generation = generation;
+		header->successor = -1;
+
+		shmRing_initQueue(base, &header->requests, slotCount, headerSize, headerSize + 2 * headers);
+		shmRing_initQueue(base, &header->replies, slotCount, headerSize + headers, headerSize + 2 * headers + data);
+
+		__atomic_store_n(&header->magic, SHM_RING_MAGIC, __ATOMIC_RELEASE);
+	}
+
+	return status;
+}
+
+static celix_status_t shmRing_initGeneration(void *base, size_t size, int shmId, struct shm_ring_generation **out) {
+	celix_status_t status = CELIX_SUCCESS;
+	struct shm_ring_header *header = base;
+
+	if (base == NULL || size < sizeof(*header)) {
+		status = CELIX_ILLEGAL_ARGUMENT;
+	} else if (__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) != SHM_RING_MAGIC || header->version != SHM_RING_VERSION) {
+		status = CELIX_ILLEGAL_STATE;
+	} else if (header->slotCount < 2 || (header->slotCount & (header->slotCount - 1)) != 0 || header->slotSize == 0
+			|| header->slotSize % SHM_RING_ALIGN != 0
+			|| header->replies.dataOffset + (size_t) header->slotCount * header->slotSize > size) {
+		status = CELIX_ILLEGAL_STATE;
+	}
+
+	if (status == CELIX_SUCCESS) {
+		struct shm_ring_generation *gen = calloc(1, sizeof(*gen));
+		if (gen == NULL) {
+			status = CELIX_ENOMEM;
+		} else {
+			gen->base = base;
+			gen->header = header;
+			gen->mask = header->slotCount - 1;
+			gen->slotSize = header->slotSize;
+			gen->shmId = shmId;
+			*out = gen;
+		}
+	}
+
+	return status;
+}
+
+static celix_status_t shmRing_open(void *base, size_t size, bool receiver, shm_ring_pt *out) {
+	celix_status_t status = CELIX_SUCCESS;
+	shm_ring_pt ring = calloc(1, sizeof(*ring));
+
+	if (ring == NULL) {
+		status = CELIX_ENOMEM;
+	} else {
+		status = shmRing_initGeneration(base, size, -1, &ring->first);
+	}
+
+	if (status == CELIX_SUCCESS) {
+		ring->receiver = receiver;
+		ring->latest = ring->first;
+		ring->receiving = ring->first;
+		celixThreadMutex_create(&ring->lock, NULL);
+		*out = ring;
+	} else {
+		free(ring);
+	}
+
+	return status;
+}
+
+celix_status_t shmRing_create(void *base, size_t size, size_t maxSize, size_t slotSize, shm_ring_pt *ring) {
+	celix_status_t status = shmRing_format(base, size, maxSize, slotSize, 0);
+
+	if (status == CELIX_SUCCESS) {
+		status = shmRing_open(base, size, true, ring);
+	}
+
+	return status;
+}
+
+celix_status_t shmRing_attach(void *base, size_t size, shm_ring_pt *ring) {
+	return shmRing_open(base, size, false, ring);
+}
+
+void shmRing_destroy(shm_ring_pt ring) {
+	struct shm_ring_generation *gen = ring->first;
+
+	while (gen != NULL) {
+		struct shm_ring_generation *next = gen->next;
+		if (gen->shmId >= 0) {
+			shmdt(gen->base);
+			if (ring->receiver) {
+				shmctl(gen->shmId, IPC_RMID, NULL);
+			}
+		}
+		free(gen);
+		gen = next;
+	}
+
+	celixThreadMutex_destroy(&ring->lock);
+	free(ring);
+}
+
+unsigned int shmRing_getSlotCount(shm_ring_pt ring) {
+	return shmRing_latest(ring)->mask + 1;
+}
+
+unsigned int shmRing_getGeneration(shm_ring_pt ring) {
+	return shmRing_latest(ring)->header->generation;
+}
+
+size_t shmRing_getSize(shm_ring_pt ring) {
+	return shmRing_latest(ring)->header->size;
+}
+
+size_t shmRing_getMaxMessageSize(shm_ring_pt ring) {
+	struct shm_ring_header *header = ring->first->header;
+	size_t available = (header->maxSize - shmRing_headerSize()) / (2 * (SHM_RING_SLOT_HEADER_SIZE + header->slotSize));
+	size_t slotCount = 1;
+
+	while (slotCount * 2 <= available) {
+		slotCount *= 2;
+	}
+
+	return slotCount * header->slotSize - 1;
+}
+
+void shmRing_close(shm_ring_pt ring) {
+	for (struct shm_ring_generation *gen = ring->first; gen != NULL; gen = shmRing_next(ring, gen)) {
+		__atomic_store_n(&gen->header->closed, 1, __ATOMIC_RELEASE);
+		shmRing_eventSignal(&gen->header->requests.published);
+		shmRing_eventSignal(&gen->header->requests.released);
+		shmRing_eventSignal(&gen->header->replies.released);
+		shmRing_eventSignal(&gen->header->movedEvent);
+	}
+}
+
+//returns the next generation, attaching it when it was created by another process
+static struct shm_ring_generation *shmRing_next(shm_ring_pt ring, struct shm_ring_generation *gen) {
+	struct shm_ring_generation *next = __atomic_load_n(&gen->next, __ATOMIC_ACQUIRE);
+
+	if (next == NULL && shmRing_isMoved(gen)) {
+		celixThreadMutex_lock(&ring->lock);
+		if (gen->next == NULL) {
+			int shmId = gen->header->successor;
+			struct shmid_ds info;
+			void *base = NULL;
+
+			if (shmctl(shmId, IPC_STAT, &info) == 0 && (base = shmat(shmId, NULL, 0)) != (void *) -1) {
+				if (shmRing_initGeneration(base, info.shm_segsz, shmId, &next) == CELIX_SUCCESS) {
+					__atomic_store_n(&gen->next, next, __ATOMIC_RELEASE);
+				} else {
+					shmdt(base);
+				}
+			}
+		}
+		next = gen->next;
+		celixThreadMutex_unlock(&ring->lock);
+	}
+
+	return next;
+}
+
+static struct shm_ring_generation *shmRing_latest(shm_ring_pt ring) {
+	struct shm_ring_generation *gen = __atomic_load_n(&ring->latest, __ATOMIC_ACQUIRE);
+	struct shm_ring_generation *next = NULL;
+
+	if (shmRing_isMoved(gen)) {
+		while ((next = shmRing_next(ring, gen)) != NULL) {
+			gen = next;
+		}
+		__atomic_store_n(&ring->latest, gen, __ATOMIC_RELEASE);
+	}
+
+	return gen;
+}
+
+//receiver side, creates the generation following gen which can hold a message of capacity bytes
+static celix_status_t shmRing_grow(shm_ring_pt ring, struct shm_ring_generation *gen, size_t capacity) {
+	celix_status_t status = CELIX_SUCCESS;
+	struct shm_ring_header *header = gen->header;
+	size_t size = shmRing_sizeFor(gen->slotSize, capacity);
+	struct shm_ring_generation *next = NULL;
+	void *base = (void *) -1;
+	int shmId = -1;
+
+	if (size > header->maxSize) {
+		status = CELIX_ILLEGAL_ARGUMENT;
+	} else {
+		//double at least, so a slowly growing message size does not lead to a long chain
+		if (size < 2 * (size_t) header->size) {
+			size = 2 * (size_t) header->size < header->maxSize ? 2 * (size_t) header->size : header->maxSize;
+		}
+		if ((shmId = shmget(IPC_PRIVATE, size, IPC_CREAT | 0666)) < 0 || (base = shmat(shmId, NULL, 0)) == (void *) -1) {
+			status = CELIX_ENOMEM;
+		} else {
+			status = shmRing_format(base, size, header->maxSize, gen->slotSize, header->generation + 1);
+			if (status == CELIX_SUCCESS) {
+				status = shmRing_initGeneration(base, size, shmId, &next);
+			}
+		}
+	}
+
+	//reset the request first, a caller which sees the failure of this attempt may request again
+	__atomic_store_n(&header->requestedCapacity, 0, __ATOMIC_SEQ_CST);
+	if (status == CELIX_SUCCESS) {
+		celixThreadMutex_lock(&ring->lock);
+		gen->next = next;
+		header->successor = shmId;
+		__atomic_store_n(&header->failedCapacity, 0, __ATOMIC_SEQ_CST);
+		__atomic_store_n(&header->moved, 1, __ATOMIC_SEQ_CST);
+		celixThreadMutex_unlock(&ring->lock);
+	} else {
+		if (base != (void *) -1) {
+			shmdt(base);
+		}
+		if (shmId >= 0) {
+			shmctl(shmId, IPC_RMID, NULL);
+		}
+		__atomic_store_n(&header->failedCapacity, (uint32_t) capacity, __ATOMIC_SEQ_CST);
+		__atomic_add_fetch(&header->growFailures, 1, __ATOMIC_SEQ_CST);
+	}
+
+	shmRing_eventSignal(&header->movedEvent);
+	shmRing_eventSignal(&header->requests.released);
+
+	return status;
+}
+
+//caller side, asks the receiver for a larger generation and waits until it is there
+static celix_status_t shmRing_requestGrowth(struct shm_ring_generation *gen, size_t capacity) {
+	struct shm_ring_header *header = gen->header;
+	unsigned int spins = 0;
+
+	if (shmRing_sizeFor(gen->slotSize, capacity) > header->maxSize) {
+		return CELIX_ILLEGAL_ARGUMENT;
+	}
+
+	for (;;) {
+		//only failures of attempts made after this point concern this request
+		uint32_t failures = __atomic_load_n(&header->growFailures, __ATOMIC_SEQ_CST);
+		uint32_t requested = __atomic_load_n(&header->requestedCapacity, __ATOMIC_SEQ_CST);
+		bool retry = false;
+
+		while (requested < capacity && !__atomic_compare_exchange_n(&header->requestedCapacity, &requested, (uint32_t) capacity, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)) {
+			//requested is updated by the failed exchange
+		}
+		shmRing_eventSignal(&header->requests.published);
+
+		while (!retry) {
+			uint32_t seen = shmRing_eventValue(&header->movedEvent);
+
+			if (shmRing_isMoved(gen)) {
+				return CELIX_SUCCESS;
+			} else if (__atomic_load_n(&header->growFailures, __ATOMIC_SEQ_CST) != failures) {
+				if (__atomic_load_n(&header->failedCapacity, __ATOMIC_SEQ_CST) <= capacity) {
+					return CELIX_ENOMEM;
+				}
+				//a larger request failed and took this one with it, ask again
+				retry = true;
+			} else if (shmRing_isClosed(gen)) {
+				return CELIX_ILLEGAL_STATE;
+			} else {
+				shmRing_eventWait(&header->movedEvent, seen, &spins);
+			}
+		}
+	}
+}
+
+/*
+ * Claims count consecutive slots which do not wrap around the end of the ring. The slots
+ * skipped to get there are published as padding when the queue is consumed in order
+ * (requests) or released directly otherwise (replies). Requests are not claimed in a
+ * generation which has moved, moved is set instead.
+ */
+static celix_status_t shmRing_claim(struct shm_ring_generation *gen, struct shm_ring_queue *queue, uint32_t count, bool requests, uint32_t *pos, bool *moved) {
+	unsigned int spins = 0;
+
+	for (;;) {
+		uint32_t seen = shmRing_eventValue(&queue->released);
+		uint32_t head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+		uint32_t index = head & gen->mask;
+		uint32_t padding = index + count > gen->mask + 1 ? gen->mask + 1 - index : 0;
+		uint32_t claim = padding > 0 ? padding : count;
+		bool available = true;
+
+		if (requests && shmRing_isMoved(gen)) {
+			*moved = true;
+			return CELIX_SUCCESS;
+		}
+
+		for (uint32_t i = 0; i < claim && available; i++) {
+			available = __atomic_load_n(&shmRing_slot(gen, queue, head + i)->seq, __ATOMIC_ACQUIRE) == head + i;
+		}
+
+		if (available) {
+			if (__atomic_compare_exchange_n(&queue->head, &head, head + claim, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+				if (requests) {
+					//the receiver stops draining once it has seen the move and all claimed slots
+					if (padding == 0 && shmRing_isMoved(gen)) {
+						shmRing_publish(gen, queue, head, count, SHM_RING_FLAG_PADDING, 0);
+						*moved = true;
+						return CELIX_SUCCESS;
+					} else if (padding > 0) {
+						shmRing_publish(gen, queue, head, padding, SHM_RING_FLAG_PADDING, 0);
+					}
+				} else if (padding > 0) {
+					shmRing_release(gen, queue, head, padding);
+				}
+
+				if (padding == 0) {
+					*pos = head;
+					return CELIX_SUCCESS;
+				}
+			}
+		} else if (shmRing_isClosed(gen)) {
+			return CELIX_ILLEGAL_STATE;
+		} else {
+			shmRing_eventWait(&queue->released, seen, &spins);
+		}
+	}
+}
+
+//publishes the claimed slots, the first slot last
+static void shmRing_publish(struct shm_ring_generation *gen, struct shm_ring_queue *queue, uint32_t pos, uint32_t count, uint32_t flags, size_t length) {
+	struct shm_ring_slot *first = shmRing_slot(gen, queue, pos);
+	first->flags = flags;
+	first->count = count;
+	first->length = (uint32_t) length;
+
+	for (uint32_t i = count; i > 0; i--) {
+		__atomic_store_n(&shmRing_slot(gen, queue, pos + i - 1)->seq, pos + i, __ATOMIC_RELEASE);
+	}
+	shmRing_eventSignal(&queue->published);
+}
+
+static void shmRing_release(struct shm_ring_generation *gen, struct shm_ring_queue *queue, uint32_t pos, uint32_t count) {
+	for (uint32_t i = 0; i < count; i++) {
+		__atomic_store_n(&shmRing_slot(gen, queue, pos + i)->seq, pos + i + gen->mask + 1, __ATOMIC_RELEASE);
+	}
+	shmRing_eventSignal(&queue->released);
+}
+
+celix_status_t shmRing_beginCall(shm_ring_pt ring, size_t capacity, shm_ring_call_pt *out, char **buffer) {
+	celix_status_t status = CELIX_SUCCESS;
+	shm_ring_call_pt call = NULL;
+
+	if (capacity > shmRing_getMaxMessageSize(ring)) {
+		return CELIX_ILLEGAL_ARGUMENT;
+	} else if ((call = calloc(1, sizeof(*call))) == NULL) {
+		return CELIX_ENOMEM;
+	}
+
+	call->capacity = capacity;
+	for (;;) {
+		struct shm_ring_generation *gen = shmRing_latest(ring);
+		bool moved = false;
+
+		if (capacity > shmRing_maxMessage(gen)) {
+			status = shmRing_requestGrowth(gen, capacity);
+		} else {
+			call->gen = gen;
+			call->count = shmRing_slotsFor(gen->slotSize, capacity);
+			status = shmRing_claim(gen, &gen->header->requests, call->count, true, &call->pos, &moved);
+			if (status == CELIX_SUCCESS && !moved) {
+				break;
+			}
+		}
+
+		if (status != CELIX_SUCCESS) {
+			free(call);
+			return status;
+		}
+	}
+
+	struct shm_ring_slot *first = shmRing_slot(call->gen, &call->gen->header->requests, call->pos);
+	__atomic_store_n(&first->state.value, SHM_RING_STATE_PENDING, __ATOMIC_RELAXED);
+	*buffer = shmRing_data(call->gen, &call->gen->header->requests, call->pos);
+	*out = call;
+
+	return status;
+}
+
+celix_status_t shmRing_commitCall(shm_ring_pt ring, shm_ring_call_pt call, size_t length, const char **reply, size_t *replyLength) {
+	struct shm_ring_generation *gen = call->gen;
+	struct shm_ring_queue *requests = &gen->header->requests;
+	struct shm_ring_slot *first = shmRing_slot(gen, requests, call->pos);
+	unsigned int spins = 0;
+	uint32_t state;
+
+	if (call->committed || length > call->capacity) {
+		return CELIX_ILLEGAL_ARGUMENT;
+	}
+
+	shmRing_data(gen, requests, call->pos)[length] = '\0';
+	shmRing_publish(gen, requests, call->pos, call->count, 0, length);
+	call->committed = true;
+
+	while ((state = __atomic_load_n(&first->state.value, __ATOMIC_ACQUIRE)) == SHM_RING_STATE_PENDING) {
+		if (shmRing_isClosed(gen)) {
+			return CELIX_ILLEGAL_STATE;
+		}
+		shmRing_eventWait(&first->state, SHM_RING_STATE_PENDING, &spins);
+	}
+
+	if (state != SHM_RING_STATE_REPLIED) {
+		return CELIX_BUNDLE_EXCEPTION;
+	}
+
+	//a reply too large for this generation is put in a later one
+	struct shm_ring_generation *replyGen = gen;
+	while (replyGen != NULL && replyGen->header->generation != first->replyGeneration) {
+		replyGen = shmRing_next(ring, replyGen);
+	}
+	if (replyGen == NULL) {
+		return CELIX_BUNDLE_EXCEPTION;
+	}
+
+	call->replyGen = replyGen;
+	call->replyPos = first->replyPos;
+	call->replyCount = first->replyCount;
+	*reply = shmRing_data(replyGen, &replyGen->header->replies, call->replyPos);
+	if (replyLength != NULL) {
+		*replyLength = first->replyLength;
+	}
+
+	return CELIX_SUCCESS;
+}
+
+void shmRing_endCall(shm_ring_pt ring, shm_ring_call_pt call) {
+	if (!call->committed) {
+		//the receiver consumes the slots in order, so an unused claim is handed over as padding
+		shmRing_publish(call->gen, &call->gen->header->requests, call->pos, call->count, SHM_RING_FLAG_PADDING, 0);
+	} else {
+		if (call->replyGen != NULL && call->replyCount > 0) {
+			shmRing_release(call->replyGen, &call->replyGen->header->replies, call->replyPos, call->replyCount);
+		}
+		shmRing_release(call->gen, &call->gen->header->requests, call->pos, call->count);
+	}
+	free(call);
+}
+
+celix_status_t shmRing_call(shm_ring_pt ring, const char *request, size_t length, char **reply, size_t *replyLength) {
+	shm_ring_call_pt call = NULL;
+	char *buffer = NULL;
+	celix_status_t status = shmRing_beginCall(ring, length, &call, &buffer);
+
+	if (status == CELIX_SUCCESS) {
+		const char *data = NULL;
+		size_t dataLength = 0;
+
+		memcpy(buffer, request, length);
+		status = shmRing_commitCall(ring, call, length, &data, &dataLength);
+		if (status == CELIX_SUCCESS) {
+			*reply = malloc(dataLength + 1);
+			if (*reply == NULL) {
+				status = CELIX_ENOMEM;
+			} else {
+				memcpy(*reply, data, dataLength + 1);
+				if (replyLength != NULL) {
+					*replyLength = dataLength;
+				}
+			}
+		}
+
+		//after a close the receiver is gone, the slots are left as is since the segment is torn down
+		if (status != CELIX_ILLEGAL_STATE) {
+			shmRing_endCall(ring, call);
+		} else {
+			free(call);
+		}
+	}
+
+	return status;
+}
+
+celix_status_t shmRing_receive(shm_ring_pt ring, shm_ring_request_pt *out) {
+	unsigned int spins = 0;
+
+	for (;;) {
+		struct shm_ring_generation *gen = ring->receiving;
+		struct shm_ring_queue *requests = &gen->header->requests;
+		uint32_t seen = shmRing_eventValue(&requests->published);
+		uint32_t requested = __atomic_load_n(&gen->header->requestedCapacity, __ATOMIC_SEQ_CST);
+		uint32_t tail = __atomic_load_n(&requests->tail, __ATOMIC_ACQUIRE);
+		struct shm_ring_slot *first = shmRing_slot(gen, requests, tail);
+
+		if (shmRing_isClosed(gen)) {
+			return CELIX_ILLEGAL_STATE;
+		} else if (requested > shmRing_maxMessage(gen) && !shmRing_isMoved(gen)) {
+			shmRing_grow(ring, gen, requested);
+		} else if (__atomic_load_n(&first->seq, __ATOMIC_ACQUIRE) == tail + 1) {
+			uint32_t count = first->count;
+			uint32_t flags = first->flags;
+
+			if (__atomic_compare_exchange_n(&requests->tail, &tail, tail + count, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+				if ((flags & SHM_RING_FLAG_PADDING) != 0) {
+					shmRing_release(gen, requests, tail, count);
+				} else {
+					shm_ring_request_pt request = calloc(1, sizeof(*request));
+					if (request == NULL) {
+						first->replyCount = 0;
+						__atomic_store_n(&first->state.value, SHM_RING_STATE_FAILED, __ATOMIC_SEQ_CST);
+						shmRing_eventNotify(&first->state);
+						return CELIX_ENOMEM;
+					}
+					request->gen = gen;
+					request->pos = tail;
+					request->length = first->length;
+					request->data = shmRing_data(gen, requests, tail);
+					*out = request;
+					return CELIX_SUCCESS;
+				}
+			}
+		} else if (shmRing_isMoved(gen) && tail == __atomic_load_n(&requests->head, __ATOMIC_SEQ_CST) && gen->next != NULL) {
+			//drained, continue with the next generation
+			ring->receiving = gen->next;
+			spins = 0;
+		} else {
+			shmRing_eventWait(&requests->published, seen, &spins);
+		}
+	}
+}
+
+char *shmRing_requestData(shm_ring_request_pt request) {
+	return request->data;
+}
+
+size_t shmRing_requestLength(shm_ring_request_pt request) {
+	return request->length;
+}
+
+celix_status_t shmRing_beginReply(shm_ring_pt ring, shm_ring_request_pt request, size_t capacity, char **buffer) {
+	celix_status_t status = CELIX_SUCCESS;
+	struct shm_ring_generation *gen = request->gen;
+
+	if (request->replyCount > 0 || capacity > shmRing_getMaxMessageSize(ring)) {
+		return CELIX_ILLEGAL_ARGUMENT;
+	}
+
+	while (status == CELIX_SUCCESS && capacity > shmRing_maxMessage(gen)) {
+		if (gen->next == NULL) {
+			status = shmRing_grow(ring, gen, capacity);
+		}
+		gen = gen->next;
+	}
+
+	if (status == CELIX_SUCCESS) {
+		uint32_t count = shmRing_slotsFor(gen->slotSize, capacity);
+		status = shmRing_claim(gen, &gen->header->replies, count, false, &request->replyPos, NULL);
+		if (status == CELIX_SUCCESS) {
+			request->replyGen = gen;
+			request->replyCount = count;
+			request->replyCapacity = capacity;
+			*buffer = shmRing_data(gen, &gen->header->replies, request->replyPos);
+		}
+	}
+
+	return status;
+}
+
+celix_status_t shmRing_commitReply(shm_ring_pt ring, shm_ring_request_pt request, size_t length) {
+	celix_status_t status = CELIX_SUCCESS;
+
+	if (request->replyCount == 0 || length > request->replyCapacity) {
+		status = CELIX_ILLEGAL_ARGUMENT;
+		if (request->replyCount > 0) {
+			shmRing_release(request->replyGen, &request->replyGen->header->replies, request->replyPos, request->replyCount);
+			request->replyCount = 0;
+		}
+		shmRing_answer(request, SHM_RING_STATE_FAILED, 0);
+	} else {
+		shmRing_data(request->replyGen, &request->replyGen->header->replies, request->replyPos)[length] = '\0';
+		shmRing_answer(request, SHM_RING_STATE_REPLIED, length);
+	}
+
+	return status;
+}
+
+celix_status_t shmRing_reply(shm_ring_pt ring, shm_ring_request_pt request, const char *reply, size_t length) {
+	celix_status_t status = CELIX_SUCCESS;
+	char *buffer = NULL;
+
+	if (reply == NULL) {
+		status = CELIX_ILLEGAL_ARGUMENT;
+	} else {
+		status = shmRing_beginReply(ring, request, length, &buffer);
+	}
+
+	if (status == CELIX_SUCCESS) {
+		memcpy(buffer, reply, length);
+		status = shmRing_commitReply(ring, request, length);
+	} else {
+		shmRing_answer(request, SHM_RING_STATE_FAILED, 0);
+	}
+
+	return status;
+}
+
+//hands the reply over through the first request slot and destroys the request
+static void shmRing_answer(shm_ring_request_pt request, uint32_t state, size_t length) {
+	struct shm_ring_slot *first = shmRing_slot(request->gen, &request->gen->header->requests, request->pos);
+
+	if (request->replyGen != NULL) {
+		first->replyGeneration = request->replyGen->header->generation;
+	}
+	first->replyPos = request->replyPos;
+	first->replyCount = request->replyCount;
+	first->replyLength = (uint32_t) length;
+	__atomic_store_n(&first->state.value, state, __ATOMIC_SEQ_CST);
+	shmRing_eventNotify(&first->state);
+
+	free(request);
+}
@@ -0,0 +1,412 @@
+/**
+ *Licensed to the Apache Software Foundation (ASF) under one
+ *or more contributor license agreements.  See the NOTICE file
+ *distributed with this work for additional information
+ *regarding copyright ownership.  The ASF licenses this file
+ *to you under the Apache License, Version 2.0 (the
+ *"License"); you may not use this file except in compliance
+ *with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *Unless required by applicable law or agreed to in writing,
+ *software distributed under the License is distributed on an
+ *"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ *specific language governing permissions and limitations
+ *under the License.
+ */
+#include <CppUTest/TestHarness.h>
+#include "CppUTest/CommandLineTestRunner.h"
+
+extern "C" {
+
+	#include <stdio.h>
+	#include <stdlib.h>
+	#include <string.h>
+	#include <time.h>
+	#include <unistd.h>
+	#include <pthread.h>
+
+	#include "discovery_shm.h"
+	#include "utils.h"
+
+	#define TABLE_CAPACITY 8
+	#define READERS 4
+	#define UPDATES 200000
+
+	struct seqlock_data {
+		shmData_pt data;
+		volatile bool running;
+		int reads;
+		int failures;
+	};
+
+	struct waiter_data {
+		shmData_pt data;
+		unsigned int seen;
+		double waited; //seconds
+	};
+
+	static shmData_pt table = NULL;
+
+	static double now(void) {
+		struct timespec time;
+		clock_gettime(CLOCK_MONOTONIC, &time);
+		return time.tv_sec + time.tv_nsec / 1e9;
+	}
+
+	//writes count keys which all hash to the same entry of the table into keys
+	static void collidingKeys(char keys[][32], int count) {
+		unsigned int mask = discoveryShm_getCapacity(table) - 1;
+		unsigned int home = utils_stringHash("probe0") & mask;
+		int found = 0;
+
+		for (int i = 0; found < count; i++) {
+			snprintf(keys[found], 32, "probe%d", i);
+			if ((utils_stringHash(keys[found]) & mask) == home) {
+				found++;
+			}
+		}
+	}
+
+	static bool contains(shmData_pt data, const char *key, const char *value) {
+		char found[SHM_ENTRY_MAX_VALUE_LENGTH];
+
+		return discoveryShm_get(data, (char *) key, found) == CELIX_SUCCESS && strcmp(found, value) == 0;
+	}
+
+	//the value of the entry is a single repeated character, a torn read would mix them
+	static void *seqlockReader(void *handle) {
+		struct seqlock_data *reader = (struct seqlock_data *) handle;
+		char value[SHM_ENTRY_MAX_VALUE_LENGTH];
+
+		while (reader->running) {
+			if (discoveryShm_get(reader->data, (char *) "torn", value) != CELIX_SUCCESS) {
+				continue;
+			}
+			reader->reads++;
+			if (strlen(value) != SHM_ENTRY_MAX_VALUE_LENGTH - 1 || strspn(value, value[0] == 'a' ? "a" : "b") != strlen(value)) {
+				reader->failures++;
+			}
+		}
+
+		return NULL;
+	}
+
+	static void *changeWaiter(void *handle) {
+		struct waiter_data *waiter = (struct waiter_data *) handle;
+		double start = now();
+
+		discoveryShm_waitForChange(waiter->data, waiter->seen, 5);
+		waiter->waited = now() - start;
+
+		return NULL;
+	}
+
+	static unsigned int generationOf(shmData_pt data) {
+		char *keys[TABLE_CAPACITY];
+		char *values[TABLE_CAPACITY];
+		unsigned int generation = 0;
+		int size = 0;
+
+		for (int i = 0; i < TABLE_CAPACITY; i++) {
+			keys[i] = (char *) malloc(SHM_ENTRY_MAX_KEY_LENGTH);
+			values[i] = (char *) malloc(SHM_ENTRY_MAX_VALUE_LENGTH);
+		}
+		discoveryShm_getEntries(data, 0, keys, values, &size, &generation);
+		for (int i = 0; i < TABLE_CAPACITY; i++) {
+			free(keys[i]);
+			free(values[i]);
+		}
+
+		return generation;
+	}
+
+	static void testProbing(void) {
+		char keys[TABLE_CAPACITY + 1][32];
+
+		collidingKeys(keys, TABLE_CAPACITY + 1);
+
+		//all keys share their home entry, each next one is placed further along the probe sequence
+		for (int i = 0; i < TABLE_CAPACITY; i++) {
+			CHECK_EQUAL(CELIX_SUCCESS, discoveryShm_set(table, keys[i], keys[i]));
+		}
+		CHECK_EQUAL(CELIX_ILLEGAL_STATE, discoveryShm_set(table, keys[TABLE_CAPACITY], keys[TABLE_CAPACITY]));
+
+		for (int i = 0; i < TABLE_CAPACITY; i++) {
+			CHECK(contains(table, keys[i], keys[i]));
+		}
+		CHECK_EQUAL(CELIX_BUNDLE_EXCEPTION, discoveryShm_get(table, keys[TABLE_CAPACITY], NULL));
+
+		//a removed entry in the middle of the probe sequence does not hide the entries after it, and is reused
+		CHECK_EQUAL(CELIX_SUCCESS, discoveryShm_remove(table, keys[2]));
+		CHECK_EQUAL(CELIX_BUNDLE_EXCEPTION, discoveryShm_get(table, keys[2], NULL));
+		for (int i = 3; i < TABLE_CAPACITY; i++) {
+			CHECK(contains(table, keys[i], keys[i]));
+		}
+		CHECK_EQUAL(CELIX_SUCCESS, discoveryShm_set(table, keys[TABLE_CAPACITY], keys[TABLE_CAPACITY]));
+		CHECK(contains(table, keys[TABLE_CAPACITY], keys[TABLE_CAPACITY]));
+
+		//updating an entry does not insert it twice
+		CHECK_EQUAL(CELIX_SUCCESS, discoveryShm_set(table, keys[0], (char *) "updated"));
+		CHECK(contains(table, keys[0], "updated"));
+
+		char *found[TABLE_CAPACITY];
+		int size = 0;
+		for (int i = 0; i < TABLE_CAPACITY; i++) {
+			found[i] = (char *) malloc(SHM_ENTRY_MAX_KEY_LENGTH);
+		}
+		CHECK_EQUAL(CELIX_SUCCESS, discoveryShm_getKeys(table, found, &size));
+		CHECK_EQUAL(TABLE_CAPACITY, size);
+		for (int i = 0; i < TABLE_CAPACITY; i++) {
+			free(found[i]);
+		}
+	}
+
+	static void testTombstoneTrimming(void) {
+		char keys[4][32];
+
+		collidingKeys(keys, 4);
+		for (int i = 0; i < 4; i++) {
+			CHECK_EQUAL(CELIX_SUCCESS, discoveryShm_set(table, keys[i], keys[i]));
+		}
+
+		//the tombstone of keys[1] stays, keys[2] and keys[3] are behind it
+		CHECK_EQUAL(CELIX_SUCCESS, discoveryShm_remove(table, keys[1]));
+		CHECK(contains(table, keys[2], keys[2]));
+		CHECK(contains(table, keys[3], keys[3]));
+
+		//the last entry of the sequence is followed by an empty one: it is trimmed, up to the used keys[2]
+		CHECK_EQUAL(CELIX_SUCCESS, discoveryShm_remove(table, keys[3]));
+		CHECK(contains(table, keys[0], keys[0]));
+		CHECK(contains(table, keys[2], keys[2]));
+
+		//now keys[2] is the last one, trimming it also trims the tombstone of keys[1] but stops at keys[0]
+		CHECK_EQUAL(CELIX_SUCCESS, discoveryShm_remove(table, keys[2]));
+		CHECK(contains(table, keys[0], keys[0]));
+		CHECK_EQUAL(CELIX_BUNDLE_EXCEPTION, discoveryShm_remove(table, keys[1]));
+
+		//the whole table can be filled again
+		CHECK_EQUAL(CELIX_SUCCESS, discoveryShm_remove(table, keys[0]));
+		char more[TABLE_CAPACITY][32];
+		collidingKeys(more, TABLE_CAPACITY);
+		for (int i = 0; i < TABLE_CAPACITY; i++) {
+			CHECK_EQUAL(CELIX_SUCCESS, discoveryShm_set(table, more[i], more[i]));
+		}
+		for (int i = 0; i < TABLE_CAPACITY; i++) {
+			CHECK(contains(table, more[i], more[i]));
+		}
+	}
+
+	static void testSeqlockReads(void) {
+		char a[SHM_ENTRY_MAX_VALUE_LENGTH];
+		char b[SHM_ENTRY_MAX_VALUE_LENGTH];
+		struct seqlock_data readers[READERS];
+		pthread_t threads[READERS];
+		int failures = 0;
+		int reads = 0;
+
+		memset(a, 'a', sizeof(a) - 1);
+		a[sizeof(a) - 1] = '\0';
+		memset(b, 'b', sizeof(b) - 1);
+		b[sizeof(b) - 1] = '\0';
+		CHECK_EQUAL(CELIX_SUCCESS, discoveryShm_set(table, (char *) "torn", a));
+
+		for (int i = 0; i < READERS; i++) {
+			readers[i].data = table;
+			readers[i].running = true;
+			readers[i].reads = 0;
+			readers[i].failures = 0;
+			pthread_create(&threads[i], NULL, seqlockReader, &readers[i]);
+		}
+
+		//the readers never take the lock, they must still never see a value while it is written
+		for (int i = 0; i < UPDATES; i++) {
+			discoveryShm_set(table, (char *) "torn", (i % 2 == 0) ? b : a);
+		}
+
+		for (int i = 0; i < READERS; i++) {
+			readers[i].running = false;
+			pthread_join(threads[i], NULL);
+			failures += readers[i].failures;
+			reads += readers[i].reads;
+		}
+
+		CHECK(reads > 0);
+		CHECK_EQUAL(0, failures);
+	}
+
+	static void testGetEntriesSince(void) {
+		char *keys[TABLE_CAPACITY];
+		char *values[TABLE_CAPACITY];
+		unsigned int generation = 0;
+		unsigned int since = 0;
+		int size = 0;
+
+		for (int i = 0; i < TABLE_CAPACITY; i++) {
+			keys[i] = (char *) malloc(SHM_ENTRY_MAX_KEY_LENGTH);
+			values[i] = (char *) malloc(SHM_ENTRY_MAX_VALUE_LENGTH);
+		}
+
+		CHECK_EQUAL(CELIX_SUCCESS, discoveryShm_set(table, (char *) "a", (char *) "1"));
+		CHECK_EQUAL(CELIX_SUCCESS, discoveryShm_set(table, (char *) "b", (char *) "1"));
+
+		//generation 0: everything is new
+		CHECK_EQUAL(CELIX_SUCCESS, discoveryShm_getEntries(table, 0, keys, values, &size, &since));
+		CHECK_EQUAL(2, size);
+		for (int i = 0; i < size; i++) {
+			STRCMP_EQUAL("1", values[i]);
+		}
+
+		//a refresh with the same value is no change
+		CHECK_EQUAL(CELIX_SUCCESS, discoveryShm_set(table, (char *) "a", (char *) "1"));
+		CHECK_EQUAL(since, generationOf(table));
+
+		CHECK_EQUAL(CELIX_SUCCESS, discoveryShm_set(table, (char *) "b", (char *) "2"));
+		CHECK_EQUAL(CELIX_SUCCESS, discoveryShm_set(table, (char *) "c", (char *) "3"));
+
+		//all keys are listed, only the values changed since the previous snapshot are copied
+		CHECK_EQUAL(CELIX_SUCCESS, discoveryShm_getEntries(table, since, keys, values, &size, &generation));
+		CHECK_EQUAL(3, size);
+		CHECK(generation > since);
+		for (int i = 0; i < size; i++) {
+			if (strcmp(keys[i], "a") == 0) {
+				STRCMP_EQUAL("", values[i]);
+			} else if (strcmp(keys[i], "b") == 0) {
+				STRCMP_EQUAL("2", values[i]);
+			} else {
+				STRCMP_EQUAL("c", keys[i]);
+				STRCMP_EQUAL("3", values[i]);
+			}
+		}
+
+		//a removal changes the generation, the key is gone from the next snapshot
+		since = generation;
+		CHECK_EQUAL(CELIX_SUCCESS, discoveryShm_remove(table, (char *) "c"));
+		CHECK_EQUAL(CELIX_SUCCESS, discoveryShm_getEntries(table, since, keys, values, &size, &generation));
+		CHECK_EQUAL(2, size);
+		CHECK(generation > since);
+		for (int i = 0; i < size; i++) {
+			STRCMP_EQUAL("", values[i]);
+		}
+
+		for (int i = 0; i < TABLE_CAPACITY; i++) {
+			free(keys[i]);
+			free(values[i]);
+		}
+	}
+
+	static void testWaitForChange(void) {
+		struct waiter_data waiter;
+		pthread_t thread;
+
+		//a generation which is already outdated returns at once
+		CHECK_EQUAL(CELIX_SUCCESS, discoveryShm_set(table, (char *) "a", (char *) "1"));
+		waiter.data = table;
+		waiter.seen = generationOf(table) - 1;
+		changeWaiter(&waiter);
+		CHECK(waiter.waited < 0.5);
+
+		//a change in another attachment of the segment wakes up the waiter
+		shmData_pt other = NULL;
+		CHECK_EQUAL(CELIX_SUCCESS, discoveryShm_attach(&other));
+		waiter.seen = generationOf(table);
+		pthread_create(&thread, NULL, changeWaiter, &waiter);
+		usleep(100000);
+		CHECK_EQUAL(CELIX_SUCCESS, discoveryShm_set(other, (char *) "b", (char *) "1"));
+		pthread_join(thread, NULL);
+		CHECK(waiter.waited < 2.0);
+
+#ifdef __linux__
+		//wakeUp releases a waiter without a change, e.g. to stop it
+		waiter.seen = generationOf(table);
+		pthread_create(&thread, NULL, changeWaiter, &waiter);
+		usleep(100000);
+		CHECK_EQUAL(CELIX_SUCCESS, discoveryShm_wakeUp(other));
+		pthread_join(thread, NULL);
+		CHECK(waiter.waited < 2.0);
+#endif
+
+		//without a change the waiter times out
+		waiter.seen = generationOf(table);
+		double start = now();
+		CHECK_EQUAL(CELIX_SUCCESS, discoveryShm_waitForChange(table, waiter.seen, 1));
+		CHECK(now() - start >= 0.9);
+
+		discoveryShm_detach(other);
+	}
+
+	static void *creator(void *handle) {
+		shmData_pt *data = (shmData_pt *) handle;
+
+		if (discoveryShm_create(data, TABLE_CAPACITY) != CELIX_SUCCESS) {
+			*data = NULL;
+		}
+
+		return NULL;
+	}
+
+	static void testConcurrentCreate(void) {
+		shmData_pt created[2] = { NULL, NULL };
+		pthread_t threads[2];
+
+		//the framework losing the race attaches to the segment of the other one instead of clearing it
+		discoveryShm_destroy(table);
+		table = NULL;
+		for (int i = 0; i < 2; i++) {
+			pthread_create(&threads[i], NULL, creator, &created[i]);
+		}
+		for (int i = 0; i < 2; i++) {
+			pthread_join(threads[i], NULL);
+			CHECK(created[i] != NULL);
+		}
+
+		CHECK_EQUAL(CELIX_SUCCESS, discoveryShm_set(created[0], (char *) "a", (char *) "1"));
+		CHECK(contains(created[1], "a", "1"));
+
+		discoveryShm_detach(created[1]);
+		table = created[0];
+	}
+}
+
+TEST_GROUP(DiscoveryShmTests) {
+	void setup() {
+		//start from a new segment, not one left by an earlier run
+		if (discoveryShm_attach(&table) == CELIX_SUCCESS) {
+			discoveryShm_destroy(table);
+		}
+		table = NULL;
+		CHECK_EQUAL(CELIX_SUCCESS, discoveryShm_create(&table, TABLE_CAPACITY));
+		CHECK_EQUAL(TABLE_CAPACITY, discoveryShm_getCapacity(table));
+	}
+
+	void teardown() {
+		discoveryShm_destroy(table);
+		table = NULL;
+	}
+};
+
+TEST(DiscoveryShmTests, probing) {
+	testProbing();
+}
+
+TEST(DiscoveryShmTests, tombstoneTrimming) {
+	testTombstoneTrimming();
+}
+
+TEST(DiscoveryShmTests, seqlockReads) {
+	testSeqlockReads();
+}
+
+TEST(DiscoveryShmTests, getEntriesSince) {
+	testGetEntriesSince();
+}
+
+TEST(DiscoveryShmTests, waitForChange) {
+	testWaitForChange();
+}
+
+TEST(DiscoveryShmTests, concurrentCreate) {
+	testConcurrentCreate();
+}
@@ -0,0 +1,394 @@
+/**
+ *Licensed to the Apache Software Foundation (ASF) under one
+ *or more contributor license agreements.  See the NOTICE file
+ *distributed with this work for additional information
+ *regarding copyright ownership.  The ASF licenses this file
+ *to you under the Apache License, Version 2.0 (the
+ *"License"); you may not use this file except in compliance
+ *with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *Unless required by applicable law or agreed to in writing,
+ *software distributed under the License is distributed on an
+ *"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ *specific language governing permissions and limitations
+ *under the License.
+ */
+#include <CppUTest/TestHarness.h>
+#include "CppUTest/CommandLineTestRunner.h"
+
+extern "C" {
+
+	#include <stdio.h>
+	#include <stdlib.h>
+	#include <string.h>
+	#include <pthread.h>
+
+	#include "shm_ring.h"
+	#include "dyn_type.h"
+
+	#define SEGMENT_SIZE (64 * 1024)
+	#define SLOT_SIZE 512
+	#define CALLERS 4
+	#define CALLS 200
+
+	#define GROWTH_SEGMENT_SIZE (8 * 1024)
+	#define GROWTH_MAX_SIZE (1024 * 1024)
+	#define GROWTH_LARGE_REQUEST (20 * 1024)
+
+	#define FRAME_SEGMENT_SIZE (4 * 1024 * 1024)
+	#define FRAME_SLOT_SIZE (64 * 1024)
+	#define FRAME_SAMPLES 100000
+
+	struct frame {
+		int64_t timestamp;
+		struct {
+			uint32_t cap;
+			uint32_t len;
+			double *buf;
+		} samples;
+	};
+
+	struct caller_data {
+		shm_ring_pt ring;
+		int id;
+		int failures;
+	};
+
+	//replies with the request prefixed by "re:"
+	static void *echoReceiver(void *handle) {
+		shm_ring_pt ring = (shm_ring_pt) handle;
+		shm_ring_request_pt request = NULL;
+
+		while (shmRing_receive(ring, &request) == CELIX_SUCCESS) {
+			size_t length = shmRing_requestLength(request);
+			char *reply = (char *) malloc(length + 4);
+			memcpy(reply, "re:", 3);
+			memcpy(reply + 3, shmRing_requestData(request), length + 1);
+			shmRing_reply(ring, request, reply, length + 3);
+			free(reply);
+		}
+
+		return NULL;
+	}
+
+	//replies to "big:N" with N bytes, to everything else like the echo receiver
+	static void *growingReceiver(void *handle) {
+		shm_ring_pt ring = (shm_ring_pt) handle;
+		shm_ring_request_pt request = NULL;
+
+		while (shmRing_receive(ring, &request) == CELIX_SUCCESS) {
+			char *data = shmRing_requestData(request);
+			size_t length = shmRing_requestLength(request);
+			char *reply = NULL;
+
+			if (strncmp(data, "big:", 4) == 0) {
+				size_t size = (size_t) atol(data + 4);
+				if (shmRing_beginReply(ring, request, size, &reply) == CELIX_SUCCESS) {
+					memset(reply, 'r', size);
+					shmRing_commitReply(ring, request, size);
+				}
+			} else if (shmRing_beginReply(ring, request, length + 3, &reply) == CELIX_SUCCESS) {
+				memcpy(reply, "re:", 3);
+				memcpy(reply + 3, data, length);
+				shmRing_commitReply(ring, request, length + 3);
+			}
+		}
+
+		return NULL;
+	}
+
+	static void *growingCaller(void *handle) {
+		struct caller_data *data = (struct caller_data *) handle;
+
+		for (int i = 0; i < CALLS; i++) {
+			//a few requests do not fit in the initial segment
+			size_t length = (i % 50 == 25) ? GROWTH_LARGE_REQUEST + (size_t) data->id : 32;
+			char *request = (char *) malloc(length + 1);
+			memset(request, 'a' + data->id, length);
+			request[length] = '\0';
+
+			char *reply = NULL;
+			size_t replyLength = 0;
+			if (shmRing_call(data->ring, request, length, &reply, &replyLength) != CELIX_SUCCESS || replyLength != length + 3
+					|| strncmp(reply, "re:", 3) != 0 || strcmp(reply + 3, request) != 0) {
+				data->failures++;
+			}
+
+			free(reply);
+			free(request);
+		}
+
+		return NULL;
+	}
+
+	static void *caller(void *handle) {
+		struct caller_data *data = (struct caller_data *) handle;
+
+		for (int i = 0; i < CALLS; i++) {
+			//every few calls the request spans several slots
+			size_t length = (i % 7 == 0) ? SLOT_SIZE * 3 + (size_t) i : 16;
+			char *request = (char *) malloc(length + 1);
+			memset(request, 'a' + data->id, length);
+			snprintf(request, length, "%d:%d", data->id, i);
+			request[strlen(request)] = '-';
+			request[length] = '\0';
+
+			char *reply = NULL;
+			size_t replyLength = 0;
+			if (shmRing_call(data->ring, request, length, &reply, &replyLength) != CELIX_SUCCESS || replyLength != length + 3
+					|| strncmp(reply, "re:", 3) != 0 || strcmp(reply + 3, request) != 0) {
+				data->failures++;
+			}
+
+			free(reply);
+			free(request);
+		}
+
+		return NULL;
+	}
+
+	static void *allocSegment(size_t size) {
+		void *segment = NULL;
+		if (posix_memalign(&segment, SHM_RING_ALIGN, size) == 0) {
+			memset(segment, 0, size);
+		}
+		return segment;
+	}
+
+	//reads the frame in place and replies with the sum of the samples
+	static void *frameReceiver(void *handle) {
+		shm_ring_pt ring = (shm_ring_pt) handle;
+		shm_ring_request_pt request = NULL;
+		dyn_type *type = NULL;
+		dynType_parseWithStr("{J[D timestamp samples}", NULL, NULL, &type);
+
+		while (shmRing_receive(ring, &request) == CELIX_SUCCESS) {
+			struct frame *frame = (struct frame *) shmRing_requestData(request);
+			char *reply = NULL;
+
+			if (shmRing_requestLength(request) < sizeof(*frame) || dynType_offsetsToPointers(type, frame, frame, shmRing_requestLength(request)) != 0) {
+				shmRing_reply(ring, request, NULL, 0);
+			} else if (shmRing_beginReply(ring, request, 64, &reply) == CELIX_SUCCESS) {
+				double sum = 0.0;
+				for (uint32_t i = 0; i < frame->samples.len; i++) {
+					sum += frame->samples.buf[i];
+				}
+				int length = snprintf(reply, 64, "%lld:%.1f", (long long) frame->timestamp, sum);
+				shmRing_commitReply(ring, request, (size_t) length);
+			}
+		}
+
+		dynType_destroy(type);
+		return NULL;
+	}
+
+	static void testConcurrentCalls(void) {
+		void *segment = allocSegment(SEGMENT_SIZE);
+		shm_ring_pt server = NULL;
+		shm_ring_pt client = NULL;
+
+		CHECK_EQUAL(CELIX_SUCCESS, shmRing_create(segment, SEGMENT_SIZE, SEGMENT_SIZE, SLOT_SIZE, &server));
+		CHECK_EQUAL(CELIX_SUCCESS, shmRing_attach(segment, SEGMENT_SIZE, &client));
+		CHECK_EQUAL(32, shmRing_getSlotCount(client));
+
+		pthread_t receiver;
+		pthread_create(&receiver, NULL, echoReceiver, server);
+
+		pthread_t callers[CALLERS];
+		struct caller_data data[CALLERS];
+		for (int i = 0; i < CALLERS; i++) {
+			data[i].ring = client;
+			data[i].id = i;
+			data[i].failures = 0;
+			pthread_create(&callers[i], NULL, caller, &data[i]);
+		}
+		for (int i = 0; i < CALLERS; i++) {
+			pthread_join(callers[i], NULL);
+			CHECK_EQUAL(0, data[i].failures);
+		}
+
+		shmRing_close(server);
+		pthread_join(receiver, NULL);
+
+		shmRing_destroy(client);
+		shmRing_destroy(server);
+		free(segment);
+	}
+
+	static void testLayoutChecks(void) {
+		char *segment = (char *) allocSegment(SEGMENT_SIZE);
+		shm_ring_pt ring = NULL;
+
+		//an unformatted segment is not accepted
+		CHECK_EQUAL(CELIX_ILLEGAL_STATE, shmRing_attach(segment, SEGMENT_SIZE, &ring));
+		//not enough room for two slots per ring
+		CHECK_EQUAL(CELIX_ILLEGAL_ARGUMENT, shmRing_create(segment, SLOT_SIZE * 2, SLOT_SIZE * 2, SLOT_SIZE, &ring));
+
+		CHECK_EQUAL(CELIX_SUCCESS, shmRing_create(segment, SEGMENT_SIZE, SEGMENT_SIZE, SLOT_SIZE, &ring));
+		size_t tooLarge = shmRing_getMaxMessageSize(ring) + 1;
+		char *request = (char *) calloc(1, tooLarge + 1);
+		char *reply = NULL;
+		CHECK_EQUAL(CELIX_ILLEGAL_ARGUMENT, shmRing_call(ring, request, tooLarge, &reply, NULL));
+		free(request);
+
+		//a closed ring stops the receiver
+		shm_ring_request_pt received = NULL;
+		shmRing_close(ring);
+		CHECK_EQUAL(CELIX_ILLEGAL_STATE, shmRing_receive(ring, &received));
+
+		shmRing_destroy(ring);
+		free(segment);
+	}
+
+	static void testGrowth(void) {
+		void *segment = allocSegment(GROWTH_SEGMENT_SIZE);
+		shm_ring_pt server = NULL;
+		shm_ring_pt client = NULL;
+
+		CHECK_EQUAL(CELIX_SUCCESS, shmRing_create(segment, GROWTH_SEGMENT_SIZE, GROWTH_MAX_SIZE, SLOT_SIZE, &server));
+		CHECK_EQUAL(CELIX_SUCCESS, shmRing_attach(segment, GROWTH_SEGMENT_SIZE, &client));
+		CHECK_EQUAL(0, shmRing_getGeneration(client));
+		CHECK(shmRing_getMaxMessageSize(client) > GROWTH_LARGE_REQUEST);
+
+		pthread_t receiver;
+		pthread_create(&receiver, NULL, growingReceiver, server);
+
+		pthread_t callers[CALLERS];
+		struct caller_data data[CALLERS];
+		for (int i = 0; i < CALLERS; i++) {
+			data[i].ring = client;
+			data[i].id = i;
+			data[i].failures = 0;
+			pthread_create(&callers[i], NULL, growingCaller, &data[i]);
+		}
+		for (int i = 0; i < CALLERS; i++) {
+			pthread_join(callers[i], NULL);
+			CHECK_EQUAL(0, data[i].failures);
+		}
+		CHECK(shmRing_getGeneration(client) > 0);
+		CHECK(shmRing_getSize(client) > GROWTH_SEGMENT_SIZE);
+
+		//a reply larger than the current generation grows the ring as well
+		char request[32];
+		size_t size = shmRing_getSize(client);
+		snprintf(request, sizeof(request), "big:%zu", size);
+		char *reply = NULL;
+		size_t replyLength = 0;
+		CHECK_EQUAL(CELIX_SUCCESS, shmRing_call(client, request, strlen(request), &reply, &replyLength));
+		CHECK_EQUAL(size, replyLength);
+		CHECK(reply != NULL && reply[0] == 'r' && reply[size - 1] == 'r' && reply[size] == '\0');
+		free(reply);
+
+		//a client attaching later follows the chain from the initial segment
+		shm_ring_pt late = NULL;
+		CHECK_EQUAL(CELIX_SUCCESS, shmRing_attach(segment, GROWTH_SEGMENT_SIZE, &late));
+		CHECK_EQUAL(shmRing_getGeneration(client), shmRing_getGeneration(late));
+		reply = NULL;
+		CHECK_EQUAL(CELIX_SUCCESS, shmRing_call(late, "late", 4, &reply, NULL));
+		STRCMP_EQUAL("re:late", reply);
+		free(reply);
+
+		//the maximum size is a hard limit
+		size_t tooLarge = shmRing_getMaxMessageSize(client) + 1;
+		char *large = (char *) calloc(1, tooLarge + 1);
+		reply = NULL;
+		CHECK_EQUAL(CELIX_ILLEGAL_ARGUMENT, shmRing_call(client, large, tooLarge, &reply, NULL));
+		free(large);
+
+		shmRing_close(server);
+		pthread_join(receiver, NULL);
+
+		shmRing_destroy(late);
+		shmRing_destroy(client);
+		shmRing_destroy(server);
+		free(segment);
+	}
+
+	static void testZeroCopyFrame(void) {
+		void *segment = allocSegment(FRAME_SEGMENT_SIZE);
+		shm_ring_pt server = NULL;
+		shm_ring_pt client = NULL;
+		dyn_type *type = NULL;
+
+		CHECK_EQUAL(CELIX_SUCCESS, shmRing_create(segment, FRAME_SEGMENT_SIZE, FRAME_SEGMENT_SIZE, FRAME_SLOT_SIZE, &server));
+		CHECK_EQUAL(CELIX_SUCCESS, shmRing_attach(segment, FRAME_SEGMENT_SIZE, &client));
+		CHECK_EQUAL(0, dynType_parseWithStr("{J[D timestamp samples}", NULL, NULL, &type));
+
+		pthread_t receiver;
+		pthread_create(&receiver, NULL, frameReceiver, server);
+
+		for (int64_t call = 0; call < 3; call++) {
+			shm_ring_call_pt handle = NULL;
+			char *buffer = NULL;
+			CHECK_EQUAL(CELIX_SUCCESS, shmRing_beginCall(client, shmRing_getMaxMessageSize(client), &handle, &buffer));
+
+			//the frame is built directly in the claimed slots
+			dyn_type_arena *arena = NULL;
+			dyn_type *samplesType = NULL;
+			struct frame *frame = NULL;
+			dynType_complex_dynTypeAt(type, 1, &samplesType);
+			CHECK_EQUAL(0, dynType_arenaCreateInRegion(buffer, shmRing_getMaxMessageSize(client), &arena));
+			CHECK_EQUAL(0, dynType_allocInArena(arena, type, (void **) &frame));
+			CHECK_EQUAL(0, dynType_sequence_allocInArena(arena, samplesType, &frame->samples, FRAME_SAMPLES));
+			frame->timestamp = call;
+			for (int i = 0; i < FRAME_SAMPLES; i++) {
+				frame->samples.buf[i] = 1.0;
+			}
+			frame->samples.len = FRAME_SAMPLES;
+
+			size_t length = dynType_arenaUsed(arena);
+			CHECK_EQUAL(0, dynType_pointersToOffsets(type, frame, buffer, length));
+			dynType_arenaDestroy(arena);
+
+			const char *reply = NULL;
+			CHECK_EQUAL(CELIX_SUCCESS, shmRing_commitCall(client, handle, length, &reply, NULL));
+			char expected[64];
+			snprintf(expected, sizeof(expected), "%lld:%.1f", (long long) call, (double) FRAME_SAMPLES);
+			STRCMP_EQUAL(expected, reply);
+			shmRing_endCall(client, handle);
+		}
+
+		//an abandoned call is skipped by the receiver
+		shm_ring_call_pt abandoned = NULL;
+		char *buffer = NULL;
+		CHECK_EQUAL(CELIX_SUCCESS, shmRing_beginCall(client, 16, &abandoned, &buffer));
+		shmRing_endCall(client, abandoned);
+		char *reply = NULL;
+		CHECK_EQUAL(CELIX_BUNDLE_EXCEPTION, shmRing_call(client, "not a frame", 11, &reply, NULL));
+
+		shmRing_close(server);
+		pthread_join(receiver, NULL);
+
+		dynType_destroy(type);
+		shmRing_destroy(client);
+		shmRing_destroy(server);
+		free(segment);
+	}
+}
+
+TEST_GROUP(ShmRingTests) {
+	void setup() {
+	}
+
+	void teardown() {
+	}
+};
+
+TEST(ShmRingTests, concurrentCalls) {
+	testConcurrentCalls();
+}
+
+TEST(ShmRingTests, layoutChecks) {
+	testLayoutChecks();
+}
+
+TEST(ShmRingTests, growth) {
+	testGrowth();
+}
+
+TEST(ShmRingTests, zeroCopyFrame) {
+	testZeroCopyFrame();
+}
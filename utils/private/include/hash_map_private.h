@@ -45,6 +45,17 @@ struct hashMapEntry {
 	unsigned int hash;
 };
 
+/*
+ * Inline entry of an open addressing map. Key and value are laid out as in struct hashMapEntry, so a slot can be
+ * handed out as a hash_map_entry_pt for hashMapEntry_getKey/getValue.
+ */
+struct hashMapSlot {
+	void* key;
+	void* value;
+	unsigned int hash;
+	unsigned int distance; //0 for an empty slot, otherwise the probe distance + 1
+};
+
 struct hashMap {
 	hash_map_entry_pt * table;
 	unsigned int size;
@@ -52,6 +63,12 @@ struct hashMap {
 	unsigned int modificationCount;
 	unsigned int tablelength;
 
+	//open addressing, see hashMap_createOpenAddressing
+	bool openAddressing;
+	struct hashMapSlot * slots; //tablelength home slots followed by overflow slots, probing never wraps around
+	unsigned int overflow;
+	unsigned int shift; //32 - log2(tablelength)
+
 	unsigned int (*hashKey)(const void* key);
 	unsigned int (*hashValue)(const void* value);
 	int (*equalsKey)(const void* key1, const void* key2);
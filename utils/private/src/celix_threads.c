@@ -24,6 +24,7 @@
  *  \copyright  Apache License, Version 2.0
  */
 #include <stdlib.h>
+#include <time.h>
 #include "signal.h"
 #include "celix_threads.h"
 
@@ -143,6 +144,16 @@ celix_status_t celixThreadCondition_wait(celix_thread_cond_t *cond, celix_thread
     return pthread_cond_wait(cond, mutex);
 }
 
+celix_status_t celixThreadCondition_timedwaitRelative(celix_thread_cond_t *cond, celix_thread_mutex_t *mutex, long seconds, long nanoseconds) {
+    struct timespec time;
+
+    clock_gettime(CLOCK_REALTIME, &time);
+    time.tv_sec += seconds + (time.tv_nsec + nanoseconds) / 1000000000L;
+    time.tv_nsec = (time.tv_nsec + nanoseconds) % 1000000000L;
+
+    return pthread_cond_timedwait(cond, mutex, &time);
+}
+
 celix_status_t celixThreadCondition_broadcast(celix_thread_cond_t *cond) {
     return pthread_cond_broadcast(cond);
 }
@@ -36,6 +36,7 @@
 static unsigned int DEFAULT_INITIAL_CAPACITY = 16;
 static float DEFAULT_LOAD_FACTOR = 0.75f;
 static unsigned int MAXIMUM_CAPACITY = 1 << 30;
+static float OPEN_ADDRESSING_LOAD_FACTOR = 0.875f;
 
 unsigned int hashMap_hashCode(const void * toHash) {
 	intptr_t address = (intptr_t) toHash;
@@ -67,14 +68,58 @@ static unsigned int hashMap_indexFor(unsigned int h, unsigned int length) {
 	return h & (length - 1);
 }
 
+static hash_map_pt hashMap_alloc(unsigned int (*keyHash)(const void *), unsigned int (*valueHash)(const void *),
+		int (*keyEquals)(const void *, const void *), int (*valueEquals)(const void *, const void *));
+
+static unsigned int hashMap_openSlotCount(hash_map_pt map);
+static struct hashMapSlot * hashMap_openFind(hash_map_pt map, const void * key);
+static struct hashMapSlot * hashMap_openFindHash(hash_map_pt map, const void * key, unsigned int hash);
+static void hashMap_openPut(hash_map_pt map, unsigned int hash, void * key, void * value);
+static void hashMap_openRemoveSlot(hash_map_pt map, struct hashMapSlot * slot);
+static hash_map_entry_pt hashMap_openDetach(hash_map_pt map, struct hashMapSlot * slot);
+static void hashMapIterator_openAdvance(hash_map_iterator_pt iterator);
+
 hash_map_pt hashMap_create(unsigned int (*keyHash)(const void *), unsigned int (*valueHash)(const void *),
 		int (*keyEquals)(const void *, const void *), int (*valueEquals)(const void *, const void *)) {
+	hash_map_pt map = hashMap_alloc(keyHash, valueHash, keyEquals, valueEquals);
+	map->table = (hash_map_entry_pt *) calloc(DEFAULT_INITIAL_CAPACITY, sizeof(hash_map_entry_pt));
+	return map;
+}
+
+hash_map_pt hashMap_createOpenAddressing(unsigned int (*keyHash)(const void *), unsigned int (*valueHash)(const void *),
+		int (*keyEquals)(const void *, const void *), int (*valueEquals)(const void *, const void *)) {
+	return hashMap_createOpenAddressingWithCapacity(DEFAULT_INITIAL_CAPACITY, keyHash, valueHash, keyEquals, valueEquals);
+}
+
+hash_map_pt hashMap_createOpenAddressingWithCapacity(unsigned int initialCapacity, unsigned int (*keyHash)(const void *),
+		unsigned int (*valueHash)(const void *), int (*keyEquals)(const void *, const void *), int (*valueEquals)(const void *, const void *)) {
+	hash_map_pt map = hashMap_alloc(keyHash, valueHash, keyEquals, valueEquals);
+	unsigned int bits = 1;
+	while (bits < 30 && (1u << bits) < initialCapacity) {
+		bits++;
+	}
+	map->openAddressing = true;
+	map->tablelength = 1u << bits;
+	map->shift = 32 - bits;
+	//room for the probe sequences of the last home slots, grows when it turns out to be too small
+	map->overflow = 2 * bits + 4 < map->tablelength ? 2 * bits + 4 : map->tablelength;
+	map->treshold = (unsigned int) (map->tablelength * OPEN_ADDRESSING_LOAD_FACTOR);
+	map->slots = calloc(hashMap_openSlotCount(map), sizeof(*map->slots));
+	return map;
+}
+
+static hash_map_pt hashMap_alloc(unsigned int (*keyHash)(const void *), unsigned int (*valueHash)(const void *),
+		int (*keyEquals)(const void *, const void *), int (*valueEquals)(const void *, const void *)) {
 	hash_map_pt map = (hash_map_pt) malloc(sizeof(*map));
 	map->treshold = (unsigned int) (DEFAULT_INITIAL_CAPACITY * DEFAULT_LOAD_FACTOR);
-	map->table = (hash_map_entry_pt *) calloc(DEFAULT_INITIAL_CAPACITY, sizeof(hash_map_entry_pt));
+	map->table = NULL;
 	map->size = 0;
 	map->modificationCount = 0;
 	map->tablelength = DEFAULT_INITIAL_CAPACITY;
+	map->openAddressing = false;
+	map->slots = NULL;
+	map->overflow = 0;
+	map->shift = 0;
 	map->hashKey = hashMap_hashCode;
 	map->hashValue = hashMap_hashCode;
 	map->equalsKey = hashMap_equals;
@@ -99,6 +144,7 @@ hash_map_pt hashMap_create(unsigned int (*keyHash)(const void *), unsigned int (
 void hashMap_destroy(hash_map_pt map, bool freeKeys, bool freeValues) {
 	hashMap_clear(map, freeKeys, freeValues);
 	free(map->table);
+	free(map->slots);
 	free(map);
 }
 
@@ -112,6 +158,10 @@ bool hashMap_isEmpty(hash_map_pt map) {
 
 void * hashMap_get(hash_map_pt map, const void* key) {
 	unsigned int hash;
+	if (map->openAddressing) {
+		struct hashMapSlot * slot = hashMap_openFind(map, key);
+		return slot == NULL ? NULL : slot->value;
+	}
 	if (key == NULL) {
 		hash_map_entry_pt entry;
 		for (entry = map->table[0]; entry != NULL; entry = entry->next) {
@@ -137,6 +187,9 @@ bool hashMap_containsKey(hash_map_pt map, const void* key) {
 }
 
 hash_map_entry_pt hashMap_getEntry(hash_map_pt map, const void* key) {
+	if (map->openAddressing) {
+		return (hash_map_entry_pt) hashMap_openFind(map, key);
+	}
 	unsigned int hash = (key == NULL) ? 0 : hashMap_hash(map->hashKey(key));
 	hash_map_entry_pt entry;
 	int index = hashMap_indexFor(hash, map->tablelength);
@@ -151,6 +204,19 @@ hash_map_entry_pt hashMap_getEntry(hash_map_pt map, const void* key) {
 void * hashMap_put(hash_map_pt map, void * key, void * value) {
 	unsigned int hash;
 	int i;
+	if (map->openAddressing) {
+		struct hashMapSlot * slot;
+		hash = (key == NULL) ? 0 : map->hashKey(key);
+		slot = hashMap_openFindHash(map, key, hash);
+		if (slot != NULL) {
+			void * oldValue = slot->value;
+			slot->value = value;
+			return oldValue;
+		}
+		map->modificationCount++;
+		hashMap_openPut(map, hash, key, value);
+		return NULL;
+	}
 	if (key == NULL) {
 		hash_map_entry_pt entry;
 		for (entry = map->table[0]; entry != NULL; entry = entry->next) {
@@ -209,6 +275,14 @@ void hashMap_resize(hash_map_pt map, int newCapacity) {
 }
 
 void * hashMap_remove(hash_map_pt map, const void* key) {
+	if (map->openAddressing) {
+		struct hashMapSlot * slot = hashMap_openFind(map, key);
+		void * value = (slot == NULL ? NULL : slot->value);
+		if (slot != NULL) {
+			hashMap_openRemoveSlot(map, slot);
+		}
+		return value;
+	}
 	hash_map_entry_pt entry = hashMap_removeEntryForKey(map, key);
 	void * value = (entry == NULL ? NULL : entry->value);
 	if (entry != NULL) {
@@ -220,6 +294,10 @@ void * hashMap_remove(hash_map_pt map, const void* key) {
 }
 
 hash_map_entry_pt hashMap_removeEntryForKey(hash_map_pt map, const void* key) {
+	if (map->openAddressing) {
+		struct hashMapSlot * slot = hashMap_openFind(map, key);
+		return slot == NULL ? NULL : hashMap_openDetach(map, slot);
+	}
 	unsigned int hash = (key == NULL) ? 0 : hashMap_hash(map->hashKey(key));
 	int i = hashMap_indexFor(hash, map->tablelength);
 	hash_map_entry_pt prev = map->table[i];
@@ -252,6 +330,13 @@ hash_map_entry_pt hashMap_removeMapping(hash_map_pt map, hash_map_entry_pt entry
 	if (entry == NULL) {
 		return NULL;
 	}
+	if (map->openAddressing) {
+		struct hashMapSlot * slot = hashMap_openFind(map, entry->key);
+		if (slot == NULL || !hashMap_entryEquals(map, (hash_map_entry_pt) slot, entry)) {
+			return NULL;
+		}
+		return hashMap_openDetach(map, slot);
+	}
 	hash = (entry->key == NULL) ? 0 : hashMap_hash(map->hashKey(entry->key));
 	i = hashMap_indexFor(hash, map->tablelength);
 	prev = map->table[i];
@@ -280,6 +365,21 @@ void hashMap_clear(hash_map_pt map, bool freeKey, bool freeValue) {
 	unsigned int i;
 	hash_map_entry_pt * table;
 	map->modificationCount++;
+	if (map->openAddressing) {
+		unsigned int slotCount = hashMap_openSlotCount(map);
+		for (i = 0; i < slotCount; i++) {
+			struct hashMapSlot * slot = &map->slots[i];
+			if (slot->distance != 0) {
+				if (freeKey && slot->key != NULL)
+					free(slot->key);
+				if (freeValue && slot->value != NULL)
+					free(slot->value);
+			}
+		}
+		memset(map->slots, 0, slotCount * sizeof(*map->slots));
+		map->size = 0;
+		return;
+	}
 	table = map->table;
 
 	for (i = 0; i < map->tablelength; i++) {
@@ -300,6 +400,16 @@ void hashMap_clear(hash_map_pt map, bool freeKey, bool freeValue) {
 
 bool hashMap_containsValue(hash_map_pt map, const void* value) {
 	unsigned int i;
+	if (map->openAddressing) {
+		unsigned int slotCount = hashMap_openSlotCount(map);
+		for (i = 0; i < slotCount; i++) {
+			struct hashMapSlot * slot = &map->slots[i];
+			if (slot->distance != 0 && (slot->value == value || (value != NULL && map->equalsValue(slot->value, value)))) {
+				return true;
+			}
+		}
+		return false;
+	}
 	if (value == NULL) {
 		for (i = 0; i < map->tablelength; i++) {
 			hash_map_entry_pt entry;
@@ -335,6 +445,136 @@ void hashMap_addEntry(hash_map_pt map, int hash, void* key, void* value, int buc
 	}
 }
 
+/*
+ * Open addressing uses Robin Hood hashing on a single slot array. Slots [0, tablelength) are home slots and are
+ * followed by a small overflow area, so a probe sequence never wraps around. This keeps lookups and removal
+ * (backward shift deletion) simple and allows an iterator to keep scanning forward after removing an entry.
+ */
+
+static unsigned int hashMap_openSlotCount(hash_map_pt map) {
+	return map->tablelength + map->overflow;
+}
+
+static unsigned int hashMap_openHome(hash_map_pt map, unsigned int hash) {
+	return (hash * 2654435769u) >> map->shift;
+}
+
+static struct hashMapSlot * hashMap_openFindHash(hash_map_pt map, const void * key, unsigned int hash) {
+	unsigned int slotCount = hashMap_openSlotCount(map);
+	unsigned int distance = 1;
+	unsigned int i;
+	for (i = hashMap_openHome(map, hash); i < slotCount; i++, distance++) {
+		struct hashMapSlot * slot = &map->slots[i];
+		if (slot->distance < distance) {
+			//empty slot or a slot closer to its home than the key would be: the key is not present
+			break;
+		}
+		if (slot->hash == hash && (slot->key == key || (key != NULL && slot->key != NULL && map->equalsKey(key, slot->key)))) {
+			return slot;
+		}
+	}
+	return NULL;
+}
+
+static struct hashMapSlot * hashMap_openFind(hash_map_pt map, const void * key) {
+	return hashMap_openFindHash(map, key, (key == NULL) ? 0 : map->hashKey(key));
+}
+
+/*
+ * Inserts entry, swapping it with entries that are closer to their home slot. Returns false if the probe sequence
+ * ran past the last slot, in which case entry holds the (possibly displaced) entry that still has to be inserted.
+ */
+static bool hashMap_openInsert(hash_map_pt map, struct hashMapSlot * entry) {
+	unsigned int slotCount = hashMap_openSlotCount(map);
+	unsigned int i;
+	entry->distance = 1;
+	for (i = hashMap_openHome(map, entry->hash); i < slotCount; i++, entry->distance++) {
+		struct hashMapSlot * slot = &map->slots[i];
+		if (slot->distance == 0) {
+			*slot = *entry;
+			return true;
+		}
+		if (slot->distance < entry->distance) {
+			struct hashMapSlot displaced = *slot;
+			*slot = *entry;
+			*entry = displaced;
+		}
+	}
+	return false;
+}
+
+static void hashMap_openRehash(hash_map_pt map, unsigned int tablelength, unsigned int overflow) {
+	struct hashMapSlot * oldSlots = map->slots;
+	unsigned int oldSlotCount = hashMap_openSlotCount(map);
+	bool done = false;
+
+	while (!done) {
+		unsigned int i;
+		map->tablelength = tablelength;
+		map->overflow = overflow;
+		map->shift = 32 - __builtin_ctz(tablelength);
+		map->slots = calloc(hashMap_openSlotCount(map), sizeof(*map->slots));
+		done = true;
+		for (i = 0; i < oldSlotCount && done; i++) {
+			if (oldSlots[i].distance != 0) {
+				struct hashMapSlot entry = oldSlots[i];
+				done = hashMap_openInsert(map, &entry);
+			}
+		}
+		if (!done) {
+			free(map->slots);
+			overflow *= 2;
+		}
+	}
+
+	free(oldSlots);
+	map->treshold = (unsigned int) ceil(tablelength * OPEN_ADDRESSING_LOAD_FACTOR);
+}
+
+static void hashMap_openPut(hash_map_pt map, unsigned int hash, void * key, void * value) {
+	struct hashMapSlot entry;
+	memset(&entry, 0, sizeof(entry));
+	entry.hash = hash;
+	entry.key = key;
+	entry.value = value;
+
+	if (map->size >= map->treshold && map->tablelength < MAXIMUM_CAPACITY) {
+		hashMap_openRehash(map, 2 * map->tablelength, map->overflow + 2);
+	}
+	while (!hashMap_openInsert(map, &entry)) {
+		if (map->size * 4 < map->tablelength || map->tablelength == MAXIMUM_CAPACITY) {
+			//sparse map with a long cluster at the end of the table: more overflow slots is enough
+			hashMap_openRehash(map, map->tablelength, 2 * map->overflow);
+		} else {
+			hashMap_openRehash(map, 2 * map->tablelength, map->overflow + 2);
+		}
+	}
+	map->size++;
+}
+
+static void hashMap_openRemoveSlot(hash_map_pt map, struct hashMapSlot * slot) {
+	struct hashMapSlot * last = &map->slots[hashMap_openSlotCount(map) - 1];
+	while (slot < last && (slot + 1)->distance > 1) {
+		*slot = *(slot + 1);
+		slot->distance--;
+		slot++;
+	}
+	memset(slot, 0, sizeof(*slot));
+	map->modificationCount++;
+	map->size--;
+}
+
+//returns a separately allocated copy, so callers can free removed entries the same way as chained entries
+static hash_map_entry_pt hashMap_openDetach(hash_map_pt map, struct hashMapSlot * slot) {
+	hash_map_entry_pt entry = (hash_map_entry_pt) malloc(sizeof(*entry));
+	entry->key = slot->key;
+	entry->value = slot->value;
+	entry->hash = slot->hash;
+	entry->next = NULL;
+	hashMap_openRemoveSlot(map, slot);
+	return entry;
+}
+
 hash_map_iterator_pt hashMapIterator_alloc(void) {
     return calloc(1, sizeof(hash_map_iterator_t));
 }
@@ -362,7 +602,9 @@ void hashMapIterator_init(hash_map_pt map, hash_map_iterator_pt iterator) {
 	iterator->index = 0;
 	iterator->next = NULL;
 	iterator->current = NULL;
-	if (map->size > 0) {
+	if (map->openAddressing) {
+		hashMapIterator_openAdvance(iterator);
+	} else if (map->size > 0) {
 		while (iterator->index < map->tablelength && (iterator->next = map->table[iterator->index++]) == NULL) {
 		}
 	}
@@ -385,6 +627,19 @@ bool hashMapIterator_hasNext(hash_map_iterator_pt iterator) {
 	return iterator->next != NULL;
 }
 
+static void hashMapIterator_openAdvance(hash_map_iterator_pt iterator) {
+	hash_map_pt map = iterator->map;
+	unsigned int slotCount = hashMap_openSlotCount(map);
+	iterator->next = NULL;
+	while (iterator->index < slotCount) {
+		struct hashMapSlot * slot = &map->slots[iterator->index++];
+		if (slot->distance != 0) {
+			iterator->next = (hash_map_entry_pt) slot;
+			break;
+		}
+	}
+}
+
 void hashMapIterator_remove(hash_map_iterator_pt iterator) {
 	void * key;
 	hash_map_entry_pt entry;
@@ -394,6 +649,16 @@ void hashMapIterator_remove(hash_map_iterator_pt iterator) {
 	if (iterator->expectedModCount != iterator->map->modificationCount) {
 		return;
 	}
+	if (iterator->map->openAddressing) {
+		//backward shift deletion only moves entries which have not been visited yet into the removed slot
+		struct hashMapSlot * slot = (struct hashMapSlot *) iterator->current;
+		iterator->current = NULL;
+		hashMap_openRemoveSlot(iterator->map, slot);
+		iterator->index = slot - iterator->map->slots;
+		hashMapIterator_openAdvance(iterator);
+		iterator->expectedModCount = iterator->map->modificationCount;
+		return;
+	}
 	key = iterator->current->key;
 	iterator->current = NULL;
 	entry = hashMap_removeEntryForKey(iterator->map, key);
@@ -410,7 +675,9 @@ void * hashMapIterator_nextValue(hash_map_iterator_pt iterator) {
 	if (entry == NULL) {
 		return NULL;
 	}
-	if ((iterator->next = entry->next) == NULL) {
+	if (iterator->map->openAddressing) {
+		hashMapIterator_openAdvance(iterator);
+	} else if ((iterator->next = entry->next) == NULL) {
 		while (iterator->index < iterator->map->tablelength && (iterator->next = iterator->map->table[iterator->index++]) == NULL) {
 		}
 	}
@@ -427,7 +694,9 @@ void * hashMapIterator_nextKey(hash_map_iterator_pt iterator) {
 	if (entry == NULL) {
 		return NULL;
 	}
-	if ((iterator->next = entry->next) == NULL) {
+	if (iterator->map->openAddressing) {
+		hashMapIterator_openAdvance(iterator);
+	} else if ((iterator->next = entry->next) == NULL) {
 		while (iterator->index < iterator->map->tablelength && (iterator->next = iterator->map->table[iterator->index++]) == NULL) {
 		}
 	}
@@ -444,7 +713,9 @@ hash_map_entry_pt hashMapIterator_nextEntry(hash_map_iterator_pt iterator) {
 	if (entry == NULL) {
 		return NULL;
 	}
-	if ((iterator->next = entry->next) == NULL) {
+	if (iterator->map->openAddressing) {
+		hashMapIterator_openAdvance(iterator);
+	} else if ((iterator->next = entry->next) == NULL) {
 		while (iterator->index < iterator->map->tablelength && (iterator->next = iterator->map->table[iterator->index++]) == NULL) {
 		}
 	}
@@ -28,6 +28,8 @@
 #include <unistd.h>
 #include <string.h>
 #include <signal.h>
+#include <errno.h>
+#include <time.h>
 
 #include "CppUTest/TestHarness.h"
 #include "CppUTest/TestHarness_c.h"
@@ -56,6 +58,12 @@ static char* my_strdup(const char* s) {
 	return d;
 }
 
+static double elapsedSince(struct timespec *start) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
 static int celix_thread_t_equals(const void * object, const void * compareTo){
 	celix_thread_t * thread1 = (celix_thread_t*) object;
 	celix_thread_t * thread2 = (celix_thread_t*) compareTo;
@@ -378,6 +386,38 @@ TEST(celix_thread_condition, broadcast) {
 	free(param);
 }
 
+//test timed wait, timing out and signaled before the timeout
+TEST(celix_thread_condition, timedwaitRelative) {
+	struct timespec start;
+	struct func_param * param = (struct func_param*) calloc(1, sizeof(struct func_param));
+	celixThreadMutex_create(&param->mu, NULL);
+	celixThreadCondition_init(&param->cond, NULL);
+
+	celixThreadMutex_lock(&param->mu);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	LONGS_EQUAL(ETIMEDOUT, celixThreadCondition_timedwaitRelative(&param->cond, &param->mu, 0, 200000000));
+	CHECK(elapsedSince(&start) >= 0.19);
+	CHECK(elapsedSince(&start) < 2);
+
+	//nanoseconds which carry over into the seconds
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	LONGS_EQUAL(ETIMEDOUT, celixThreadCondition_timedwaitRelative(&param->cond, &param->mu, 0, 999999999));
+	CHECK(elapsedSince(&start) >= 0.99);
+	CHECK(elapsedSince(&start) < 3);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	celixThread_create(&thread, NULL, thread_test_func_cond_wait, param);
+	while (param->i != 666) {
+		LONGS_EQUAL(CELIX_SUCCESS, celixThreadCondition_timedwaitRelative(&param->cond, &param->mu, 10, 0));
+	}
+	CHECK(elapsedSince(&start) < 5);
+	celixThreadMutex_unlock(&param->mu);
+
+	celixThread_join(thread, NULL);
+	free(param);
+}
+
 //----------------------CELIX READ-WRITE LOCK TESTS----------------------
 
 TEST(celix_thread_rwlock, create){
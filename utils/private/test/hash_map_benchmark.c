@@ -0,0 +1,138 @@
+/**
+ *Licensed to the Apache Software Foundation (ASF) under one
+ *or more contributor license agreements.  See the NOTICE file
+ *distributed with this work for additional information
+ *regarding copyright ownership.  The ASF licenses this file
+ *to you under the Apache License, Version 2.0 (the
+ *"License"); you may not use this file except in compliance
+ *with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *Unless required by applicable law or agreed to in writing,
+ *software distributed under the License is distributed on an
+ *"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ *specific language governing permissions and limitations
+ *under the License.
+ */
+/*
+ * hash_map_benchmark.c
+ *
+ *  Compares the chained hash map (hashMap_create) with the open addressing hash map (hashMap_createOpenAddressing).
+ *  Usage: hash_map_benchmark [nrOfEntries] [nrOfRounds]
+ *
+ *  \author    	<a href="mailto:dev@celix.apache.org">Apache Celix Project Team</a>
+ *  \copyright	Apache License, Version 2.0
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "hash_map.h"
+
+typedef hash_map_pt (*map_create_fp)(unsigned int (*keyHash)(const void*), unsigned int (*valueHash)(const void*),
+		int (*keyEquals)(const void*, const void*), int (*valueEquals)(const void*, const void*));
+
+static unsigned int benchmark_stringHash(const void *string) {
+	const char *str = string;
+	unsigned int hash = 1315423911;
+	for (; *str != '\0'; str++) {
+		hash ^= ((hash << 5) + (*str) + (hash >> 2));
+	}
+	return hash;
+}
+
+static int benchmark_stringEquals(const void *string, const void *toCompare) {
+	return strcmp(string, toCompare) == 0;
+}
+
+static double benchmark_elapsed(struct timespec *start) {
+	struct timespec end;
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return (end.tv_sec - start->tv_sec) * 1000.0 + (end.tv_nsec - start->tv_nsec) / 1000000.0;
+}
+
+static void benchmark_run(const char *name, map_create_fp create, char **keys, int nrOfEntries, int nrOfRounds) {
+	double put = 0, get = 0, miss = 0, iterate = 0, remove = 0;
+	int round;
+	int i;
+	unsigned long found = 0;
+
+	for (round = 0; round < nrOfRounds; round++) {
+		struct timespec start;
+		hash_map_pt map = create(benchmark_stringHash, NULL, benchmark_stringEquals, NULL);
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (i = 0; i < nrOfEntries; i++) {
+			hashMap_put(map, keys[i], keys[i]);
+		}
+		put += benchmark_elapsed(&start);
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (i = nrOfEntries - 1; i >= 0; i--) {
+			found += hashMap_get(map, keys[i]) != NULL;
+		}
+		get += benchmark_elapsed(&start);
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (i = 0; i < nrOfEntries; i++) {
+			found += hashMap_get(map, keys[nrOfEntries + i]) != NULL;
+		}
+		miss += benchmark_elapsed(&start);
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		hash_map_iterator_t iter = hashMapIterator_construct(map);
+		while (hashMapIterator_hasNext(&iter)) {
+			found += hashMapIterator_nextValue(&iter) != NULL;
+		}
+		iterate += benchmark_elapsed(&start);
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (i = 0; i < nrOfEntries; i++) {
+			hashMap_remove(map, keys[i]);
+		}
+		remove += benchmark_elapsed(&start);
+
+		hashMap_destroy(map, false, false);
+	}
+
+	//nanoseconds per operation
+	double ops = (double) nrOfEntries * nrOfRounds / 1000000.0;
+	printf("%-16s put %7.1f  get %7.1f  miss %7.1f  iterate %7.1f  remove %7.1f ns/op  (%lu)\n", name,
+			put / ops, get / ops, miss / ops, iterate / ops, remove / ops, found);
+}
+
+int main(int argc, char **argv) {
+	int nrOfEntries = argc > 1 ? atoi(argv[1]) : 100000;
+	int nrOfRounds = argc > 2 ? atoi(argv[2]) : 10;
+	int i;
+
+	//first half of the keys is put in the map, the second half is used for lookup misses
+	char **keys = malloc(2 * nrOfEntries * sizeof(*keys));
+	for (i = 0; i < 2 * nrOfEntries; i++) {
+		char buf[32];
+		snprintf(buf, sizeof(buf), "service.key.%d", i);
+		keys[i] = strdup(buf);
+	}
+
+	//shuffle, so entries are not put and looked up in allocation order
+	srand(42);
+	for (i = 2 * nrOfEntries - 1; i > 0; i--) {
+		int j = rand() % (i + 1);
+		char *tmp = keys[i];
+		keys[i] = keys[j];
+		keys[j] = tmp;
+	}
+
+	printf("%d entries, %d rounds\n", nrOfEntries, nrOfRounds);
+	benchmark_run("chained", hashMap_create, keys, nrOfEntries, nrOfRounds);
+	benchmark_run("open addressing", hashMap_createOpenAddressing, keys, nrOfEntries, nrOfRounds);
+
+	for (i = 0; i < 2 * nrOfEntries; i++) {
+		free(keys[i]);
+	}
+	free(keys);
+	return 0;
+}
@@ -1490,3 +1490,154 @@ TEST(hash_map_hash, containsValue){
 
 	hashMap_clear(map, true, true);
 }
+
+TEST_GROUP(hash_map_open_addressing){
+	hash_map_pt map;
+
+	void setup() {
+		map = hashMap_createOpenAddressing(test_hashKeyChar, test_hashValueChar, test_equalsKeyChar, test_equalsValueChar);
+	}
+	void teardown() {
+		hashMap_destroy(map, true, true);
+	}
+};
+
+static unsigned int test_collidingHash(const void * k) {
+	(void)(k);
+	return 42;
+}
+
+TEST(hash_map_open_addressing, create){
+	CHECK(map != NULL);
+	CHECK(map->openAddressing);
+	LONGS_EQUAL(0, map->size);
+	LONGS_EQUAL(16, map->tablelength);
+}
+
+TEST(hash_map_open_addressing, putGetRemove){
+	char key[16];
+	int i;
+
+	for (i = 0; i < 1000; i++) {
+		snprintf(key, sizeof(key), "key%d", i);
+		POINTERS_EQUAL(NULL, hashMap_put(map, my_strdup(key), my_strdup(key)));
+	}
+	LONGS_EQUAL(1000, hashMap_size(map));
+	CHECK(map->tablelength >= 1024);
+
+	for (i = 0; i < 1000; i++) {
+		snprintf(key, sizeof(key), "key%d", i);
+		STRCMP_EQUAL(key, (char *) hashMap_get(map, key));
+	}
+	POINTERS_EQUAL(NULL, hashMap_get(map, "unexisting"));
+
+	for (i = 0; i < 1000; i += 2) {
+		snprintf(key, sizeof(key), "key%d", i);
+		hash_map_entry_pt entry = hashMap_getEntry(map, key);
+		CHECK(entry != NULL);
+		void * entryKey = hashMapEntry_getKey(entry);
+		free(hashMap_remove(map, key));
+		free(entryKey);
+	}
+	LONGS_EQUAL(500, hashMap_size(map));
+
+	for (i = 0; i < 1000; i++) {
+		snprintf(key, sizeof(key), "key%d", i);
+		CHECK_EQUAL(i % 2 == 1, hashMap_containsKey(map, key));
+	}
+}
+
+TEST(hash_map_open_addressing, nullKey){
+	char * value = my_strdup("value");
+	char * value2 = my_strdup("value2");
+
+	hashMap_put(map, NULL, value);
+	POINTERS_EQUAL(value, hashMap_get(map, NULL));
+	POINTERS_EQUAL(value, hashMap_put(map, NULL, value2));
+	LONGS_EQUAL(1, hashMap_size(map));
+	POINTERS_EQUAL(value2, hashMap_remove(map, NULL));
+	CHECK(hashMap_isEmpty(map));
+
+	free(value);
+	free(value2);
+}
+
+TEST(hash_map_open_addressing, collisions){
+	char key[16];
+	int i;
+
+	hashMap_destroy(map, true, true);
+	map = hashMap_createOpenAddressing(test_collidingHash, NULL, test_equalsKeyChar, NULL);
+
+	for (i = 0; i < 100; i++) {
+		snprintf(key, sizeof(key), "key%d", i);
+		hashMap_put(map, my_strdup(key), NULL);
+	}
+	LONGS_EQUAL(100, hashMap_size(map));
+
+	for (i = 0; i < 100; i += 3) {
+		snprintf(key, sizeof(key), "key%d", i);
+		hash_map_entry_pt entry = hashMap_removeEntryForKey(map, key);
+		CHECK(entry != NULL);
+		free(entry->key);
+		free(entry);
+	}
+
+	for (i = 0; i < 100; i++) {
+		snprintf(key, sizeof(key), "key%d", i);
+		CHECK_EQUAL(i % 3 != 0, hashMap_containsKey(map, key));
+	}
+}
+
+TEST(hash_map_open_addressing, iteratorRemove){
+	char key[16];
+	int i;
+	int count = 0;
+
+	for (i = 0; i < 200; i++) {
+		snprintf(key, sizeof(key), "key%d", i);
+		hashMap_put(map, my_strdup(key), NULL);
+	}
+
+	hash_map_iterator_pt it = hashMapIterator_create(map);
+	while (hashMapIterator_hasNext(it)) {
+		char * itKey = (char *) hashMapIterator_nextKey(it);
+		count++;
+		if (atoi(itKey + 3) % 2 == 0) {
+			hashMapIterator_remove(it);
+			free(itKey);
+		}
+	}
+	hashMapIterator_destroy(it);
+
+	LONGS_EQUAL(200, count);
+	LONGS_EQUAL(100, hashMap_size(map));
+
+	count = 0;
+	it = hashMapIterator_create(map);
+	while (hashMapIterator_hasNext(it)) {
+		char * itKey = (char *) hashMapIterator_nextKey(it);
+		CHECK(atoi(itKey + 3) % 2 == 1);
+		count++;
+	}
+	hashMapIterator_destroy(it);
+	LONGS_EQUAL(100, count);
+}
+
+TEST(hash_map_open_addressing, entrySetAndClear){
+	char * key = my_strdup("key");
+	char * value = my_strdup("value");
+	hash_map_entry_set_pt entrySet = hashMapEntrySet_create(map);
+
+	hashMap_put(map, key, value);
+	hash_map_entry_pt entry = hashMap_getEntry(map, key);
+	CHECK(hashMapEntrySet_remove(entrySet, entry));
+	CHECK(hashMap_isEmpty(map));
+	hashMapEntrySet_destroy(entrySet);
+
+	hashMap_put(map, key, value);
+	CHECK(hashMap_containsValue(map, value));
+	hashMap_clear(map, true, true);
+	CHECK(hashMap_isEmpty(map));
+	CHECK(!hashMap_containsKey(map, "key"));
+}
@@ -100,6 +100,8 @@ typedef pthread_condattr_t celix_thread_condattr_t;
 celix_status_t celixThreadCondition_init(celix_thread_cond_t *condition, celix_thread_condattr_t *attr);
 celix_status_t celixThreadCondition_destroy(celix_thread_cond_t *condition);
 celix_status_t celixThreadCondition_wait(celix_thread_cond_t *cond, celix_thread_mutex_t *mutex);
+//returns ETIMEDOUT when the condition was not signaled within the given (relative) time
+celix_status_t celixThreadCondition_timedwaitRelative(celix_thread_cond_t *cond, celix_thread_mutex_t *mutex, long seconds, long nanoseconds);
 celix_status_t celixThreadCondition_broadcast(celix_thread_cond_t *cond);
 celix_status_t celixThreadCondition_signal(celix_thread_cond_t *cond);
 
@@ -50,6 +50,19 @@ typedef struct hashMapEntrySet * hash_map_entry_set_pt;
 
 UTILS_EXPORT hash_map_pt hashMap_create(unsigned int (*keyHash)(const void*), unsigned int (*valueHash)(const void*),
 		int (*keyEquals)(const void*, const void*), int (*valueEquals)(const void*, const void*));
+/**
+ * Creates a hash map which stores its entries inline in an open addressing (Robin Hood) table instead of in
+ * separately allocated, chained entries. It supports the same hashMap_* API and iterator semantics.
+ * Note that an entry returned by hashMap_getEntry or hashMapIterator_nextEntry is only valid until the map is modified.
+ */
+UTILS_EXPORT hash_map_pt hashMap_createOpenAddressing(unsigned int (*keyHash)(const void*), unsigned int (*valueHash)(const void*),
+		int (*keyEquals)(const void*, const void*), int (*valueEquals)(const void*, const void*));
+/**
+ * Same as hashMap_createOpenAddressing, but starts with room for initialCapacity (rounded up to a power of two) home slots.
+ * A small capacity keeps small maps a compact flat array of slots, the table grows once it gets too full.
+ */
+UTILS_EXPORT hash_map_pt hashMap_createOpenAddressingWithCapacity(unsigned int initialCapacity, unsigned int (*keyHash)(const void*),
+		unsigned int (*valueHash)(const void*), int (*keyEquals)(const void*, const void*), int (*valueEquals)(const void*, const void*));
 UTILS_EXPORT void hashMap_destroy(hash_map_pt map, bool freeKeys, bool freeValues);
 UTILS_EXPORT int hashMap_size(hash_map_pt map);
 UTILS_EXPORT bool hashMap_isEmpty(hash_map_pt map);